@@ -0,0 +1,647 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "memory_usage.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string filter;
+    std::string outPath;
+    std::size_t maxUsers{100000};
+    std::size_t maxExpenses{100000};
+    std::size_t maxThreads{8};
+    double minSeconds{0.2};
+    std::uint64_t seed{42};
+};
+
+struct BenchResult {
+    explicit BenchResult(std::string benchName) : name(std::move(benchName)) {}
+
+    std::string name;
+    std::size_t iterations{0};
+    double seconds{0.0};
+    std::map<std::string, double> counters;
+};
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Collects benchmark results and renders them as text and JSON.
+ */
+class BenchRunner {
+public:
+    explicit BenchRunner(Options options) : options_(std::move(options)) {}
+
+    const Options &options() const noexcept { return options_; }
+
+    bool enabled(const std::string &name) const {
+        return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+    }
+
+    void record(BenchResult result) {
+        double nsPerOp = result.iterations ? result.seconds * 1e9 / static_cast<double>(result.iterations) : 0.0;
+        std::cout << std::left << std::setw(44) << result.name << std::right << std::setw(10) << result.iterations
+                  << " iters " << std::setw(14) << std::fixed << std::setprecision(1) << nsPerOp << " ns/op";
+        for (const auto &[key, value] : result.counters) {
+            std::cout << "  " << key << "=" << std::setprecision(2) << value;
+        }
+        std::cout << "\n";
+        results_.push_back(std::move(result));
+    }
+
+    nlohmann::json toJson() const {
+        nlohmann::json j;
+        nlohmann::json meta;
+        meta["seed"] = static_cast<double>(options_.seed);
+        meta["hardwareThreads"] = static_cast<double>(std::thread::hardware_concurrency());
+        meta["maxUsers"] = static_cast<double>(options_.maxUsers);
+        j["meta"] = meta;
+        j["results"] = nlohmann::json::array();
+        for (const auto &result : results_) {
+            nlohmann::json entry;
+            entry["name"] = result.name;
+            entry["iterations"] = static_cast<double>(result.iterations);
+            entry["seconds"] = result.seconds;
+            entry["nsPerOp"] = result.iterations ? result.seconds * 1e9 / static_cast<double>(result.iterations) : 0.0;
+            nlohmann::json counters;
+            for (const auto &[key, value] : result.counters) {
+                counters[key] = value;
+            }
+            entry["counters"] = counters;
+            j["results"].push_back(entry);
+        }
+        return j;
+    }
+
+private:
+    Options options_;
+    std::vector<BenchResult> results_;
+};
+
+/**
+ * @brief Builds a manager with `userCount` users partitioned into groups of `groupSize`.
+ */
+struct Ledger {
+    std::unique_ptr<SplitwiseManager> manager{std::make_unique<SplitwiseManager>()};
+    std::vector<std::string> users;
+    std::vector<std::string> groups;
+    std::vector<std::vector<std::string>> members;
+};
+
+Ledger buildLedger(std::size_t userCount, std::size_t groupSize) {
+    Ledger ledger;
+    ledger.users.reserve(userCount);
+    for (std::size_t i = 0; i < userCount; ++i) {
+        ledger.users.push_back(ledger.manager->addUser("user" + std::to_string(i)));
+    }
+    for (std::size_t start = 0; start < userCount; start += groupSize) {
+        std::size_t end = std::min(userCount, start + groupSize);
+        std::vector<std::string> members(ledger.users.begin() + static_cast<std::ptrdiff_t>(start),
+                                         ledger.users.begin() + static_cast<std::ptrdiff_t>(end));
+        ledger.groups.push_back(ledger.manager->addGroup("group" + std::to_string(start / groupSize), members));
+        ledger.members.push_back(std::move(members));
+    }
+    return ledger;
+}
+
+SplitInput makeInput(const std::string &strategy,
+                     const std::vector<std::string> &participants,
+                     std::mt19937_64 &rng) {
+    std::uniform_int_distribution<int> cents(100, 100000);
+    SplitInput input;
+    input.payerId = participants.front();
+    input.participantIds = participants;
+    input.amount = static_cast<double>(cents(rng)) / 100.0;
+    if (strategy == "exact") {
+        double share = input.amount / static_cast<double>(participants.size());
+        input.exactShares.assign(participants.size(), share);
+        input.exactShares.back() = input.amount - share * static_cast<double>(participants.size() - 1);
+    } else if (strategy == "percent") {
+        double share = 100.0 / static_cast<double>(participants.size());
+        input.percentShares.assign(participants.size(), share);
+        input.percentShares.back() = 100.0 - share * static_cast<double>(participants.size() - 1);
+    }
+    return input;
+}
+
+/**
+ * @brief Add one expense per group so every user carries a non-zero balance.
+ */
+void seedExpenses(Ledger &ledger, std::size_t perGroup, std::mt19937_64 &rng) {
+    auto equal = SplitStrategyFactory::create("equal");
+    for (std::size_t round = 0; round < perGroup; ++round) {
+        for (std::size_t g = 0; g < ledger.groups.size(); ++g) {
+            auto participants = ledger.members[g];
+            std::rotate(participants.begin(),
+                        participants.begin() + static_cast<std::ptrdiff_t>(round % participants.size()),
+                        participants.end());
+            ledger.manager->addExpense(ledger.groups[g], "seed", makeInput("equal", participants, rng), equal);
+        }
+    }
+}
+
+std::vector<std::size_t> scaleSteps(std::size_t from, std::size_t max) {
+    std::vector<std::size_t> steps;
+    for (std::size_t n = from; n <= max; n *= 10) {
+        steps.push_back(n);
+    }
+    return steps;
+}
+
+void benchAddExpense(BenchRunner &runner) {
+    for (const std::string strategyType : {"equal", "exact", "percent"}) {
+        for (std::size_t participantCount : {2, 8, 64}) {
+            std::string name = "addExpense/" + strategyType + "/participants=" + std::to_string(participantCount);
+            if (!runner.enabled(name)) {
+                continue;
+            }
+            std::mt19937_64 rng(runner.options().seed);
+            Ledger ledger = buildLedger(participantCount, participantCount);
+            auto strategy = SplitStrategyFactory::create(strategyType);
+            std::vector<SplitInput> inputs;
+            for (int i = 0; i < 256; ++i) {
+                inputs.push_back(makeInput(strategyType, ledger.members.front(), rng));
+            }
+
+            BenchResult result(name);
+            auto start = Clock::now();
+            while (secondsSince(start) < runner.options().minSeconds) {
+                for (const auto &input : inputs) {
+                    ledger.manager->addExpense(ledger.groups.front(), "bench", input, strategy);
+                }
+                result.iterations += inputs.size();
+            }
+            result.seconds = secondsSince(start);
+            result.counters["opsPerSec"] = static_cast<double>(result.iterations) / result.seconds;
+            runner.record(std::move(result));
+        }
+    }
+}
+
+void benchSettleUp(BenchRunner &runner) {
+    for (std::size_t users : scaleSteps(1000, runner.options().maxUsers)) {
+        std::string name = "settleUpGreedy/users=" + std::to_string(users);
+        if (!runner.enabled(name)) {
+            continue;
+        }
+        std::mt19937_64 rng(runner.options().seed);
+        Ledger ledger = buildLedger(users, 10);
+        seedExpenses(ledger, 1, rng);
+
+        BenchResult result(name);
+        std::size_t transfers = 0;
+        auto start = Clock::now();
+        do {
+            transfers = ledger.manager->settleUpGreedy().size();
+            ++result.iterations;
+        } while (secondsSince(start) < runner.options().minSeconds);
+        result.seconds = secondsSince(start);
+        result.counters["transfers"] = static_cast<double>(transfers);
+        runner.record(std::move(result));
+    }
+}
+
+/**
+ * @brief Times the ranked top-100 creditor query that dashboards poll, against the same ledgers as settle-up.
+ */
+void benchTopCreditors(BenchRunner &runner) {
+    for (std::size_t users : scaleSteps(1000, runner.options().maxUsers)) {
+        std::string name = "topCreditors/users=" + std::to_string(users);
+        if (!runner.enabled(name)) {
+            continue;
+        }
+        std::mt19937_64 rng(runner.options().seed);
+        Ledger ledger = buildLedger(users, 10);
+        seedExpenses(ledger, 1, rng);
+
+        BenchResult result(name);
+        std::size_t listed = 0;
+        auto start = Clock::now();
+        do {
+            listed = ledger.manager->getTopCreditors(100).size();
+            ++result.iterations;
+        } while (secondsSince(start) < runner.options().minSeconds);
+        result.seconds = secondsSince(start);
+        result.counters["listed"] = static_cast<double>(listed);
+        runner.record(std::move(result));
+    }
+}
+
+/**
+ * @brief Times the rollup of one bottom-level department while the groups above and beside it grow.
+ *
+ * Groups form an 8-ary tree (group `i` sits under group `(i - 1) / 8`); the department queried is the parent of the
+ * last group, so its subtree stays the same size at every ledger size.
+ */
+void benchRollup(BenchRunner &runner) {
+    for (std::size_t users : scaleSteps(1000, runner.options().maxUsers)) {
+        std::string name = "rollup/users=" + std::to_string(users);
+        if (!runner.enabled(name)) {
+            continue;
+        }
+        std::mt19937_64 rng(runner.options().seed);
+        Ledger ledger = buildLedger(users, 10);
+        for (std::size_t g = 1; g < ledger.groups.size(); ++g) {
+            ledger.manager->setGroupParent(ledger.groups[g], ledger.groups[(g - 1) / 8]);
+        }
+        seedExpenses(ledger, 1, rng);
+        const std::string department = ledger.manager->getGroupParent(ledger.groups.back());
+
+        BenchResult result(name);
+        std::size_t entries = 0;
+        auto start = Clock::now();
+        do {
+            entries = ledger.manager->getRollupBalances(department).size();
+            ++result.iterations;
+        } while (secondsSince(start) < runner.options().minSeconds);
+        result.seconds = secondsSince(start);
+        result.counters["entries"] = static_cast<double>(entries);
+        runner.record(std::move(result));
+    }
+}
+
+/**
+ * @brief Times rejecting resubmitted expenses once `keys` idempotency keys are remembered.
+ *
+ * Every timed request repeats a key from the window, so each one passes the Bloom filters and is answered by the exact
+ * key set without touching balances.
+ */
+void benchDeduplication(BenchRunner &runner) {
+    for (std::size_t keys : scaleSteps(1000, runner.options().maxExpenses)) {
+        std::string name = "dedup/keys=" + std::to_string(keys);
+        if (!runner.enabled(name)) {
+            continue;
+        }
+        std::mt19937_64 rng(runner.options().seed);
+        Ledger ledger = buildLedger(8, 8);
+        std::vector<ExpenseRequest> requests(256);
+        for (std::size_t i = 0; i < keys; ++i) {
+            ExpenseRequest &request = requests[i % requests.size()];
+            request.groupId = ledger.groups.front();
+            request.description = "bench";
+            request.input = makeInput("equal", ledger.members.front(), rng);
+            request.strategy = SplitStrategyFactory::create("equal");
+            request.idempotencyKey = "client-" + std::to_string(i);
+            ledger.manager->addExpense(request);
+        }
+
+        BenchResult result(name);
+        auto start = Clock::now();
+        while (secondsSince(start) < runner.options().minSeconds) {
+            for (const auto &request : requests) {
+                ledger.manager->addExpense(request);
+            }
+            result.iterations += requests.size();
+        }
+        result.seconds = secondsSince(start);
+        const DeduplicationStats stats = ledger.manager->getDeduplicationStats();
+        result.counters["bytesPerKey"] = static_cast<double>(stats.bytes) / static_cast<double>(stats.keys);
+        runner.record(std::move(result));
+    }
+}
+
+void benchPersistence(BenchRunner &runner) {
+    for (std::size_t expenses : scaleSteps(1000, runner.options().maxExpenses)) {
+        std::string saveName = "saveToJson/expenses=" + std::to_string(expenses);
+        std::string loadName = "loadFromJson/expenses=" + std::to_string(expenses);
+        if (!runner.enabled(saveName) && !runner.enabled(loadName)) {
+            continue;
+        }
+        std::mt19937_64 rng(runner.options().seed);
+        std::size_t users = std::max<std::size_t>(10, expenses / 10);
+        Ledger ledger = buildLedger(users, 10);
+        seedExpenses(ledger, std::max<std::size_t>(1, expenses / ledger.groups.size()), rng);
+        const std::string path = "splitwise_bench_" + std::to_string(expenses) + ".json";
+
+        BenchResult save(saveName);
+        auto start = Clock::now();
+        do {
+            ledger.manager->saveToJson(path);
+            ++save.iterations;
+        } while (secondsSince(start) < runner.options().minSeconds);
+        save.seconds = secondsSince(start);
+
+        std::ifstream sizeProbe(path, std::ios::binary | std::ios::ate);
+        double bytes = static_cast<double>(sizeProbe.tellg());
+        save.counters["bytes"] = bytes;
+        save.counters["MBps"] = bytes * static_cast<double>(save.iterations) / save.seconds / 1e6;
+        if (runner.enabled(saveName)) {
+            runner.record(std::move(save));
+        }
+
+        if (runner.enabled(loadName)) {
+            BenchResult load(loadName);
+            SplitwiseManager target;
+            start = Clock::now();
+            do {
+                target.loadFromJson(path);
+                ++load.iterations;
+            } while (secondsSince(start) < runner.options().minSeconds);
+            load.seconds = secondsSince(start);
+            load.counters["bytes"] = bytes;
+            load.counters["MBps"] = bytes * static_cast<double>(load.iterations) / load.seconds / 1e6;
+            runner.record(std::move(load));
+        }
+        std::remove(path.c_str());
+    }
+}
+
+void benchContention(BenchRunner &runner) {
+    for (std::size_t threads = 1; threads <= runner.options().maxThreads; threads *= 2) {
+        std::string name = "contention/mixed80r20w/threads=" + std::to_string(threads);
+        if (!runner.enabled(name)) {
+            continue;
+        }
+        std::mt19937_64 seedRng(runner.options().seed);
+        Ledger ledger = buildLedger(200, 10);
+        seedExpenses(ledger, 1, seedRng);
+        auto equal = SplitStrategyFactory::create("equal");
+
+        std::atomic<bool> stop{false};
+        std::atomic<std::size_t> reads{0};
+        std::atomic<std::size_t> writes{0};
+        std::vector<std::thread> workers;
+        auto start = Clock::now();
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::mt19937_64 rng(runner.options().seed + t + 1);
+                std::uniform_int_distribution<int> pick(0, 99);
+                std::uniform_int_distribution<std::size_t> groupPick(0, ledger.groups.size() - 1);
+                std::size_t localReads = 0;
+                std::size_t localWrites = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    if (pick(rng) < 80) {
+                        ledger.manager->settleUpGreedy();
+                        ++localReads;
+                    } else {
+                        std::size_t g = groupPick(rng);
+                        ledger.manager->addExpense(
+                            ledger.groups[g], "contention", makeInput("equal", ledger.members[g], rng), equal);
+                        ++localWrites;
+                    }
+                }
+                reads += localReads;
+                writes += localWrites;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(runner.options().minSeconds));
+        stop = true;
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        BenchResult result(name);
+        result.seconds = secondsSince(start);
+        result.iterations = reads + writes;
+        result.counters["reads"] = static_cast<double>(reads);
+        result.counters["writes"] = static_cast<double>(writes);
+        result.counters["opsPerSec"] = static_cast<double>(result.iterations) / result.seconds;
+        runner.record(std::move(result));
+    }
+}
+
+/**
+ * @brief Time `loadFromJson`, `saveToJson` and `settleUpGreedy` on one ledger at 1, 2, 4 ... `maxThreads` threads.
+ */
+/**
+ * @brief Times `memoryUsage()` and records the ledger footprint, so `--compare` also catches size regressions.
+ */
+void benchMemory(BenchRunner &runner) {
+    for (std::size_t expenses : scaleSteps(1000, runner.options().maxExpenses)) {
+        std::string name = "memoryUsage/expenses=" + std::to_string(expenses);
+        if (!runner.enabled(name)) {
+            continue;
+        }
+        std::mt19937_64 rng(runner.options().seed);
+        const memory::HeapStats heapBefore = memory::heapStats();
+        Ledger ledger = buildLedger(std::max<std::size_t>(10, expenses / 10), 10);
+        seedExpenses(ledger, std::max<std::size_t>(1, expenses / ledger.groups.size()), rng);
+        const memory::HeapStats heapAfter = memory::heapStats();
+
+        BenchResult result(name);
+        memory::MemoryUsage usage;
+        auto start = Clock::now();
+        do {
+            usage = ledger.manager->memoryUsage();
+            ++result.iterations;
+        } while (secondsSince(start) < runner.options().minSeconds);
+        result.seconds = secondsSince(start);
+        const double recorded = static_cast<double>(usage.components.at("expenses").objects);
+        result.counters["bytes"] = static_cast<double>(usage.total().bytes);
+        result.counters["bytesPerExpense"] = static_cast<double>(usage.total().bytes) / recorded;
+        if (heapAfter.enabled) {
+            result.counters["heapBytesPerExpense"] =
+                static_cast<double>(heapAfter.liveBytes - heapBefore.liveBytes) / recorded;
+        }
+        runner.record(std::move(result));
+    }
+}
+
+void benchScaling(BenchRunner &runner) {
+    const std::vector<std::string> operations = {"loadFromJson", "saveToJson", "settleUpGreedy"};
+    bool any = false;
+    for (const auto &operation : operations) {
+        any = any || runner.enabled("scaling/" + operation);
+    }
+    if (!any) {
+        return;
+    }
+    std::mt19937_64 rng(runner.options().seed);
+    std::size_t expenses = runner.options().maxExpenses;
+    Ledger ledger = buildLedger(std::max<std::size_t>(10, expenses / 10), 10);
+    seedExpenses(ledger, std::max<std::size_t>(1, expenses / ledger.groups.size()), rng);
+    const std::string path = "splitwise_bench_scaling.json";
+    ledger.manager->saveToJson(path);
+    SplitwiseManager target;
+
+    std::map<std::string, double> baseline;
+    for (std::size_t threads = 1; threads <= runner.options().maxThreads; threads *= 2) {
+        for (const auto &operation : operations) {
+            std::string name = "scaling/" + operation + "/threads=" + std::to_string(threads);
+            if (!runner.enabled(name)) {
+                continue;
+            }
+            target.setParallelism(static_cast<unsigned>(threads));
+            ledger.manager->setParallelism(static_cast<unsigned>(threads));
+            BenchResult result(name);
+            auto start = Clock::now();
+            do {
+                if (operation == "loadFromJson") {
+                    target.loadFromJson(path);
+                } else if (operation == "saveToJson") {
+                    ledger.manager->saveToJson(path);
+                } else {
+                    ledger.manager->settleUpGreedy();
+                }
+                ++result.iterations;
+            } while (secondsSince(start) < runner.options().minSeconds);
+            result.seconds = secondsSince(start);
+            double secondsPerOp = result.seconds / static_cast<double>(result.iterations);
+            baseline.emplace(operation, secondsPerOp);
+            result.counters["threads"] = static_cast<double>(threads);
+            result.counters["speedup"] = baseline.at(operation) / secondsPerOp;
+            runner.record(std::move(result));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+nlohmann::json readResults(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open results file: " + path);
+    }
+    nlohmann::json j;
+    in >> j;
+    if (!j.contains("results")) {
+        throw std::runtime_error("Invalid results file: " + path);
+    }
+    return j;
+}
+
+/**
+ * @brief Lower-is-better values of one result: its time per operation, plus footprint counters when present.
+ */
+std::vector<std::pair<std::string, double>> comparableValues(const nlohmann::json &entry) {
+    const std::string name = entry.at("name").get<std::string>();
+    std::vector<std::pair<std::string, double>> values{{name, entry.at("nsPerOp").get<double>()}};
+    const nlohmann::json &counters = entry.at("counters");
+    for (const char *footprint : {"bytesPerExpense", "heapBytesPerExpense"}) {
+        if (counters.contains(footprint)) {
+            values.emplace_back(name + " [" + footprint + "]", counters.at(footprint).get<double>());
+        }
+    }
+    return values;
+}
+
+/**
+ * @brief Compare two result files; returns non-zero when a benchmark regressed past the threshold in time or footprint.
+ */
+int compareResults(const std::string &basePath, const std::string &candidatePath, double threshold) {
+    const nlohmann::json base = readResults(basePath);
+    const nlohmann::json candidates = readResults(candidatePath);
+    std::map<std::string, double> baseline;
+    for (const auto &entry : base.at("results")) {
+        for (const auto &[key, value] : comparableValues(entry)) {
+            baseline[key] = value;
+        }
+    }
+
+    int regressions = 0;
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(14) << "base"
+              << std::setw(14) << "new" << std::setw(10) << "change" << "\n";
+    for (const auto &entry : candidates.at("results")) {
+        for (const auto &[name, candidate] : comparableValues(entry)) {
+            auto it = baseline.find(name);
+            if (it == baseline.end() || it->second <= 0.0) {
+                continue;
+            }
+            double change = (candidate - it->second) / it->second;
+            bool regressed = change > threshold;
+            regressions += regressed ? 1 : 0;
+            std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(14) << it->second << std::setw(14) << candidate << std::setw(9)
+                      << std::showpos << change * 100.0 << std::noshowpos << "%"
+                      << (regressed ? "  REGRESSION" : "") << "\n";
+        }
+    }
+    std::cout << regressions << " regression(s) above " << threshold * 100.0 << "%\n";
+    return regressions == 0 ? 0 : 1;
+}
+
+void printUsage() {
+    std::cout << "Usage: splitwise_bench [--filter TEXT] [--out FILE] [--max-users N] [--max-expenses N]\n"
+              << "                       [--max-threads N] [--min-time SECONDS] [--seed N]\n"
+              << "       splitwise_bench --compare BASE.json CANDIDATE.json [--threshold FRACTION]\n";
+}
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    std::vector<std::string> compare;
+    double threshold = 0.10;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--filter") {
+                options.filter = next();
+            } else if (arg == "--out") {
+                options.outPath = next();
+            } else if (arg == "--max-users") {
+                options.maxUsers = std::stoul(next());
+            } else if (arg == "--max-expenses") {
+                options.maxExpenses = std::stoul(next());
+            } else if (arg == "--max-threads") {
+                options.maxThreads = std::stoul(next());
+            } else if (arg == "--min-time") {
+                options.minSeconds = std::stod(next());
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(next());
+            } else if (arg == "--compare") {
+                compare.push_back(next());
+                compare.push_back(next());
+            } else if (arg == "--threshold") {
+                threshold = std::stod(next());
+            } else {
+                printUsage();
+                return arg == "--help" ? 0 : 2;
+            }
+        }
+
+        if (!compare.empty()) {
+            return compareResults(compare[0], compare[1], threshold);
+        }
+
+        BenchRunner runner(options);
+        benchAddExpense(runner);
+        benchSettleUp(runner);
+        benchTopCreditors(runner);
+        benchRollup(runner);
+        benchDeduplication(runner);
+        benchPersistence(runner);
+        benchContention(runner);
+        benchScaling(runner);
+        benchMemory(runner);
+
+        if (!options.outPath.empty()) {
+            std::ofstream out(options.outPath);
+            if (!out) {
+                throw std::runtime_error("Failed to open file for writing: " + options.outPath);
+            }
+            out << std::setw(2) << runner.toJson();
+            std::cout << "Results written to " << options.outPath << "\n";
+        }
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "splitwise_manager.hpp"
+#include "strand.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * @brief Non-blocking facade over a `SplitwiseManager`.
+ *
+ * Every call returns immediately with a future, or takes a completion callback that runs on a pool worker once the
+ * operation finishes (callbacks must not throw). Expenses are routed to a strand per group, so writes to one group are
+ * applied in submission order while different groups proceed concurrently on the shared pool. `settleUpAsync` and
+ * `saveAsync` wait behind the work already queued on every group strand, so they observe every expense submitted
+ * before them, without holding up later submissions.
+ */
+class AsyncSplitwiseManager {
+public:
+    using ExpenseCallback = std::function<void(const std::string &expenseId, std::exception_ptr error)>;
+    using SettleCallback = std::function<void(std::vector<SettlementTransaction> transactions, std::exception_ptr error)>;
+    using SaveCallback = std::function<void(std::exception_ptr error)>;
+
+    /**
+     * @brief Run on a private pool of `threads` workers (0 = hardware concurrency).
+     */
+    explicit AsyncSplitwiseManager(SplitwiseManager &manager, unsigned threads = 0);
+
+    /**
+     * @brief Run on a pool shared with other components; `pool` must outlive this object.
+     */
+    AsyncSplitwiseManager(SplitwiseManager &manager, ThreadPool &pool);
+
+    /**
+     * @brief Waits for every submitted operation to complete.
+     */
+    ~AsyncSplitwiseManager();
+
+    AsyncSplitwiseManager(const AsyncSplitwiseManager &) = delete;
+    AsyncSplitwiseManager &operator=(const AsyncSplitwiseManager &) = delete;
+
+    /**
+     * @brief Queue `request` on its group's strand; the future yields the new expense id or rethrows the validation
+     * error `addExpense` would have thrown.
+     */
+    std::future<std::string> addExpenseAsync(ExpenseRequest request);
+    void addExpenseAsync(ExpenseRequest request, ExpenseCallback done);
+
+    /**
+     * @brief Settle once every previously submitted expense has been applied (`currency` as in `settleUpGreedy`).
+     */
+    std::future<std::vector<SettlementTransaction>> settleUpAsync(std::string currency = {});
+    void settleUpAsync(std::string currency, SettleCallback done);
+
+    /**
+     * @brief Save to `path` once every previously submitted expense has been applied.
+     */
+    std::future<void> saveAsync(std::string path);
+    void saveAsync(std::string path, SaveCallback done);
+
+    /**
+     * @brief Block until every operation submitted so far has completed.
+     */
+    void waitIdle();
+
+    std::size_t strandCount() const;
+
+private:
+    std::shared_ptr<Strand> strandFor(const std::string &groupId);
+    void afterQueued(ThreadPool::Task task);
+    void begin();
+    void finish();
+
+    SplitwiseManager &manager_;
+    std::unique_ptr<ThreadPool> ownedPool_;
+    ThreadPool &pool_;
+
+    mutable std::mutex strandsMutex_;
+    std::map<std::string, std::shared_ptr<Strand>> strands_;
+
+    std::mutex idleMutex_;
+    std::condition_variable idle_;
+    std::size_t inFlight_{0};
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Runs save requests on one background thread, coalescing requests for the same path.
+ *
+ * A request for a path that is already queued joins that queued save and receives the same future, so bursts of
+ * requests cost one save each time the writer gets to them. A save that is already running is never joined: the
+ * request queues a fresh save, which therefore captures every change made before it was requested.
+ */
+class AsyncSaver {
+public:
+    using SaveFunction = std::function<void(const std::string &path)>;
+
+    explicit AsyncSaver(SaveFunction save);
+
+    /**
+     * @brief Completes every queued save before returning.
+     */
+    ~AsyncSaver();
+
+    AsyncSaver(const AsyncSaver &) = delete;
+    AsyncSaver &operator=(const AsyncSaver &) = delete;
+
+    /**
+     * @brief Queue a save of `path`; the future rethrows any error raised by the save.
+     */
+    std::shared_future<void> request(const std::string &path);
+
+    /**
+     * @brief Block until no save is queued or running.
+     */
+    void waitIdle();
+
+    /**
+     * @brief Number of requests absorbed by an already queued save.
+     */
+    std::size_t coalescedCount() const;
+
+private:
+    struct Pending {
+        std::promise<void> promise;
+        std::shared_future<void> future;
+    };
+
+    void run();
+
+    SaveFunction save_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<std::string, Pending> pending_;
+    std::size_t coalesced_{0};
+    bool busy_{false};
+    bool stopping_{false};
+    std::thread worker_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "balance_sheet.hpp"
+
+/**
+ * @brief Periodic balance snapshots used to answer "balances as of time T" without replaying the ledger.
+ *
+ * Checkpoint `i` holds the sum of every expense with a timestamp `<= boundary`. A new checkpoint copies the live
+ * balances once at least `max(minInterval, users)` expenses were recorded since the previous one, which keeps the
+ * copy cost amortised O(1) per expense and total memory proportional to the ledger. Backdated inserts, edits and
+ * deletes are folded into every checkpoint whose boundary is at or after the affected timestamp.
+ */
+class BalanceHistory {
+public:
+    struct Checkpoint {
+        std::int64_t boundary{0};
+        BalanceSheet balances;
+    };
+
+    explicit BalanceHistory(std::size_t minInterval = 1024);
+
+    /**
+     * @brief Drop every checkpoint.
+     */
+    void clear();
+
+    /**
+     * @brief Account for a new expense whose delta has already been applied to `live`.
+     *
+     * `latestTimestamp` is the newest timestamp in the ledger, which bounds everything contained in `live`.
+     */
+    void record(std::int64_t timestamp,
+                const BalanceSheet::BalanceMap &delta,
+                const BalanceSheet &live,
+                std::int64_t latestTimestamp);
+
+    /**
+     * @brief Apply a correction (e.g. a reversed delta) to checkpoints covering `timestamp`.
+     */
+    void revise(std::int64_t timestamp, const BalanceSheet::BalanceMap &delta);
+
+    /**
+     * @brief Add `delta` times `weight(boundary)` to every checkpoint whose boundary is at or after `timestamp`.
+     *
+     * Folds many occurrences of a recurring expense into each checkpoint at once; `weight` returns how many of them
+     * fall at or before that checkpoint's boundary (negative to remove them).
+     */
+    template <typename Weight>
+    void reviseScaled(std::int64_t timestamp, const BalanceSheet::BalanceMap &delta, Weight &&weight) {
+        for (auto it = firstAtOrAfter(timestamp); it != checkpoints_.end(); ++it) {
+            const double factor = weight(it->boundary);
+            if (factor == 0.0) {
+                continue;
+            }
+            BalanceSheet::BalanceMap scaled = delta;
+            for (auto &[userId, change] : scaled) {
+                change *= factor;
+            }
+            it->balances.applyDelta(scaled);
+        }
+    }
+
+    /**
+     * @brief The newest checkpoint with `boundary <= timestamp`, or nullptr.
+     */
+    const Checkpoint *latestAtOrBefore(std::int64_t timestamp) const;
+
+    std::size_t size() const noexcept { return checkpoints_.size(); }
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    std::vector<Checkpoint>::iterator firstAtOrAfter(std::int64_t timestamp);
+
+    std::size_t minInterval_;
+    std::size_t sinceLast_{0};
+    std::vector<Checkpoint> checkpoints_;
+};
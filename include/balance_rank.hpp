@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "balance_sheet.hpp"
+
+/**
+ * @brief One user's position in a balance ranking.
+ */
+struct RankedBalance {
+    std::string userId;
+    double balance{0.0};
+};
+
+/**
+ * @brief Order-statistic treap over `(balance, userId)` that mirrors a balance map as deltas are applied.
+ *
+ * Every node stores the size of its subtree, so top-N and bottom-N cost O(log n + k) and rank and range counts
+ * cost O(log n), without copying or sorting the balances. Balances follow `BalanceSheet::applyDelta` exactly,
+ * including the snap of near-zero results to zero, so the two always hold identical values.
+ */
+class BalanceRank {
+public:
+    void applyDelta(const BalanceSheet::BalanceMap &delta);
+    void clear();
+
+    std::size_t size() const noexcept { return balances_.size(); }
+
+    /**
+     * @brief The mirrored balances, keyed by user id.
+     */
+    const std::unordered_map<std::string, double> &balances() const noexcept { return balances_; }
+
+    /**
+     * @brief Up to `n` largest balances (most owed first).
+     */
+    std::vector<RankedBalance> top(std::size_t n) const;
+
+    /**
+     * @brief Up to `n` smallest balances (largest debt first).
+     */
+    std::vector<RankedBalance> bottom(std::size_t n) const;
+
+    /**
+     * @brief 1-based position of `userId` counted from the largest balance; empty when the user has no entry.
+     */
+    std::optional<std::size_t> rank(const std::string &userId) const;
+
+    /**
+     * @brief Number of balances with `low <= balance <= high`.
+     */
+    std::size_t countBetween(double low, double high) const;
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    static constexpr std::uint32_t kNil = UINT32_MAX;
+
+    struct Node {
+        double balance{0.0};
+        std::string userId;
+        std::uint32_t priority{0};
+        std::uint32_t left{kNil};
+        std::uint32_t right{kNil};
+        std::uint32_t size{1};
+    };
+
+    std::uint32_t sizeOf(std::uint32_t node) const noexcept { return node == kNil ? 0 : nodes_[node].size; }
+    void update(std::uint32_t node) noexcept;
+    bool less(const Node &node, double balance, const std::string &userId) const noexcept;
+    void split(std::uint32_t node,
+               double balance,
+               const std::string &userId,
+               std::uint32_t &left,
+               std::uint32_t &right);
+    std::uint32_t merge(std::uint32_t left, std::uint32_t right);
+    void insert(double balance, const std::string &userId);
+    std::uint32_t erase(std::uint32_t node, double balance, const std::string &userId);
+    std::uint32_t allocate(double balance, const std::string &userId);
+    std::size_t countBelow(double balance, bool inclusive) const;
+
+    // Nodes live in one arena addressed by index; erased slots are reused through `free_`.
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> free_;
+    std::uint32_t root_{kNil};
+    std::uint64_t seed_{0x9E3779B97F4A7C15ULL};
+    std::unordered_map<std::string, double> balances_;
+};
+
+/**
+ * @brief Balance rankings for the whole ledger and for each group, updated with every applied delta.
+ *
+ * Query methods take a group id; an empty id ranks the global balances.
+ */
+class BalanceRankIndex {
+public:
+    void apply(const std::string &groupId, const BalanceSheet::BalanceMap &delta);
+    void clear();
+
+    /**
+     * @brief Ranking for `groupId` (empty = global); nullptr when no delta was applied to that group.
+     */
+    const BalanceRank *find(const std::string &groupId) const;
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    BalanceRank global_;
+    std::map<std::string, BalanceRank> byGroup_;
+};
@@ -36,6 +36,11 @@ public:
      */
     static BalanceSheet fromJson(const nlohmann::json &j);
 
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
 private:
     BalanceMap balances_{};
 };
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "splitwise_manager.hpp"
+
+/**
+ * @brief Maps CSV header names onto expense fields.
+ *
+ * `group`, `payer` and `amount` columns are required. Missing optional columns fall back to: all group members as
+ * participants, the `equal` strategy, no shares, an empty description, the import time and the base currency. `date` cells hold Unix
+ * seconds or `YYYY-MM-DD[THH:MM:SS]` (UTC). List cells (participants, shares) use `listDelimiter` between items.
+ */
+struct CsvColumnMapping {
+    std::string group{"group"};
+    std::string payer{"payer"};
+    std::string amount{"amount"};
+    std::string participants{"participants"};
+    std::string strategy{"strategy"};
+    std::string shares{"shares"};
+    std::string description{"description"};
+    std::string timestamp{"date"};
+    std::string currency{"currency"};
+    char delimiter{','};
+    char listDelimiter{';'};
+
+    /**
+     * @brief Parse overrides such as `group=Account,payer=Paid By,amount=Total`.
+     */
+    static CsvColumnMapping parse(const std::string &spec);
+};
+
+/**
+ * @brief Tuning knobs for `CsvImporter`.
+ */
+struct CsvImportOptions {
+    CsvColumnMapping mapping{};
+    unsigned threads{0};
+    std::size_t chunkBytes{4 << 20};
+    std::size_t batchSize{4096};
+};
+
+/**
+ * @brief A rejected CSV record and the reason it was rejected.
+ */
+struct CsvLineError {
+    std::size_t line{0};
+    std::string message;
+};
+
+/**
+ * @brief Outcome of a CSV import.
+ */
+struct CsvImportReport {
+    std::size_t rows{0};
+    std::size_t imported{0};
+    std::vector<CsvLineError> errors;
+    double seconds{0.0};
+
+    double rowsPerSecond() const noexcept { return seconds > 0.0 ? static_cast<double>(rows) / seconds : 0.0; }
+};
+
+/**
+ * @brief Streaming, parallel CSV importer for bank and card exports.
+ *
+ * The file is memory-mapped and cut into chunks at record boundaries. Chunks are parsed and validated on worker
+ * threads and applied to the manager strictly in file order through `addExpenses`, so ids and balances match a
+ * sequential import. Quoted fields (with `""` escapes) are supported; records may not span lines.
+ */
+class CsvImporter {
+public:
+    explicit CsvImporter(CsvImportOptions options = {});
+
+    /**
+     * @brief Import every record of `path` into `manager`; bad records are reported per line and skipped.
+     */
+    CsvImportReport importFile(SplitwiseManager &manager, const std::string &path) const;
+
+private:
+    CsvImportOptions options_;
+};
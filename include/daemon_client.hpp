@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "daemon_protocol.hpp"
+
+/**
+ * @brief Blocking client for `DaemonServer`.
+ *
+ * `send` only buffers a request; `flush` writes every buffered request in one go and `receive` returns responses in
+ * request order, so callers can pipeline as deeply as they like. `call` is the one-request convenience wrapper.
+ */
+class DaemonClient {
+public:
+    /**
+     * @throws std::runtime_error when the server cannot be reached.
+     */
+    static DaemonClient connectUnix(const std::string &socketPath);
+    static DaemonClient connectTcp(const std::string &host, std::uint16_t port);
+
+    DaemonClient(DaemonClient &&other) noexcept;
+    DaemonClient &operator=(DaemonClient &&other) noexcept;
+    ~DaemonClient();
+
+    DaemonClient(const DaemonClient &) = delete;
+    DaemonClient &operator=(const DaemonClient &) = delete;
+
+    /**
+     * @brief Queue one script command line; returns its request id.
+     */
+    std::uint64_t send(const std::string &command);
+
+    void flush();
+
+    /**
+     * @brief Flush queued requests and shut down the sending side; responses can still be received.
+     *
+     * @throws std::runtime_error when the requests cannot be sent.
+     */
+    void finishSending();
+
+    /**
+     * @brief Flush queued requests, then block for the next response.
+     *
+     * @throws std::runtime_error when the connection drops.
+     */
+    protocol::Response receive();
+
+    protocol::Response call(const std::string &command);
+
+    /**
+     * @brief Pipeline `commands` and collect their responses in order.
+     */
+    std::vector<protocol::Response> callBatch(const std::vector<std::string> &commands);
+
+private:
+    explicit DaemonClient(int fd) : fd_(fd) {}
+
+    int fd_{-1};
+    std::uint64_t nextId_{1};
+    std::string outgoing_;
+    protocol::FrameDecoder decoder_;
+};
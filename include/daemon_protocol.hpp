@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Wire format shared by `DaemonServer` and `DaemonClient`.
+ *
+ * Every message is a frame: a 4-byte big-endian payload length followed by the payload. A request payload is an 8-byte
+ * big-endian request id followed by one script command line (see `ScriptRunner`). A response payload is the echoed
+ * request id, one status byte (0 = ok, 1 = error) and the command's output text. Clients may pipeline any number of
+ * requests; responses on one connection arrive in request order.
+ */
+namespace protocol {
+
+constexpr std::size_t kMaxPayload = 16u << 20;
+
+struct Request {
+    std::uint64_t id{0};
+    std::string command;
+};
+
+struct Response {
+    std::uint64_t id{0};
+    bool ok{true};
+    std::string body;
+};
+
+void encodeRequest(std::string &out, std::uint64_t id, std::string_view command);
+void encodeResponse(std::string &out, const Response &response);
+
+/**
+ * @throws std::runtime_error when the payload is too short to hold its header.
+ */
+Request decodeRequest(std::string_view payload);
+Response decodeResponse(std::string_view payload);
+
+/**
+ * @brief Reassembles frames from an arbitrarily split byte stream.
+ */
+class FrameDecoder {
+public:
+    void feed(const char *data, std::size_t size);
+
+    /**
+     * @brief Pop the next complete payload into `payload`; returns false when more bytes are needed.
+     *
+     * @throws std::runtime_error when a frame announces more than `kMaxPayload` bytes.
+     */
+    bool next(std::string &payload);
+
+private:
+    std::string buffer_;
+    std::size_t offset_{0};
+};
+
+} // namespace protocol
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "splitwise_manager.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * @brief Where and how `DaemonServer` listens.
+ *
+ * A non-empty `socketPath` selects a Unix domain socket; otherwise the server listens on loopback TCP `port`
+ * (0 = pick a free port, see `DaemonServer::port()`).
+ */
+struct DaemonOptions {
+    std::string socketPath;
+    std::uint16_t port{0};
+    unsigned workers{0};
+    bool readOnly{false};  ///< Serve queries only, e.g. on a replication follower (see `ScriptOptions::readOnly`).
+};
+
+/**
+ * @brief Counters describing the server's lifetime activity.
+ */
+struct DaemonStats {
+    std::size_t connectionsAccepted{0};
+    std::size_t requestsServed{0};
+    std::size_t responseBatches{0};
+};
+
+/**
+ * @brief Serves one `SplitwiseManager` to many local clients over the `protocol` frame format.
+ *
+ * A single epoll thread accepts connections, reads and decodes frames and writes responses; commands run on a
+ * `ThreadPool`. Each connection acts as a strand: at most one worker task drains its queued requests at a time, so
+ * pipelined requests execute and answer in order, while different connections run in parallel. Every request drained
+ * in one task is answered with a single batched write. A client that shuts down its sending side still receives the
+ * responses to everything it sent before the connection is closed.
+ */
+class DaemonServer {
+public:
+    DaemonServer(SplitwiseManager &manager, DaemonOptions options);
+
+    /**
+     * @brief Stops the event loop and closes every connection.
+     */
+    ~DaemonServer();
+
+    DaemonServer(const DaemonServer &) = delete;
+    DaemonServer &operator=(const DaemonServer &) = delete;
+
+    /**
+     * @brief Bind and run the event loop on a background thread.
+     *
+     * @throws std::runtime_error when the socket cannot be bound.
+     */
+    void start();
+
+    /**
+     * @brief Bind (unless `start` already did) and run the event loop on the calling thread until `requestStop`.
+     */
+    void run();
+
+    /**
+     * @brief Ask the event loop to exit. Async-signal-safe, so it may be called from a signal handler.
+     */
+    void requestStop() noexcept;
+
+    /**
+     * @brief Request a stop and wait for a loop started with `start()` to exit.
+     */
+    void stop();
+
+    /**
+     * @brief Bound TCP port (meaningful for TCP listeners after `start`/`run` bound the socket).
+     */
+    std::uint16_t port() const noexcept { return port_; }
+
+    DaemonStats stats() const;
+
+private:
+    struct Connection;
+
+    void bind();
+    void loop();
+    void acceptConnections();
+    void readFrom(const std::shared_ptr<Connection> &connection);
+    void drain(const std::shared_ptr<Connection> &connection);
+    void flushPending();
+    void writeTo(const std::shared_ptr<Connection> &connection);
+    void closeIfFinished(const std::shared_ptr<Connection> &connection);
+    void close(const std::shared_ptr<Connection> &connection);
+    void updateInterest(Connection &connection);
+
+    SplitwiseManager &manager_;
+    DaemonOptions options_;
+    int listenFd_{-1};
+    int epollFd_{-1};
+    int wakeFd_{-1};
+    std::uint16_t port_{0};
+    std::atomic<bool> stopRequested_{false};
+    std::map<int, std::shared_ptr<Connection>> connections_;
+
+    std::mutex readyMutex_;
+    std::vector<std::shared_ptr<Connection>> ready_;
+
+    std::atomic<std::size_t> connectionsAccepted_{0};
+    std::atomic<std::size_t> requestsServed_{0};
+    std::atomic<std::size_t> responseBatches_{0};
+
+    std::thread loopThread_;
+    // Destroyed before the descriptors are closed, so no worker is left writing into a dead connection.
+    std::unique_ptr<ThreadPool> pool_;
+};
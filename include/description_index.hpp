@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "posting_list.hpp"
+
+/**
+ * @brief Split text into lowercase alphanumeric terms, dropping duplicates while keeping first-seen order.
+ *
+ * ASCII letters and digits form terms; bytes >= 0x80 are kept so UTF-8 words survive intact. Everything else
+ * separates terms.
+ */
+std::vector<std::string> tokenizeDescription(std::string_view text);
+
+/**
+ * @brief A ranked search result: an expense handle from `ExpenseIndex` and its relevance.
+ */
+struct DescriptionMatch {
+    std::uint32_t handle{0};
+    double score{0.0};
+};
+
+/**
+ * @brief Inverted index from description terms to posting lists of expense handles.
+ *
+ * Terms live in an ordered dictionary so every query term also matches as a prefix ("lis" finds "lisbon"). A document
+ * matches when each query term matches one of its terms; it scores the sum over query terms of the best matching
+ * term's inverse document frequency, with prefix-only matches weighted at half. Ties rank newer handles first.
+ */
+class DescriptionIndex {
+public:
+    void clear();
+
+    /**
+     * @brief Rebuild from `descriptions[handle]`, tokenizing chunks on `threads` workers. Deleted handles are null.
+     */
+    void build(const std::vector<const std::string *> &descriptions, unsigned threads);
+
+    void add(std::uint32_t handle, std::string_view description);
+    void remove(std::uint32_t handle, std::string_view description);
+
+    /**
+     * @brief Best `limit` matches for `query`, restricted to handles present in every one of `filters`.
+     */
+    std::vector<DescriptionMatch> search(std::string_view query,
+                                         std::size_t limit,
+                                         const std::vector<const PostingList *> &filters = {}) const;
+
+    std::size_t termCount() const noexcept { return terms_.size(); }
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    using Candidates = std::vector<DescriptionMatch>;
+
+    Candidates candidatesFor(const std::string &term) const;
+
+    std::map<std::string, PostingList, std::less<>> terms_;
+    std::size_t documents_{0};
+};
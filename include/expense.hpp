@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <nlohmann/json.hpp>
@@ -8,15 +9,19 @@
 
 /**
  * @brief Represents an expense recorded in the system.
+ *
+ * Expenses are immutable values that share one heap record, so copying one (for example into a background save
+ * snapshot) costs a reference-count increment rather than a deep copy of its strings and share vectors.
  */
 class Expense {
 public:
-    Expense() = default;
+    Expense();
     Expense(std::string id,
             std::string groupId,
             std::string description,
             SplitInput input,
-            std::shared_ptr<SplitStrategy> strategy);
+            std::shared_ptr<SplitStrategy> strategy,
+            std::int64_t timestamp = 0);
 
     const std::string &getId() const noexcept;
     const std::string &getGroupId() const noexcept;
@@ -24,14 +29,37 @@ public:
     const SplitInput &getInput() const noexcept;
     const std::shared_ptr<SplitStrategy> &getStrategy() const noexcept;
 
+    /**
+     * @brief When the expense occurred, in seconds since the Unix epoch (0 for records saved before timestamps).
+     */
+    std::int64_t getTimestamp() const noexcept;
+
     nlohmann::json toJson() const;
     static Expense fromJson(const nlohmann::json &j, const std::shared_ptr<SplitStrategy> &strategy);
 
+    /**
+     * @brief Estimated footprint in bytes: this handle plus the shared record, and the strategy divided among the
+     * records sharing it.
+     */
+    std::size_t memoryBytes() const noexcept;
+
 private:
-    std::string id_{};
-    std::string groupId_{};
-    std::string description_{};
-    SplitInput input_{};
-    std::shared_ptr<SplitStrategy> strategy_{};
+    struct Record {
+        std::string id;
+        std::string groupId;
+        std::string description;
+        SplitInput input;
+        std::shared_ptr<SplitStrategy> strategy;
+        std::int64_t timestamp{0};
+    };
+
+    std::shared_ptr<const Record> record_;
 };
 
+/**
+ * @brief Parse Unix seconds or a UTC date in the form `YYYY-MM-DD[THH:MM[:SS]]`.
+ *
+ * @throws std::invalid_argument when the text is neither.
+ */
+std::int64_t parseTimestamp(const std::string &text);
+
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "expense.hpp"
+#include "posting_list.hpp"
+
+/**
+ * @brief One page of a cursor-paginated expense query.
+ *
+ * `nextCursor` is empty once the listing is exhausted; otherwise pass it back to continue after the last item.
+ */
+struct ExpensePage {
+    std::vector<Expense> expenses;
+    std::string nextCursor;
+};
+
+/**
+ * @brief Per-user and per-group posting lists of expense handles.
+ *
+ * Every indexed expense gets a dense 32-bit handle in ingestion order (reassigned in id-creation order when the index
+ * is rebuilt), so listings are stable across pages and posting lists stay small deltas. A user's list covers every
+ * expense they paid for or take part in.
+ */
+class ExpenseIndex {
+public:
+    using Handle = std::uint32_t;
+
+    void clear();
+
+    /**
+     * @brief Rebuild from scratch in one pass over `expenses`.
+     */
+    void build(const std::map<std::string, Expense> &expenses);
+
+    void insert(const Expense &expense);
+
+    /**
+     * @brief Re-index an edited expense under its existing handle.
+     */
+    void update(const Expense &before, const Expense &after);
+
+    void erase(const Expense &expense);
+
+    /**
+     * @brief Handle of an indexed expense id, or `kNoHandle`.
+     */
+    Handle handleOf(const std::string &expenseId) const;
+
+    /**
+     * @brief Expense id for a handle; empty when the expense has since been deleted.
+     */
+    const std::string &idOf(Handle handle) const { return ids_.at(handle); }
+
+    /**
+     * @brief Number of handles assigned so far, including those of deleted expenses.
+     */
+    std::size_t handleCount() const noexcept { return ids_.size(); }
+
+    /**
+     * @brief Postings for a user or group, or nullptr when nothing is indexed under that id.
+     */
+    const PostingList *userPostings(const std::string &userId) const;
+    const PostingList *groupPostings(const std::string &groupId) const;
+
+    /**
+     * @brief Collect up to `limit` ids from `postings` starting at `cursor` (empty = from the start).
+     *
+     * @throws std::invalid_argument for malformed cursors.
+     */
+    std::vector<std::string> page(const PostingList *postings,
+                                  const std::string &cursor,
+                                  std::size_t limit,
+                                  std::string &nextCursor) const;
+
+    std::size_t memoryBytes() const noexcept;
+
+    static constexpr Handle kNoHandle = ~Handle{0};
+
+private:
+    void post(const Expense &expense, Handle handle);
+    void unpost(const Expense &expense, Handle handle);
+
+    std::vector<std::string> ids_;
+    std::unordered_map<std::string, Handle> handles_;
+    std::unordered_map<std::string, PostingList> byUser_;
+    std::unordered_map<std::string, PostingList> byGroup_;
+};
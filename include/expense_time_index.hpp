@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "expense.hpp"
+
+/**
+ * @brief Time-ordered secondary index over expense ids, globally and per group.
+ *
+ * Range scans cost O(log n + k). Entries with equal timestamps are ordered by expense id.
+ */
+class ExpenseTimeIndex {
+public:
+    using Entry = std::pair<std::int64_t, std::string>;
+    using EntrySet = std::set<Entry>;
+
+    void insert(const Expense &expense);
+    void erase(const Expense &expense);
+    void clear();
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+    /**
+     * @brief All indexed expenses in time order.
+     */
+    const EntrySet &all() const noexcept { return all_; }
+
+    /**
+     * @brief Visit expenses with `from <= timestamp <= to`, optionally restricted to one group (empty = all groups).
+     */
+    template <typename Fn>
+    void forEachInRange(const std::string &groupId, std::int64_t from, std::int64_t to, Fn &&fn) const {
+        const EntrySet *entries = &all_;
+        if (!groupId.empty()) {
+            auto it = byGroup_.find(groupId);
+            if (it == byGroup_.end()) {
+                return;
+            }
+            entries = &it->second;
+        }
+        for (auto it = entries->lower_bound({from, std::string{}}); it != entries->end() && it->first <= to; ++it) {
+            fn(it->second);
+        }
+    }
+
+private:
+    EntrySet all_;
+    std::map<std::string, EntrySet> byGroup_;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "balance_sheet.hpp"
+
+/**
+ * @brief Immutable table of exchange rates loaded from a local file.
+ *
+ * The file lists one `CODE VALUE` pair per line, where VALUE is what one unit of CODE is worth in the table's
+ * reference currency; blank lines and `#` comments are ignored. Any cross rate is `value(from) / value(to)`, so a table
+ * of N currencies answers all N * N pairs from one hash lookup per code.
+ */
+class FxTable {
+public:
+    /**
+     * @brief Parse a rate table from a stream.
+     *
+     * @throws std::runtime_error for malformed lines, duplicate codes or non-positive values.
+     */
+    static FxTable parse(std::istream &in, const std::string &source = "<stream>");
+
+    /**
+     * @brief Load `path`, reusing the parsed table while the file's size and modification time are unchanged.
+     */
+    static std::shared_ptr<const FxTable> load(const std::string &path);
+
+    bool contains(const std::string &code) const { return index_.count(code) != 0; }
+
+    /**
+     * @brief Units of `to` per unit of `from`.
+     *
+     * @throws std::invalid_argument when either code is missing from the table.
+     */
+    double rate(const std::string &from, const std::string &to) const;
+
+    /**
+     * @brief Add `balances` (denominated in `from`) into `out` converted to `to`, with one rate lookup for the batch.
+     */
+    void convertInto(const BalanceSheet::BalanceMap &balances,
+                     const std::string &from,
+                     const std::string &to,
+                     BalanceSheet::BalanceMap &out) const;
+
+    std::size_t size() const noexcept { return values_.size(); }
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    std::size_t indexOf(const std::string &code) const;
+
+    std::unordered_map<std::string, std::size_t> index_;
+    std::vector<double> values_;
+};
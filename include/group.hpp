@@ -1,29 +1,134 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <nlohmann/json.hpp>
 
+/**
+ * @brief One entry of a group's membership history: `userId` joined or left at `epoch`.
+ */
+struct MembershipChange {
+    std::uint64_t epoch{0};
+    std::int64_t timestamp{0};
+    std::string userId;
+    bool joined{true};
+};
+
 /**
  * @brief Represents a group of users that can share expenses.
+ *
+ * Membership is versioned. Every `addMember` / `removeMember` starts a new epoch stamped with the time of the change;
+ * the founding members passed to the constructor belong from epoch 0, which covers all earlier time. Each user keeps
+ * the epochs at which their stints in the group began and ended, so "was this user a member at epoch e" is one hash
+ * lookup plus a comparison (a scan of earlier stints only for users who left and rejoined).
  */
 class Group {
 public:
+    using Epoch = std::uint64_t;
+
     Group() = default;
     Group(std::string id, std::string name, std::vector<std::string> memberIds);
 
     const std::string &getId() const noexcept;
     const std::string &getName() const noexcept;
+
+    /**
+     * @brief Current members. Removing a member moves the last member into its slot.
+     */
     const std::vector<std::string> &getMemberIds() const noexcept;
 
+    /**
+     * @brief Members at `timestamp`; the current list when no change came later, otherwise every past and present
+     * member is checked.
+     */
+    std::vector<std::string> getMemberIdsAt(std::int64_t timestamp) const;
+
+    /**
+     * @brief Whether `userId` is a member now, in O(1).
+     */
     bool hasMember(const std::string &userId) const;
 
+    /**
+     * @brief Whether `userId` was a member during `epoch`, in O(1) for users with a single stint.
+     */
+    bool hasMemberAtEpoch(const std::string &userId, Epoch epoch) const;
+
+    /**
+     * @brief Whether `userId` was a member at `timestamp`; changes stamped at `timestamp` already apply.
+     */
+    bool hasMemberAt(const std::string &userId, std::int64_t timestamp) const;
+
+    /**
+     * @brief The latest epoch (0 until membership first changes).
+     */
+    Epoch getEpoch() const noexcept;
+
+    /**
+     * @brief The epoch in effect at `timestamp`, in O(log changes).
+     */
+    Epoch epochAt(std::int64_t timestamp) const;
+
+    /**
+     * @brief Timestamp of the latest membership change; the minimum timestamp while there is none.
+     */
+    std::int64_t getLastChangeTime() const noexcept;
+
+    /**
+     * @brief Add `userId` from `timestamp` on and return the new epoch.
+     *
+     * @throws std::invalid_argument when the user is already a member or `timestamp` precedes the latest change.
+     */
+    Epoch addMember(const std::string &userId, std::int64_t timestamp);
+
+    /**
+     * @brief Remove `userId` from `timestamp` on and return the new epoch; expenses before then stay valid.
+     *
+     * @throws std::invalid_argument when the user is not a member or `timestamp` precedes the latest change.
+     */
+    Epoch removeMember(const std::string &userId, std::int64_t timestamp);
+
+    /**
+     * @brief Every membership change in epoch order.
+     */
+    std::vector<MembershipChange> getHistory() const;
+
+    /**
+     * @brief Estimated heap footprint in bytes, excluding `sizeof(Group)` itself.
+     */
+    std::size_t memoryBytes() const noexcept;
+
     nlohmann::json toJson() const;
+
+    /**
+     * @throws std::runtime_error when the membership history contradicts the member list.
+     */
     static Group fromJson(const nlohmann::json &j);
 
 private:
+    static constexpr Epoch kOpen = std::numeric_limits<Epoch>::max();
+
+    /**
+     * @brief Member during `joined <= epoch < left`.
+     */
+    struct Stint {
+        Epoch joined{0};
+        Epoch left{kOpen};
+    };
+
+    struct Membership {
+        Stint latest;
+        std::vector<Stint> earlier;  // only for users who left and rejoined
+        std::size_t position{0};     // index in memberIds_ while a member
+    };
+
+    Epoch beginChange(std::int64_t timestamp);
+
     std::string id_{};
     std::string name_{};
     std::vector<std::string> memberIds_{};
+    std::unordered_map<std::string, Membership> members_{};  // current and former members
+    std::vector<std::int64_t> epochTimes_{};                 // epochTimes_[e - 1] is when epoch e began
 };
-
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "balance_rank.hpp"
+#include "balance_sheet.hpp"
+
+/**
+ * @brief Optional parent/child links between groups, with the base-currency balances of every subtree.
+ *
+ * Only groups that have a parent or children are tracked; each keeps the net of its own expenses plus those of all its
+ * descendants. A delta applied to a group is added to the group and each of its ancestors, so a rollup is a single
+ * lookup and an update costs O(depth). A group's own balances are read from the per-group rankings, which already
+ * mirror every applied delta.
+ *
+ * While balances are being recomputed from scratch the totals are stale: `invalidate` drops them, deltas are ignored,
+ * and `rebuild` derives them again in one bottom-up pass.
+ */
+class GroupHierarchy {
+public:
+    /**
+     * @brief Parent of `groupId`; empty for a root or a group outside the hierarchy.
+     */
+    std::string parentOf(const std::string &groupId) const;
+
+    /**
+     * @brief Direct children of `groupId` in the order they were attached.
+     */
+    std::vector<std::string> childrenOf(const std::string &groupId) const;
+
+    /**
+     * @brief Move `groupId` and its subtree under `parentId`, or detach it when `parentId` is empty.
+     *
+     * The subtree total is subtracted from the old ancestors and added to the new ones, in O(depth x users in the
+     * subtree). Groups left without a parent or children stop being tracked.
+     *
+     * @throws std::invalid_argument when `parentId` is `groupId` itself or one of its descendants.
+     */
+    void setParent(const std::string &groupId, const std::string &parentId, const BalanceRankIndex &ranks);
+
+    /**
+     * @brief Add a base-currency delta applied to `groupId` to the group and its ancestors.
+     */
+    void apply(const std::string &groupId, const BalanceSheet::BalanceMap &delta);
+
+    /**
+     * @brief Balances of `groupId` and all its descendants; nullptr when the group is not in the hierarchy.
+     */
+    const BalanceSheet::BalanceMap *rollup(const std::string &groupId) const;
+
+    /**
+     * @brief Every link as child id -> parent id.
+     */
+    std::map<std::string, std::string> parents() const;
+
+    /**
+     * @brief Replace all links (child id -> parent id); totals stay stale until `rebuild`.
+     *
+     * @throws std::runtime_error when the links form a cycle.
+     */
+    void assign(const std::map<std::string, std::string> &parents);
+
+    /**
+     * @brief Drop every total and ignore deltas until `rebuild`.
+     */
+    void invalidate();
+
+    /**
+     * @brief Derive every total from the groups' own balances, visiting each group once with children first.
+     */
+    void rebuild(const BalanceRankIndex &ranks);
+
+    void clear();
+
+    /**
+     * @brief Number of groups that have a parent or children.
+     */
+    std::size_t size() const noexcept { return nodes_.size(); }
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    struct Node {
+        std::string parent;
+        std::vector<std::string> children;
+        BalanceSheet total;
+    };
+
+    Node &nodeFor(const std::string &groupId, const BalanceRankIndex &ranks);
+    void addToAncestors(const std::string &groupId, const BalanceSheet::BalanceMap &delta);
+    void prune(const std::string &groupId);
+
+    std::map<std::string, Node> nodes_;
+    bool stale_{false};
+};
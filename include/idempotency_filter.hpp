@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "split_strategy.hpp"
+
+/**
+ * @brief How `SplitwiseManager` recognises an expense that was submitted twice.
+ */
+struct DeduplicationOptions {
+    std::int64_t windowSeconds{24 * 60 * 60};  ///< How long after ingestion a key keeps rejecting duplicates.
+    bool contentKeys{false};                   ///< Derive a key from the content of expenses submitted without one.
+    std::size_t expectedKeys{1 << 16};         ///< Keys per window the Bloom filters are sized for.
+};
+
+/**
+ * @brief A remembered idempotency key: the expense it created and when it was ingested (seconds since the epoch).
+ */
+struct IdempotencyRecord {
+    std::string key;
+    std::string expenseId;
+    std::int64_t time{0};
+
+    nlohmann::json toJson() const;
+    static IdempotencyRecord fromJson(const nlohmann::json &j);
+};
+
+/**
+ * @brief Counters reported by the `dedup-stats` script command.
+ */
+struct DeduplicationStats {
+    std::size_t keys{0};
+    std::uint64_t lookups{0};
+    std::uint64_t duplicates{0};
+    std::uint64_t filtered{0};        ///< Lookups answered by the Bloom filters without touching the exact set.
+    std::uint64_t falsePositives{0};  ///< Lookups the Bloom filters let through for a key the exact set did not hold.
+    std::size_t bytes{0};
+
+    nlohmann::json toJson() const;
+};
+
+/**
+ * @brief Idempotency keys seen within a sliding window, each mapped to the expense it created.
+ *
+ * A lookup first consults two Bloom filters and only reaches the exact hash map when one of them may hold the key, so
+ * the common case of a new key costs a few bit probes. Each filter covers one window-long generation of insertions;
+ * when a generation ends the older filter is dropped, which never happens before every key in it has expired. Keys
+ * expire in insertion order from a queue, so expiry is amortised O(1) as well.
+ *
+ * Time only moves forward: a lookup or insertion dated before the latest one is treated as happening at the latest.
+ */
+class IdempotencyFilter {
+public:
+    /**
+     * @throws std::invalid_argument for a non-positive window or zero expected keys.
+     */
+    explicit IdempotencyFilter(DeduplicationOptions options = {});
+
+    const DeduplicationOptions &options() const noexcept { return options_; }
+
+    /**
+     * @brief Apply new options to the remembered keys, rebuilding the Bloom filters for them.
+     *
+     * @throws std::invalid_argument for a non-positive window or zero expected keys.
+     */
+    void configure(const DeduplicationOptions &options);
+
+    /**
+     * @brief Expense recorded for `key` within the window ending at `now`; nullptr when the key is new.
+     */
+    const std::string *find(const std::string &key, std::int64_t now);
+
+    /**
+     * @brief Remember that `key` created `expenseId` at `time`; a key already remembered keeps its first expense.
+     */
+    void insert(const std::string &key, const std::string &expenseId, std::int64_t time);
+
+    /**
+     * @brief Every remembered key, oldest first.
+     */
+    std::vector<IdempotencyRecord> records() const;
+
+    /**
+     * @brief Replace the remembered keys with `records` (as returned by `records`) and rebuild the Bloom filters.
+     */
+    void restore(const std::vector<IdempotencyRecord> &records);
+
+    void clear();
+
+    std::size_t size() const noexcept { return keys_.size(); }
+
+    DeduplicationStats stats() const;
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+    /**
+     * @brief Key derived from an expense's group, payer, amount, currency, strategy and participant shares.
+     *
+     * Participants are sorted, so the order they were listed in does not matter. The digest is computed with a fixed
+     * hash function, so keys stay valid across builds and restarts.
+     */
+    static std::string contentKey(const std::string &groupId, const SplitInput &input, const std::string &strategy);
+
+private:
+    /**
+     * @brief Fixed-size bit array probed by double hashing; allocated on the first insertion.
+     */
+    class BloomFilter {
+    public:
+        void add(std::uint64_t hash, std::size_t expectedKeys);
+        bool mayContain(std::uint64_t hash) const noexcept;
+        void clear() noexcept;
+        std::size_t memoryBytes() const noexcept;
+
+    private:
+        std::vector<std::uint64_t> words_;
+    };
+
+    struct Entry {
+        std::string expenseId;
+        std::int64_t time;
+    };
+
+    void advance(std::int64_t now);
+    void rebuildFilters();
+
+    DeduplicationOptions options_;
+    std::unordered_map<std::string, Entry> keys_;
+    std::deque<std::pair<std::int64_t, const std::string *>> order_;  // insertion time and key, oldest first
+    BloomFilter current_;
+    BloomFilter previous_;
+    std::int64_t generationStart_{0};
+    std::int64_t clock_{0};
+    std::uint64_t lookups_{0};
+    std::uint64_t duplicates_{0};
+    std::uint64_t filtered_{0};
+    std::uint64_t falsePositives_{0};
+};
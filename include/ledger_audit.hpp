@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "balance_sheet.hpp"
+#include "expense.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * @brief Neumaier-compensated running sum; the error stays O(1) ulp however many terms are added.
+ */
+class CompensatedSum {
+public:
+    void add(double value) noexcept;
+    void add(const CompensatedSum &other) noexcept;
+    double value() const noexcept { return sum_ + compensation_; }
+
+private:
+    double sum_{0.0};
+    double compensation_{0.0};
+};
+
+/**
+ * @brief A user whose recorded balance differs from the recomputed one.
+ */
+struct BalanceDiscrepancy {
+    std::string currency;
+    std::string userId;
+    double expected{0.0};
+    double recorded{0.0};
+};
+
+/**
+ * @brief A group (or, with an empty `groupId`, the whole ledger) whose balances do not net to zero.
+ */
+struct ZeroSumViolation {
+    std::string groupId;
+    std::string currency;
+    double sum{0.0};
+};
+
+/**
+ * @brief Outcome of `SplitwiseManager::audit`.
+ *
+ * `expected` holds balances recomputed from the expense records with compensated summation. `live` compares them
+ * with the manager's balance sheets; `persisted` compares a saved ledger's `"balances"` with that file's own records.
+ */
+struct AuditReport {
+    std::size_t expensesChecked{0};
+    std::map<std::string, BalanceSheet::BalanceMap> expected;
+    std::vector<ZeroSumViolation> zeroSumViolations;
+    std::vector<BalanceDiscrepancy> live;
+    bool persistedChecked{false};
+    std::size_t persistedExpensesChecked{0};
+    std::vector<BalanceDiscrepancy> persisted;
+
+    bool ok() const noexcept { return zeroSumViolations.empty() && live.empty() && persisted.empty(); }
+};
+
+/**
+ * @brief Balances and zero-sum checks recomputed from `expenses`.
+ */
+struct LedgerRecount {
+    std::map<std::string, BalanceSheet::BalanceMap> balances;
+    std::vector<ZeroSumViolation> violations;
+};
+
+/**
+ * @brief Recompute every balance from `expenses` in parallel chunks on `pool` (null = inline).
+ *
+ * Balances are keyed by currency, with `baseCurrency` standing for expenses that carry no code. Each chunk folds its
+ * splits into compensated per-user and per-group sums, and chunks are merged in order, so the result does not depend
+ * on the pool size. Groups and currencies whose net exceeds `tolerance` are reported as violations.
+ */
+LedgerRecount recountLedger(const std::vector<Expense> &expenses,
+                            const std::string &baseCurrency,
+                            double tolerance,
+                            ThreadPool *pool);
+
+/**
+ * @brief Users (in either map) whose balances differ by more than `tolerance`, tagged with `currency`.
+ */
+std::vector<BalanceDiscrepancy> diffBalances(const std::string &currency,
+                                             const BalanceSheet::BalanceMap &expected,
+                                             const BalanceSheet::BalanceMap &recorded,
+                                             double tolerance);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "balance_sheet.hpp"
+#include "expense.hpp"
+#include "group.hpp"
+#include "idempotency_filter.hpp"
+#include "recurring_expense.hpp"
+#include "thread_pool.hpp"
+#include "user.hpp"
+
+/**
+ * @brief Point-in-time copy of everything `saveToJson` persists.
+ *
+ * Captured under the manager lock and serialised after it is released. Expense copies share their immutable records,
+ * so capturing costs one reference-count increment per expense.
+ */
+struct LedgerSnapshot {
+    std::vector<User> users;
+    std::vector<Group> groups;
+    std::map<std::string, std::string> groupParents;  ///< Rollup hierarchy as child group id -> parent group id.
+    std::vector<Expense> expenses;
+    BalanceSheet balances;
+    std::string baseCurrency;
+    std::map<std::string, std::size_t> counters;
+    std::vector<RecurringExpense> recurring;
+    std::int64_t recurringAsOf{std::numeric_limits<std::int64_t>::min()};  ///< Occurrences up to here are in balances.
+    std::uint64_t replicationSequence{0};  ///< Last replicated operation reflected in this state.
+    std::vector<IdempotencyRecord> idempotencyKeys;  ///< Keys within the deduplication window, oldest first.
+
+    /**
+     * @brief The ledger in the on-disk JSON layout read by `SplitwiseManager::loadFromJson`.
+     */
+    nlohmann::json toJson() const;
+
+    /**
+     * @brief `toJson().dump(indent)`, with expense records rendered in parallel chunks on `pool` (null = inline).
+     */
+    std::string dump(int indent, ThreadPool *pool = nullptr) const;
+};
+
+/**
+ * @brief Replace `path` with `contents` so readers see either the old or the new file, never a partial one.
+ *
+ * Writes a sibling temp file, fsyncs it, renames it over `path` and fsyncs the directory.
+ *
+ * @throws std::runtime_error when any step fails; the original file is left untouched.
+ */
+void writeFileAtomically(const std::string &path, const std::string &contents);
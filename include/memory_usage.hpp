@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#ifndef SPLITWISE_TRACK_ALLOCATIONS
+#define SPLITWISE_TRACK_ALLOCATIONS 0
+#endif
+
+namespace memory {
+
+constexpr bool kHeapTrackingEnabled = SPLITWISE_TRACK_ALLOCATIONS != 0;
+
+/**
+ * @brief Bytes a heap allocation of `requested` bytes really occupies.
+ *
+ * Models a glibc-style allocator: an 8-byte chunk header, 16-byte granularity and a 32-byte minimum chunk.
+ */
+constexpr std::size_t allocationBytes(std::size_t requested) noexcept {
+    const std::size_t chunk = (requested + sizeof(std::size_t) + 15) / 16 * 16;
+    return chunk < 32 ? 32 : chunk;
+}
+
+/**
+ * @brief Out-of-line storage of `s`; zero while it fits the small-string buffer.
+ */
+inline std::size_t stringBytes(const std::string &s) noexcept {
+    return s.capacity() > 15 ? allocationBytes(s.capacity() + 1) : 0;
+}
+
+/**
+ * @brief One `std::map` / `std::set` node holding `Value`: colour word and three pointers ahead of the value.
+ */
+template <typename Value>
+constexpr std::size_t treeNodeBytes() noexcept {
+    return allocationBytes(4 * sizeof(void *) + sizeof(Value));
+}
+
+/**
+ * @brief One `std::unordered_map` node holding `Value`: next pointer and cached hash around the value.
+ */
+template <typename Value>
+constexpr std::size_t hashNodeBytes() noexcept {
+    return allocationBytes(sizeof(void *) + sizeof(Value) + sizeof(std::size_t));
+}
+
+/**
+ * @brief Heap buffer of a vector (by capacity, not size).
+ */
+template <typename T>
+std::size_t vectorBytes(const std::vector<T> &values) noexcept {
+    return values.capacity() != 0 ? allocationBytes(values.capacity() * sizeof(T)) : 0;
+}
+
+/**
+ * @brief Bucket array of an unordered container; a single bucket lives inside the container itself.
+ */
+template <typename HashMap>
+std::size_t bucketBytes(const HashMap &map) noexcept {
+    return map.bucket_count() > 1 ? allocationBytes(map.bucket_count() * sizeof(void *)) : 0;
+}
+
+/**
+ * @brief Object count and estimated bytes (inline size, node and allocator overhead included) of one structure.
+ */
+struct Footprint {
+    std::size_t objects{0};
+    std::size_t bytes{0};
+
+    Footprint &operator+=(const Footprint &other) noexcept {
+        objects += other.objects;
+        bytes += other.bytes;
+        return *this;
+    }
+
+    nlohmann::json toJson() const;
+};
+
+/**
+ * @brief Process-wide heap counters maintained by the replaced global `operator new` / `operator delete`.
+ *
+ * Only collected when built with SPLITWISE_TRACK_ALLOCATIONS; otherwise `enabled` is false and every counter is zero.
+ * Sizes are the bytes requested, without allocator overhead.
+ */
+struct HeapStats {
+    bool enabled{kHeapTrackingEnabled};
+    std::uint64_t liveBytes{0};
+    std::uint64_t peakBytes{0};
+    std::uint64_t liveAllocations{0};
+    std::uint64_t totalAllocations{0};
+
+    nlohmann::json toJson() const;
+};
+
+HeapStats heapStats() noexcept;
+
+/**
+ * @brief Estimated footprint of a manager, broken down by structure.
+ *
+ * `components` is keyed by structure name (`users`, `expenses`, `descriptionIndex`, ...). `lastLoadJson` is the
+ * JSON document built by the most recent load, which is freed once the load finishes but sets its peak.
+ */
+struct MemoryUsage {
+    std::map<std::string, Footprint> components;
+    Footprint lastLoadJson;
+    HeapStats heap;
+
+    /**
+     * @brief Sum of every component (excluding the transient `lastLoadJson`).
+     */
+    Footprint total() const noexcept;
+
+    nlohmann::json toJson() const;
+};
+
+} // namespace memory
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+
+#ifndef SPLITWISE_ENABLE_METRICS
+#define SPLITWISE_ENABLE_METRICS 1
+#endif
+
+namespace metrics {
+
+constexpr bool kEnabled = SPLITWISE_ENABLE_METRICS != 0;
+
+/**
+ * @brief Manager operations that carry a latency histogram.
+ */
+enum class Operation : std::size_t {
+    AddUser,
+    AddGroup,
+    AddExpense,
+    AddExpenses,
+    UpdateExpense,
+    DeleteExpense,
+    SettleUpGreedy,
+    SaveToJson,
+    LoadFromJson,
+    Count
+};
+
+/**
+ * @brief Stable display name for an operation (used as JSON key).
+ */
+const char *operationName(Operation op) noexcept;
+
+/**
+ * @brief Summary of a latency distribution in nanoseconds.
+ */
+struct HistogramSnapshot {
+    std::uint64_t count{0};
+    double meanNs{0.0};
+    std::uint64_t minNs{0};
+    std::uint64_t p50Ns{0};
+    std::uint64_t p90Ns{0};
+    std::uint64_t p99Ns{0};
+    std::uint64_t p999Ns{0};
+    std::uint64_t maxNs{0};
+
+    nlohmann::json toJson() const;
+};
+
+/**
+ * @brief Point-in-time view of the manager instrumentation.
+ */
+struct ManagerStats {
+    bool enabled{kEnabled};
+    std::map<std::string, HistogramSnapshot> operations;
+    HistogramSnapshot lockWait;
+    HistogramSnapshot lockHold;
+    std::uint64_t expensesApplied{0};
+    std::uint64_t balancesTouched{0};
+
+    nlohmann::json toJson() const;
+};
+
+#if SPLITWISE_ENABLE_METRICS
+
+/**
+ * @brief HDR-style log-linear latency histogram.
+ *
+ * Values below 8ns get exact buckets; above that each power of two is split into 8 linear sub-buckets (<= 12.5%
+ * relative error) up to ~2^40ns. Recording threads are spread over cache-line aligned stripes of relaxed atomics,
+ * so concurrent recorders neither lock nor share counters; snapshots sum the stripes.
+ */
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kSubBucketBits = 3;
+    static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+    static constexpr std::size_t kMaxExponent = 40;
+    static constexpr std::size_t kBucketCount = kSubBuckets + (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+    static constexpr std::size_t kStripes = 8;
+
+    void record(std::uint64_t valueNs) noexcept;
+    HistogramSnapshot snapshot() const;
+
+    static std::size_t bucketIndex(std::uint64_t valueNs) noexcept;
+    static std::uint64_t bucketLowerBound(std::size_t index) noexcept;
+    static std::uint64_t bucketUpperBound(std::size_t index) noexcept;
+
+private:
+    struct alignas(64) Stripe {
+        std::array<std::atomic<std::uint64_t>, kBucketCount> buckets{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> sum{0};
+    };
+
+    std::array<Stripe, kStripes> stripes_{};
+};
+
+/**
+ * @brief Instrumentation owned by a `SplitwiseManager`.
+ */
+class ManagerMetrics {
+public:
+    LatencyHistogram &operation(Operation op) noexcept { return operations_[static_cast<std::size_t>(op)]; }
+    LatencyHistogram &lockWait() noexcept { return lockWait_; }
+    LatencyHistogram &lockHold() noexcept { return lockHold_; }
+
+    void addExpensesApplied(std::uint64_t count) noexcept {
+        expensesApplied_.fetch_add(count, std::memory_order_relaxed);
+    }
+    void addBalancesTouched(std::uint64_t count) noexcept {
+        balancesTouched_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    ManagerStats snapshot() const;
+
+private:
+    std::array<LatencyHistogram, static_cast<std::size_t>(Operation::Count)> operations_{};
+    LatencyHistogram lockWait_{};
+    LatencyHistogram lockHold_{};
+    std::atomic<std::uint64_t> expensesApplied_{0};
+    std::atomic<std::uint64_t> balancesTouched_{0};
+};
+
+/**
+ * @brief Records the lifetime of a scope into an operation histogram.
+ */
+class ScopedTimer {
+public:
+    ScopedTimer(ManagerMetrics &metrics, Operation op) noexcept
+        : histogram_(metrics.operation(op)), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        histogram_.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count()));
+    }
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    LatencyHistogram &histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief `std::lock_guard` replacement that records time spent waiting for and holding the mutex.
+ */
+class TimedLockGuard {
+public:
+    TimedLockGuard(std::mutex &mutex, ManagerMetrics &metrics);
+    ~TimedLockGuard();
+    TimedLockGuard(const TimedLockGuard &) = delete;
+    TimedLockGuard &operator=(const TimedLockGuard &) = delete;
+
+private:
+    std::mutex &mutex_;
+    ManagerMetrics &metrics_;
+    std::chrono::steady_clock::time_point acquired_;
+};
+
+#else
+
+class ManagerMetrics {
+public:
+    void addExpensesApplied(std::uint64_t) noexcept {}
+    void addBalancesTouched(std::uint64_t) noexcept {}
+    ManagerStats snapshot() const { return {}; }
+};
+
+class ScopedTimer {
+public:
+    ScopedTimer(ManagerMetrics &, Operation) noexcept {}
+};
+
+class TimedLockGuard {
+public:
+    TimedLockGuard(std::mutex &mutex, ManagerMetrics &) : lock_(mutex) {}
+
+private:
+    std::lock_guard<std::mutex> lock_;
+};
+
+#endif
+
+} // namespace metrics
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Produce `count` items on `threads` workers and hand them to `consume` strictly in index order.
+ *
+ * `produce(index)` runs concurrently and returns a `Chunk`; `consume(index, chunk)` runs on the calling thread in
+ * ascending index order. At most `threads * 4` produced chunks are buffered, so memory stays bounded however many
+ * chunks there are. The first exception thrown by either side stops the pipeline and is rethrown.
+ */
+template <typename Chunk, typename Produce, typename Consume>
+void runOrderedPipeline(std::size_t count, unsigned threads, Produce produce, Consume consume) {
+    threads = std::max(1u, threads);
+    const std::size_t window = static_cast<std::size_t>(threads) * 4;
+    std::vector<Chunk> slots(window);
+    std::vector<bool> ready(window, false);
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t nextToConsume = 0;
+    std::atomic<std::size_t> nextToProduce{0};
+    std::exception_ptr failure;
+
+    auto worker = [&] {
+        try {
+            while (true) {
+                std::size_t index = nextToProduce.fetch_add(1);
+                if (index >= count) {
+                    return;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return index < nextToConsume + window || failure; });
+                    if (failure) {
+                        return;
+                    }
+                }
+                Chunk chunk = produce(index);
+                std::lock_guard<std::mutex> lock(mutex);
+                slots[index % window] = std::move(chunk);
+                ready[index % window] = true;
+                cv.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            failure = std::current_exception();
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back(worker);
+    }
+    try {
+        for (std::size_t index = 0; index < count; ++index) {
+            Chunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return ready[index % window] || failure; });
+                if (failure) {
+                    break;
+                }
+                chunk = std::move(slots[index % window]);
+                ready[index % window] = false;
+                ++nextToConsume;
+                cv.notify_all();
+            }
+            consume(index, chunk);
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failure) {
+            failure = std::current_exception();
+        }
+        cv.notify_all();
+    }
+    for (auto &thread : workers) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "balance_sheet.hpp"
+#include "expense.hpp"
+#include "group.hpp"
+#include "idempotency_filter.hpp"
+#include "recurring_expense.hpp"
+#include "user.hpp"
+
+/**
+ * @brief Net balances of one group keyed by the currency code its expenses carry (empty = base currency).
+ */
+using GroupBalanceSummary = std::map<std::string, BalanceSheet::BalanceMap>;
+
+/**
+ * @brief One group's entry in a partitioned ledger's manifest.
+ */
+struct GroupManifestEntry {
+    std::string id;
+    std::string name;
+    std::string segment;  ///< File name of the group's segment, relative to the ledger directory.
+    std::size_t expenseCount{0};
+    GroupBalanceSummary balances;
+
+    nlohmann::json toJson() const;
+    static GroupManifestEntry fromJson(const nlohmann::json &j);
+};
+
+/**
+ * @brief Index of a partitioned ledger: ledger-wide settings plus one summary per group segment.
+ *
+ * The manifest is written last, so a directory always describes the segments that were fully written before it.
+ */
+struct LedgerManifest {
+    static constexpr int kVersion = 1;
+
+    std::string baseCurrency;
+    std::map<std::string, std::size_t> counters;
+    std::int64_t latestTimestamp{0};
+    std::vector<GroupManifestEntry> groups;
+    std::map<std::string, std::string> groupParents;  ///< Rollup hierarchy as child group id -> parent group id.
+    // Recurring templates are small and always resident, so they live in the manifest rather than in segments.
+    std::vector<RecurringExpense> recurring;
+    std::int64_t recurringAsOf{std::numeric_limits<std::int64_t>::min()};
+    std::vector<IdempotencyRecord> idempotencyKeys;  ///< Keys within the deduplication window, oldest first.
+    std::uint64_t replicationSequence{0};            ///< Last replicated operation numbered when this was written.
+
+    nlohmann::json toJson() const;
+
+    /**
+     * @throws std::runtime_error for an unsupported version or malformed entries.
+     */
+    static LedgerManifest fromJson(const nlohmann::json &j);
+};
+
+/**
+ * @brief A group's members and expenses, stored in its own file.
+ */
+struct GroupSegment {
+    Group group;
+    std::vector<Expense> expenses;
+
+    nlohmann::json toJson() const;
+
+    /**
+     * @throws std::runtime_error when an expense belongs to another group or names an unknown strategy.
+     */
+    static GroupSegment fromJson(const nlohmann::json &j);
+};
+
+/**
+ * @brief Residency and paging counters of a manager opened with `SplitwiseManager::openPartitioned`.
+ */
+struct PartitionStats {
+    bool open{false};
+    std::string directory;
+    std::size_t groups{0};
+    std::size_t residentGroups{0};
+    std::size_t residentBytes{0};
+    std::size_t budgetBytes{0};
+    std::uint64_t pageIns{0};
+    std::uint64_t evictions{0};
+    std::uint64_t segmentWrites{0};
+
+    nlohmann::json toJson() const;
+};
+
+/**
+ * @brief Directory layout of a partitioned ledger: `manifest.json`, `users.json` and `group-<id>.json` per group.
+ *
+ * Every file is replaced atomically, so a crash leaves each one either old or new.
+ */
+namespace partitioned {
+
+constexpr const char *kManifestFile = "manifest.json";
+constexpr const char *kUsersFile = "users.json";
+
+std::string segmentFileName(const std::string &groupId);
+
+/**
+ * @brief Sum the splits of `expenses` per currency code.
+ */
+GroupBalanceSummary summarize(const std::vector<Expense> &expenses);
+
+/**
+ * @throws std::runtime_error when the file is missing or malformed.
+ */
+LedgerManifest readManifest(const std::string &directory);
+void writeManifest(const std::string &directory, const LedgerManifest &manifest);
+
+std::vector<User> readUsers(const std::string &directory);
+void writeUsers(const std::string &directory, const std::vector<User> &users);
+
+GroupSegment readSegment(const std::string &directory, const std::string &segment);
+void writeSegment(const std::string &directory, const std::string &segment, const GroupSegment &contents);
+
+/**
+ * @brief Copy a segment file unchanged from one ledger directory to another.
+ */
+void copySegment(const std::string &fromDirectory, const std::string &toDirectory, const std::string &segment);
+
+/**
+ * @brief Create `directory` (and its parents) when it does not exist yet.
+ */
+void ensureDirectory(const std::string &directory);
+
+} // namespace partitioned
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Sorted set of 32-bit handles stored as delta-encoded varint blocks.
+ *
+ * Each block keeps its first and last value uncompressed, which doubles as a skip list: `Iterator::seek` binary
+ * searches block bounds and only decodes the block that can contain the target. Appending a value larger than every
+ * stored value (the common case for freshly assigned handles) touches only the last block; inserts and removals in the
+ * middle re-encode a single block.
+ */
+class PostingList {
+public:
+    static constexpr std::size_t kBlockSize = 128;
+
+    /**
+     * @brief Forward cursor over the values in ascending order.
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const PostingList &list);
+
+        bool valid() const noexcept { return valid_; }
+        std::uint32_t value() const noexcept { return value_; }
+
+        void next();
+
+        /**
+         * @brief Advance to the first value `>= target`; never moves backwards.
+         */
+        void seek(std::uint32_t target);
+
+    private:
+        void enterBlock(std::size_t block);
+
+        const PostingList *list_;
+        std::size_t block_{0};
+        std::size_t offset_{0};
+        std::uint32_t value_{0};
+        bool valid_{false};
+    };
+
+    /**
+     * @brief Insert `value`; returns false when it was already present.
+     */
+    bool add(std::uint32_t value);
+
+    /**
+     * @brief Remove `value`; returns false when it was absent.
+     */
+    bool remove(std::uint32_t value);
+
+    void clear() noexcept;
+
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t size() const noexcept { return size_; }
+
+    Iterator begin() const { return Iterator(*this); }
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    struct Block {
+        std::uint32_t first{0};
+        std::uint32_t last{0};
+        std::uint32_t count{0};
+        std::vector<std::uint8_t> gaps;
+    };
+
+    static std::vector<std::uint32_t> decode(const Block &block);
+    static Block encode(const std::uint32_t *values, std::size_t count);
+    static void appendGap(std::vector<std::uint8_t> &bytes, std::uint32_t gap);
+    static std::uint32_t readGap(const std::vector<std::uint8_t> &bytes, std::size_t &offset);
+
+    std::size_t findBlock(std::uint32_t value) const noexcept;
+
+    std::vector<Block> blocks_;
+    std::size_t size_{0};
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <set>
+#include <string>
+#include <nlohmann/json.hpp>
+
+#include "balance_sheet.hpp"
+#include "expense.hpp"
+#include "split_strategy.hpp"
+
+/**
+ * @brief Occurrence times of a recurring expense: every `interval` seconds from `start` up to and including `end`.
+ */
+struct RecurrenceSchedule {
+    std::int64_t start{0};
+    std::int64_t interval{0};
+    std::int64_t end{std::numeric_limits<std::int64_t>::max()};
+
+    /**
+     * @brief Number of occurrences at or before `timestamp`, in O(1).
+     */
+    std::uint64_t countUpTo(std::int64_t timestamp) const noexcept;
+
+    std::int64_t occurrenceTime(std::uint64_t index) const noexcept {
+        return start + static_cast<std::int64_t>(index) * interval;
+    }
+};
+
+/**
+ * @brief A template that stands for every occurrence of a periodic expense (rent, subscriptions, utilities).
+ *
+ * Only the split input, the schedule and the indexes of occurrences that were edited or deleted are stored; the
+ * splits of one occurrence are computed once, so any number of occurrences contributes `count x delta` to balances.
+ * Occurrence `i` is addressed as the expense id `<templateId>#<i>` and exists only when queried, until it is edited
+ * or deleted and becomes a regular expense (or nothing) that the template skips from then on.
+ */
+class RecurringExpense {
+public:
+    RecurringExpense() = default;
+
+    /**
+     * @throws std::invalid_argument for a null strategy, a non-positive interval or input the strategy rejects.
+     */
+    RecurringExpense(std::string id,
+                     std::string groupId,
+                     std::string description,
+                     SplitInput input,
+                     std::shared_ptr<SplitStrategy> strategy,
+                     RecurrenceSchedule schedule);
+
+    const std::string &getId() const noexcept { return id_; }
+    const std::string &getGroupId() const noexcept { return groupId_; }
+    const std::string &getDescription() const noexcept { return description_; }
+    const SplitInput &getInput() const noexcept { return input_; }
+    const std::shared_ptr<SplitStrategy> &getStrategy() const noexcept { return strategy_; }
+    const RecurrenceSchedule &getSchedule() const noexcept { return schedule_; }
+    const std::set<std::uint64_t> &getSkipped() const noexcept { return skipped_; }
+
+    /**
+     * @brief Splits of a single occurrence.
+     */
+    const BalanceSheet::BalanceMap &getDelta() const noexcept { return delta_; }
+
+    /**
+     * @brief Occurrences with `after < time <= upTo` that have not been skipped.
+     */
+    std::uint64_t countBetween(std::int64_t after, std::int64_t upTo) const;
+
+    /**
+     * @brief Whether occurrence `index` is scheduled and has not been skipped.
+     */
+    bool hasOccurrence(std::uint64_t index) const;
+
+    /**
+     * @brief Occurrence `index` as an expense with id `<templateId>#<index>`.
+     */
+    Expense occurrence(std::uint64_t index) const;
+
+    /**
+     * @brief Stop counting occurrence `index`, which has been materialized or deleted.
+     */
+    void skip(std::uint64_t index) { skipped_.insert(index); }
+
+    void setEnd(std::int64_t end) noexcept { schedule_.end = end; }
+
+    nlohmann::json toJson() const;
+    static RecurringExpense fromJson(const nlohmann::json &j, const std::shared_ptr<SplitStrategy> &strategy);
+
+    /**
+     * @brief Estimated heap and inline footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+    static std::string occurrenceId(const std::string &templateId, std::uint64_t index);
+
+    /**
+     * @brief Split `<templateId>#<index>` into its parts; false for any other id.
+     */
+    static bool parseOccurrenceId(const std::string &id, std::string &templateId, std::uint64_t &index);
+
+private:
+    std::string id_;
+    std::string groupId_;
+    std::string description_;
+    SplitInput input_;
+    std::shared_ptr<SplitStrategy> strategy_;
+    RecurrenceSchedule schedule_;
+    std::set<std::uint64_t> skipped_;
+    BalanceSheet::BalanceMap delta_;
+};
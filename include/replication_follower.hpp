@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "daemon_client.hpp"
+#include "splitwise_manager.hpp"
+
+/**
+ * @brief Where a follower finds its leader and how it polls it.
+ */
+struct FollowerOptions {
+    std::string leaderSocket;
+    std::chrono::milliseconds pollInterval{20};  ///< Pause between polls once caught up, and between reconnects.
+    std::size_t batchSize{1000};                 ///< Operations requested per `log-since` call.
+};
+
+/**
+ * @brief Keeps a manager in step with a leader daemon by pulling the leader's operation log.
+ *
+ * Each round asks the leader for the operations after the manager's replication sequence (`log-since`) and applies
+ * them with `applyReplicatedBatch`, repeating until it has caught up. Because the request names the last applied
+ * sequence, a follower that was disconnected, restarted from its own saved ledger or started late catches up from
+ * wherever it stopped. When that point has already been dropped from the leader's log, the follower reloads the
+ * leader's `snapshot` and continues from the sequence it reflects. `start` runs the rounds on a background thread, reconnecting after failures; the lag it
+ * achieves is reported by `SplitwiseManager::getReplicationStatus`.
+ */
+class ReplicationFollower {
+public:
+    ReplicationFollower(SplitwiseManager &manager, FollowerOptions options);
+
+    /**
+     * @brief Stops the background thread.
+     */
+    ~ReplicationFollower();
+
+    ReplicationFollower(const ReplicationFollower &) = delete;
+    ReplicationFollower &operator=(const ReplicationFollower &) = delete;
+
+    void start();
+    void stop();
+
+    /**
+     * @brief Pull and apply operations until caught up with the leader; returns how many were applied.
+     *
+     * Not to be mixed with a running background thread.
+     *
+     * @throws std::runtime_error when the leader cannot be reached or refuses the request, or an operation does not
+     * apply.
+     */
+    std::size_t syncOnce();
+
+    /**
+     * @brief Block until the manager has applied operation `sequence`; false if `timeout` passes first.
+     */
+    bool waitFor(std::uint64_t sequence, std::chrono::milliseconds timeout);
+
+    bool connected() const;
+
+    /**
+     * @brief Message of the most recent failed round; empty after a successful one.
+     */
+    std::string lastError() const;
+
+    /**
+     * @brief Number of times the follower fell behind the leader's retained log and reloaded a snapshot.
+     */
+    std::size_t bootstraps() const;
+
+private:
+    void loop();
+    void bootstrap();
+
+    SplitwiseManager &manager_;
+    FollowerOptions options_;
+    std::unique_ptr<DaemonClient> client_;  // owned by whichever thread syncs
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    bool stopping_{false};
+    bool connected_{false};
+    std::size_t bootstraps_{0};
+    std::string lastError_;
+    std::thread thread_;
+};
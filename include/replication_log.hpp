@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief One operation applied by a leader, numbered in the order it was applied.
+ *
+ * `operation` is a JSON object whose `"op"` names the mutation (`user`, `group`, `member`, `parent`, `expense`,
+ * `update`, `delete`, `base-currency`) and whose other fields carry everything needed to repeat it exactly, including
+ * the ids the leader assigned and resolved timestamps.
+ */
+struct ReplicatedOperation {
+    std::uint64_t sequence{0};
+    std::int64_t time{0};  ///< Leader wall clock in milliseconds when the operation was applied.
+    nlohmann::json operation;
+};
+
+/**
+ * @brief Operations after a requested sequence number, plus the leader's position when they were read.
+ */
+struct ReplicationBatch {
+    std::uint64_t leaderSequence{0};
+    std::int64_t leaderTime{0};  ///< Time of the leader's latest operation.
+    std::vector<ReplicatedOperation> operations;
+
+    /**
+     * @brief Single-line JSON used by the `log-since` script command.
+     */
+    std::string encode() const;
+
+    /**
+     * @throws std::runtime_error when `text` is not an encoded batch.
+     */
+    static ReplicationBatch decode(const std::string &text);
+};
+
+/**
+ * @brief Where a manager stands in replication.
+ *
+ * A leader reports its own sequence; a follower also reports the leader position seen with its last batch and how far
+ * it trails it, in operations and in leader milliseconds (0 once caught up).
+ */
+struct ReplicationStatus {
+    std::string role{"standalone"};  ///< `standalone`, `leader` or `follower`.
+    std::uint64_t sequence{0};
+    std::uint64_t leaderSequence{0};
+    std::uint64_t lagOperations{0};
+    std::int64_t lagMillis{0};
+
+    nlohmann::json toJson() const;
+};
+
+/**
+ * @brief In-memory log of the operations a leader applied after `start`.
+ *
+ * Only the most recent `retain` operations are kept: appending beyond that drops the oldest and advances `start`.
+ * Followers catch up from any sequence number at or after `start`; earlier history must come from a saved ledger or
+ * snapshot, which records the sequence it reflects.
+ */
+class ReplicationLog {
+public:
+    static constexpr std::size_t kDefaultRetention = 100000;
+
+    /**
+     * @brief Marker in the error `after` raises for a sequence that has been dropped.
+     */
+    static constexpr const char *kNotRetained = "no longer retained";
+
+    /**
+     * @throws std::invalid_argument when `retain` is zero.
+     */
+    explicit ReplicationLog(std::uint64_t start = 0, std::size_t retain = kDefaultRetention);
+
+    /**
+     * @brief Append the next operation, dropping the oldest beyond the retention limit, and return its sequence.
+     */
+    std::uint64_t append(nlohmann::json operation, std::int64_t time);
+
+    std::size_t retention() const noexcept { return retain_; }
+
+    std::uint64_t start() const noexcept { return start_; }
+    std::uint64_t latest() const noexcept { return start_ + entries_.size(); }
+    std::int64_t latestTime() const noexcept { return entries_.empty() ? 0 : entries_.back().time; }
+
+    /**
+     * @brief Up to `limit` operations with sequence numbers above `sequence`, in order.
+     *
+     * @throws std::invalid_argument when `sequence` precedes `start()` or is beyond `latest()`.
+     */
+    ReplicationBatch after(std::uint64_t sequence, std::size_t limit) const;
+
+    /**
+     * @brief Estimated heap footprint in bytes.
+     */
+    std::size_t memoryBytes() const noexcept;
+
+private:
+    std::uint64_t start_{0};
+    std::size_t retain_{kDefaultRetention};
+    std::deque<ReplicatedOperation> entries_;
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "splitwise_manager.hpp"
+
+/**
+ * @brief Options for non-interactive command execution.
+ */
+struct ScriptOptions {
+    /**
+     * @brief Number of consecutive `add-expense` commands submitted together through `addExpenses` (1 = unbatched).
+     */
+    std::size_t batchSize{1};
+
+    /**
+     * @brief Stop at the first failing command instead of reporting it and continuing.
+     */
+    bool stopOnError{false};
+
+    /**
+     * @brief Reject every command that would change the ledger, as on a replication follower.
+     */
+    bool readOnly{false};
+};
+
+/**
+ * @brief Totals reported after running a script.
+ */
+struct ScriptSummary {
+    std::size_t commands{0};
+    std::size_t errors{0};
+};
+
+/**
+ * @brief Executes the line-oriented command language used by `splitwise --script`.
+ *
+ * One command per line; blank lines and lines starting with `#` are ignored. Tokens are separated by whitespace and
+ * may be double-quoted to include spaces.
+ *
+ *     add-user NAME                                  -> prints the new user id
+ *     add-user-id ID NAME                            -> adds a user under ID (see `addUserWithId`), prints ID
+ *     add-group NAME MEMBER...                       -> prints the new group id
+ *     add-member GROUP USER [@TIMESTAMP] | remove-member GROUP USER [@TIMESTAMP]
+ *                                                    -> membership change from TIMESTAMP (default now) on,
+ *                                                       prints "epoch N"
+ *     set-parent GROUP [PARENT]                      -> moves GROUP under PARENT for rollups (no PARENT: top
+ *                                                       level), prints "ok"
+ *     add-expense GROUP PAYER AMOUNT STRATEGY DESCRIPTION [@TIMESTAMP] [key=KEY] [PARTICIPANT[=SHARE]...]
+ *                                                    -> prints the new expense id; no participants means the whole
+ *                                                       group as of TIMESTAMP, the payer is always included,
+ *                                                       SHARE is the exact amount or percentage depending on
+ *                                                       STRATEGY, TIMESTAMP defaults to now, AMOUNT may end in
+ *                                                       a currency code (12.50EUR) and defaults to the base
+ *                                                       currency; a KEY (or content key) seen within the
+ *                                                       deduplication window prints the original expense id
+ *     update-expense EXPENSE PAYER AMOUNT STRATEGY DESCRIPTION [PARTICIPANT[=SHARE]...]
+ *                                                    -> replaces the split of an expense, prints "ok"
+ *     delete-expense EXPENSE                         -> removes an expense, prints "ok"
+ *     add-recurring GROUP PAYER AMOUNT STRATEGY DESCRIPTION every=INTERVAL [@START] [until=END] [PARTICIPANT...]
+ *                                                    -> prints the new template id; INTERVAL is seconds or has an
+ *                                                       s/m/h/d/w suffix, START defaults to now; occurrences are
+ *                                                       addressed as TEMPLATE#INDEX by update/delete-expense
+ *     end-recurring TEMPLATE END                     -> last time the template may occur, prints "ok"
+ *     accrue TIMESTAMP                               -> counts occurrences up to TIMESTAMP, prints "ok"
+ *     recurring                                      -> one "TEMPLATE GROUP AMOUNT every SECONDS from START
+ *                                                       accrued N" line per template
+ *     balances                                       -> one "USER BALANCE" line per user
+ *     balance-summary [CURRENCY]                     -> every balance (converted into CURRENCY) as one JSON object
+ *                                                       of full-precision numbers
+ *     top-creditors N [GROUP] | top-debtors N [GROUP]
+ *                                                    -> up to N "USER BALANCE" lines, largest credit (or debt)
+ *                                                       first, globally or within GROUP
+ *     rank USER [GROUP]                              -> position counted from the largest balance, or "none"
+ *     count-balances LOW HIGH [GROUP]                -> number of balances in the inclusive range
+ *     rollup GROUP                                   -> "USER BALANCE" lines for GROUP and every group below it
+ *     children GROUP                                 -> one line per group directly below GROUP
+ *     search QUERY [group=GROUP] [user=USER] [limit=N]
+ *                                                    -> one "EXPENSE SCORE" line per description match, best
+ *                                                       first; quote multi-word queries
+ *     balances-as-of TIMESTAMP                       -> balances counting only expenses up to TIMESTAMP
+ *     expenses-between GROUP|* FROM TO               -> one "EXPENSE TIMESTAMP GROUP AMOUNT" line per expense in
+ *                                                       the inclusive range, oldest first
+ *     user-expenses USER [CURSOR|-] [LIMIT]          -> one expense line per expense the user takes part in,
+ *     group-expenses GROUP [CURSOR|-] [LIMIT]           oldest first, LIMIT (default 100) per page, then
+ *                                                       "next CURSOR" when more remain
+ *     settle [CURRENCY]                              -> one "FROM TO AMOUNT" line per transfer; with CURRENCY,
+ *                                                       all currencies are converted and settled together
+ *     balances-in CURRENCY                           -> every currency converted into CURRENCY, "USER BALANCE"
+ *     base-currency CODE                             -> names the base currency, prints "ok"
+ *     fx-load PATH                                   -> loads an `FxTable` file, prints "loaded N rates"
+ *     save PATH | load PATH                          -> prints "ok"
+ *     save-async PATH                                -> queues a background save, prints "queued"
+ *     wait-saves                                     -> waits for queued saves, prints "ok"
+ *     save-partitioned DIR | open-partitioned DIR    -> per-group ledger directory (`openPartitioned` pages
+ *                                                       groups in lazily), prints "ok"
+ *     memory-budget BYTES                            -> `setMemoryBudget` (0 = no limit), prints "ok"
+ *     partitions                                     -> prints `getPartitionStats()` as JSON
+ *     import-csv PATH [field=Header,...]             -> imports with `CsvImporter`, prints a rows/s summary and
+ *                                                       one `error: PATH:LINE: message` per rejected record
+ *     stats                                          -> prints `getStats()` as JSON
+ *     memory                                         -> prints `memoryUsage()` as JSON
+ *     dedup WINDOW [content]                         -> deduplication window (seconds or s/m/h/d/w suffix), with
+ *                                                       `content` also keying expenses submitted without a
+ *                                                       key, prints "ok"
+ *     dedup-stats                                    -> prints `getDeduplicationStats()` as JSON
+ *     audit [PATH]                                   -> recounts balances (and PATH's saved balances), prints
+ *                                                       one line per problem, then `ok N expenses`; fails
+ *                                                       when any problem is found
+ *     log-since SEQUENCE [LIMIT]                     -> a leader's logged operations after SEQUENCE (at most
+ *                                                       LIMIT, default 1000) as one `ReplicationBatch` JSON line
+ *     snapshot                                       -> the whole ledger as one JSON line (`saveToJsonText`), from
+ *                                                       which a lagging follower bootstraps
+ *     replication                                    -> prints `getReplicationStatus()` as JSON
+ *
+ * TIMESTAMP, FROM and TO are Unix seconds or UTC dates (`YYYY-MM-DD[THH:MM:SS]`).
+ * With `ScriptOptions::readOnly`, only commands that leave the ledger unchanged are accepted (queries, settle, saves,
+ * `stats`, `memory`, `audit`, `partitions`, `log-since`, `snapshot`, `replication`).
+ * Failures are printed as `error: line N: message`. Output is buffered and written in large blocks.
+ */
+class ScriptRunner {
+public:
+    ScriptRunner(SplitwiseManager &manager, std::ostream &out, ScriptOptions options = {});
+    ~ScriptRunner();
+
+    ScriptRunner(const ScriptRunner &) = delete;
+    ScriptRunner &operator=(const ScriptRunner &) = delete;
+
+    /**
+     * @brief Execute every command read from `in` and flush all output.
+     */
+    ScriptSummary run(std::istream &in);
+
+    /**
+     * @brief Execute a single command line; failures are reported in the output like `run` does.
+     *
+     * @return false if the command failed.
+     */
+    bool execute(const std::string &line);
+
+    /**
+     * @brief Submit any pending batched expenses and write buffered output.
+     */
+    void flush();
+
+private:
+    void dispatch(const std::vector<std::string> &tokens);
+    void queueExpense(const std::vector<std::string> &tokens);
+    ExpenseRequest parseExpense(const std::vector<std::string> &tokens, const std::string &groupId) const;
+    void submitPending();
+    void reportError(std::size_t line, const std::string &message);
+    void write(const std::string &text);
+
+    SplitwiseManager &manager_;
+    std::ostream &out_;
+    ScriptOptions options_;
+    std::string buffer_;
+    std::size_t lineNumber_{0};
+    std::size_t errors_{0};
+    std::vector<ExpenseRequest> pending_;
+    std::vector<std::size_t> pendingLines_;
+};
+
+/**
+ * @brief Split a command line into whitespace separated tokens, honouring double quotes and backslash escapes.
+ */
+std::vector<std::string> tokenizeCommand(const std::string &line);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "daemon_client.hpp"
+#include "daemon_protocol.hpp"
+#include "splitwise_manager.hpp"
+
+/**
+ * @brief How `ShardCoordinator` starts its worker processes.
+ *
+ * Worker `k` runs `binary --daemon --socket DIR/shard-k.sock --shard k/N` and loads `DIR/shard-k.json` when that
+ * file exists, so a ledger saved with `save DIR` is picked up again by the next coordinator of the same size.
+ */
+struct ShardSpawnOptions {
+    std::string binary;
+    std::string directory;
+    std::size_t shards{2};
+    unsigned workers{1};  ///< Thread pool size of each worker.
+};
+
+/**
+ * @brief Runs one ledger as N shard daemons on the same host and routes script commands between them.
+ *
+ * Every shard is a `splitwise --daemon` whose manager numbers groups, expenses and recurring templates with
+ * `setIdSequence(k, N)`, so the number in an id names its shard: `(number - 1) % N`. A group and everything recorded
+ * in it live on one shard. Users are replicated: shard 0 assigns the id and the others add the user under it, so any
+ * shard can accept any member.
+ *
+ * A user's balance is the sum of their balances on every shard, because each shard holds the complete expenses of
+ * its groups. `balances` and `settle` collect full-precision `balance-summary` output from all shards (pipelined, so
+ * the shards compute in parallel) and settle the sum with `settleGreedy`, giving the transfers a single ledger would.
+ *
+ * Not thread-safe: one caller drives a coordinator at a time.
+ */
+class ShardCoordinator {
+public:
+    /**
+     * @brief Connect to shard daemons that are already running, listed in shard order.
+     *
+     * @throws std::runtime_error when a shard cannot be reached.
+     */
+    explicit ShardCoordinator(const std::vector<std::string> &socketPaths);
+
+    /**
+     * @brief Start `options.shards` worker processes and connect to them once they listen.
+     *
+     * @throws std::runtime_error when a worker cannot be started or exits before it listens.
+     */
+    explicit ShardCoordinator(const ShardSpawnOptions &options);
+
+    /**
+     * @brief Disconnects, then stops (SIGTERM) and reaps the workers this coordinator started.
+     */
+    ~ShardCoordinator();
+
+    ShardCoordinator(const ShardCoordinator &) = delete;
+    ShardCoordinator &operator=(const ShardCoordinator &) = delete;
+
+    std::size_t shardCount() const noexcept { return shards_.size(); }
+
+    /**
+     * @brief Shard that owns a group, expense, recurring template or occurrence id (`GRP7`, `EXP12`, `REC3#4`).
+     *
+     * @throws std::invalid_argument when the id has no number.
+     */
+    static std::size_t shardOf(const std::string &id, std::size_t shards);
+
+    /**
+     * @brief Run one script command line on the shards it concerns.
+     *
+     * Commands naming a group, expense or template (as their first argument, or as the optional GROUP of the
+     * ranking commands) go to its shard; `add-group` goes to the shards in turn. `add-user` and `add-user-id` are
+     * replicated, `accrue`, `base-currency`, `fx-load` and `dedup` are broadcast, `save DIR` and `load DIR` use one
+     * `shard-k.json` per shard, and `balances`, `balance-summary` and `settle` combine every shard. Other commands
+     * span groups on several shards and are rejected. Idempotency keys are kept by the shard of the expense's group.
+     */
+    protocol::Response execute(const std::string &command);
+
+    /**
+     * @brief Base-currency balances (converted into `currency` when given) summed across shards.
+     *
+     * @throws std::runtime_error when a shard fails.
+     */
+    BalanceSheet::BalanceMap getAllBalances(const std::string &currency = {});
+
+    /**
+     * @brief Greedy settlement of the summed balances.
+     */
+    std::vector<SettlementTransaction> settleUpGreedy(const std::string &currency = {});
+
+private:
+    protocol::Response forward(std::size_t shard, const std::string &command);
+    protocol::Response broadcast(const std::vector<std::string> &commands);
+    protocol::Response replicateUser(const std::vector<std::string> &tokens, bool explicitId);
+    void stopWorkers() noexcept;
+
+    std::vector<DaemonClient> shards_;
+    std::vector<pid_t> workers_;
+    std::size_t nextGroupShard_{0};
+};
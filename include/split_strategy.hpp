@@ -16,6 +16,7 @@ struct SplitInput {
     std::vector<std::string> participantIds;
     std::vector<double> exactShares;
     std::vector<double> percentShares;
+    std::string currency;  ///< Upper-case currency code; empty means the ledger's base currency.
 };
 
 /**
@@ -1,17 +1,38 @@
 #pragma once
 
 #include <functional>
+#include <future>
+#include <iosfwd>
 #include <limits>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "async_saver.hpp"
+#include "balance_history.hpp"
+#include "balance_rank.hpp"
 #include "balance_sheet.hpp"
+#include "description_index.hpp"
 #include "expense.hpp"
+#include "expense_index.hpp"
+#include "expense_time_index.hpp"
+#include "fx_table.hpp"
 #include "group.hpp"
+#include "group_hierarchy.hpp"
+#include "idempotency_filter.hpp"
+#include "ledger_audit.hpp"
+#include "ledger_snapshot.hpp"
+#include "memory_usage.hpp"
+#include "metrics.hpp"
+#include "partitioned_ledger.hpp"
+#include "recurring_expense.hpp"
+#include "replication_log.hpp"
 #include "split_strategy_factory.hpp"
+#include "thread_pool.hpp"
 #include "user.hpp"
 
 /**
@@ -21,6 +42,11 @@ class INotifier {
 public:
     virtual ~INotifier() = default;
     virtual void notifyLargeExpense(const Expense &expense, double threshold) = 0;
+
+    /**
+     * @brief Estimated footprint in bytes; notifiers that hold state should override this.
+     */
+    virtual std::size_t memoryBytes() const noexcept { return sizeof(*this); }
 };
 
 /**
@@ -40,6 +66,44 @@ struct SettlementTransaction {
     double amount{0.0};
 };
 
+/**
+ * @brief Greedy settlement of `balances`: repeatedly match the largest creditor with the largest debtor.
+ *
+ * `pool` (may be null) splits creditors from debtors in parallel; the result does not depend on it.
+ */
+std::vector<SettlementTransaction> settleGreedy(const BalanceSheet::BalanceMap &balances, ThreadPool *pool = nullptr);
+
+/**
+ * @brief A single expense submitted through `SplitwiseManager::addExpense` or `SplitwiseManager::addExpenses`.
+ */
+struct ExpenseRequest {
+    std::string groupId;
+    std::string description;
+    SplitInput input;
+    std::shared_ptr<SplitStrategy> strategy;
+    std::optional<std::int64_t> timestamp;
+    std::string idempotencyKey;  ///< Client key that makes resubmitting the request safe; empty for none.
+};
+
+/**
+ * @brief Outcome of one item in a batch call: the new id on success, otherwise the validation error.
+ */
+struct BatchResult {
+    std::string id;
+    std::string error;
+    bool duplicate{false};  ///< The request repeated an earlier idempotency key; `id` is the expense it created.
+
+    bool ok() const noexcept { return error.empty(); }
+};
+
+/**
+ * @brief A description search result, best first.
+ */
+struct ExpenseSearchHit {
+    std::string expenseId;
+    double score{0.0};
+};
+
 /**
  * @brief Central orchestrator responsible for managing users, groups and expenses.
  */
@@ -47,16 +111,74 @@ class SplitwiseManager {
 public:
     SplitwiseManager();
 
+    /**
+     * @brief Finishes any queued background saves.
+     */
+    ~SplitwiseManager();
+
     /**
      * @brief Add a new user to the system.
      */
     std::string addUser(const std::string &name);
 
+    /**
+     * @brief Add a user under an id chosen by the caller, e.g. one replicated from another shard.
+     *
+     * @throws std::invalid_argument when the id is empty or already taken.
+     */
+    void addUserWithId(const std::string &userId, const std::string &name);
+
+    /**
+     * @brief Number new groups, expenses and recurring templates `shard + 1`, `shard + 1 + shards`, ...
+     *
+     * Managers given distinct `shard` indexes of the same `shards` count never issue the same id, and an id's number
+     * names the shard that issued it (see `ShardCoordinator`). User ids are not affected.
+     *
+     * @throws std::invalid_argument unless `shard < shards`.
+     */
+    void setIdSequence(std::size_t shard, std::size_t shards);
+
     /**
      * @brief Add a new group with the provided members.
      */
     std::string addGroup(const std::string &name, const std::vector<std::string> &memberIds);
 
+    /**
+     * @brief Add a user to a group from `timestamp` (default now) on and return the group's new membership epoch.
+     *
+     * Expenses are validated against the membership in effect at their own timestamp, so a member can take part
+     * only in expenses dated at or after they joined. Changes to one group must be made in time order.
+     *
+     * @throws std::invalid_argument for an unknown group or user, an existing member or an out-of-order change.
+     */
+    Group::Epoch addGroupMember(const std::string &groupId, const std::string &userId);
+    Group::Epoch addGroupMember(const std::string &groupId, const std::string &userId, std::int64_t timestamp);
+
+    /**
+     * @brief Remove a member from `timestamp` (default now) on; expenses dated before then keep them.
+     *
+     * @throws std::invalid_argument when the user is not a member, or takes part in an expense or recurring
+     * occurrence at or after `timestamp`.
+     */
+    Group::Epoch removeGroupMember(const std::string &groupId, const std::string &userId);
+    Group::Epoch removeGroupMember(const std::string &groupId, const std::string &userId, std::int64_t timestamp);
+
+    /**
+     * @brief Place a group under `parentId` for balance rollups, or detach it when `parentId` is empty.
+     *
+     * Moving a group moves its whole subtree; the rollups of its old and new ancestors are adjusted at once.
+     *
+     * @throws std::invalid_argument for an unknown group, or a parent that is the group itself or one of its
+     * descendants.
+     */
+    void setGroupParent(const std::string &groupId, const std::string &parentId);
+
+    /**
+     * @brief Parent of a group in the rollup hierarchy; empty for a top-level group.
+     */
+    std::string getGroupParent(const std::string &groupId) const;
+    std::vector<std::string> getChildGroups(const std::string &groupId) const;
+
     /**
      * @brief Record a new expense and update balances according to the strategy.
      */
@@ -66,40 +188,387 @@ public:
                            const std::shared_ptr<SplitStrategy> &strategy);
 
     /**
-     * @brief Access users.
+     * @brief Record an expense that occurred at `timestamp` (seconds since the Unix epoch).
+     */
+    std::string addExpense(const std::string &groupId,
+                           const std::string &description,
+                           const SplitInput &input,
+                           const std::shared_ptr<SplitStrategy> &strategy,
+                           std::int64_t timestamp);
+
+    /**
+     * @brief Record the expense described by `request`, at most once per idempotency key.
+     *
+     * The key is `request.idempotencyKey`, or with content keys enabled (see `setDeduplication`) a digest of the
+     * request's group, payer, amount, currency, strategy and participant shares. A request whose key was ingested
+     * within the deduplication window is not applied again: the id of the expense the key first created is returned,
+     * even if that expense has since been edited or deleted. Requests without a key are always applied.
+     */
+    std::string addExpense(const ExpenseRequest &request);
+
+    /**
+     * @brief Record several expenses under a single lock acquisition.
+     *
+     * Each request is validated and applied in order exactly as `addExpense` would; a failing request is reported
+     * in its `BatchResult` and does not affect the others. A request repeating a key, including one earlier in the
+     * same batch, is reported with `duplicate` set.
+     */
+    std::vector<BatchResult> addExpenses(const std::vector<ExpenseRequest> &requests);
+
+    /**
+     * @brief Replace the description and split of an existing expense.
+     *
+     * The old split is reversed and the new one applied to the balance sheet, so the cost is proportional to the
+     * participants involved rather than the size of the ledger. The expense keeps its id and group. An occurrence
+     * id of a recurring expense (`REC1#4`) first materializes that occurrence as a regular expense.
+     */
+    void updateExpense(const std::string &expenseId,
+                       const std::string &description,
+                       const SplitInput &input,
+                       const std::shared_ptr<SplitStrategy> &strategy);
+
+    /**
+     * @brief Remove an expense (or one occurrence of a recurring expense) and reverse its effect on balances.
+     */
+    void deleteExpense(const std::string &expenseId);
+
+    /**
+     * @brief Record a template that repeats `input` on `schedule` and return its id (`REC<n>`).
+     *
+     * Occurrences up to the accrual time (see `accrueRecurring`) count towards balances in closed form, one
+     * multiplication per template, and are never stored individually. `getExpensesBetween` and `getExpense` return
+     * them as expenses with ids `<templateId>#<index>`; listings and searches cover stored expenses only.
+     *
+     * @throws std::invalid_argument for the same reasons as `addExpense`, or a non-positive interval.
+     */
+    std::string addRecurringExpense(const std::string &groupId,
+                                    const std::string &description,
+                                    const SplitInput &input,
+                                    const std::shared_ptr<SplitStrategy> &strategy,
+                                    const RecurrenceSchedule &schedule);
+
+    /**
+     * @brief Change the last time a recurring expense may occur, adding or reversing accrued occurrences.
+     *
+     * @throws std::invalid_argument for an unknown template id.
+     */
+    void endRecurringExpense(const std::string &templateId, std::int64_t end);
+
+    /**
+     * @brief Count every recurring occurrence up to `asOf` towards balances.
+     *
+     * The accrual time only moves forward. Mutating calls and loads advance it to the current time automatically.
+     */
+    void accrueRecurring(std::int64_t asOf);
+
+    std::vector<RecurringExpense> getRecurringExpenses() const;
+
+    /**
+     * @brief Occurrences at or before this time are included in balances.
      */
-    const std::map<std::string, User> &getUsers() const noexcept;
+    std::int64_t getRecurringAsOf() const;
 
     /**
-     * @brief Access groups.
+     * @brief Expenses with `from <= timestamp <= to` in time order; an empty group id matches every group.
+     *
+     * Includes the accrued occurrences of recurring expenses in the range.
      */
-    const std::map<std::string, Group> &getGroups() const noexcept;
+    std::vector<Expense> getExpensesBetween(const std::string &groupId, std::int64_t from, std::int64_t to) const;
 
     /**
-     * @brief Access expenses.
+     * @brief Base-currency balances including only expenses with a timestamp `<= timestamp`.
+     *
+     * Starts from the nearest balance checkpoint and replays the few expenses after it.
      */
-    const std::map<std::string, Expense> &getExpenses() const noexcept;
+    BalanceSheet::BalanceMap getBalancesAsOf(std::int64_t timestamp) const;
 
     /**
-     * @brief Retrieve all balances.
+     * @brief Expenses a user paid for or takes part in, oldest first, `limit` per page.
+     *
+     * Pass an empty cursor for the first page and the returned `nextCursor` for the following ones.
      */
-    const BalanceSheet::BalanceMap &getAllBalances() const noexcept;
+    ExpensePage getUserExpenses(const std::string &userId,
+                                const std::string &cursor = {},
+                                std::size_t limit = 100) const;
+
+    /**
+     * @brief Expenses recorded in a group, oldest first, `limit` per page.
+     */
+    ExpensePage getGroupExpenses(const std::string &groupId,
+                                 const std::string &cursor = {},
+                                 std::size_t limit = 100) const;
+
+    /**
+     * @brief Rank expenses whose descriptions match every term of `query`; each term also matches as a prefix.
+     *
+     * Optional group and user ids restrict results to that group's expenses or those the user takes part in.
+     */
+    std::vector<ExpenseSearchHit> searchExpenses(const std::string &query,
+                                                 std::size_t limit = 20,
+                                                 const std::string &groupId = {},
+                                                 const std::string &userId = {}) const;
+
+    /**
+     * @brief Copy of every user, taken under the manager lock.
+     */
+    std::map<std::string, User> getUsers() const;
+
+    /**
+     * @brief Copy of the resident groups, taken under the manager lock (see `getGroup` for a single group).
+     */
+    std::map<std::string, Group> getGroups() const;
+
+    /**
+     * @brief Copy of the resident expenses, taken under the manager lock (see `getExpense` for a single expense).
+     */
+    std::map<std::string, Expense> getExpenses() const;
+
+    /**
+     * @brief Copy of all base-currency balances (see `getBalancesIn` for every currency combined).
+     *
+     * Taken under the manager lock, so it is safe to call while other threads (daemon workers, a replication
+     * follower) change the ledger.
+     */
+    BalanceSheet::BalanceMap getAllBalances() const;
 
     /**
      * @brief Save the current state to a JSON file.
+     *
+     * The lock is held only while a `LedgerSnapshot` is captured; serialisation and the atomic file replacement run
+     * after it is released, so concurrent writers are not stalled by the save.
      */
     void saveToJson(const std::string &path);
 
+    /**
+     * @brief Save on a background thread; the future completes (or rethrows) when the file is in place.
+     *
+     * Requests arriving while an earlier save of the same path is still queued share that save.
+     */
+    std::shared_future<void> saveAsync(const std::string &path);
+
+    /**
+     * @brief Block until every queued background save has finished.
+     */
+    void waitForSaves();
+
     /**
      * @brief Load the state from a JSON file.
      */
     void loadFromJson(const std::string &path);
 
     /**
-     * @brief Compute settlement transactions using a greedy strategy.
+     * @brief The ledger in the `saveToJson` layout as one compact line, including the replication sequence it
+     * reflects; served to followers that must bootstrap (script: `snapshot`).
+     */
+    std::string saveToJsonText() const;
+
+    /**
+     * @brief `loadFromJson` from a document held in memory, such as a leader's `saveToJsonText`.
+     */
+    void loadFromJsonText(const std::string &text);
+
+    /**
+     * @brief Write the ledger as a directory of `users.json`, one segment per group and a manifest.
+     *
+     * Saving back into the directory the manager was opened from rewrites only the segments of groups changed since
+     * they were paged in; saving elsewhere copies the segments of groups that are not resident.
+     *
+     * @throws std::runtime_error when a file cannot be written.
+     */
+    void savePartitioned(const std::string &directory);
+
+    /**
+     * @brief Open a partitioned ledger by reading only its manifest and users.
+     *
+     * Global balances start as the sum of the manifest's per-group summaries. A group's members and expenses are
+     * paged in the first time an operation names the group; operations spanning every group (saves, audits,
+     * `getBalancesAsOf`, unfiltered searches, per-user listings and edits of expenses in groups that are not
+     * resident) page in all of them. `getGroups()` and `getExpenses()` list resident groups only.
+     *
+     * @throws std::runtime_error when the manifest or users file is missing or malformed.
+     */
+    void openPartitioned(const std::string &directory);
+
+    /**
+     * @brief Evict least recently used groups while resident groups are estimated above `bytes` (0 = no limit).
+     *
+     * Only ledgers opened with `openPartitioned` are paged; changed groups are written back to their segment, with
+     * the manifest, before they are dropped. Operations spanning every group may exceed the budget until the next
+     * group is paged in.
+     */
+    void setMemoryBudget(std::size_t bytes);
+
+    PartitionStats getPartitionStats() const;
+
+    /**
+     * @brief Look up one group or expense, paging it in when the ledger is partitioned.
+     *
+     * @throws std::invalid_argument for an unknown id.
+     */
+    Group getGroup(const std::string &groupId) const;
+    Expense getExpense(const std::string &expenseId) const;
+
+    /**
+     * @brief Up to `n` users owed the most in the base currency, largest first; only positive balances are listed.
+     *
+     * With a group id, balances are the net of that group's expenses alone. Rankings are maintained as balances
+     * change, so the cost is O(log users + n) rather than a sort of every balance.
+     *
+     * @throws std::invalid_argument for an unknown group id.
+     */
+    std::vector<RankedBalance> getTopCreditors(std::size_t n, const std::string &groupId = {}) const;
+
+    /**
+     * @brief Up to `n` users owing the most in the base currency, largest debt first; only negative balances are
+     * listed.
+     */
+    std::vector<RankedBalance> getTopDebtors(std::size_t n, const std::string &groupId = {}) const;
+
+    /**
+     * @brief 1-based position of a user's base-currency balance counted from the largest, in O(log users).
+     *
+     * Empty when the user has no balance (globally, or in the group).
+     */
+    std::optional<std::size_t> getBalanceRank(const std::string &userId, const std::string &groupId = {}) const;
+
+    /**
+     * @brief Number of base-currency balances with `low <= balance <= high`, in O(log users).
+     */
+    std::size_t countBalancesBetween(double low, double high, const std::string &groupId = {}) const;
+
+    /**
+     * @brief Base-currency balances of a group and every group below it in the hierarchy.
+     *
+     * Totals are kept per group and updated with each applied delta along the path to the root, so the lookup does
+     * not depend on how many groups or expenses the subtree holds.
+     *
+     * @throws std::invalid_argument for an unknown group id.
+     */
+    BalanceSheet::BalanceMap getRollupBalances(const std::string &groupId) const;
+
+    /**
+     * @brief Compute settlement transactions for base-currency balances using a greedy strategy.
      */
     std::vector<SettlementTransaction> settleUpGreedy() const;
 
+    /**
+     * @brief Settle every currency at once, converting all balances into `currency` (empty = base currency).
+     */
+    std::vector<SettlementTransaction> settleUpGreedy(const std::string &currency) const;
+
+    /**
+     * @brief Name the currency that `getAllBalances()` is kept in; expenses in that code join the base balances.
+     */
+    void setBaseCurrency(const std::string &currency);
+    std::string getBaseCurrency() const;
+
+    /**
+     * @brief Rates used by `getBalancesIn` and `settleUpGreedy(currency)`; see `FxTable::load`.
+     */
+    void setFxTable(std::shared_ptr<const FxTable> table);
+
+    /**
+     * @brief Unconverted balances per currency code; base-currency balances are keyed by `getBaseCurrency()`.
+     */
+    std::map<std::string, BalanceSheet::BalanceMap> getBalancesByCurrency() const;
+
+    /**
+     * @brief Net balance of every user across all currencies, expressed in `currency` (empty = base currency).
+     *
+     * @throws std::invalid_argument when a needed rate is missing or no FX table is set.
+     */
+    BalanceSheet::BalanceMap getBalancesIn(const std::string &currency) const;
+
+    /**
+     * @brief Recompute every balance from the expense records and check it against the live balance sheets.
+     *
+     * Runs on a snapshot: the lock is held only while expenses and balances are copied, so ingestion continues
+     * during the recount. With `ledgerPath`, a saved ledger's `"balances"` are also checked against a recount of that
+     * file's own expenses. Amounts that differ by more than `tolerance` are reported.
+     *
+     * @throws std::runtime_error when `ledgerPath` cannot be read or parsed.
+     */
+    AuditReport audit(const std::string &ledgerPath = {}, double tolerance = 1e-6) const;
+
+    /**
+     * @brief Number of threads used by load validation, balance recomputation, settle-up and JSON serialisation
+     * (0 = hardware concurrency, 1 = run everything on the calling thread).
+     *
+     * The calling thread takes part, so a pool of `threads - 1` workers is started on first use.
+     */
+    void setParallelism(unsigned threads);
+    unsigned getParallelism() const;
+
+    /**
+     * @brief Snapshot operation latency histograms, mutex wait/hold times and ledger counters.
+     *
+     * Returns an empty snapshot with `enabled == false` when built without SPLITWISE_ENABLE_METRICS.
+     */
+    metrics::ManagerStats getStats() const;
+
+    /**
+     * @brief Estimated bytes and object counts per ledger structure, plus process heap counters when built with
+     * SPLITWISE_TRACK_ALLOCATIONS.
+     *
+     * Estimates include tree and hash node headers, bucket arrays, out-of-line strings and allocator rounding. Every
+     * container is walked under the lock, so the cost is linear in the ledger size.
+     */
+    memory::MemoryUsage memoryUsage() const;
+
+    /**
+     * @brief Set the deduplication window and whether expenses submitted without a key get a content key.
+     *
+     * Keys already remembered are kept and judged against the new window. Keys are saved with the ledger, so
+     * resubmissions are recognised across restarts; followers record the keys their leader ingested.
+     *
+     * @throws std::invalid_argument for a non-positive window or zero expected keys.
+     */
+    void setDeduplication(const DeduplicationOptions &options);
+    DeduplicationOptions getDeduplication() const;
+
+    /**
+     * @brief Remembered keys, lookups, duplicates rejected, Bloom filter effectiveness and memory use.
+     */
+    DeduplicationStats getDeduplicationStats() const;
+
+    /**
+     * @brief Make this manager a replication leader: from now on every user, group, membership, expense and
+     * base-currency change is appended to an operation log that followers replay.
+     *
+     * Numbering continues from `getReplicationSequence()`, so a leader restarted from its saved ledger carries on
+     * where it stopped. While logging, changes that are not replicated (recurring templates, loads) are refused.
+     * Only the latest `retain` operations are kept; a follower further behind bootstraps from `saveToJsonText`.
+     *
+     * @throws std::invalid_argument on a follower, or when `retain` is zero.
+     */
+    void enableReplicationLog(std::size_t retain = ReplicationLog::kDefaultRetention);
+
+    /**
+     * @brief Up to `limit` logged operations after `sequence`, with the leader's current position.
+     *
+     * @throws std::invalid_argument when logging is off, or `sequence` precedes the log or is ahead of it.
+     */
+    ReplicationBatch getReplicatedOperations(std::uint64_t sequence, std::size_t limit = 1000) const;
+
+    /**
+     * @brief Follower side: apply the operations of `batch` after `getReplicationSequence()` under one lock and
+     * return how many were applied.
+     *
+     * Operations at or below the current sequence are skipped, so a batch fetched twice is harmless. Each applied
+     * operation advances the sequence, so a failure leaves the replica at the last good operation.
+     *
+     * @throws std::invalid_argument when the batch skips a sequence number or this manager is a leader;
+     * std::runtime_error when an operation cannot be applied (the replica has diverged).
+     */
+    std::size_t applyReplicatedBatch(const ReplicationBatch &batch);
+
+    /**
+     * @brief Sequence number of the last operation logged (leader) or applied (follower); saved with the ledger.
+     */
+    std::uint64_t getReplicationSequence() const;
+
+    ReplicationStatus getReplicationStatus() const;
+
     /**
      * @brief Configure an observer notifier.
      */
@@ -111,16 +580,153 @@ public:
     void setNotificationThreshold(double threshold);
 
 private:
+    /**
+     * @brief Bookkeeping for one group of a partitioned ledger.
+     */
+    struct Partition {
+        std::string name;
+        std::string segment;
+        GroupBalanceSummary stored;  ///< Summary of the segment currently on disk.
+        std::size_t storedExpenses{0};
+        std::size_t bytes{0};  ///< Estimated footprint while resident.
+        bool onDisk{false};
+        bool resident{false};
+        bool dirty{false};
+        std::list<std::string>::iterator recent{};
+    };
+
+    std::string addGroupLocked(const std::string &name, const std::vector<std::string> &memberIds, std::string id = {});
+    Group::Epoch changeMembershipLocked(const std::string &groupId,
+                                        const std::string &userId,
+                                        std::int64_t timestamp,
+                                        bool joined);
+    std::string addExpenseLocked(const std::string &groupId,
+                                 const std::string &description,
+                                 const SplitInput &input,
+                                 const std::shared_ptr<SplitStrategy> &strategy,
+                                 std::int64_t timestamp,
+                                 std::string id = {});
+    /**
+     * @brief `addExpenseLocked` behind the idempotency filter: a repeated key returns the expense it first created
+     * and sets `duplicate` instead. New expenses are logged for replication along with their key.
+     */
+    std::string ingestExpenseLocked(const std::string &groupId,
+                                    const std::string &description,
+                                    const SplitInput &input,
+                                    const std::shared_ptr<SplitStrategy> &strategy,
+                                    std::int64_t timestamp,
+                                    const std::string &clientKey,
+                                    std::int64_t now,
+                                    bool &duplicate);
+    void updateExpenseLocked(const std::string &expenseId,
+                             const std::string &description,
+                             const SplitInput &input,
+                             const std::shared_ptr<SplitStrategy> &strategy);
+    void deleteExpenseLocked(const std::string &expenseId);
+    void logOperationLocked(nlohmann::json operation);
+    void logExpenseLocked(const char *op,
+                          const std::string &expenseId,
+                          const std::string &idempotencyKey = {},
+                          std::int64_t ingested = 0);
+    void applyOperationLocked(const nlohmann::json &operation);
+    void refuseWhileLeaderLocked(const std::string &what) const;
+    void reserveIdLocked(const std::string &prefix, const std::string &id);
+    ExpensePage pageLocked(const PostingList *postings, const std::string &cursor, std::size_t limit) const;
+    BalanceSheet::BalanceMap balancesInLocked(const std::string &currency) const;
+    bool isBaseCurrencyLocked(const std::string &currency) const noexcept;
+    void applyCurrencyDeltaLocked(const std::string &groupId,
+                                  const std::string &currency,
+                                  std::int64_t timestamp,
+                                  const BalanceSheet::BalanceMap &delta);
+    const BalanceRank &balanceRankLocked(const std::string &groupId) const;
+    void requireGroupLocked(const std::string &groupId) const;
+    void setGroupParentLocked(const std::string &groupId, const std::string &parentId);
+    static void validateCurrency(const std::string &currency);
+    std::shared_ptr<ThreadPool> threadPool() const;
+    LedgerSnapshot captureSnapshot() const;
+    void loadLocked(std::istream &in);
+    Group &groupLocked(const std::string &groupId);
+    void validateExpenseLocked(const std::string &groupId, const SplitInput &input, std::int64_t timestamp) const;
     std::string generateId(const std::string &prefix);
     void recomputeBalances();
+    void accrueRecurringLocked(std::int64_t asOf);
+    void applyRecurringLocked(const RecurringExpense &recurring, std::int64_t after, std::int64_t upTo, double sign);
+    bool materializeOccurrenceLocked(const std::string &expenseId);
+    std::int64_t historyBoundaryLocked() const noexcept;
+    /**
+     * @brief Rebuild the balance checkpoints alone from the resident expenses and recurring templates.
+     *
+     * Used when `historyStale_` is set: an opened partitioned ledger takes its live balances from the manifest and
+     * only builds checkpoints once a query needs them.
+     */
+    void rebuildHistoryLocked() const;
+    void rebuildIndexesLocked() const;
+    void validateLoadedExpenseLocked(const Expense &expense, const Group &group) const;
+    void resetPartitionsLocked();
+    void ensureResidentLocked(const std::string &groupId) const;
+    void ensureAllResidentLocked() const;
+    void pageInLocked(const std::string &groupId, bool enforceBudget) const;
+    void evictLocked(const std::string &groupId) const;
+    void enforceBudgetLocked(const std::string &pinned) const;
+    void writeBackLocked(const std::string &groupId) const;
+    void syncManifestLocked() const;
+    void notePartitionChangeLocked(const std::string &groupId, std::ptrdiff_t bytes);
+    LedgerManifest manifestHeaderLocked() const;
+    GroupSegment segmentLocked(const std::string &groupId) const;
 
     mutable std::mutex mutex_{};
     std::map<std::string, User> users_{};
-    std::map<std::string, Group> groups_{};
-    std::map<std::string, Expense> expenses_{};
+    // Resident groups and expenses, and the indexes over them. On a partitioned ledger const queries page groups in
+    // and out under mutex_, which changes what is held in memory but not the ledger, so these and the paging
+    // bookkeeping below are mutable. Everything else stays const-checked.
+    mutable std::map<std::string, Group> groups_{};
+    mutable std::map<std::string, Expense> expenses_{};
+    mutable ExpenseTimeIndex timeIndex_{};
+    mutable ExpenseIndex expenseIndex_{};
+    mutable DescriptionIndex descriptionIndex_{};
     BalanceSheet balanceSheet_{};
+    BalanceRankIndex balanceRanks_{};  // mirrors balanceSheet_, plus base-currency balances per group
+    GroupHierarchy groupHierarchy_{};  // subtree totals, fed the same per-group deltas as balanceRanks_
+    std::map<std::string, BalanceSheet> currencyBalances_{};
+    IdempotencyFilter idempotency_{};  // keys of recently ingested expenses, in ingestion (wall-clock) time
+    std::string baseCurrency_{};
+    std::shared_ptr<const FxTable> fxTable_{};
+    // Checkpoints are derived from the expenses; while historyStale_ is set they are rebuilt on first use, which
+    // const queries may do under mutex_.
+    mutable BalanceHistory balanceHistory_{};
+    std::int64_t latestTimestamp_{std::numeric_limits<std::int64_t>::min()};
     std::shared_ptr<INotifier> notifier_{};
     double notificationThreshold_{std::numeric_limits<double>::infinity()};
     std::map<std::string, std::size_t> counters_{};
+    std::size_t idShard_{0};
+    std::size_t idShards_{1};
+    // Replication: replicationLog_ is set on leaders only; the leader position is what a follower last saw.
+    std::unique_ptr<ReplicationLog> replicationLog_{};
+    std::uint64_t replicationSequence_{0};
+    std::int64_t replicationTime_{0};  // leader time of the last logged or applied operation
+    bool following_{false};
+    std::uint64_t leaderSequence_{0};
+    std::int64_t leaderTime_{0};
+    memory::Footprint lastLoadJson_{};
+    std::map<std::string, RecurringExpense> recurring_{};
+    std::int64_t recurringAsOf_{std::numeric_limits<std::int64_t>::min()};
+    // Partitioned ledgers only: partitionDir_ is empty for a ledger held entirely in memory.
+    std::string partitionDir_{};
+    mutable std::map<std::string, Partition> partitions_{};
+    mutable std::list<std::string> recentGroups_{};  // most recently used first
+    mutable std::size_t residentBytes_{0};
+    std::size_t memoryBudget_{0};
+    mutable bool usersDirty_{false};
+    mutable bool historyStale_{false};
+    mutable std::uint64_t pageIns_{0};
+    mutable std::uint64_t evictions_{0};
+    mutable std::uint64_t segmentWrites_{0};
+    mutable metrics::ManagerMetrics metrics_{};
+    // Guarded by poolMutex_ rather than mutex_, so a save can fetch the pool after releasing the ledger lock.
+    mutable std::mutex poolMutex_{};
+    unsigned parallelism_{0};
+    mutable std::shared_ptr<ThreadPool> pool_{};
+    // Declared last so it is destroyed first: queued saves still read the members above.
+    AsyncSaver saver_;
 };
 
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "thread_pool.hpp"
+
+/**
+ * @brief Serialising executor layered over a `ThreadPool`.
+ *
+ * Tasks posted to one strand run one at a time in posting order, on whichever pool worker picks up the strand; tasks
+ * of different strands run concurrently. A strand occupies at most one worker, so a busy strand cannot starve the
+ * others. Create strands with `std::make_shared`: queued work keeps the strand alive until it has run.
+ */
+class Strand : public std::enable_shared_from_this<Strand> {
+public:
+    explicit Strand(ThreadPool &pool) : pool_(pool) {}
+
+    Strand(const Strand &) = delete;
+    Strand &operator=(const Strand &) = delete;
+
+    void post(ThreadPool::Task task);
+
+    /**
+     * @brief Tasks queued but not yet started.
+     */
+    std::size_t pending() const;
+
+private:
+    void drain();
+
+    ThreadPool &pool_;
+    mutable std::mutex mutex_;
+    std::deque<ThreadPool::Task> queue_;
+    bool scheduled_{false};
+};
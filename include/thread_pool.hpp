@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Work-stealing pool of worker threads.
+ *
+ * Every worker owns a deque. Tasks submitted from inside a worker go to the back of its own deque and are taken back
+ * LIFO, which keeps recursive work cache-warm; tasks submitted from outside enter a shared FIFO injection queue. An
+ * idle worker drains its own deque, then the injection queue, then steals from the front of its peers' deques.
+ *
+ * Tasks must not throw; anything escaping a task terminates the process, as with a detached `std::thread`. Use
+ * `parallelFor` / `parallelReduce` for data-parallel loops: they propagate exceptions to the caller.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Start `threads` workers (0 = hardware concurrency).
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    /**
+     * @brief Runs every queued task, then joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(Task task);
+
+    unsigned size() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * @brief Run `chunk(0) .. chunk(count - 1)` across the pool, with the calling thread taking chunks too; returns
+     * once every chunk has finished and rethrows the first exception a chunk threw.
+     *
+     * The caller works through chunks itself rather than blocking, so this may be nested inside pool tasks.
+     */
+    void forEachChunk(std::size_t count, const std::function<void(std::size_t)> &chunk);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool takeTask(unsigned index, Task &task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::mutex injectMutex_;
+    std::deque<Task> injected_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<std::size_t> queued_{0};
+    bool stopping_{false};
+    std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief Call `body(begin, end)` for consecutive ranges of at most `grain` items covering `[0, count)`.
+ *
+ * Ranges run concurrently on `pool`, or one after another on the calling thread when `pool` is null.
+ */
+template <typename Body>
+void parallelFor(ThreadPool *pool, std::size_t count, std::size_t grain, Body &&body) {
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = (count + grain - 1) / grain;
+    auto runChunk = [&](std::size_t chunk) { body(chunk * grain, std::min(count, (chunk + 1) * grain)); };
+    if (pool == nullptr || chunks <= 1) {
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            runChunk(chunk);
+        }
+        return;
+    }
+    pool->forEachChunk(chunks, runChunk);
+}
+
+/**
+ * @brief Fold `[0, count)` with `map(begin, end) -> T` per range and `combine(T, T) -> T` across ranges.
+ *
+ * Partial results are combined left to right in range order, and ranges depend only on `grain`, so floating-point
+ * reductions give the same answer whatever the pool size.
+ */
+template <typename T, typename Map, typename Combine>
+T parallelReduce(ThreadPool *pool, std::size_t count, std::size_t grain, T identity, Map &&map, Combine &&combine) {
+    grain = std::max<std::size_t>(grain, 1);
+    std::vector<T> partials((count + grain - 1) / grain, identity);
+    parallelFor(pool, count, grain, [&](std::size_t begin, std::size_t end) { partials[begin / grain] = map(begin, end); });
+    T result = std::move(identity);
+    for (auto &partial : partials) {
+        result = combine(std::move(result), std::move(partial));
+    }
+    return result;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Scoped span tracing exported in the Chrome trace event format (Perfetto / about:tracing).
+ *
+ * Tracing is off by default. It is switched on with `tracing::start(path)` or by setting the `SPLITWISE_TRACE`
+ * environment variable to an output path before the process starts. While off, a `Span` costs one relaxed atomic load.
+ */
+namespace tracing {
+
+namespace detail {
+extern std::atomic<bool> gEnabled;
+void recordSpan(const char *name, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end, std::uint32_t depth);
+std::uint32_t &threadDepth() noexcept;
+}
+
+/**
+ * @brief Begin collecting spans; they are written to `path` by `flush()`, `stop()` or at process exit.
+ */
+void start(const std::string &path);
+
+/**
+ * @brief Stop collecting spans and write everything recorded so far.
+ */
+void stop();
+
+/**
+ * @brief Write all recorded spans to the configured output path (the file is rewritten each time).
+ */
+void flush();
+
+/**
+ * @brief Discard recorded spans without writing them.
+ */
+void clear();
+
+inline bool enabled() noexcept { return detail::gEnabled.load(std::memory_order_relaxed); }
+
+/**
+ * @brief RAII span; `name` must outlive the trace (use string literals).
+ */
+class Span {
+public:
+    explicit Span(const char *name) noexcept : name_(name), active_(enabled()) {
+        if (active_) {
+            depth_ = detail::threadDepth()++;
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~Span() {
+        if (active_) {
+            detail::recordSpan(name_, start_, std::chrono::steady_clock::now(), depth_);
+            --detail::threadDepth();
+        }
+    }
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+private:
+    const char *name_;
+    bool active_;
+    std::uint32_t depth_{0};
+    std::chrono::steady_clock::time_point start_{};
+};
+
+} // namespace tracing
@@ -0,0 +1,156 @@
+#include "async_manager.hpp"
+
+#include <atomic>
+#include <utility>
+
+AsyncSplitwiseManager::AsyncSplitwiseManager(SplitwiseManager &manager, unsigned threads)
+    : manager_(manager), ownedPool_(std::make_unique<ThreadPool>(threads)), pool_(*ownedPool_) {}
+
+AsyncSplitwiseManager::AsyncSplitwiseManager(SplitwiseManager &manager, ThreadPool &pool)
+    : manager_(manager), pool_(pool) {}
+
+AsyncSplitwiseManager::~AsyncSplitwiseManager() {
+    waitIdle();
+}
+
+std::future<std::string> AsyncSplitwiseManager::addExpenseAsync(ExpenseRequest request) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> result = promise->get_future();
+    addExpenseAsync(std::move(request), [promise](const std::string &expenseId, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(expenseId);
+        }
+    });
+    return result;
+}
+
+void AsyncSplitwiseManager::addExpenseAsync(ExpenseRequest request, ExpenseCallback done) {
+    begin();
+    std::shared_ptr<Strand> strand = strandFor(request.groupId);
+    strand->post([this, request = std::move(request), done = std::move(done)] {
+        std::string expenseId;
+        std::exception_ptr error;
+        try {
+            expenseId = manager_.addExpense(request);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done(expenseId, error);
+        finish();
+    });
+}
+
+std::future<std::vector<SettlementTransaction>> AsyncSplitwiseManager::settleUpAsync(std::string currency) {
+    auto promise = std::make_shared<std::promise<std::vector<SettlementTransaction>>>();
+    auto result = promise->get_future();
+    settleUpAsync(std::move(currency), [promise](std::vector<SettlementTransaction> transactions, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(transactions));
+        }
+    });
+    return result;
+}
+
+void AsyncSplitwiseManager::settleUpAsync(std::string currency, SettleCallback done) {
+    begin();
+    afterQueued([this, currency = std::move(currency), done = std::move(done)] {
+        std::vector<SettlementTransaction> transactions;
+        std::exception_ptr error;
+        try {
+            transactions = manager_.settleUpGreedy(currency);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done(std::move(transactions), error);
+        finish();
+    });
+}
+
+std::future<void> AsyncSplitwiseManager::saveAsync(std::string path) {
+    auto promise = std::make_shared<std::promise<void>>();
+    std::future<void> result = promise->get_future();
+    saveAsync(std::move(path), [promise](std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value();
+        }
+    });
+    return result;
+}
+
+void AsyncSplitwiseManager::saveAsync(std::string path, SaveCallback done) {
+    begin();
+    afterQueued([this, path = std::move(path), done = std::move(done)] {
+        std::exception_ptr error;
+        try {
+            // saveToJson holds the manager lock only while snapshotting, so group strands keep running meanwhile.
+            manager_.saveToJson(path);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done(error);
+        finish();
+    });
+}
+
+void AsyncSplitwiseManager::waitIdle() {
+    std::unique_lock<std::mutex> lock(idleMutex_);
+    idle_.wait(lock, [this] { return inFlight_ == 0; });
+}
+
+std::size_t AsyncSplitwiseManager::strandCount() const {
+    std::lock_guard<std::mutex> lock(strandsMutex_);
+    return strands_.size();
+}
+
+std::shared_ptr<Strand> AsyncSplitwiseManager::strandFor(const std::string &groupId) {
+    std::lock_guard<std::mutex> lock(strandsMutex_);
+    auto &strand = strands_[groupId];
+    if (!strand) {
+        strand = std::make_shared<Strand>(pool_);
+    }
+    return strand;
+}
+
+void AsyncSplitwiseManager::afterQueued(ThreadPool::Task task) {
+    std::vector<std::shared_ptr<Strand>> strands;
+    {
+        std::lock_guard<std::mutex> lock(strandsMutex_);
+        strands.reserve(strands_.size());
+        for (const auto &[groupId, strand] : strands_) {
+            strands.push_back(strand);
+        }
+    }
+    if (strands.empty()) {
+        pool_.submit(std::move(task));
+        return;
+    }
+    // A marker on every strand; the last one to be reached releases the task onto the pool. Strands continue with
+    // their later work immediately instead of waiting for the task to run.
+    auto remaining = std::make_shared<std::atomic<std::size_t>>(strands.size());
+    auto shared = std::make_shared<ThreadPool::Task>(std::move(task));
+    for (const auto &strand : strands) {
+        strand->post([this, remaining, shared] {
+            if (remaining->fetch_sub(1) == 1) {
+                pool_.submit(std::move(*shared));
+            }
+        });
+    }
+}
+
+void AsyncSplitwiseManager::begin() {
+    std::lock_guard<std::mutex> lock(idleMutex_);
+    ++inFlight_;
+}
+
+void AsyncSplitwiseManager::finish() {
+    std::lock_guard<std::mutex> lock(idleMutex_);
+    if (--inFlight_ == 0) {
+        idle_.notify_all();
+    }
+}
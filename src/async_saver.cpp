@@ -0,0 +1,73 @@
+#include "async_saver.hpp"
+
+#include <exception>
+#include <utility>
+
+#include "tracing.hpp"
+
+AsyncSaver::AsyncSaver(SaveFunction save) : save_(std::move(save)) {}
+
+AsyncSaver::~AsyncSaver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+std::shared_future<void> AsyncSaver::request(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_.find(path);
+    if (it != pending_.end()) {
+        ++coalesced_;
+        return it->second.future;
+    }
+    Pending pending;
+    pending.future = pending.promise.get_future().share();
+    auto future = pending.future;
+    pending_.emplace(path, std::move(pending));
+    // Started on first use so managers that never save asynchronously do not own an idle thread.
+    if (!worker_.joinable()) {
+        worker_ = std::thread([this] { run(); });
+    }
+    cv_.notify_all();
+    return future;
+}
+
+void AsyncSaver::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return pending_.empty() && !busy_; });
+}
+
+std::size_t AsyncSaver::coalescedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return coalesced_;
+}
+
+void AsyncSaver::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return !pending_.empty() || stopping_; });
+        if (pending_.empty()) {
+            return;
+        }
+        auto node = pending_.extract(pending_.begin());
+        busy_ = true;
+        lock.unlock();
+        {
+            tracing::Span span("asyncSave");
+            try {
+                save_(node.key());
+                node.mapped().promise.set_value();
+            } catch (...) {
+                node.mapped().promise.set_exception(std::current_exception());
+            }
+        }
+        lock.lock();
+        busy_ = false;
+        cv_.notify_all();
+    }
+}
@@ -0,0 +1,57 @@
+#include "balance_history.hpp"
+
+#include <algorithm>
+
+#include "memory_usage.hpp"
+
+BalanceHistory::BalanceHistory(std::size_t minInterval) : minInterval_(std::max<std::size_t>(1, minInterval)) {}
+
+void BalanceHistory::clear() {
+    checkpoints_.clear();
+    sinceLast_ = 0;
+}
+
+void BalanceHistory::record(std::int64_t timestamp,
+                            const BalanceSheet::BalanceMap &delta,
+                            const BalanceSheet &live,
+                            std::int64_t latestTimestamp) {
+    revise(timestamp, delta);
+    if (++sinceLast_ < std::max(minInterval_, live.getBalances().size())) {
+        return;
+    }
+    sinceLast_ = 0;
+    if (!checkpoints_.empty() && checkpoints_.back().boundary == latestTimestamp) {
+        checkpoints_.back().balances = live;
+    } else {
+        checkpoints_.push_back({latestTimestamp, live});
+    }
+}
+
+void BalanceHistory::revise(std::int64_t timestamp, const BalanceSheet::BalanceMap &delta) {
+    for (auto it = firstAtOrAfter(timestamp); it != checkpoints_.end(); ++it) {
+        it->balances.applyDelta(delta);
+    }
+}
+
+std::vector<BalanceHistory::Checkpoint>::iterator BalanceHistory::firstAtOrAfter(std::int64_t timestamp) {
+    return std::lower_bound(checkpoints_.begin(), checkpoints_.end(), timestamp,
+                            [](const Checkpoint &checkpoint, std::int64_t value) {
+                                return checkpoint.boundary < value;
+                            });
+}
+
+const BalanceHistory::Checkpoint *BalanceHistory::latestAtOrBefore(std::int64_t timestamp) const {
+    auto it = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), timestamp,
+                               [](std::int64_t value, const Checkpoint &checkpoint) {
+                                   return value < checkpoint.boundary;
+                               });
+    return it == checkpoints_.begin() ? nullptr : &*std::prev(it);
+}
+
+std::size_t BalanceHistory::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this) + memory::vectorBytes(checkpoints_);
+    for (const auto &checkpoint : checkpoints_) {
+        bytes += checkpoint.balances.memoryBytes() - sizeof(BalanceSheet);
+    }
+    return bytes;
+}
@@ -0,0 +1,225 @@
+#include "balance_rank.hpp"
+
+#include <cmath>
+
+#include "memory_usage.hpp"
+
+namespace {
+// In-order walk that stops after `n` nodes: O(depth + n). Descending walks visit right subtrees first.
+template <typename Nodes>
+std::vector<RankedBalance> walk(const Nodes &nodes, std::uint32_t root, std::uint32_t nil, std::size_t n,
+                                bool descending) {
+    std::vector<RankedBalance> result;
+    std::vector<std::uint32_t> stack;
+    std::uint32_t node = root;
+    while ((node != nil || !stack.empty()) && result.size() < n) {
+        while (node != nil) {
+            stack.push_back(node);
+            node = descending ? nodes[node].right : nodes[node].left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        result.push_back({nodes[node].userId, nodes[node].balance});
+        node = descending ? nodes[node].left : nodes[node].right;
+    }
+    return result;
+}
+}
+
+void BalanceRank::applyDelta(const BalanceSheet::BalanceMap &delta) {
+    for (const auto &[userId, change] : delta) {
+        auto [it, inserted] = balances_.try_emplace(userId, 0.0);
+        if (!inserted) {
+            root_ = erase(root_, it->second, userId);
+        }
+        // Same arithmetic as BalanceSheet::applyDelta so both hold bit-identical balances.
+        it->second += change;
+        if (std::abs(it->second) < 1e-9) {
+            it->second = 0.0;
+        }
+        insert(it->second, userId);
+    }
+}
+
+void BalanceRank::clear() {
+    nodes_.clear();
+    free_.clear();
+    balances_.clear();
+    root_ = kNil;
+}
+
+std::vector<RankedBalance> BalanceRank::top(std::size_t n) const { return walk(nodes_, root_, kNil, n, true); }
+
+std::vector<RankedBalance> BalanceRank::bottom(std::size_t n) const { return walk(nodes_, root_, kNil, n, false); }
+
+std::optional<std::size_t> BalanceRank::rank(const std::string &userId) const {
+    auto it = balances_.find(userId);
+    if (it == balances_.end()) {
+        return std::nullopt;
+    }
+    std::size_t below = 0;
+    std::uint32_t node = root_;
+    while (node != kNil) {
+        if (less(nodes_[node], it->second, userId)) {
+            below += sizeOf(nodes_[node].left) + 1;
+            node = nodes_[node].right;
+        } else {
+            node = nodes_[node].left;
+        }
+    }
+    return balances_.size() - below;
+}
+
+std::size_t BalanceRank::countBetween(double low, double high) const {
+    if (low > high) {
+        return 0;
+    }
+    return countBelow(high, true) - countBelow(low, false);
+}
+
+std::size_t BalanceRank::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this) + memory::vectorBytes(nodes_) + memory::vectorBytes(free_) +
+                        memory::bucketBytes(balances_);
+    for (const auto &node : nodes_) {
+        bytes += memory::stringBytes(node.userId);
+    }
+    for (const auto &[userId, balance] : balances_) {
+        bytes += memory::hashNodeBytes<std::pair<const std::string, double>>() + memory::stringBytes(userId);
+    }
+    return bytes;
+}
+
+void BalanceRank::update(std::uint32_t node) noexcept {
+    nodes_[node].size = sizeOf(nodes_[node].left) + sizeOf(nodes_[node].right) + 1;
+}
+
+bool BalanceRank::less(const Node &node, double balance, const std::string &userId) const noexcept {
+    return node.balance < balance || (node.balance == balance && node.userId < userId);
+}
+
+void BalanceRank::split(std::uint32_t node,
+                        double balance,
+                        const std::string &userId,
+                        std::uint32_t &left,
+                        std::uint32_t &right) {
+    if (node == kNil) {
+        left = right = kNil;
+        return;
+    }
+    if (less(nodes_[node], balance, userId)) {
+        split(nodes_[node].right, balance, userId, nodes_[node].right, right);
+        left = node;
+    } else {
+        split(nodes_[node].left, balance, userId, left, nodes_[node].left);
+        right = node;
+    }
+    update(node);
+}
+
+std::uint32_t BalanceRank::merge(std::uint32_t left, std::uint32_t right) {
+    if (left == kNil || right == kNil) {
+        return left == kNil ? right : left;
+    }
+    if (nodes_[left].priority > nodes_[right].priority) {
+        nodes_[left].right = merge(nodes_[left].right, right);
+        update(left);
+        return left;
+    }
+    nodes_[right].left = merge(left, nodes_[right].left);
+    update(right);
+    return right;
+}
+
+void BalanceRank::insert(double balance, const std::string &userId) {
+    const std::uint32_t node = allocate(balance, userId);
+    std::uint32_t left = kNil;
+    std::uint32_t right = kNil;
+    split(root_, balance, userId, left, right);
+    root_ = merge(merge(left, node), right);
+}
+
+std::uint32_t BalanceRank::erase(std::uint32_t node, double balance, const std::string &userId) {
+    if (node == kNil) {
+        return kNil;
+    }
+    Node &current = nodes_[node];
+    if (current.balance == balance && current.userId == userId) {
+        const std::uint32_t merged = merge(current.left, current.right);
+        free_.push_back(node);
+        return merged;
+    }
+    if (less(current, balance, userId)) {
+        current.right = erase(current.right, balance, userId);
+    } else {
+        current.left = erase(current.left, balance, userId);
+    }
+    update(node);
+    return node;
+}
+
+std::uint32_t BalanceRank::allocate(double balance, const std::string &userId) {
+    // xorshift64: random priorities keep the expected depth logarithmic whatever the insertion order.
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 7;
+    seed_ ^= seed_ << 17;
+    std::uint32_t node;
+    if (free_.empty()) {
+        node = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    } else {
+        node = free_.back();
+        free_.pop_back();
+    }
+    Node &slot = nodes_[node];
+    slot.balance = balance;
+    slot.userId = userId;
+    slot.priority = static_cast<std::uint32_t>(seed_ >> 32);
+    slot.left = slot.right = kNil;
+    slot.size = 1;
+    return node;
+}
+
+std::size_t BalanceRank::countBelow(double balance, bool inclusive) const {
+    std::size_t count = 0;
+    std::uint32_t node = root_;
+    while (node != kNil) {
+        const double value = nodes_[node].balance;
+        if (value < balance || (inclusive && value == balance)) {
+            count += sizeOf(nodes_[node].left) + 1;
+            node = nodes_[node].right;
+        } else {
+            node = nodes_[node].left;
+        }
+    }
+    return count;
+}
+
+void BalanceRankIndex::apply(const std::string &groupId, const BalanceSheet::BalanceMap &delta) {
+    if (delta.empty()) {
+        return;
+    }
+    global_.applyDelta(delta);
+    byGroup_[groupId].applyDelta(delta);
+}
+
+void BalanceRankIndex::clear() {
+    global_.clear();
+    byGroup_.clear();
+}
+
+const BalanceRank *BalanceRankIndex::find(const std::string &groupId) const {
+    if (groupId.empty()) {
+        return &global_;
+    }
+    auto it = byGroup_.find(groupId);
+    return it == byGroup_.end() ? nullptr : &it->second;
+}
+
+std::size_t BalanceRankIndex::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this) + global_.memoryBytes() - sizeof(BalanceRank);
+    for (const auto &[groupId, rank] : byGroup_) {
+        bytes += memory::treeNodeBytes<decltype(byGroup_)::value_type>() + memory::stringBytes(groupId) +
+                 rank.memoryBytes() - sizeof(BalanceRank);
+    }
+    return bytes;
+}
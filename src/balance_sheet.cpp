@@ -2,6 +2,8 @@
 
 #include <cmath>
 
+#include "memory_usage.hpp"
+
 void BalanceSheet::applyDelta(const BalanceMap &delta) {
     for (const auto &[userId, change] : delta) {
         balances_[userId] += change;
@@ -15,6 +17,14 @@ void BalanceSheet::clear() { balances_.clear(); }
 
 const BalanceSheet::BalanceMap &BalanceSheet::getBalances() const noexcept { return balances_; }
 
+std::size_t BalanceSheet::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this);
+    for (const auto &[userId, balance] : balances_) {
+        bytes += memory::treeNodeBytes<BalanceMap::value_type>() + memory::stringBytes(userId);
+    }
+    return bytes;
+}
+
 nlohmann::json BalanceSheet::toJson() const {
     nlohmann::json j;
     for (const auto &[userId, balance] : balances_) {
@@ -0,0 +1,416 @@
+#include "csv_importer.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ordered_pipeline.hpp"
+#include "split_strategy_factory.hpp"
+#include "tracing.hpp"
+
+namespace {
+/**
+ * @brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open file for reading: " + path);
+        }
+        struct stat info {};
+        if (::fstat(fd_, &info) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to stat file: " + path);
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ > 0) {
+            void *address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (address == MAP_FAILED) {
+                ::close(fd_);
+                throw std::runtime_error("Failed to memory-map file: " + path);
+            }
+            ::madvise(address, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(address);
+        }
+    }
+
+    ~MappedFile() {
+        if (data_) {
+            ::munmap(const_cast<char *>(data_), size_);
+        }
+        ::close(fd_);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::string_view view() const noexcept { return {data_, size_}; }
+
+private:
+    int fd_{-1};
+    const char *data_{nullptr};
+    std::size_t size_{0};
+};
+
+/**
+ * @brief Split one record into fields, unescaping quoted fields.
+ */
+void splitRecord(std::string_view record, char delimiter, std::vector<std::string> &fields) {
+    fields.clear();
+    std::string current;
+    bool quoted = false;
+    for (std::size_t i = 0; i < record.size(); ++i) {
+        char c = record[i];
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < record.size() && record[i + 1] == '"') {
+                    current.push_back('"');
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                current.push_back(c);
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == delimiter) {
+            fields.push_back(std::move(current));
+            current.clear();
+        } else {
+            current.push_back(c);
+        }
+    }
+    if (quoted) {
+        throw std::invalid_argument("Unterminated quoted field");
+    }
+    fields.push_back(std::move(current));
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+double parseDouble(std::string_view text, const char *what) {
+    text = trim(text);
+    double value = 0.0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size() || text.empty()) {
+        throw std::invalid_argument(std::string(what) + " is not a number: '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+template <typename Fn> void forEachListItem(std::string_view cell, char delimiter, Fn fn) {
+    cell = trim(cell);
+    while (!cell.empty()) {
+        std::size_t pos = cell.find(delimiter);
+        std::string_view item = trim(cell.substr(0, pos));
+        if (!item.empty()) {
+            fn(item);
+        }
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        cell.remove_prefix(pos + 1);
+    }
+}
+
+struct ColumnIndexes {
+    std::size_t group{0};
+    std::size_t payer{0};
+    std::size_t amount{0};
+    std::optional<std::size_t> participants;
+    std::optional<std::size_t> strategy;
+    std::optional<std::size_t> shares;
+    std::optional<std::size_t> description;
+    std::optional<std::size_t> timestamp;
+    std::optional<std::size_t> currency;
+};
+
+ColumnIndexes resolveColumns(const std::vector<std::string> &header, const CsvColumnMapping &mapping) {
+    auto find = [&](const std::string &name) -> std::optional<std::size_t> {
+        for (std::size_t i = 0; i < header.size(); ++i) {
+            if (trim(header[i]) == name) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    };
+    auto require = [&](const std::string &name) {
+        auto index = find(name);
+        if (!index) {
+            throw std::runtime_error("CSV header is missing required column '" + name + "'");
+        }
+        return *index;
+    };
+    ColumnIndexes columns;
+    columns.group = require(mapping.group);
+    columns.payer = require(mapping.payer);
+    columns.amount = require(mapping.amount);
+    columns.participants = find(mapping.participants);
+    columns.strategy = find(mapping.strategy);
+    columns.shares = find(mapping.shares);
+    columns.description = find(mapping.description);
+    columns.timestamp = find(mapping.timestamp);
+    columns.currency = find(mapping.currency);
+    return columns;
+}
+
+struct ParsedRow {
+    std::size_t line{0};
+    ExpenseRequest request;
+};
+
+/**
+ * @brief Parse output for one chunk; `line` values are relative to the chunk until applied.
+ */
+struct ParsedChunk {
+    std::size_t lineCount{0};
+    std::vector<ParsedRow> rows;
+    std::vector<CsvLineError> errors;
+};
+
+ExpenseRequest parseRecord(const std::vector<std::string> &fields,
+                           const ColumnIndexes &columns,
+                           const CsvColumnMapping &mapping) {
+    auto cell = [&](std::size_t index) -> std::string_view {
+        if (index >= fields.size()) {
+            throw std::invalid_argument("Expected at least " + std::to_string(index + 1) + " fields, found " +
+                                        std::to_string(fields.size()));
+        }
+        return fields[index];
+    };
+
+    ExpenseRequest request;
+    request.groupId = std::string(trim(cell(columns.group)));
+    request.input.payerId = std::string(trim(cell(columns.payer)));
+    request.input.amount = parseDouble(cell(columns.amount), "Amount");
+    if (request.groupId.empty() || request.input.payerId.empty()) {
+        throw std::invalid_argument("Group and payer must not be empty");
+    }
+    if (request.input.amount < 0.0) {
+        throw std::invalid_argument("Amount cannot be negative");
+    }
+    std::string_view strategyName = columns.strategy ? trim(cell(*columns.strategy)) : std::string_view{};
+    request.strategy = SplitStrategyFactory::create(strategyName.empty() ? "equal" : std::string(strategyName));
+    if (columns.description) {
+        request.description = std::string(trim(cell(*columns.description)));
+    }
+    if (columns.timestamp) {
+        std::string_view date = trim(cell(*columns.timestamp));
+        if (!date.empty()) {
+            request.timestamp = parseTimestamp(std::string(date));
+        }
+    }
+    if (columns.currency) {
+        request.input.currency = std::string(trim(cell(*columns.currency)));
+    }
+    if (columns.participants) {
+        forEachListItem(cell(*columns.participants), mapping.listDelimiter, [&](std::string_view item) {
+            request.input.participantIds.emplace_back(item);
+        });
+    }
+    if (columns.shares) {
+        auto &shares = request.strategy->name() == "percent" ? request.input.percentShares
+                                                             : request.input.exactShares;
+        forEachListItem(cell(*columns.shares), mapping.listDelimiter,
+                        [&](std::string_view item) { shares.push_back(parseDouble(item, "Share")); });
+    }
+    // Validate share vectors here, on the worker, so the sequential apply step only touches the ledger.
+    if (!request.input.participantIds.empty()) {
+        auto &participants = request.input.participantIds;
+        if (std::find(participants.begin(), participants.end(), request.input.payerId) == participants.end()) {
+            participants.push_back(request.input.payerId);
+        }
+        request.strategy->computeSplits(request.input);
+    }
+    return request;
+}
+}
+
+CsvColumnMapping CsvColumnMapping::parse(const std::string &spec) {
+    CsvColumnMapping mapping;
+    std::string_view rest = spec;
+    while (!rest.empty()) {
+        std::size_t comma = rest.find(',');
+        std::string_view item = rest.substr(0, comma);
+        std::size_t eq = item.find('=');
+        if (eq == std::string_view::npos) {
+            throw std::invalid_argument("Column mapping entries must look like field=Header: " + std::string(item));
+        }
+        std::string field(trim(item.substr(0, eq)));
+        std::string header(trim(item.substr(eq + 1)));
+        if (field == "group") {
+            mapping.group = header;
+        } else if (field == "payer") {
+            mapping.payer = header;
+        } else if (field == "amount") {
+            mapping.amount = header;
+        } else if (field == "participants") {
+            mapping.participants = header;
+        } else if (field == "strategy") {
+            mapping.strategy = header;
+        } else if (field == "shares") {
+            mapping.shares = header;
+        } else if (field == "description") {
+            mapping.description = header;
+        } else if (field == "timestamp") {
+            mapping.timestamp = header;
+        } else if (field == "currency") {
+            mapping.currency = header;
+        } else if (field == "delimiter" && header.size() == 1) {
+            mapping.delimiter = header.front();
+        } else if (field == "list-delimiter" && header.size() == 1) {
+            mapping.listDelimiter = header.front();
+        } else {
+            throw std::invalid_argument("Unknown column mapping field: " + field);
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(comma + 1);
+    }
+    return mapping;
+}
+
+CsvImporter::CsvImporter(CsvImportOptions options) : options_(std::move(options)) {
+    if (options_.threads == 0) {
+        options_.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    options_.chunkBytes = std::max<std::size_t>(1, options_.chunkBytes);
+    options_.batchSize = std::max<std::size_t>(1, options_.batchSize);
+}
+
+CsvImportReport CsvImporter::importFile(SplitwiseManager &manager, const std::string &path) const {
+    tracing::Span span("importCsv");
+    auto start = std::chrono::steady_clock::now();
+    CsvImportReport report;
+
+    MappedFile file(path);
+    std::string_view data = file.view();
+    std::size_t headerEnd = data.find('\n');
+    std::vector<std::string> header;
+    splitRecord(trim(data.substr(0, headerEnd)), options_.mapping.delimiter, header);
+    const ColumnIndexes columns = resolveColumns(header, options_.mapping);
+    std::string_view body = headerEnd == std::string_view::npos ? std::string_view{} : data.substr(headerEnd + 1);
+
+    // Cut the body into chunks that end just after a newline.
+    std::vector<std::string_view> chunks;
+    {
+        tracing::Span chunkSpan("importCsv.chunk");
+        std::size_t offset = 0;
+        while (offset < body.size()) {
+            std::size_t end = std::min(body.size(), offset + options_.chunkBytes);
+            if (end < body.size()) {
+                std::size_t newline = body.find('\n', end - 1);
+                end = newline == std::string_view::npos ? body.size() : newline + 1;
+            }
+            chunks.push_back(body.substr(offset, end - offset));
+            offset = end;
+        }
+    }
+
+    std::size_t lineBase = 2;
+    runOrderedPipeline<ParsedChunk>(
+        chunks.size(),
+        options_.threads,
+        [&](std::size_t index) {
+            tracing::Span parseSpan("importCsv.parse");
+            ParsedChunk parsed;
+            std::vector<std::string> fields;
+            std::string_view rest = chunks[index];
+            while (!rest.empty()) {
+                std::size_t newline = rest.find('\n');
+                std::string_view record = rest.substr(0, newline);
+                rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+                std::size_t line = parsed.lineCount++;
+                if (trim(record).empty()) {
+                    continue;
+                }
+                try {
+                    splitRecord(record, options_.mapping.delimiter, fields);
+                    parsed.rows.push_back({line, parseRecord(fields, columns, options_.mapping)});
+                } catch (const std::exception &ex) {
+                    parsed.errors.push_back({line, ex.what()});
+                }
+            }
+            return parsed;
+        },
+        [&](std::size_t, ParsedChunk &parsed) {
+            tracing::Span applySpan("importCsv.apply");
+            report.rows += parsed.rows.size() + parsed.errors.size();
+            std::vector<CsvLineError> chunkErrors = std::move(parsed.errors);
+
+            // Looked up once per chunk through getGroup, which pages in a group evicted from a partitioned ledger.
+            std::map<std::string, std::optional<Group>> groups;
+            std::vector<ExpenseRequest> batch;
+            std::vector<std::size_t> batchLines;
+            auto submit = [&] {
+                auto results = manager.addExpenses(batch);
+                for (std::size_t i = 0; i < results.size(); ++i) {
+                    if (results[i].ok()) {
+                        ++report.imported;
+                    } else {
+                        chunkErrors.push_back({batchLines[i], results[i].error});
+                    }
+                }
+                batch.clear();
+                batchLines.clear();
+            };
+            for (auto &row : parsed.rows) {
+                auto &participants = row.request.input.participantIds;
+                if (participants.empty()) {
+                    auto [it, inserted] = groups.try_emplace(row.request.groupId);
+                    if (inserted) {
+                        try {
+                            it->second = manager.getGroup(row.request.groupId);
+                        } catch (const std::invalid_argument &) {
+                            // Left without participants, so addExpenses reports the unknown group on this row.
+                        }
+                    }
+                    if (it->second) {
+                        const auto &timestamp = row.request.timestamp;
+                        participants = timestamp ? it->second->getMemberIdsAt(*timestamp) : it->second->getMemberIds();
+                    }
+                }
+                batch.push_back(std::move(row.request));
+                batchLines.push_back(row.line);
+                if (batch.size() >= options_.batchSize) {
+                    submit();
+                }
+            }
+            if (!batch.empty()) {
+                submit();
+            }
+
+            std::sort(chunkErrors.begin(), chunkErrors.end(),
+                      [](const CsvLineError &a, const CsvLineError &b) { return a.line < b.line; });
+            for (auto &error : chunkErrors) {
+                error.line += lineBase;
+                report.errors.push_back(std::move(error));
+            }
+            lineBase += parsed.lineCount;
+        });
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
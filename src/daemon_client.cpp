@@ -0,0 +1,141 @@
+#include "daemon_client.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+DaemonClient DaemonClient::connectUnix(const std::string &socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + socketPath);
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        std::string reason = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("Failed to connect to " + socketPath + ": " + reason);
+    }
+    return DaemonClient(fd);
+}
+
+DaemonClient DaemonClient::connectTcp(const std::string &host, std::uint16_t port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw std::runtime_error("Invalid IPv4 address: " + host);
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        std::string reason = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("Failed to connect to " + host + ":" + std::to_string(port) + ": " + reason);
+    }
+    int noDelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return DaemonClient(fd);
+}
+
+DaemonClient::DaemonClient(DaemonClient &&other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      nextId_(other.nextId_),
+      outgoing_(std::move(other.outgoing_)),
+      decoder_(std::move(other.decoder_)) {}
+
+DaemonClient &DaemonClient::operator=(DaemonClient &&other) noexcept {
+    if (this != &other) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = std::exchange(other.fd_, -1);
+        nextId_ = other.nextId_;
+        outgoing_ = std::move(other.outgoing_);
+        decoder_ = std::move(other.decoder_);
+    }
+    return *this;
+}
+
+DaemonClient::~DaemonClient() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::uint64_t DaemonClient::send(const std::string &command) {
+    std::uint64_t id = nextId_++;
+    protocol::encodeRequest(outgoing_, id, command);
+    return id;
+}
+
+void DaemonClient::flush() {
+    std::size_t written = 0;
+    while (written < outgoing_.size()) {
+        ssize_t sent = ::send(fd_, outgoing_.data() + written, outgoing_.size() - written, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to send request: ") + std::strerror(errno));
+        }
+        written += static_cast<std::size_t>(sent);
+    }
+    outgoing_.clear();
+}
+
+void DaemonClient::finishSending() {
+    flush();
+    if (::shutdown(fd_, SHUT_WR) != 0) {
+        throw std::runtime_error(std::string("Failed to shut down connection: ") + std::strerror(errno));
+    }
+}
+
+protocol::Response DaemonClient::receive() {
+    flush();
+    std::string payload;
+    char buffer[64 * 1024];
+    while (!decoder_.next(payload)) {
+        ssize_t received = ::recv(fd_, buffer, sizeof(buffer), 0);
+        if (received == 0) {
+            throw std::runtime_error("Connection closed by server");
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to receive response: ") + std::strerror(errno));
+        }
+        decoder_.feed(buffer, static_cast<std::size_t>(received));
+    }
+    return protocol::decodeResponse(payload);
+}
+
+protocol::Response DaemonClient::call(const std::string &command) {
+    send(command);
+    return receive();
+}
+
+std::vector<protocol::Response> DaemonClient::callBatch(const std::vector<std::string> &commands) {
+    for (const auto &command : commands) {
+        send(command);
+    }
+    std::vector<protocol::Response> responses;
+    responses.reserve(commands.size());
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        responses.push_back(receive());
+    }
+    return responses;
+}
@@ -0,0 +1,82 @@
+#include "daemon_protocol.hpp"
+
+#include <stdexcept>
+
+namespace protocol {
+namespace {
+void appendBigEndian(std::string &out, std::uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+std::uint64_t readBigEndian(std::string_view data, std::size_t offset, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(data[offset + static_cast<std::size_t>(i)]);
+    }
+    return value;
+}
+
+void appendFrameHeader(std::string &out, std::size_t payloadSize) {
+    if (payloadSize > kMaxPayload) {
+        throw std::length_error("Frame payload exceeds protocol limit");
+    }
+    appendBigEndian(out, payloadSize, 4);
+}
+}
+
+void encodeRequest(std::string &out, std::uint64_t id, std::string_view command) {
+    appendFrameHeader(out, 8 + command.size());
+    appendBigEndian(out, id, 8);
+    out.append(command);
+}
+
+void encodeResponse(std::string &out, const Response &response) {
+    appendFrameHeader(out, 9 + response.body.size());
+    appendBigEndian(out, response.id, 8);
+    out.push_back(response.ok ? 0 : 1);
+    out.append(response.body);
+}
+
+Request decodeRequest(std::string_view payload) {
+    if (payload.size() < 8) {
+        throw std::runtime_error("Malformed request frame");
+    }
+    return Request{readBigEndian(payload, 0, 8), std::string(payload.substr(8))};
+}
+
+Response decodeResponse(std::string_view payload) {
+    if (payload.size() < 9) {
+        throw std::runtime_error("Malformed response frame");
+    }
+    return Response{readBigEndian(payload, 0, 8), payload[8] == 0, std::string(payload.substr(9))};
+}
+
+void FrameDecoder::feed(const char *data, std::size_t size) {
+    // Compact lazily so a long pipelined stream does not keep shifting the buffer.
+    if (offset_ > 0 && offset_ * 2 >= buffer_.size()) {
+        buffer_.erase(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.append(data, size);
+}
+
+bool FrameDecoder::next(std::string &payload) {
+    std::string_view pending(buffer_.data() + offset_, buffer_.size() - offset_);
+    if (pending.size() < 4) {
+        return false;
+    }
+    std::size_t length = readBigEndian(pending, 0, 4);
+    if (length > kMaxPayload) {
+        throw std::runtime_error("Frame exceeds " + std::to_string(kMaxPayload) + " bytes");
+    }
+    if (pending.size() < 4 + length) {
+        return false;
+    }
+    payload.assign(pending.substr(4, length));
+    offset_ += 4 + length;
+    return true;
+}
+
+} // namespace protocol
@@ -0,0 +1,391 @@
+#include "daemon_server.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "daemon_protocol.hpp"
+#include "script_runner.hpp"
+#include "tracing.hpp"
+
+namespace {
+constexpr int MAX_EVENTS = 64;
+constexpr std::size_t READ_CHUNK = 64 * 1024;
+
+std::runtime_error systemError(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+}
+
+/**
+ * @brief Per-client state. Fields marked "loop" are only touched by the event-loop thread, "strand" only by the one
+ * worker task currently draining the connection, and the rest under `mutex`.
+ */
+struct DaemonServer::Connection {
+    Connection(int socket, SplitwiseManager &manager, const ScriptOptions &options)
+        : fd(socket), runner(manager, output, options) {}
+
+    int fd;                           // loop; -1 once closed
+    protocol::FrameDecoder decoder;   // loop
+    std::string writeBuffer;          // loop
+    std::uint32_t interest{EPOLLIN};  // loop; events registered with epoll
+    bool readClosed{false};           // loop; the client sent EOF, so close once everything it sent is answered
+
+    std::mutex mutex;
+    std::deque<protocol::Request> inbox;
+    std::string outbox;
+    bool scheduled{false};
+    bool closed{false};
+
+    std::ostringstream output;  // strand
+    ScriptRunner runner;        // strand
+};
+
+DaemonServer::DaemonServer(SplitwiseManager &manager, DaemonOptions options)
+    : manager_(manager), options_(std::move(options)), pool_(std::make_unique<ThreadPool>(options_.workers)) {}
+
+DaemonServer::~DaemonServer() {
+    stop();
+    pool_.reset();
+    for (auto &[fd, connection] : connections_) {
+        ::close(fd);
+    }
+    connections_.clear();
+    for (int fd : {listenFd_, epollFd_, wakeFd_}) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    if (listenFd_ >= 0 && !options_.socketPath.empty()) {
+        ::unlink(options_.socketPath.c_str());
+    }
+}
+
+void DaemonServer::start() {
+    bind();
+    loopThread_ = std::thread([this] { loop(); });
+}
+
+void DaemonServer::run() {
+    if (listenFd_ < 0) {
+        bind();
+    }
+    loop();
+}
+
+void DaemonServer::requestStop() noexcept {
+    stopRequested_.store(true);
+    if (wakeFd_ >= 0) {
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = ::write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+void DaemonServer::stop() {
+    requestStop();
+    if (loopThread_.joinable()) {
+        loopThread_.join();
+    }
+}
+
+DaemonStats DaemonServer::stats() const {
+    return DaemonStats{connectionsAccepted_.load(), requestsServed_.load(), responseBatches_.load()};
+}
+
+void DaemonServer::bind() {
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        throw systemError("Failed to create event loop");
+    }
+
+    if (!options_.socketPath.empty()) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (options_.socketPath.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + options_.socketPath);
+        }
+        std::strcpy(address.sun_path, options_.socketPath.c_str());
+        listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        ::unlink(options_.socketPath.c_str());
+        if (listenFd_ < 0 || ::bind(listenFd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            throw systemError("Failed to bind " + options_.socketPath);
+        }
+    } else {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(options_.port);
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (listenFd_ < 0 || ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            ::bind(listenFd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            throw systemError("Failed to bind 127.0.0.1:" + std::to_string(options_.port));
+        }
+        socklen_t length = sizeof(address);
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr *>(&address), &length);
+        port_ = ntohs(address.sin_port);
+    }
+    if (::listen(listenFd_, SOMAXCONN) != 0) {
+        throw systemError("Failed to listen");
+    }
+
+    for (int fd : {listenFd_, wakeFd_}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void DaemonServer::loop() {
+    epoll_event events[MAX_EVENTS];
+    while (!stopRequested_.load()) {
+        int count = ::epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("epoll_wait failed");
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd_) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wakeFd_) {
+                flushPending();
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            std::shared_ptr<Connection> connection = it->second;
+            const std::uint32_t flags = events[i].events;
+            if (flags & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                readFrom(connection);
+            }
+            if (connection->fd >= 0 && (flags & EPOLLOUT)) {
+                writeTo(connection);
+            }
+            closeIfFinished(connection);
+        }
+    }
+}
+
+void DaemonServer::acceptConnections() {
+    while (true) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;  // EAGAIN once the backlog is empty; transient errors are retried on the next event.
+        }
+        if (options_.socketPath.empty()) {
+            int noDelay = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        connections_.emplace(fd, std::make_shared<Connection>(fd, manager_, ScriptOptions{1, false, options_.readOnly}));
+        ++connectionsAccepted_;
+    }
+}
+
+void DaemonServer::readFrom(const std::shared_ptr<Connection> &connection) {
+    char buffer[READ_CHUNK];
+    bool open = true;
+    while (true) {
+        ssize_t received = ::recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection->decoder.feed(buffer, static_cast<std::size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received == 0) {
+            // A half-close ends the requests, not the conversation: everything read so far is still answered.
+            connection->readClosed = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            open = false;
+        }
+        break;
+    }
+
+    std::deque<protocol::Request> requests;
+    try {
+        std::string payload;
+        while (connection->decoder.next(payload)) {
+            requests.push_back(protocol::decodeRequest(payload));
+        }
+    } catch (const std::exception &) {
+        open = false;  // A corrupt stream cannot be resynchronised.
+    }
+
+    if (!requests.empty()) {
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            for (auto &request : requests) {
+                connection->inbox.push_back(std::move(request));
+            }
+            schedule = !connection->scheduled;
+            connection->scheduled = true;
+        }
+        if (schedule) {
+            pool_->submit([this, connection] { drain(connection); });
+        }
+    }
+    if (!open) {
+        close(connection);
+    } else if (connection->readClosed) {
+        updateInterest(*connection);
+    }
+}
+
+void DaemonServer::drain(const std::shared_ptr<Connection> &connection) {
+    while (true) {
+        std::deque<protocol::Request> batch;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            if (connection->inbox.empty() || connection->closed) {
+                connection->scheduled = false;
+                return;
+            }
+            batch.swap(connection->inbox);
+        }
+
+        tracing::Span span("daemon.batch");
+        std::string responses;
+        for (const auto &request : batch) {
+            protocol::Response response{request.id, true, {}};
+            response.ok = connection->runner.execute(request.command);
+            connection->runner.flush();
+            response.body = connection->output.str();
+            connection->output.str({});
+            try {
+                protocol::encodeResponse(responses, response);
+            } catch (const std::exception &ex) {
+                protocol::encodeResponse(responses, {request.id, false, std::string("error: ") + ex.what() + "\n"});
+            }
+        }
+        requestsServed_ += batch.size();
+        ++responseBatches_;
+        bool idle = false;
+        {
+            // Going idle together with publishing the responses lets the loop tell when a half-closed client is done.
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->outbox += responses;
+            idle = connection->inbox.empty() || connection->closed;
+            connection->scheduled = !idle;
+        }
+        {
+            std::lock_guard<std::mutex> lock(readyMutex_);
+            ready_.push_back(connection);
+        }
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = ::write(wakeFd_, &one, sizeof(one));
+        if (idle) {
+            return;
+        }
+    }
+}
+
+void DaemonServer::flushPending() {
+    std::uint64_t ignored = 0;
+    [[maybe_unused]] ssize_t drained = ::read(wakeFd_, &ignored, sizeof(ignored));
+    std::vector<std::shared_ptr<Connection>> ready;
+    {
+        std::lock_guard<std::mutex> lock(readyMutex_);
+        ready.swap(ready_);
+    }
+    for (const auto &connection : ready) {
+        if (connection->fd < 0) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->writeBuffer += connection->outbox;
+            connection->outbox.clear();
+        }
+        writeTo(connection);
+        closeIfFinished(connection);
+    }
+}
+
+void DaemonServer::writeTo(const std::shared_ptr<Connection> &connection) {
+    std::string &buffer = connection->writeBuffer;
+    std::size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t sent = ::send(connection->fd, buffer.data() + written, buffer.size() - written, MSG_NOSIGNAL);
+        if (sent >= 0) {
+            written += static_cast<std::size_t>(sent);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else if (errno != EINTR) {
+            close(connection);
+            return;
+        }
+    }
+    buffer.erase(0, written);
+    updateInterest(*connection);
+}
+
+void DaemonServer::closeIfFinished(const std::shared_ptr<Connection> &connection) {
+    if (connection->fd < 0 || !connection->readClosed || !connection->writeBuffer.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->scheduled || !connection->outbox.empty()) {
+            return;
+        }
+    }
+    close(connection);
+}
+
+void DaemonServer::close(const std::shared_ptr<Connection> &connection) {
+    if (connection->fd < 0) {
+        return;
+    }
+    ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    connections_.erase(connection->fd);
+    connection->fd = -1;
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    connection->closed = true;
+    connection->inbox.clear();
+}
+
+void DaemonServer::updateInterest(Connection &connection) {
+    // A socket at EOF stays readable, so a half-closed connection stops asking for input and is watched
+    // edge-triggered, which reports a hangup once instead of on every wait.
+    const std::uint32_t events = (connection.readClosed ? static_cast<std::uint32_t>(EPOLLET) : EPOLLIN) |
+                                 (connection.writeBuffer.empty() ? 0u : EPOLLOUT);
+    if (connection.interest == events) {
+        return;
+    }
+    connection.interest = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &event);
+}
@@ -0,0 +1,188 @@
+#include "description_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+
+#include "memory_usage.hpp"
+#include "ordered_pipeline.hpp"
+
+namespace {
+constexpr std::size_t BUILD_CHUNK = 1 << 15;
+constexpr double PREFIX_WEIGHT = 0.5;
+
+bool isTermByte(unsigned char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c >= 0x80; }
+}
+
+std::vector<std::string> tokenizeDescription(std::string_view text) {
+    std::vector<std::string> terms;
+    std::string current;
+    auto finish = [&] {
+        if (!current.empty() && std::find(terms.begin(), terms.end(), current) == terms.end()) {
+            terms.push_back(current);
+        }
+        current.clear();
+    };
+    for (char raw : text) {
+        auto c = static_cast<unsigned char>(raw);
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<unsigned char>(c - 'A' + 'a');
+        }
+        if (isTermByte(c)) {
+            current.push_back(static_cast<char>(c));
+        } else {
+            finish();
+        }
+    }
+    finish();
+    return terms;
+}
+
+void DescriptionIndex::clear() {
+    terms_.clear();
+    documents_ = 0;
+}
+
+void DescriptionIndex::build(const std::vector<const std::string *> &descriptions, unsigned threads) {
+    clear();
+    using Chunk = std::unordered_map<std::string, std::vector<std::uint32_t>>;
+    const std::size_t chunks = (descriptions.size() + BUILD_CHUNK - 1) / BUILD_CHUNK;
+    runOrderedPipeline<Chunk>(
+        chunks,
+        threads,
+        [&](std::size_t index) {
+            Chunk chunk;
+            const std::size_t end = std::min(descriptions.size(), (index + 1) * BUILD_CHUNK);
+            for (std::size_t handle = index * BUILD_CHUNK; handle < end; ++handle) {
+                if (!descriptions[handle]) {
+                    continue;
+                }
+                for (auto &term : tokenizeDescription(*descriptions[handle])) {
+                    chunk[std::move(term)].push_back(static_cast<std::uint32_t>(handle));
+                }
+            }
+            return chunk;
+        },
+        [&](std::size_t, Chunk &chunk) {
+            // Chunks arrive in handle order, so every add below takes the posting list's append path.
+            for (auto &[term, handles] : chunk) {
+                auto &postings = terms_[term];
+                for (std::uint32_t handle : handles) {
+                    postings.add(handle);
+                }
+            }
+        });
+    documents_ = static_cast<std::size_t>(
+        std::count_if(descriptions.begin(), descriptions.end(), [](const std::string *d) { return d != nullptr; }));
+}
+
+void DescriptionIndex::add(std::uint32_t handle, std::string_view description) {
+    for (auto &term : tokenizeDescription(description)) {
+        terms_[std::move(term)].add(handle);
+    }
+    ++documents_;
+}
+
+void DescriptionIndex::remove(std::uint32_t handle, std::string_view description) {
+    for (const auto &term : tokenizeDescription(description)) {
+        auto it = terms_.find(term);
+        if (it != terms_.end() && it->second.remove(handle) && it->second.empty()) {
+            terms_.erase(it);
+        }
+    }
+    if (documents_ > 0) {
+        --documents_;
+    }
+}
+
+DescriptionIndex::Candidates DescriptionIndex::candidatesFor(const std::string &term) const {
+    Candidates candidates;
+    for (auto it = terms_.lower_bound(term); it != terms_.end() && it->first.compare(0, term.size(), term) == 0;
+         ++it) {
+        const double idf = std::log(1.0 + static_cast<double>(documents_) / static_cast<double>(it->second.size()));
+        const double weight = it->first.size() == term.size() ? idf : idf * PREFIX_WEIGHT;
+        for (auto posting = it->second.begin(); posting.valid(); posting.next()) {
+            candidates.push_back({posting.value(), weight});
+        }
+    }
+    // One entry per handle, keeping the best-scoring expansion of the term.
+    std::sort(candidates.begin(), candidates.end(), [](const DescriptionMatch &a, const DescriptionMatch &b) {
+        return a.handle != b.handle ? a.handle < b.handle : a.score > b.score;
+    });
+    candidates.erase(std::unique(candidates.begin(), candidates.end(),
+                                 [](const DescriptionMatch &a, const DescriptionMatch &b) {
+                                     return a.handle == b.handle;
+                                 }),
+                     candidates.end());
+    return candidates;
+}
+
+std::vector<DescriptionMatch> DescriptionIndex::search(std::string_view query,
+                                                       std::size_t limit,
+                                                       const std::vector<const PostingList *> &filters) const {
+    std::vector<Candidates> perTerm;
+    for (const auto &term : tokenizeDescription(query)) {
+        perTerm.push_back(candidatesFor(term));
+        if (perTerm.back().empty()) {
+            return {};
+        }
+    }
+    if (perTerm.empty() || limit == 0) {
+        return {};
+    }
+    // Intersect starting from the most selective term so the others are only probed.
+    std::sort(perTerm.begin(), perTerm.end(),
+              [](const Candidates &a, const Candidates &b) { return a.size() < b.size(); });
+    Candidates matches = std::move(perTerm.front());
+    std::vector<std::pair<Candidates::const_iterator, Candidates::const_iterator>> probes;
+    for (std::size_t t = 1; t < perTerm.size(); ++t) {
+        probes.emplace_back(perTerm[t].begin(), perTerm[t].end());
+    }
+    std::vector<PostingList::Iterator> allowed;
+    for (const PostingList *filter : filters) {
+        allowed.push_back(filter->begin());
+    }
+    // Candidates are sorted by handle, so every probe only moves forward.
+    std::size_t kept = 0;
+    for (DescriptionMatch match : matches) {
+        bool everyTerm = std::all_of(allowed.begin(), allowed.end(), [&](PostingList::Iterator &it) {
+            it.seek(match.handle);
+            return it.valid() && it.value() == match.handle;
+        });
+        for (auto it = probes.begin(); everyTerm && it != probes.end(); ++it) {
+            auto &[probe, end] = *it;
+            probe = std::lower_bound(probe, end, match.handle,
+                                     [](const DescriptionMatch &c, std::uint32_t h) { return c.handle < h; });
+            everyTerm = probe != end && probe->handle == match.handle;
+            if (everyTerm) {
+                match.score += probe->score;
+            }
+        }
+        if (everyTerm) {
+            matches[kept++] = match;
+        }
+    }
+    matches.resize(kept);
+
+    auto better = [](const DescriptionMatch &a, const DescriptionMatch &b) {
+        return a.score != b.score ? a.score > b.score : a.handle > b.handle;
+    };
+    if (matches.size() > limit) {
+        std::partial_sort(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(limit), matches.end(),
+                          better);
+        matches.resize(limit);
+    } else {
+        std::sort(matches.begin(), matches.end(), better);
+    }
+    return matches;
+}
+
+std::size_t DescriptionIndex::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this);
+    for (const auto &[term, postings] : terms_) {
+        bytes += memory::treeNodeBytes<std::pair<const std::string, PostingList>>() + memory::stringBytes(term) +
+                 postings.memoryBytes() - sizeof(PostingList);
+    }
+    return bytes;
+}
@@ -1,49 +1,90 @@
 #include "expense.hpp"
 
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+
+#include "memory_usage.hpp"
+
 Expense::Expense(std::string id,
                  std::string groupId,
                  std::string description,
                  SplitInput input,
-                 std::shared_ptr<SplitStrategy> strategy)
-    : id_(std::move(id)),
-      groupId_(std::move(groupId)),
-      description_(std::move(description)),
-      input_(std::move(input)),
-      strategy_(std::move(strategy)) {}
+                 std::shared_ptr<SplitStrategy> strategy,
+                 std::int64_t timestamp)
+    : record_(std::make_shared<const Record>(Record{std::move(id),
+                                                    std::move(groupId),
+                                                    std::move(description),
+                                                    std::move(input),
+                                                    std::move(strategy),
+                                                    timestamp})) {}
+
+Expense::Expense() {
+    static const auto empty = std::make_shared<const Record>();
+    record_ = empty;
+}
+
+std::size_t Expense::memoryBytes() const noexcept {
+    using memory::stringBytes;
+    using memory::vectorBytes;
+    const Record &record = *record_;
+    // make_shared places the control block (vtable pointer and two counts) and the record in one allocation.
+    std::size_t bytes = sizeof(*this) + memory::allocationBytes(2 * sizeof(void *) + sizeof(Record));
+    bytes += stringBytes(record.id) + stringBytes(record.groupId) + stringBytes(record.description);
+    bytes += stringBytes(record.input.payerId) + stringBytes(record.input.currency);
+    bytes += vectorBytes(record.input.participantIds) + vectorBytes(record.input.exactShares) +
+             vectorBytes(record.input.percentShares);
+    for (const auto &participantId : record.input.participantIds) {
+        bytes += stringBytes(participantId);
+    }
+    if (record.strategy) {
+        bytes += memory::allocationBytes(2 * sizeof(void *) + sizeof(SplitStrategy)) /
+                 static_cast<std::size_t>(record.strategy.use_count());
+    }
+    return bytes;
+}
 
-const std::string &Expense::getId() const noexcept { return id_; }
+const std::string &Expense::getId() const noexcept { return record_->id; }
 
-const std::string &Expense::getGroupId() const noexcept { return groupId_; }
+const std::string &Expense::getGroupId() const noexcept { return record_->groupId; }
 
-const std::string &Expense::getDescription() const noexcept { return description_; }
+const std::string &Expense::getDescription() const noexcept { return record_->description; }
 
-const SplitInput &Expense::getInput() const noexcept { return input_; }
+const SplitInput &Expense::getInput() const noexcept { return record_->input; }
 
-const std::shared_ptr<SplitStrategy> &Expense::getStrategy() const noexcept { return strategy_; }
+const std::shared_ptr<SplitStrategy> &Expense::getStrategy() const noexcept { return record_->strategy; }
+
+std::int64_t Expense::getTimestamp() const noexcept { return record_->timestamp; }
 
 nlohmann::json Expense::toJson() const {
+    const Record &r = *record_;
     nlohmann::json j;
-    j["id"] = id_;
-    j["groupId"] = groupId_;
-    j["description"] = description_;
-    j["payerId"] = input_.payerId;
-    j["amount"] = input_.amount;
+    j["id"] = r.id;
+    j["groupId"] = r.groupId;
+    j["description"] = r.description;
+    j["payerId"] = r.input.payerId;
+    j["amount"] = r.input.amount;
     auto participants = nlohmann::json::array();
-    for (const auto &participant : input_.participantIds) {
+    for (const auto &participant : r.input.participantIds) {
         participants.push_back(participant);
     }
     j["participants"] = participants;
     auto exactShares = nlohmann::json::array();
-    for (double share : input_.exactShares) {
+    for (double share : r.input.exactShares) {
         exactShares.push_back(share);
     }
     j["exactShares"] = exactShares;
     auto percentShares = nlohmann::json::array();
-    for (double share : input_.percentShares) {
+    for (double share : r.input.percentShares) {
         percentShares.push_back(share);
     }
     j["percentShares"] = percentShares;
-    j["strategy"] = strategy_ ? strategy_->name() : std::string{};
+    j["strategy"] = r.strategy ? r.strategy->name() : std::string{};
+    if (!r.input.currency.empty()) {
+        j["currency"] = r.input.currency;
+    }
+    j["timestamp"] = static_cast<double>(r.timestamp);
     return j;
 }
 
@@ -58,10 +99,50 @@ Expense Expense::fromJson(const nlohmann::json &j, const std::shared_ptr<SplitSt
     if (j.contains("percentShares")) {
         input.percentShares = j.at("percentShares").get<std::vector<double>>();
     }
+    input.currency = j.value("currency", std::string{});
     return Expense{j.at("id").get<std::string>(),
                    j.at("groupId").get<std::string>(),
                    j.value("description", std::string{}),
                    input,
-                   strategy};
+                   strategy,
+                   static_cast<std::int64_t>(j.value("timestamp", 0.0))};
 }
 
+
+namespace {
+// Howard Hinnant's days_from_civil: days since 1970-01-01 in the proleptic Gregorian calendar.
+std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2 ? 1 : 0;
+    const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const auto yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+}
+}
+
+std::int64_t parseTimestamp(const std::string &text) {
+    const char *begin = text.data();
+    const char *end = begin + text.size();
+    std::int64_t seconds = 0;
+    auto [ptr, ec] = std::from_chars(begin, end, seconds);
+    if (ec == std::errc{} && ptr == end) {
+        return seconds;
+    }
+
+    int year = 0;
+    unsigned month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    int consumed = 0;
+    int fields = std::sscanf(text.c_str(), "%d-%u-%u%n", &year, &month, &day, &consumed);
+    bool valid = fields == 3 && month >= 1 && month <= 12 && day >= 1 && day <= 31;
+    if (valid && static_cast<std::size_t>(consumed) < text.size()) {
+        int timeConsumed = 0;
+        const char *rest = text.c_str() + consumed;
+        fields = std::sscanf(rest, "%*1[T ]%u:%u%n:%u%n", &hour, &minute, &timeConsumed, &second, &timeConsumed);
+        valid = fields >= 2 && rest[timeConsumed] == '\0' && hour < 24 && minute < 60 && second < 61;
+    }
+    if (!valid) {
+        throw std::invalid_argument("Invalid timestamp: " + text);
+    }
+    return daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+}
@@ -0,0 +1,149 @@
+#include "expense_index.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
+
+#include "memory_usage.hpp"
+
+void ExpenseIndex::clear() {
+    ids_.clear();
+    handles_.clear();
+    byUser_.clear();
+    byGroup_.clear();
+}
+
+void ExpenseIndex::build(const std::map<std::string, Expense> &expenses) {
+    clear();
+    std::vector<const Expense *> ordered;
+    ordered.reserve(expenses.size());
+    for (const auto &[id, expense] : expenses) {
+        ordered.push_back(&expense);
+    }
+    // Generated ids share a prefix, so (length, text) order is creation order ("EXP9" before "EXP10").
+    std::sort(ordered.begin(), ordered.end(), [](const Expense *lhs, const Expense *rhs) {
+        const auto &a = lhs->getId();
+        const auto &b = rhs->getId();
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    ids_.reserve(ordered.size());
+    handles_.reserve(ordered.size());
+    for (const Expense *expense : ordered) {
+        insert(*expense);
+    }
+}
+
+void ExpenseIndex::insert(const Expense &expense) {
+    if (ids_.size() >= kNoHandle) {
+        throw std::length_error("Expense index is full");
+    }
+    auto handle = static_cast<Handle>(ids_.size());
+    if (!handles_.emplace(expense.getId(), handle).second) {
+        throw std::invalid_argument("Expense already indexed: " + expense.getId());
+    }
+    ids_.push_back(expense.getId());
+    post(expense, handle);
+}
+
+void ExpenseIndex::update(const Expense &before, const Expense &after) {
+    Handle handle = handleOf(before.getId());
+    if (handle == kNoHandle) {
+        return;
+    }
+    unpost(before, handle);
+    post(after, handle);
+}
+
+void ExpenseIndex::erase(const Expense &expense) {
+    auto it = handles_.find(expense.getId());
+    if (it == handles_.end()) {
+        return;
+    }
+    unpost(expense, it->second);
+    ids_[it->second].clear();
+    handles_.erase(it);
+}
+
+ExpenseIndex::Handle ExpenseIndex::handleOf(const std::string &expenseId) const {
+    auto it = handles_.find(expenseId);
+    return it == handles_.end() ? kNoHandle : it->second;
+}
+
+const PostingList *ExpenseIndex::userPostings(const std::string &userId) const {
+    auto it = byUser_.find(userId);
+    return it == byUser_.end() ? nullptr : &it->second;
+}
+
+const PostingList *ExpenseIndex::groupPostings(const std::string &groupId) const {
+    auto it = byGroup_.find(groupId);
+    return it == byGroup_.end() ? nullptr : &it->second;
+}
+
+std::vector<std::string> ExpenseIndex::page(const PostingList *postings,
+                                            const std::string &cursor,
+                                            std::size_t limit,
+                                            std::string &nextCursor) const {
+    Handle from = 0;
+    if (!cursor.empty()) {
+        auto [ptr, ec] = std::from_chars(cursor.data(), cursor.data() + cursor.size(), from);
+        if (ec != std::errc{} || ptr != cursor.data() + cursor.size()) {
+            throw std::invalid_argument("Invalid cursor: " + cursor);
+        }
+    }
+    nextCursor.clear();
+    std::vector<std::string> ids;
+    if (!postings) {
+        return ids;
+    }
+    auto it = postings->begin();
+    it.seek(from);
+    for (; it.valid() && ids.size() < limit; it.next()) {
+        ids.push_back(ids_[it.value()]);
+    }
+    if (it.valid()) {
+        nextCursor = std::to_string(it.value());
+    }
+    return ids;
+}
+
+std::size_t ExpenseIndex::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this) + memory::vectorBytes(ids_);
+    for (const auto &id : ids_) {
+        bytes += memory::stringBytes(id);
+    }
+    bytes += memory::bucketBytes(handles_);
+    for (const auto &[id, handle] : handles_) {
+        bytes += memory::hashNodeBytes<std::pair<const std::string, Handle>>() + memory::stringBytes(id);
+    }
+    for (const auto *lists : {&byUser_, &byGroup_}) {
+        bytes += memory::bucketBytes(*lists);
+        for (const auto &[key, postings] : *lists) {
+            bytes += memory::hashNodeBytes<std::pair<const std::string, PostingList>>() + memory::stringBytes(key) +
+                     postings.memoryBytes() - sizeof(PostingList);
+        }
+    }
+    return bytes;
+}
+
+void ExpenseIndex::post(const Expense &expense, Handle handle) {
+    byGroup_[expense.getGroupId()].add(handle);
+    byUser_[expense.getInput().payerId].add(handle);
+    for (const auto &participant : expense.getInput().participantIds) {
+        byUser_[participant].add(handle);
+    }
+}
+
+void ExpenseIndex::unpost(const Expense &expense, Handle handle) {
+    auto drop = [handle](std::unordered_map<std::string, PostingList> &lists, const std::string &key) {
+        auto it = lists.find(key);
+        if (it != lists.end() && it->second.remove(handle) && it->second.empty()) {
+            lists.erase(it);
+        }
+    };
+    drop(byGroup_, expense.getGroupId());
+    drop(byUser_, expense.getInput().payerId);
+    for (const auto &participant : expense.getInput().participantIds) {
+        drop(byUser_, participant);
+    }
+}
@@ -0,0 +1,42 @@
+#include "expense_time_index.hpp"
+
+#include "memory_usage.hpp"
+
+void ExpenseTimeIndex::insert(const Expense &expense) {
+    Entry entry{expense.getTimestamp(), expense.getId()};
+    all_.insert(entry);
+    byGroup_[expense.getGroupId()].insert(std::move(entry));
+}
+
+void ExpenseTimeIndex::erase(const Expense &expense) {
+    Entry entry{expense.getTimestamp(), expense.getId()};
+    all_.erase(entry);
+    auto it = byGroup_.find(expense.getGroupId());
+    if (it != byGroup_.end()) {
+        it->second.erase(entry);
+        if (it->second.empty()) {
+            byGroup_.erase(it);
+        }
+    }
+}
+
+void ExpenseTimeIndex::clear() {
+    all_.clear();
+    byGroup_.clear();
+}
+
+std::size_t ExpenseTimeIndex::memoryBytes() const noexcept {
+    auto entryBytes = [](const EntrySet &entries) {
+        std::size_t bytes = 0;
+        for (const auto &entry : entries) {
+            bytes += memory::treeNodeBytes<Entry>() + memory::stringBytes(entry.second);
+        }
+        return bytes;
+    };
+    std::size_t bytes = sizeof(*this) + entryBytes(all_);
+    for (const auto &[groupId, entries] : byGroup_) {
+        bytes += memory::treeNodeBytes<std::pair<const std::string, EntrySet>>() + memory::stringBytes(groupId) +
+                 entryBytes(entries);
+    }
+    return bytes;
+}
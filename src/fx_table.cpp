@@ -0,0 +1,111 @@
+#include "fx_table.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include "memory_usage.hpp"
+
+namespace {
+struct CachedTable {
+    std::filesystem::file_time_type modified;
+    std::uintmax_t size{0};
+    std::shared_ptr<const FxTable> table;
+};
+
+std::mutex gCacheMutex;
+std::map<std::string, CachedTable> gCache;
+}
+
+FxTable FxTable::parse(std::istream &in, const std::string &source) {
+    FxTable table;
+    std::string line;
+    for (std::size_t lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        std::size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        std::istringstream fields(line);
+        std::string code;
+        if (!(fields >> code)) {
+            continue;
+        }
+        double value = 0.0;
+        std::string extra;
+        if (!(fields >> value) || (fields >> extra)) {
+            throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": expected 'CODE VALUE'");
+        }
+        if (!(value > 0.0)) {
+            throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": rate must be positive");
+        }
+        if (!table.index_.emplace(code, table.values_.size()).second) {
+            throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": duplicate currency " + code);
+        }
+        table.values_.push_back(value);
+    }
+    return table;
+}
+
+std::shared_ptr<const FxTable> FxTable::load(const std::string &path) {
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(path, ec);
+    auto size = ec ? 0 : std::filesystem::file_size(path, ec);
+    if (ec) {
+        throw std::runtime_error("Failed to open FX table: " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(gCacheMutex);
+    auto it = gCache.find(path);
+    if (it != gCache.end() && it->second.modified == modified && it->second.size == size) {
+        return it->second.table;
+    }
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open FX table: " + path);
+    }
+    auto table = std::make_shared<const FxTable>(parse(in, path));
+    gCache[path] = CachedTable{modified, size, table};
+    return table;
+}
+
+double FxTable::rate(const std::string &from, const std::string &to) const {
+    if (from == to) {
+        return 1.0;
+    }
+    return values_[indexOf(from)] / values_[indexOf(to)];
+}
+
+void FxTable::convertInto(const BalanceSheet::BalanceMap &balances,
+                          const std::string &from,
+                          const std::string &to,
+                          BalanceSheet::BalanceMap &out) const {
+    const double factor = rate(from, to);
+    auto hint = out.begin();
+    for (const auto &[userId, balance] : balances) {
+        // Both maps are ordered by user id, so the next entry belongs right after the previous one.
+        auto it = out.try_emplace(hint, userId, 0.0);
+        it->second += balance * factor;
+        hint = std::next(it);
+    }
+}
+
+std::size_t FxTable::indexOf(const std::string &code) const {
+    auto it = index_.find(code);
+    if (it == index_.end()) {
+        throw std::invalid_argument("No exchange rate for currency: " + code);
+    }
+    return it->second;
+}
+
+std::size_t FxTable::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this) + memory::bucketBytes(index_) + memory::vectorBytes(values_);
+    for (const auto &[code, position] : index_) {
+        bytes += memory::hashNodeBytes<std::pair<const std::string, std::size_t>>() + memory::stringBytes(code);
+    }
+    return bytes;
+}
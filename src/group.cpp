@@ -1,9 +1,23 @@
 #include "group.hpp"
 
 #include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "memory_usage.hpp"
 
 Group::Group(std::string id, std::string name, std::vector<std::string> memberIds)
-    : id_(std::move(id)), name_(std::move(name)), memberIds_(std::move(memberIds)) {}
+    : id_(std::move(id)), name_(std::move(name)) {
+    memberIds_.reserve(memberIds.size());
+    members_.reserve(memberIds.size());
+    for (auto &memberId : memberIds) {
+        auto [it, inserted] = members_.try_emplace(memberId);
+        if (inserted) {
+            it->second.position = memberIds_.size();
+            memberIds_.push_back(std::move(memberId));
+        }
+    }
+}
 
 const std::string &Group::getId() const noexcept { return id_; }
 
@@ -11,8 +25,129 @@ const std::string &Group::getName() const noexcept { return name_; }
 
 const std::vector<std::string> &Group::getMemberIds() const noexcept { return memberIds_; }
 
+std::vector<std::string> Group::getMemberIdsAt(std::int64_t timestamp) const {
+    const Epoch epoch = epochAt(timestamp);
+    if (epoch == getEpoch()) {
+        return memberIds_;
+    }
+    std::vector<std::string> members;
+    for (const auto &[userId, membership] : members_) {
+        if (hasMemberAtEpoch(userId, epoch)) {
+            members.push_back(userId);
+        }
+    }
+    std::sort(members.begin(), members.end());
+    return members;
+}
+
 bool Group::hasMember(const std::string &userId) const {
-    return std::find(memberIds_.begin(), memberIds_.end(), userId) != memberIds_.end();
+    auto it = members_.find(userId);
+    return it != members_.end() && it->second.latest.left == kOpen;
+}
+
+bool Group::hasMemberAtEpoch(const std::string &userId, Epoch epoch) const {
+    auto it = members_.find(userId);
+    if (it == members_.end()) {
+        return false;
+    }
+    const Membership &membership = it->second;
+    if (membership.latest.joined <= epoch) {
+        return epoch < membership.latest.left;
+    }
+    return std::any_of(membership.earlier.begin(), membership.earlier.end(),
+                       [epoch](const Stint &stint) { return stint.joined <= epoch && epoch < stint.left; });
+}
+
+bool Group::hasMemberAt(const std::string &userId, std::int64_t timestamp) const {
+    return hasMemberAtEpoch(userId, epochAt(timestamp));
+}
+
+Group::Epoch Group::getEpoch() const noexcept { return epochTimes_.size(); }
+
+Group::Epoch Group::epochAt(std::int64_t timestamp) const {
+    return static_cast<Epoch>(std::upper_bound(epochTimes_.begin(), epochTimes_.end(), timestamp) -
+                              epochTimes_.begin());
+}
+
+std::int64_t Group::getLastChangeTime() const noexcept {
+    return epochTimes_.empty() ? std::numeric_limits<std::int64_t>::min() : epochTimes_.back();
+}
+
+Group::Epoch Group::addMember(const std::string &userId, std::int64_t timestamp) {
+    if (hasMember(userId)) {
+        throw std::invalid_argument("User " + userId + " is already a member of group " + id_);
+    }
+    const Epoch epoch = beginChange(timestamp);
+    auto [it, inserted] = members_.try_emplace(userId);
+    Membership &membership = it->second;
+    if (!inserted) {
+        membership.earlier.push_back(membership.latest);
+    }
+    membership.latest = Stint{epoch, kOpen};
+    membership.position = memberIds_.size();
+    memberIds_.push_back(userId);
+    return epoch;
+}
+
+Group::Epoch Group::removeMember(const std::string &userId, std::int64_t timestamp) {
+    if (!hasMember(userId)) {
+        throw std::invalid_argument("User " + userId + " is not a member of group " + id_);
+    }
+    const Epoch epoch = beginChange(timestamp);
+    Membership &membership = members_.at(userId);
+    membership.latest.left = epoch;
+    // Swap-remove keeps removal O(1) for large groups.
+    const std::size_t position = membership.position;
+    if (position + 1 != memberIds_.size()) {
+        memberIds_[position] = std::move(memberIds_.back());
+        members_.at(memberIds_[position]).position = position;
+    }
+    memberIds_.pop_back();
+    return epoch;
+}
+
+Group::Epoch Group::beginChange(std::int64_t timestamp) {
+    if (timestamp < getLastChangeTime()) {
+        throw std::invalid_argument("Membership changes to group " + id_ + " must be in time order");
+    }
+    epochTimes_.push_back(timestamp);
+    return epochTimes_.size();
+}
+
+std::vector<MembershipChange> Group::getHistory() const {
+    std::vector<MembershipChange> history;
+    history.reserve(epochTimes_.size());
+    auto record = [&](const std::string &userId, const Stint &stint) {
+        if (stint.joined != 0) {
+            history.push_back({stint.joined, epochTimes_[stint.joined - 1], userId, true});
+        }
+        if (stint.left != kOpen) {
+            history.push_back({stint.left, epochTimes_[stint.left - 1], userId, false});
+        }
+    };
+    for (const auto &[userId, membership] : members_) {
+        for (const auto &stint : membership.earlier) {
+            record(userId, stint);
+        }
+        record(userId, membership.latest);
+    }
+    std::sort(history.begin(), history.end(),
+              [](const MembershipChange &a, const MembershipChange &b) { return a.epoch < b.epoch; });
+    return history;
+}
+
+std::size_t Group::memoryBytes() const noexcept {
+    using memory::stringBytes;
+    std::size_t bytes = stringBytes(id_) + stringBytes(name_) + memory::vectorBytes(memberIds_) +
+                        memory::vectorBytes(epochTimes_) + memory::bucketBytes(members_);
+    for (const auto &memberId : memberIds_) {
+        bytes += stringBytes(memberId);
+    }
+    for (const auto &[userId, membership] : members_) {
+        bytes += memory::hashNodeBytes<std::pair<const std::string, Membership>>() + stringBytes(userId) +
+                 memory::vectorBytes(membership.earlier);
+    }
+    return bytes;
 }
 
 nlohmann::json Group::toJson() const {
@@ -24,12 +159,69 @@ nlohmann::json Group::toJson() const {
         members.push_back(member);
     }
     j["members"] = members;
+    // Groups whose membership never changed keep the original format.
+    if (!epochTimes_.empty()) {
+        auto changes = nlohmann::json::array();
+        for (const auto &change : getHistory()) {
+            nlohmann::json entry;
+            entry["user"] = change.userId;
+            entry["action"] = change.joined ? "add" : "remove";
+            entry["timestamp"] = static_cast<double>(change.timestamp);
+            changes.push_back(entry);
+        }
+        j["membershipChanges"] = changes;
+    }
     return j;
 }
 
 Group Group::fromJson(const nlohmann::json &j) {
-    return Group{j.at("id").get<std::string>(),
-                 j.at("name").get<std::string>(),
-                 j.at("members").get<std::vector<std::string>>()};
-}
+    const std::string id = j.at("id").get<std::string>();
+    const std::vector<std::string> current = j.at("members").get<std::vector<std::string>>();
+    if (!j.contains("membershipChanges")) {
+        return Group{id, j.at("name").get<std::string>(), current};
+    }
+    const nlohmann::json &records = j.at("membershipChanges");
+    if (!records.is_array()) {
+        throw std::runtime_error("Invalid JSON format: 'membershipChanges' must be an array");
+    }
+    std::vector<MembershipChange> changes;
+    for (const auto &record : records) {
+        const std::string action = record.at("action").get<std::string>();
+        if (action != "add" && action != "remove") {
+            throw std::runtime_error("Unknown membership action in group " + id + ": " + action);
+        }
+        changes.push_back({0, static_cast<std::int64_t>(record.at("timestamp").get<double>()),
+                           record.at("user").get<std::string>(), action == "add"});
+    }
 
+    // Undo the changes from the current members backwards to find the founders, then replay them forwards.
+    std::unordered_set<std::string> members(current.begin(), current.end());
+    for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+        const bool consistent = it->joined ? members.erase(it->userId) == 1 : members.insert(it->userId).second;
+        if (!consistent) {
+            throw std::runtime_error("Membership history of group " + id + " contradicts its members at user " +
+                                     it->userId);
+        }
+    }
+    Group group{id, j.at("name").get<std::string>(), std::vector<std::string>(members.begin(), members.end())};
+    try {
+        for (const auto &change : changes) {
+            if (change.joined) {
+                group.addMember(change.userId, change.timestamp);
+            } else {
+                group.removeMember(change.userId, change.timestamp);
+            }
+        }
+    } catch (const std::invalid_argument &ex) {
+        throw std::runtime_error(std::string("Invalid membership history: ") + ex.what());
+    }
+    if (group.memberIds_.size() != current.size()) {
+        throw std::runtime_error("Group " + id + " lists a member twice");
+    }
+    // Restore the saved member order, which swap-removals during the replay do not preserve.
+    group.memberIds_ = current;
+    for (std::size_t i = 0; i < current.size(); ++i) {
+        group.members_.at(current[i]).position = i;
+    }
+    return group;
+}
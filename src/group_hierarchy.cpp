@@ -0,0 +1,186 @@
+#include "group_hierarchy.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "memory_usage.hpp"
+
+namespace {
+BalanceSheet::BalanceMap ownBalances(const BalanceRankIndex &ranks, const std::string &groupId) {
+    const BalanceRank *rank = ranks.find(groupId);
+    if (rank == nullptr) {
+        return {};
+    }
+    return BalanceSheet::BalanceMap(rank->balances().begin(), rank->balances().end());
+}
+}
+
+std::string GroupHierarchy::parentOf(const std::string &groupId) const {
+    auto it = nodes_.find(groupId);
+    return it == nodes_.end() ? std::string{} : it->second.parent;
+}
+
+std::vector<std::string> GroupHierarchy::childrenOf(const std::string &groupId) const {
+    auto it = nodes_.find(groupId);
+    return it == nodes_.end() ? std::vector<std::string>{} : it->second.children;
+}
+
+void GroupHierarchy::setParent(const std::string &groupId, const std::string &parentId, const BalanceRankIndex &ranks) {
+    if (parentOf(groupId) == parentId) {
+        return;
+    }
+    for (std::string ancestor = parentId; !ancestor.empty(); ancestor = parentOf(ancestor)) {
+        if (ancestor == groupId) {
+            throw std::invalid_argument("Group " + groupId + " cannot be placed under " + parentId +
+                                        ", which is part of its own subtree");
+        }
+    }
+
+    Node &node = nodeFor(groupId, ranks);
+    const BalanceSheet::BalanceMap subtree = node.total.getBalances();
+    if (!node.parent.empty()) {
+        const std::string oldParent = std::exchange(node.parent, std::string{});
+        auto &siblings = nodes_.at(oldParent).children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), groupId));
+        BalanceSheet::BalanceMap removed = subtree;
+        for (auto &[userId, balance] : removed) {
+            balance = -balance;
+        }
+        addToAncestors(oldParent, removed);
+        prune(oldParent);
+    }
+    if (!parentId.empty()) {
+        nodeFor(parentId, ranks).children.push_back(groupId);
+        node.parent = parentId;
+        addToAncestors(parentId, subtree);
+    }
+    prune(groupId);
+}
+
+void GroupHierarchy::apply(const std::string &groupId, const BalanceSheet::BalanceMap &delta) {
+    if (stale_ || delta.empty()) {
+        return;
+    }
+    addToAncestors(groupId, delta);
+}
+
+const BalanceSheet::BalanceMap *GroupHierarchy::rollup(const std::string &groupId) const {
+    auto it = nodes_.find(groupId);
+    return it == nodes_.end() ? nullptr : &it->second.total.getBalances();
+}
+
+std::map<std::string, std::string> GroupHierarchy::parents() const {
+    std::map<std::string, std::string> links;
+    for (const auto &[groupId, node] : nodes_) {
+        if (!node.parent.empty()) {
+            links.emplace(groupId, node.parent);
+        }
+    }
+    return links;
+}
+
+void GroupHierarchy::assign(const std::map<std::string, std::string> &parents) {
+    std::map<std::string, Node> nodes;
+    for (const auto &[groupId, parentId] : parents) {
+        if (parentId.empty()) {
+            continue;
+        }
+        nodes[groupId].parent = parentId;
+        nodes[parentId].children.push_back(groupId);
+    }
+    // A chain longer than the number of groups must revisit one of them.
+    for (const auto &[groupId, node] : nodes) {
+        std::size_t steps = 0;
+        for (std::string ancestor = node.parent; !ancestor.empty(); ancestor = nodes.at(ancestor).parent) {
+            if (++steps > nodes.size()) {
+                throw std::runtime_error("Group hierarchy contains a cycle through group '" + groupId + "'");
+            }
+        }
+    }
+    nodes_ = std::move(nodes);
+    stale_ = true;
+}
+
+void GroupHierarchy::invalidate() {
+    for (auto &[groupId, node] : nodes_) {
+        node.total.clear();
+    }
+    stale_ = true;
+}
+
+void GroupHierarchy::rebuild(const BalanceRankIndex &ranks) {
+    // Depth-first from every root, emitting a group after all of its children.
+    using Entry = std::map<std::string, Node>::iterator;
+    std::vector<Entry> order;
+    order.reserve(nodes_.size());
+    std::vector<std::pair<Entry, std::size_t>> stack;
+    for (auto root = nodes_.begin(); root != nodes_.end(); ++root) {
+        if (!root->second.parent.empty()) {
+            continue;
+        }
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto &[entry, next] = stack.back();
+            if (next < entry->second.children.size()) {
+                Entry child = nodes_.find(entry->second.children[next++]);
+                stack.emplace_back(child, 0);
+            } else {
+                order.push_back(entry);
+                stack.pop_back();
+            }
+        }
+    }
+    for (auto &[groupId, node] : nodes_) {
+        node.total.clear();
+    }
+    // Every child has its complete subtree total by the time it is folded into its parent.
+    for (Entry entry : order) {
+        Node &node = entry->second;
+        node.total.applyDelta(ownBalances(ranks, entry->first));
+        if (!node.parent.empty()) {
+            nodes_.at(node.parent).total.applyDelta(node.total.getBalances());
+        }
+    }
+    stale_ = false;
+}
+
+void GroupHierarchy::clear() {
+    nodes_.clear();
+    stale_ = false;
+}
+
+std::size_t GroupHierarchy::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this);
+    for (const auto &[groupId, node] : nodes_) {
+        bytes += memory::treeNodeBytes<decltype(nodes_)::value_type>() + memory::stringBytes(groupId) +
+                 memory::stringBytes(node.parent) + memory::vectorBytes(node.children) + node.total.memoryBytes() -
+                 sizeof(BalanceSheet);
+        for (const auto &child : node.children) {
+            bytes += memory::stringBytes(child);
+        }
+    }
+    return bytes;
+}
+
+GroupHierarchy::Node &GroupHierarchy::nodeFor(const std::string &groupId, const BalanceRankIndex &ranks) {
+    auto [it, inserted] = nodes_.try_emplace(groupId);
+    if (inserted && !stale_) {
+        it->second.total.applyDelta(ownBalances(ranks, groupId));
+    }
+    return it->second;
+}
+
+void GroupHierarchy::addToAncestors(const std::string &groupId, const BalanceSheet::BalanceMap &delta) {
+    for (auto it = nodes_.find(groupId); it != nodes_.end();) {
+        it->second.total.applyDelta(delta);
+        it = it->second.parent.empty() ? nodes_.end() : nodes_.find(it->second.parent);
+    }
+}
+
+void GroupHierarchy::prune(const std::string &groupId) {
+    auto it = nodes_.find(groupId);
+    if (it != nodes_.end() && it->second.parent.empty() && it->second.children.empty()) {
+        nodes_.erase(it);
+    }
+}
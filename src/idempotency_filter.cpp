@@ -0,0 +1,259 @@
+#include "idempotency_filter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+
+#include "memory_usage.hpp"
+
+namespace {
+constexpr std::size_t kBitsPerKey = 10;  // with 7 probes, about 1% false positives at the expected load
+constexpr unsigned kProbes = 7;
+
+// FNV-1a: stable across builds and platforms, unlike std::hash, so persisted content keys stay meaningful.
+std::uint64_t fnv1a(const std::string &text, std::uint64_t hash = 0xCBF29CE484222325ULL) {
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+std::string shortest(double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
+}
+
+void validate(const DeduplicationOptions &options) {
+    if (options.windowSeconds <= 0) {
+        throw std::invalid_argument("Deduplication window must be positive");
+    }
+    if (options.expectedKeys == 0) {
+        throw std::invalid_argument("Deduplication filter must expect at least one key");
+    }
+}
+}
+
+nlohmann::json IdempotencyRecord::toJson() const {
+    nlohmann::json j;
+    j["key"] = key;
+    j["expense"] = expenseId;
+    j["time"] = static_cast<double>(time);
+    return j;
+}
+
+IdempotencyRecord IdempotencyRecord::fromJson(const nlohmann::json &j) {
+    IdempotencyRecord record;
+    record.key = j.at("key").get<std::string>();
+    record.expenseId = j.at("expense").get<std::string>();
+    record.time = static_cast<std::int64_t>(j.at("time").get<double>());
+    if (record.key.empty()) {
+        throw std::runtime_error("Idempotency key for expense '" + record.expenseId + "' is empty");
+    }
+    return record;
+}
+
+nlohmann::json DeduplicationStats::toJson() const {
+    nlohmann::json j;
+    j["keys"] = static_cast<double>(keys);
+    j["lookups"] = static_cast<double>(lookups);
+    j["duplicates"] = static_cast<double>(duplicates);
+    j["filtered"] = static_cast<double>(filtered);
+    j["falsePositives"] = static_cast<double>(falsePositives);
+    j["bytes"] = static_cast<double>(bytes);
+    return j;
+}
+
+void IdempotencyFilter::BloomFilter::add(std::uint64_t hash, std::size_t expectedKeys) {
+    if (words_.empty()) {
+        words_.assign((expectedKeys * kBitsPerKey + 63) / 64, 0);
+    }
+    const std::uint64_t bits = words_.size() * 64;
+    const std::uint64_t step = mix(hash) | 1;
+    for (unsigned i = 0; i < kProbes; ++i, hash += step) {
+        const std::uint64_t bit = hash % bits;
+        words_[bit / 64] |= std::uint64_t{1} << (bit % 64);
+    }
+}
+
+bool IdempotencyFilter::BloomFilter::mayContain(std::uint64_t hash) const noexcept {
+    if (words_.empty()) {
+        return false;
+    }
+    const std::uint64_t bits = words_.size() * 64;
+    const std::uint64_t step = mix(hash) | 1;
+    for (unsigned i = 0; i < kProbes; ++i, hash += step) {
+        const std::uint64_t bit = hash % bits;
+        if ((words_[bit / 64] & (std::uint64_t{1} << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IdempotencyFilter::BloomFilter::clear() noexcept {
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+std::size_t IdempotencyFilter::BloomFilter::memoryBytes() const noexcept {
+    return memory::vectorBytes(words_);
+}
+
+IdempotencyFilter::IdempotencyFilter(DeduplicationOptions options) : options_(options) {
+    validate(options_);
+}
+
+void IdempotencyFilter::configure(const DeduplicationOptions &options) {
+    validate(options);
+    options_ = options;
+    // A new size or window invalidates both the bit arrays and the generation boundaries.
+    current_ = BloomFilter{};
+    previous_ = BloomFilter{};
+    rebuildFilters();
+}
+
+const std::string *IdempotencyFilter::find(const std::string &key, std::int64_t now) {
+    advance(now);
+    ++lookups_;
+    const std::uint64_t hash = fnv1a(key);
+    if (!current_.mayContain(hash) && !previous_.mayContain(hash)) {
+        ++filtered_;
+        return nullptr;
+    }
+    auto it = keys_.find(key);
+    if (it == keys_.end()) {
+        ++falsePositives_;
+        return nullptr;
+    }
+    ++duplicates_;
+    return &it->second.expenseId;
+}
+
+void IdempotencyFilter::insert(const std::string &key, const std::string &expenseId, std::int64_t time) {
+    advance(time);
+    auto [it, inserted] = keys_.try_emplace(key, Entry{expenseId, clock_});
+    if (!inserted) {
+        return;
+    }
+    order_.emplace_back(clock_, &it->first);
+    current_.add(fnv1a(key), options_.expectedKeys);
+}
+
+std::vector<IdempotencyRecord> IdempotencyFilter::records() const {
+    std::vector<IdempotencyRecord> records;
+    records.reserve(order_.size());
+    for (const auto &[time, key] : order_) {
+        records.push_back({*key, keys_.at(*key).expenseId, time});
+    }
+    return records;
+}
+
+void IdempotencyFilter::restore(const std::vector<IdempotencyRecord> &records) {
+    clear();
+    for (const auto &record : records) {
+        auto [it, inserted] = keys_.try_emplace(record.key, Entry{record.expenseId, std::max(record.time, clock_)});
+        if (inserted) {
+            clock_ = it->second.time;
+            order_.emplace_back(clock_, &it->first);
+        }
+    }
+    rebuildFilters();
+}
+
+void IdempotencyFilter::clear() {
+    keys_.clear();
+    order_.clear();
+    current_.clear();
+    previous_.clear();
+    generationStart_ = 0;
+    clock_ = 0;
+}
+
+DeduplicationStats IdempotencyFilter::stats() const {
+    DeduplicationStats stats;
+    stats.keys = keys_.size();
+    stats.lookups = lookups_;
+    stats.duplicates = duplicates_;
+    stats.filtered = filtered_;
+    stats.falsePositives = falsePositives_;
+    stats.bytes = memoryBytes();
+    return stats;
+}
+
+std::size_t IdempotencyFilter::memoryBytes() const noexcept {
+    // A deque allocates its elements in 512-byte blocks.
+    constexpr std::size_t perBlock = 512 / sizeof(decltype(order_)::value_type);
+    std::size_t bytes = sizeof(*this) + memory::bucketBytes(keys_) + current_.memoryBytes() +
+                        previous_.memoryBytes() +
+                        (order_.size() / perBlock + 1) * memory::allocationBytes(512);
+    for (const auto &[key, entry] : keys_) {
+        bytes += memory::hashNodeBytes<decltype(keys_)::value_type>() + memory::stringBytes(key) +
+                 memory::stringBytes(entry.expenseId);
+    }
+    return bytes;
+}
+
+std::string IdempotencyFilter::contentKey(const std::string &groupId,
+                                          const SplitInput &input,
+                                          const std::string &strategy) {
+    std::vector<std::string> shares;
+    shares.reserve(input.participantIds.size());
+    for (std::size_t i = 0; i < input.participantIds.size(); ++i) {
+        std::string share = input.participantIds[i];
+        if (i < input.exactShares.size()) {
+            share += '=' + shortest(input.exactShares[i]);
+        } else if (i < input.percentShares.size()) {
+            share += '%' + shortest(input.percentShares[i]);
+        }
+        shares.push_back(std::move(share));
+    }
+    std::sort(shares.begin(), shares.end());
+
+    // Fields are separated by a byte that cannot appear in ids, amounts or strategy names.
+    std::string canonical = groupId + '\x1f' + input.payerId + '\x1f' + shortest(input.amount) + input.currency +
+                            '\x1f' + strategy;
+    for (const auto &share : shares) {
+        canonical += '\x1f' + share;
+    }
+    char digest[17];
+    std::snprintf(digest, sizeof(digest), "%016llx", static_cast<unsigned long long>(fnv1a(canonical)));
+    return std::string("hash:") + digest;
+}
+
+void IdempotencyFilter::advance(std::int64_t now) {
+    clock_ = std::max(clock_, now);
+    const std::int64_t window = options_.windowSeconds;
+    while (!order_.empty() && clock_ - order_.front().first >= window) {
+        keys_.erase(*order_.front().second);
+        order_.pop_front();
+    }
+    // A generation is dropped one full window after it stopped accepting keys, once all of them have expired.
+    const std::int64_t age = clock_ - generationStart_;
+    if (age >= window && age - window >= window) {
+        current_.clear();
+        previous_.clear();
+        generationStart_ = clock_;
+    } else if (age >= window) {
+        std::swap(previous_, current_);
+        current_.clear();
+        generationStart_ += window;
+    }
+}
+
+void IdempotencyFilter::rebuildFilters() {
+    // Every remembered key was ingested at or before the clock, so one generation starting there holds them all.
+    current_.clear();
+    previous_.clear();
+    generationStart_ = clock_;
+    for (const auto &[key, entry] : keys_) {
+        current_.add(fnv1a(key), options_.expectedKeys);
+    }
+}
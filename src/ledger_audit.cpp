@@ -0,0 +1,119 @@
+#include "ledger_audit.hpp"
+
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+constexpr std::size_t AUDIT_GRAIN = 32 * 1024;
+
+/**
+ * @brief Compensated sums accumulated over one chunk of expenses.
+ */
+struct Partial {
+    // currency -> user -> balance
+    std::map<std::string, std::unordered_map<std::string, CompensatedSum>> users;
+    // (currency, group) -> net of every split in the group
+    std::map<std::pair<std::string, std::string>, CompensatedSum> groups;
+};
+}
+
+void CompensatedSum::add(double value) noexcept {
+    const double total = sum_ + value;
+    if (std::fabs(sum_) >= std::fabs(value)) {
+        compensation_ += (sum_ - total) + value;
+    } else {
+        compensation_ += (value - total) + sum_;
+    }
+    sum_ = total;
+}
+
+void CompensatedSum::add(const CompensatedSum &other) noexcept {
+    add(other.sum_);
+    add(other.compensation_);
+}
+
+LedgerRecount recountLedger(const std::vector<Expense> &expenses,
+                            const std::string &baseCurrency,
+                            double tolerance,
+                            ThreadPool *pool) {
+    Partial total = parallelReduce(
+        pool, expenses.size(), AUDIT_GRAIN, Partial{},
+        [&](std::size_t begin, std::size_t end) {
+            Partial part;
+            for (std::size_t i = begin; i < end; ++i) {
+                const Expense &expense = expenses[i];
+                const std::string &code = expense.getInput().currency;
+                const std::string &currency = code.empty() ? baseCurrency : code;
+                auto &users = part.users[currency];
+                auto &group = part.groups[{currency, expense.getGroupId()}];
+                for (const auto &[userId, delta] : expense.getStrategy()->computeSplits(expense.getInput())) {
+                    users[userId].add(delta);
+                    group.add(delta);
+                }
+            }
+            return part;
+        },
+        [](Partial merged, Partial part) {
+            for (auto &[currency, users] : part.users) {
+                auto &target = merged.users[currency];
+                for (const auto &[userId, sum] : users) {
+                    target[userId].add(sum);
+                }
+            }
+            for (const auto &[key, sum] : part.groups) {
+                merged.groups[key].add(sum);
+            }
+            return merged;
+        });
+
+    LedgerRecount recount;
+    for (const auto &[currency, users] : total.users) {
+        auto &balances = recount.balances[currency];
+        for (const auto &[userId, sum] : users) {
+            balances.emplace(userId, sum.value());
+        }
+        CompensatedSum net;
+        for (const auto &[userId, balance] : balances) {
+            net.add(balance);
+        }
+        if (std::fabs(net.value()) > tolerance) {
+            recount.violations.push_back({std::string{}, currency, net.value()});
+        }
+    }
+    for (const auto &[key, sum] : total.groups) {
+        if (std::fabs(sum.value()) > tolerance) {
+            recount.violations.push_back({key.second, key.first, sum.value()});
+        }
+    }
+    return recount;
+}
+
+std::vector<BalanceDiscrepancy> diffBalances(const std::string &currency,
+                                             const BalanceSheet::BalanceMap &expected,
+                                             const BalanceSheet::BalanceMap &recorded,
+                                             double tolerance) {
+    std::vector<BalanceDiscrepancy> result;
+    auto report = [&](const std::string &userId, double want, double have) {
+        if (std::fabs(want - have) > tolerance) {
+            result.push_back({currency, userId, want, have});
+        }
+    };
+    // Both maps are ordered by user id, so one merge pass finds every user present in either.
+    auto want = expected.begin();
+    auto have = recorded.begin();
+    while (want != expected.end() || have != recorded.end()) {
+        if (have == recorded.end() || (want != expected.end() && want->first < have->first)) {
+            report(want->first, want->second, 0.0);
+            ++want;
+        } else if (want == expected.end() || have->first < want->first) {
+            report(have->first, 0.0, have->second);
+            ++have;
+        } else {
+            report(want->first, want->second, have->second);
+            ++want;
+            ++have;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,160 @@
+#include "ledger_snapshot.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+std::atomic<unsigned> gTempCounter{0};
+constexpr std::size_t SERIALISE_GRAIN = 4096;
+
+std::runtime_error ioError(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + path + ": " + std::strerror(errno));
+}
+
+void syncDirectoryOf(const std::string &path) {
+    std::size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        // Best effort: the rename is already visible, this only makes it durable across power loss.
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+/**
+ * @brief Everything but the expense records, which `toJson` and `dump` add in their own ways.
+ */
+nlohmann::json skeletonJson(const LedgerSnapshot &snapshot) {
+    nlohmann::json j;
+    j["users"] = nlohmann::json::array();
+    for (const auto &user : snapshot.users) {
+        j["users"].push_back(user.toJson());
+    }
+    j["groups"] = nlohmann::json::array();
+    for (const auto &group : snapshot.groups) {
+        j["groups"].push_back(group.toJson());
+    }
+    if (!snapshot.groupParents.empty()) {
+        j["groupParents"] = nlohmann::json::object_t{};
+        for (const auto &[groupId, parentId] : snapshot.groupParents) {
+            j["groupParents"][groupId] = parentId;
+        }
+    }
+    j["expenses"] = nlohmann::json::array();
+    j["balances"] = snapshot.balances.toJson();
+    if (!snapshot.baseCurrency.empty()) {
+        j["baseCurrency"] = snapshot.baseCurrency;
+    }
+    nlohmann::json counterValues;
+    for (const auto &[prefix, value] : snapshot.counters) {
+        counterValues[prefix] = static_cast<double>(value);
+    }
+    j["counters"] = counterValues;
+    // Ledgers without recurring expenses keep the original layout.
+    if (!snapshot.recurring.empty()) {
+        j["recurring"] = nlohmann::json::array();
+        for (const auto &recurring : snapshot.recurring) {
+            j["recurring"].push_back(recurring.toJson());
+        }
+        j["recurringAsOf"] = static_cast<double>(snapshot.recurringAsOf);
+    }
+    if (snapshot.replicationSequence != 0) {
+        j["replicationSequence"] = static_cast<double>(snapshot.replicationSequence);
+    }
+    if (!snapshot.idempotencyKeys.empty()) {
+        j["idempotencyKeys"] = nlohmann::json::array();
+        for (const auto &record : snapshot.idempotencyKeys) {
+            j["idempotencyKeys"].push_back(record.toJson());
+        }
+    }
+    return j;
+}
+}
+
+nlohmann::json LedgerSnapshot::toJson() const {
+    nlohmann::json j = skeletonJson(*this);
+    for (const auto &expense : expenses) {
+        j["expenses"].push_back(expense.toJson());
+    }
+    return j;
+}
+
+std::string LedgerSnapshot::dump(int indent, ThreadPool *pool) const {
+    std::string text = skeletonJson(*this).dump(indent);
+    if (expenses.empty()) {
+        return text;
+    }
+    // Render each chunk of records exactly as the array element layout of json::dump would, then splice them into
+    // the skeleton's empty array. Keys are escaped when dumped, so the marker can only match the real key.
+    std::vector<std::string> chunks((expenses.size() + SERIALISE_GRAIN - 1) / SERIALISE_GRAIN);
+    const std::string elementIndent(indent > 0 ? 2 * static_cast<std::size_t>(indent) : 0, ' ');
+    parallelFor(pool, expenses.size(), SERIALISE_GRAIN, [&](std::size_t begin, std::size_t end) {
+        std::ostringstream out;
+        for (std::size_t i = begin; i < end; ++i) {
+            out << elementIndent;
+            expenses[i].toJson().dump_to(out, indent, 2);
+            if (i + 1 < expenses.size()) {
+                out << ',';
+            }
+            if (indent > 0) {
+                out << '\n';
+            }
+        }
+        chunks[begin / SERIALISE_GRAIN] = out.str();
+    });
+
+    const std::string marker = indent > 0 ? "\"expenses\": []" : "\"expenses\":[]";
+    const std::size_t at = text.find(marker) + marker.size() - 1;
+    std::string records = indent > 0 ? "\n" : "";
+    for (const auto &chunk : chunks) {
+        records += chunk;
+    }
+    records += std::string(indent > 0 ? static_cast<std::size_t>(indent) : 0, ' ');
+    text.insert(at, records);
+    return text;
+}
+
+void writeFileAtomically(const std::string &path, const std::string &contents) {
+    const std::string temp = path + ".tmp" + std::to_string(::getpid()) + "." + std::to_string(gTempCounter++);
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw ioError("Failed to open file for writing: ", path);
+    }
+    const char *data = contents.data();
+    std::size_t remaining = contents.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            auto error = ioError("Failed to write ", temp);
+            ::close(fd);
+            ::unlink(temp.c_str());
+            throw error;
+        }
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    bool flushed = ::fsync(fd) == 0;
+    flushed = ::close(fd) == 0 && flushed;
+    if (!flushed) {
+        auto error = ioError("Failed to flush ", temp);
+        ::unlink(temp.c_str());
+        throw error;
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        auto error = ioError("Failed to replace ", path);
+        ::unlink(temp.c_str());
+        throw error;
+    }
+    syncDirectoryOf(path);
+}
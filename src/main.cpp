@@ -1,4 +1,7 @@
 #include <algorithm>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -8,6 +11,10 @@
 #include <string>
 #include <vector>
 
+#include "daemon_server.hpp"
+#include "replication_follower.hpp"
+#include "script_runner.hpp"
+#include "shard_coordinator.hpp"
 #include "split_strategy_factory.hpp"
 #include "splitwise_manager.hpp"
 
@@ -23,7 +30,9 @@ void printMenu() {
               << "7. Settle up (greedy)\n"
               << "8. Save to JSON\n"
               << "9. Load from JSON\n"
-              << "10. Exit\n"
+              << "10. Show statistics\n"
+              << "11. Show memory usage\n"
+              << "12. Exit\n"
               << "Select option: "
               << std::flush;
 }
@@ -42,7 +51,7 @@ std::vector<std::string> readIds(const std::string &prompt) {
 }
 
 void printUsers(const SplitwiseManager &manager) {
-    const auto &users = manager.getUsers();
+    const auto users = manager.getUsers();
     if (users.empty()) {
         std::cout << "No users have been created yet.\n";
         return;
@@ -53,12 +62,12 @@ void printUsers(const SplitwiseManager &manager) {
 }
 
 void printGroups(const SplitwiseManager &manager) {
-    const auto &groups = manager.getGroups();
+    const auto groups = manager.getGroups();
     if (groups.empty()) {
         std::cout << "No groups have been created yet.\n";
         return;
     }
-    const auto &users = manager.getUsers();
+    const auto users = manager.getUsers();
     for (const auto &[id, group] : groups) {
         std::cout << "  " << id << ": " << group.getName() << "\n";
         std::cout << "     members: ";
@@ -83,6 +92,52 @@ void printGroups(const SplitwiseManager &manager) {
     }
 }
 
+void printStats(const metrics::ManagerStats &stats) {
+    if (!stats.enabled) {
+        std::cout << "Statistics are disabled in this build (SPLITWISE_ENABLE_METRICS=OFF).\n";
+        return;
+    }
+    auto micros = [](double ns) { return ns / 1000.0; };
+    auto printRow = [&](const std::string &name, const metrics::HistogramSnapshot &h) {
+        std::cout << "  " << std::left << std::setw(16) << name << std::right << std::setw(10) << h.count
+                  << std::setw(12) << micros(h.meanNs) << std::setw(12) << micros(static_cast<double>(h.p50Ns))
+                  << std::setw(12) << micros(static_cast<double>(h.p99Ns))
+                  << std::setw(12) << micros(static_cast<double>(h.maxNs)) << "\n";
+    };
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  " << std::left << std::setw(16) << "operation" << std::right << std::setw(10) << "count"
+              << std::setw(12) << "mean(us)" << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)"
+              << std::setw(12) << "max(us)" << "\n";
+    for (const auto &[name, histogram] : stats.operations) {
+        printRow(name, histogram);
+    }
+    printRow("mutex wait", stats.lockWait);
+    printRow("mutex hold", stats.lockHold);
+    std::cout << "  expenses applied: " << stats.expensesApplied << "\n"
+              << "  balances touched: " << stats.balancesTouched << "\n";
+}
+
+void printMemoryUsage(const memory::MemoryUsage &usage) {
+    auto printRow = [](const std::string &name, const memory::Footprint &footprint) {
+        std::cout << "  " << std::left << std::setw(18) << name << std::right << std::setw(12) << footprint.objects
+                  << std::setw(14) << std::setprecision(1) << static_cast<double>(footprint.bytes) / 1024.0 << "\n";
+    };
+    std::cout << std::fixed;
+    std::cout << "  " << std::left << std::setw(18) << "structure" << std::right << std::setw(12) << "objects"
+              << std::setw(14) << "KiB" << "\n";
+    for (const auto &[name, footprint] : usage.components) {
+        printRow(name, footprint);
+    }
+    printRow("total", usage.total());
+    printRow("last load JSON", usage.lastLoadJson);
+    if (usage.heap.enabled) {
+        std::cout << "  heap: " << usage.heap.liveBytes << " bytes live in " << usage.heap.liveAllocations
+                  << " allocations, peak " << usage.heap.peakBytes << " bytes\n";
+    } else {
+        std::cout << "  Heap tracking is disabled in this build (SPLITWISE_TRACK_ALLOCATIONS=OFF).\n";
+    }
+}
+
 double readAmount(const std::string &prompt) {
     std::cout << prompt;
     std::string line;
@@ -97,9 +152,204 @@ double readAmount(const std::string &prompt) {
         throw std::invalid_argument("Amount must be a non-negative number");
     }
 }
+
+void printUsage() {
+    std::cout << "Usage: splitwise                      interactive menu\n"
+              << "       splitwise --script FILE|-      run commands from FILE or stdin\n"
+              << "                 [--batch-size N]     submit up to N consecutive add-expense commands at once\n"
+              << "                 [--stop-on-error]    abort at the first failing command\n"
+              << "                 [--shards N --shard-dir DIR]\n"
+              << "                                      run against N shard processes kept in DIR\n"
+              << "       splitwise --daemon (--socket PATH | --port N)\n"
+              << "                 [--workers N]        serve one ledger to local clients (0 = one per core)\n"
+              << "                 [--load FILE]        start from a saved ledger\n"
+              << "                 [--shard K/N]        number new ids as shard K of N\n"
+              << "                 [--leader]           log applied operations for followers\n"
+              << "                 [--log-retain N]     operations the leader keeps for followers (default 100000)\n"
+              << "                 [--follow PATH]      replicate the leader at socket PATH and serve reads only\n";
+}
+
+DaemonServer *gDaemon = nullptr;
+
+void stopDaemon(int) {
+    if (gDaemon) {
+        gDaemon->requestStop();
+    }
+}
+
+int runDaemon(int argc, char **argv) {
+    DaemonOptions options;
+    std::string loadPath;
+    std::size_t shard = 0;
+    std::size_t shards = 1;
+    bool leader = false;
+    std::size_t retain = ReplicationLog::kDefaultRetention;
+    std::string leaderSocket;
+    bool haveEndpoint = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--daemon") {
+            continue;
+        } else if (arg == "--socket" && i + 1 < argc) {
+            options.socketPath = argv[++i];
+            haveEndpoint = true;
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.port = static_cast<std::uint16_t>(std::stoul(argv[++i]));
+            haveEndpoint = true;
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.workers = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--load" && i + 1 < argc) {
+            loadPath = argv[++i];
+        } else if (arg == "--leader") {
+            leader = true;
+        } else if (arg == "--log-retain" && i + 1 < argc) {
+            retain = static_cast<std::size_t>(std::stoull(argv[++i]));
+        } else if (arg == "--follow" && i + 1 < argc) {
+            leaderSocket = argv[++i];
+            options.readOnly = true;
+        } else if (arg == "--shard" && i + 1 < argc && std::string(argv[i + 1]).find('/') != std::string::npos) {
+            const std::string spec = argv[++i];
+            shard = std::stoul(spec.substr(0, spec.find('/')));
+            shards = std::stoul(spec.substr(spec.find('/') + 1));
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (!haveEndpoint || (leader && !leaderSocket.empty())) {
+        printUsage();
+        return 2;
+    }
+
+    SplitwiseManager manager;
+    manager.setIdSequence(shard, shards);
+    if (!loadPath.empty()) {
+        manager.loadFromJson(loadPath);
+    }
+    if (leader) {
+        manager.enableReplicationLog(retain);
+    }
+    // A follower catches up from the sequence its loaded ledger (if any) was saved at.
+    std::unique_ptr<ReplicationFollower> follower;
+    if (!leaderSocket.empty()) {
+        follower = std::make_unique<ReplicationFollower>(manager, FollowerOptions{leaderSocket});
+        follower->start();
+    }
+    DaemonServer server(manager, options);
+    gDaemon = &server;
+    std::signal(SIGINT, stopDaemon);
+    std::signal(SIGTERM, stopDaemon);
+    std::cerr << "splitwise daemon listening on "
+              << (options.socketPath.empty() ? "127.0.0.1" : options.socketPath) << "\n";
+    server.run();
+    gDaemon = nullptr;
+    if (follower) {
+        follower->stop();
+    }
+    DaemonStats stats = server.stats();
+    std::cerr << "served " << stats.requestsServed << " request(s) over " << stats.connectionsAccepted
+              << " connection(s)\n";
+    return 0;
+}
+
+int runSharded(const std::string &binary, const std::string &directory, std::size_t shards, std::istream &in) {
+    ShardCoordinator coordinator(ShardSpawnOptions{binary, directory, shards, 1});
+    std::size_t commands = 0;
+    std::size_t errors = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        ++commands;
+        protocol::Response response = coordinator.execute(line);
+        errors += response.ok ? 0 : 1;
+        std::cout << response.body;
+    }
+    std::cout.flush();
+    if (errors) {
+        std::cerr << errors << " of " << commands << " command(s) failed\n";
+    }
+    return errors ? 1 : 0;
+}
+
+int runScript(int argc, char **argv) {
+    std::string scriptPath;
+    ScriptOptions options;
+    std::size_t shards = 0;
+    std::string shardDir;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--script" && i + 1 < argc) {
+            scriptPath = argv[++i];
+        } else if (arg == "--batch-size" && i + 1 < argc) {
+            options.batchSize = std::stoul(argv[++i]);
+        } else if (arg == "--stop-on-error") {
+            options.stopOnError = true;
+        } else if (arg == "--shards" && i + 1 < argc) {
+            shards = std::stoul(argv[++i]);
+        } else if (arg == "--shard-dir" && i + 1 < argc) {
+            shardDir = argv[++i];
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+    if (scriptPath.empty() || (shards > 0) != !shardDir.empty()) {
+        printUsage();
+        return 2;
+    }
+    if (shards > 0) {
+        // Workers are this same executable started in daemon mode.
+        std::error_code error;
+        std::filesystem::path binary = std::filesystem::read_symlink("/proc/self/exe", error);
+        const std::string self = error ? std::string(argv[0]) : binary.string();
+        if (scriptPath == "-") {
+            return runSharded(self, shardDir, shards, std::cin);
+        }
+        std::ifstream in(scriptPath);
+        if (!in) {
+            std::cerr << "Error: failed to open script: " << scriptPath << "\n";
+            return 2;
+        }
+        return runSharded(self, shardDir, shards, in);
+    }
+
+    std::ios::sync_with_stdio(false);
+    SplitwiseManager manager;
+    ScriptRunner runner(manager, std::cout, options);
+    ScriptSummary summary;
+    if (scriptPath == "-") {
+        summary = runner.run(std::cin);
+    } else {
+        std::ifstream in(scriptPath);
+        if (!in) {
+            std::cerr << "Error: failed to open script: " << scriptPath << "\n";
+            return 2;
+        }
+        summary = runner.run(in);
+    }
+    if (summary.errors) {
+        std::cerr << summary.errors << " of " << summary.commands << " command(s) failed\n";
+    }
+    return summary.errors ? 1 : 0;
+}
 }
 
-int main() {
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        try {
+            if (std::find(argv + 1, argv + argc, std::string("--daemon")) != argv + argc) {
+                return runDaemon(argc, argv);
+            }
+            return runScript(argc, argv);
+        } catch (const std::exception &ex) {
+            std::cerr << "Error: " << ex.what() << "\n";
+            return 2;
+        }
+    }
+
     SplitwiseManager manager;
     manager.setNotifier(std::make_shared<ConsoleNotifier>());
     manager.setNotificationThreshold(std::numeric_limits<double>::infinity());
@@ -180,8 +430,9 @@ int main() {
                 std::cout << "Enter strategy (equal/exact/percent): ";
                 std::string strategyType;
                 std::getline(std::cin, strategyType);
-                auto itGroup = manager.getGroups().find(groupId);
-                if (itGroup == manager.getGroups().end()) {
+                const auto groups = manager.getGroups();
+                auto itGroup = groups.find(groupId);
+                if (itGroup == groups.end()) {
                     std::cout << "Unknown group id.\n";
                     break;
                 }
@@ -230,9 +481,10 @@ int main() {
                     break;
                 }
                 std::cout << std::fixed << std::setprecision(2);
+                const auto users = manager.getUsers();
                 for (const auto &[userId, balance] : balances) {
-                    auto it = manager.getUsers().find(userId);
-                    const std::string &name = it != manager.getUsers().end() ? it->second.getName() : userId;
+                    auto it = users.find(userId);
+                    const std::string &name = it != users.end() ? it->second.getName() : userId;
                     std::cout << name << " (" << userId << "): " << balance << "\n";
                 }
                 break;
@@ -244,8 +496,8 @@ int main() {
                     break;
                 }
                 std::cout << std::fixed << std::setprecision(2);
+                const auto users = manager.getUsers();
                 for (const auto &tx : settlements) {
-                    const auto &users = manager.getUsers();
                     std::string fromName = users.count(tx.fromUserId) ? users.at(tx.fromUserId).getName() : tx.fromUserId;
                     std::string toName = users.count(tx.toUserId) ? users.at(tx.toUserId).getName() : tx.toUserId;
                     std::cout << fromName << " -> " << toName << ": " << tx.amount << "\n";
@@ -268,7 +520,15 @@ int main() {
                 std::cout << "State loaded.\n";
                 break;
             }
-            case 10:
+            case 10: {
+                printStats(manager.getStats());
+                break;
+            }
+            case 11: {
+                printMemoryUsage(manager.memoryUsage());
+                break;
+            }
+            case 12:
                 running = false;
                 break;
             default:
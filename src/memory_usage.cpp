@@ -0,0 +1,168 @@
+#include "memory_usage.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace memory {
+
+nlohmann::json Footprint::toJson() const {
+    nlohmann::json j;
+    j["objects"] = static_cast<double>(objects);
+    j["bytes"] = static_cast<double>(bytes);
+    return j;
+}
+
+nlohmann::json HeapStats::toJson() const {
+    nlohmann::json j;
+    j["enabled"] = enabled;
+    j["liveBytes"] = static_cast<double>(liveBytes);
+    j["peakBytes"] = static_cast<double>(peakBytes);
+    j["liveAllocations"] = static_cast<double>(liveAllocations);
+    j["totalAllocations"] = static_cast<double>(totalAllocations);
+    return j;
+}
+
+Footprint MemoryUsage::total() const noexcept {
+    Footprint sum;
+    for (const auto &[name, footprint] : components) {
+        sum += footprint;
+    }
+    return sum;
+}
+
+nlohmann::json MemoryUsage::toJson() const {
+    nlohmann::json j;
+    nlohmann::json parts;
+    for (const auto &[name, footprint] : components) {
+        parts[name] = footprint.toJson();
+    }
+    j["components"] = parts;
+    j["total"] = total().toJson();
+    j["lastLoadJson"] = lastLoadJson.toJson();
+    j["heap"] = heap.toJson();
+    return j;
+}
+
+} // namespace memory
+
+#if SPLITWISE_TRACK_ALLOCATIONS
+
+namespace {
+struct HeapCounters {
+    std::atomic<std::uint64_t> liveBytes{0};
+    std::atomic<std::uint64_t> peakBytes{0};
+    std::atomic<std::uint64_t> liveAllocations{0};
+    std::atomic<std::uint64_t> totalAllocations{0};
+};
+
+// Constant-initialised, so allocations made during static initialisation are counted too.
+HeapCounters gCounters;
+
+constexpr std::size_t kHeader = alignof(std::max_align_t);
+
+// Every block carries its requested size in the word just before the pointer handed out, so frees can be subtracted
+// without asking the allocator.
+void *track(void *raw, std::size_t offset, std::size_t size) noexcept {
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    auto *user = static_cast<unsigned char *>(raw) + offset;
+    reinterpret_cast<std::size_t *>(user)[-1] = size;
+    const std::uint64_t live = gCounters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::uint64_t peak = gCounters.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !gCounters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    gCounters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    gCounters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    return user;
+}
+
+void *untrack(void *user, std::size_t offset) noexcept {
+    auto *bytes = static_cast<unsigned char *>(user);
+    gCounters.liveBytes.fetch_sub(reinterpret_cast<std::size_t *>(bytes)[-1], std::memory_order_relaxed);
+    gCounters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+    return bytes - offset;
+}
+
+void *allocate(std::size_t size) noexcept {
+    return track(std::malloc(size + kHeader), kHeader, size);
+}
+
+void *allocateAligned(std::size_t size, std::size_t alignment) noexcept {
+    const std::size_t offset = alignment > kHeader ? alignment : kHeader;
+    const std::size_t total = (size + offset + alignment - 1) / alignment * alignment;
+    return track(std::aligned_alloc(alignment, total), offset, size);
+}
+
+void release(void *user) noexcept {
+    if (user != nullptr) {
+        std::free(untrack(user, kHeader));
+    }
+}
+
+void releaseAligned(void *user, std::size_t alignment) noexcept {
+    if (user != nullptr) {
+        std::free(untrack(user, alignment > kHeader ? alignment : kHeader));
+    }
+}
+
+void *allocateOrThrow(std::size_t size) {
+    void *p = allocate(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *allocateAlignedOrThrow(std::size_t size, std::align_val_t alignment) {
+    void *p = allocateAligned(size, static_cast<std::size_t>(alignment));
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+}
+
+memory::HeapStats memory::heapStats() noexcept {
+    HeapStats stats;
+    stats.liveBytes = gCounters.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = gCounters.peakBytes.load(std::memory_order_relaxed);
+    stats.liveAllocations = gCounters.liveAllocations.load(std::memory_order_relaxed);
+    stats.totalAllocations = gCounters.totalAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void *operator new(std::size_t size) { return allocateOrThrow(size); }
+void *operator new[](std::size_t size) { return allocateOrThrow(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, alignment); }
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t alignment) noexcept {
+    releaseAligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *p, std::align_val_t alignment) noexcept {
+    releaseAligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *p, std::size_t, std::align_val_t alignment) noexcept {
+    releaseAligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *p, std::size_t, std::align_val_t alignment) noexcept {
+    releaseAligned(p, static_cast<std::size_t>(alignment));
+}
+
+#else
+
+memory::HeapStats memory::heapStats() noexcept {
+    return {};
+}
+
+#endif
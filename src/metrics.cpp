@@ -0,0 +1,187 @@
+#include "metrics.hpp"
+
+namespace metrics {
+
+const char *operationName(Operation op) noexcept {
+    switch (op) {
+    case Operation::AddUser: return "addUser";
+    case Operation::AddGroup: return "addGroup";
+    case Operation::AddExpense: return "addExpense";
+    case Operation::AddExpenses: return "addExpenses";
+    case Operation::UpdateExpense: return "updateExpense";
+    case Operation::DeleteExpense: return "deleteExpense";
+    case Operation::SettleUpGreedy: return "settleUpGreedy";
+    case Operation::SaveToJson: return "saveToJson";
+    case Operation::LoadFromJson: return "loadFromJson";
+    case Operation::Count: break;
+    }
+    return "unknown";
+}
+
+nlohmann::json HistogramSnapshot::toJson() const {
+    nlohmann::json j;
+    j["count"] = static_cast<double>(count);
+    j["meanNs"] = meanNs;
+    j["minNs"] = static_cast<double>(minNs);
+    j["p50Ns"] = static_cast<double>(p50Ns);
+    j["p90Ns"] = static_cast<double>(p90Ns);
+    j["p99Ns"] = static_cast<double>(p99Ns);
+    j["p999Ns"] = static_cast<double>(p999Ns);
+    j["maxNs"] = static_cast<double>(maxNs);
+    return j;
+}
+
+nlohmann::json ManagerStats::toJson() const {
+    nlohmann::json j;
+    j["enabled"] = enabled;
+    nlohmann::json ops;
+    for (const auto &[name, histogram] : operations) {
+        ops[name] = histogram.toJson();
+    }
+    j["operations"] = ops;
+    nlohmann::json lock;
+    lock["wait"] = lockWait.toJson();
+    lock["hold"] = lockHold.toJson();
+    j["mutex"] = lock;
+    j["expensesApplied"] = static_cast<double>(expensesApplied);
+    j["balancesTouched"] = static_cast<double>(balancesTouched);
+    return j;
+}
+
+#if SPLITWISE_ENABLE_METRICS
+
+namespace {
+std::size_t stripeForThisThread() noexcept {
+    static std::atomic<std::size_t> nextStripe{0};
+    thread_local const std::size_t stripe =
+        nextStripe.fetch_add(1, std::memory_order_relaxed) % LatencyHistogram::kStripes;
+    return stripe;
+}
+
+int highestBit(std::uint64_t value) noexcept {
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+
+std::uint64_t elapsedNs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t valueNs) noexcept {
+    if (valueNs < kSubBuckets) {
+        return static_cast<std::size_t>(valueNs);
+    }
+    auto exponent = static_cast<std::size_t>(highestBit(valueNs));
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    std::size_t sub = static_cast<std::size_t>(valueNs >> (exponent - kSubBucketBits)) - kSubBuckets;
+    return kSubBuckets + (exponent - kSubBucketBits) * kSubBuckets + sub;
+}
+
+std::uint64_t LatencyHistogram::bucketLowerBound(std::size_t index) noexcept {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    std::size_t offset = index - kSubBuckets;
+    std::size_t exponent = offset / kSubBuckets + kSubBucketBits;
+    std::uint64_t sub = offset % kSubBuckets;
+    return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index) noexcept {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    std::size_t exponent = (index - kSubBuckets) / kSubBuckets + kSubBucketBits;
+    return bucketLowerBound(index) + (std::uint64_t{1} << (exponent - kSubBucketBits)) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t valueNs) noexcept {
+    Stripe &stripe = stripes_[stripeForThisThread()];
+    stripe.buckets[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    stripe.count.fetch_add(1, std::memory_order_relaxed);
+    stripe.sum.fetch_add(valueNs, std::memory_order_relaxed);
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    std::array<std::uint64_t, kBucketCount> merged{};
+    std::uint64_t sum = 0;
+    for (const auto &stripe : stripes_) {
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            merged[i] += stripe.buckets[i].load(std::memory_order_relaxed);
+        }
+        sum += stripe.sum.load(std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot result;
+    for (std::uint64_t value : merged) {
+        result.count += value;
+    }
+    if (result.count == 0) {
+        return result;
+    }
+    result.meanNs = static_cast<double>(sum) / static_cast<double>(result.count);
+
+    auto valueAtRank = [&](double quantile) {
+        auto target = static_cast<std::uint64_t>(quantile * static_cast<double>(result.count - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            seen += merged[i];
+            if (seen >= target) {
+                return (bucketLowerBound(i) + bucketUpperBound(i)) / 2;
+            }
+        }
+        return bucketUpperBound(kBucketCount - 1);
+    };
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        if (merged[i]) {
+            result.minNs = bucketLowerBound(i);
+            break;
+        }
+    }
+    for (std::size_t i = kBucketCount; i-- > 0;) {
+        if (merged[i]) {
+            result.maxNs = bucketUpperBound(i);
+            break;
+        }
+    }
+    result.p50Ns = valueAtRank(0.50);
+    result.p90Ns = valueAtRank(0.90);
+    result.p99Ns = valueAtRank(0.99);
+    result.p999Ns = valueAtRank(0.999);
+    return result;
+}
+
+ManagerStats ManagerMetrics::snapshot() const {
+    ManagerStats stats;
+    for (std::size_t i = 0; i < operations_.size(); ++i) {
+        stats.operations[operationName(static_cast<Operation>(i))] = operations_[i].snapshot();
+    }
+    stats.lockWait = lockWait_.snapshot();
+    stats.lockHold = lockHold_.snapshot();
+    stats.expensesApplied = expensesApplied_.load(std::memory_order_relaxed);
+    stats.balancesTouched = balancesTouched_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+TimedLockGuard::TimedLockGuard(std::mutex &mutex, ManagerMetrics &metrics) : mutex_(mutex), metrics_(metrics) {
+    auto requested = std::chrono::steady_clock::now();
+    mutex_.lock();
+    acquired_ = std::chrono::steady_clock::now();
+    metrics_.lockWait().record(elapsedNs(requested, acquired_));
+}
+
+TimedLockGuard::~TimedLockGuard() {
+    auto released = std::chrono::steady_clock::now();
+    mutex_.unlock();
+    metrics_.lockHold().record(elapsedNs(acquired_, released));
+}
+
+#endif
+
+} // namespace metrics
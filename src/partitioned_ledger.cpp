@@ -0,0 +1,260 @@
+#include "partitioned_ledger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include "ledger_snapshot.hpp"
+#include "split_strategy_factory.hpp"
+
+namespace {
+std::string joinPath(const std::string &directory, const std::string &file) {
+    return (std::filesystem::path(directory) / file).string();
+}
+
+nlohmann::json readDocument(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open file for reading: " + path);
+    }
+    nlohmann::json j;
+    in >> j;
+    if (!j.is_object()) {
+        throw std::runtime_error("Invalid JSON format: expected an object at the root of " + path);
+    }
+    return j;
+}
+
+void requireArray(const nlohmann::json &j, const std::string &key) {
+    if (!j.contains(key) || !j.at(key).is_array()) {
+        throw std::runtime_error("Invalid JSON format: '" + key + "' must be an array");
+    }
+}
+}
+
+nlohmann::json GroupManifestEntry::toJson() const {
+    nlohmann::json j;
+    j["id"] = id;
+    j["name"] = name;
+    j["segment"] = segment;
+    j["expenses"] = static_cast<double>(expenseCount);
+    // The JSON layer cannot enumerate object keys, so currencies are listed as an array.
+    j["balances"] = nlohmann::json::array();
+    for (const auto &[currency, balances] : this->balances) {
+        nlohmann::json entry;
+        entry["currency"] = currency;
+        nlohmann::json values;
+        for (const auto &[userId, balance] : balances) {
+            values[userId] = balance;
+        }
+        entry["balances"] = values;
+        j["balances"].push_back(entry);
+    }
+    return j;
+}
+
+GroupManifestEntry GroupManifestEntry::fromJson(const nlohmann::json &j) {
+    GroupManifestEntry entry;
+    entry.id = j.at("id").get<std::string>();
+    entry.name = j.value("name", std::string{});
+    entry.segment = j.at("segment").get<std::string>();
+    entry.expenseCount = static_cast<std::size_t>(j.value("expenses", 0.0));
+    requireArray(j, "balances");
+    for (const auto &currency : j.at("balances")) {
+        entry.balances[currency.at("currency").get<std::string>()] =
+            currency.at("balances").get<BalanceSheet::BalanceMap>();
+    }
+    return entry;
+}
+
+nlohmann::json LedgerManifest::toJson() const {
+    nlohmann::json j;
+    j["version"] = kVersion;
+    if (!baseCurrency.empty()) {
+        j["baseCurrency"] = baseCurrency;
+    }
+    nlohmann::json counterValues;
+    for (const auto &[prefix, value] : counters) {
+        counterValues[prefix] = static_cast<double>(value);
+    }
+    j["counters"] = counterValues;
+    j["latestTimestamp"] = static_cast<double>(latestTimestamp);
+    j["users"] = partitioned::kUsersFile;
+    j["groups"] = nlohmann::json::array();
+    for (const auto &group : groups) {
+        j["groups"].push_back(group.toJson());
+    }
+    if (!groupParents.empty()) {
+        j["groupParents"] = nlohmann::json::object_t{};
+        for (const auto &[groupId, parentId] : groupParents) {
+            j["groupParents"][groupId] = parentId;
+        }
+    }
+    j["recurring"] = nlohmann::json::array();
+    for (const auto &expense : recurring) {
+        j["recurring"].push_back(expense.toJson());
+    }
+    j["recurringAsOf"] = static_cast<double>(recurringAsOf);
+    if (!idempotencyKeys.empty()) {
+        j["idempotencyKeys"] = nlohmann::json::array();
+        for (const auto &record : idempotencyKeys) {
+            j["idempotencyKeys"].push_back(record.toJson());
+        }
+    }
+    if (replicationSequence != 0) {
+        j["replicationSequence"] = static_cast<double>(replicationSequence);
+    }
+    return j;
+}
+
+LedgerManifest LedgerManifest::fromJson(const nlohmann::json &j) {
+    const int version = j.value("version", 0);
+    if (version != kVersion) {
+        throw std::runtime_error("Unsupported partitioned ledger version: " + std::to_string(version));
+    }
+    LedgerManifest manifest;
+    manifest.baseCurrency = j.value("baseCurrency", std::string{});
+    if (j.contains("counters")) {
+        for (const auto &[prefix, value] : j.at("counters").get<std::map<std::string, double>>()) {
+            manifest.counters[prefix] = static_cast<std::size_t>(value);
+        }
+    }
+    manifest.latestTimestamp = static_cast<std::int64_t>(j.value("latestTimestamp", 0.0));
+    requireArray(j, "groups");
+    for (const auto &group : j.at("groups")) {
+        manifest.groups.push_back(GroupManifestEntry::fromJson(group));
+    }
+    if (j.contains("groupParents")) {
+        manifest.groupParents = j.at("groupParents").get<std::map<std::string, std::string>>();
+    }
+    if (j.contains("recurring")) {
+        requireArray(j, "recurring");
+        for (const auto &record : j.at("recurring")) {
+            auto strategy = SplitStrategyFactory::create(record.at("strategy").get<std::string>());
+            manifest.recurring.push_back(RecurringExpense::fromJson(record, strategy));
+        }
+        manifest.recurringAsOf = static_cast<std::int64_t>(j.at("recurringAsOf").get<double>());
+    }
+    if (j.contains("idempotencyKeys")) {
+        requireArray(j, "idempotencyKeys");
+        for (const auto &record : j.at("idempotencyKeys")) {
+            manifest.idempotencyKeys.push_back(IdempotencyRecord::fromJson(record));
+        }
+    }
+    manifest.replicationSequence = static_cast<std::uint64_t>(j.value("replicationSequence", 0.0));
+    return manifest;
+}
+
+nlohmann::json GroupSegment::toJson() const {
+    nlohmann::json j;
+    j["group"] = group.toJson();
+    j["expenses"] = nlohmann::json::array();
+    for (const auto &expense : expenses) {
+        j["expenses"].push_back(expense.toJson());
+    }
+    return j;
+}
+
+GroupSegment GroupSegment::fromJson(const nlohmann::json &j) {
+    GroupSegment segment;
+    segment.group = Group::fromJson(j.at("group"));
+    requireArray(j, "expenses");
+    for (const auto &record : j.at("expenses")) {
+        auto strategy = SplitStrategyFactory::create(record.at("strategy").get<std::string>());
+        Expense expense = Expense::fromJson(record, strategy);
+        if (expense.getGroupId() != segment.group.getId()) {
+            throw std::runtime_error("Expense '" + expense.getId() + "' does not belong to group '" +
+                                     segment.group.getId() + "'");
+        }
+        segment.expenses.push_back(std::move(expense));
+    }
+    return segment;
+}
+
+nlohmann::json PartitionStats::toJson() const {
+    nlohmann::json j;
+    j["open"] = open;
+    j["directory"] = directory;
+    j["groups"] = static_cast<double>(groups);
+    j["residentGroups"] = static_cast<double>(residentGroups);
+    j["residentBytes"] = static_cast<double>(residentBytes);
+    j["budgetBytes"] = static_cast<double>(budgetBytes);
+    j["pageIns"] = static_cast<double>(pageIns);
+    j["evictions"] = static_cast<double>(evictions);
+    j["segmentWrites"] = static_cast<double>(segmentWrites);
+    return j;
+}
+
+namespace partitioned {
+
+std::string segmentFileName(const std::string &groupId) { return "group-" + groupId + ".json"; }
+
+GroupBalanceSummary summarize(const std::vector<Expense> &expenses) {
+    std::map<std::string, BalanceSheet> sheets;
+    for (const auto &expense : expenses) {
+        sheets[expense.getInput().currency].applyDelta(expense.getStrategy()->computeSplits(expense.getInput()));
+    }
+    GroupBalanceSummary summary;
+    for (const auto &[currency, sheet] : sheets) {
+        summary.emplace(currency, sheet.getBalances());
+    }
+    return summary;
+}
+
+LedgerManifest readManifest(const std::string &directory) {
+    return LedgerManifest::fromJson(readDocument(joinPath(directory, kManifestFile)));
+}
+
+void writeManifest(const std::string &directory, const LedgerManifest &manifest) {
+    writeFileAtomically(joinPath(directory, kManifestFile), manifest.toJson().dump(2));
+}
+
+std::vector<User> readUsers(const std::string &directory) {
+    nlohmann::json j = readDocument(joinPath(directory, kUsersFile));
+    requireArray(j, "users");
+    std::vector<User> users;
+    for (const auto &user : j.at("users")) {
+        users.push_back(User::fromJson(user));
+    }
+    return users;
+}
+
+void writeUsers(const std::string &directory, const std::vector<User> &users) {
+    nlohmann::json j;
+    j["users"] = nlohmann::json::array();
+    for (const auto &user : users) {
+        j["users"].push_back(user.toJson());
+    }
+    writeFileAtomically(joinPath(directory, kUsersFile), j.dump(2));
+}
+
+GroupSegment readSegment(const std::string &directory, const std::string &segment) {
+    return GroupSegment::fromJson(readDocument(joinPath(directory, segment)));
+}
+
+void writeSegment(const std::string &directory, const std::string &segment, const GroupSegment &contents) {
+    writeFileAtomically(joinPath(directory, segment), contents.toJson().dump(2));
+}
+
+void copySegment(const std::string &fromDirectory, const std::string &toDirectory, const std::string &segment) {
+    const std::string from = joinPath(fromDirectory, segment);
+    std::ifstream in(from, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to open file for reading: " + from);
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    writeFileAtomically(joinPath(toDirectory, segment), contents.str());
+}
+
+void ensureDirectory(const std::string &directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        throw std::runtime_error("Failed to create directory " + directory + ": " + error.message());
+    }
+}
+
+} // namespace partitioned
@@ -0,0 +1,157 @@
+#include "posting_list.hpp"
+
+#include <algorithm>
+
+#include "memory_usage.hpp"
+
+PostingList::Iterator::Iterator(const PostingList &list) : list_(&list) { enterBlock(0); }
+
+void PostingList::Iterator::enterBlock(std::size_t block) {
+    block_ = block;
+    offset_ = 0;
+    valid_ = block_ < list_->blocks_.size();
+    if (valid_) {
+        value_ = list_->blocks_[block_].first;
+    }
+}
+
+void PostingList::Iterator::next() {
+    if (!valid_) {
+        return;
+    }
+    const Block &block = list_->blocks_[block_];
+    if (offset_ < block.gaps.size()) {
+        value_ += readGap(block.gaps, offset_);
+    } else {
+        enterBlock(block_ + 1);
+    }
+}
+
+void PostingList::Iterator::seek(std::uint32_t target) {
+    if (!valid_ || value_ >= target) {
+        return;
+    }
+    const auto &blocks = list_->blocks_;
+    if (blocks[block_].last < target) {
+        auto it = std::partition_point(blocks.begin() + static_cast<std::ptrdiff_t>(block_) + 1, blocks.end(),
+                                       [target](const Block &block) { return block.last < target; });
+        enterBlock(static_cast<std::size_t>(it - blocks.begin()));
+    }
+    while (valid_ && value_ < target) {
+        next();
+    }
+}
+
+bool PostingList::add(std::uint32_t value) {
+    if (blocks_.empty() || value > blocks_.back().last) {
+        if (blocks_.empty() || blocks_.back().count >= kBlockSize) {
+            blocks_.push_back(Block{value, value, 1, {}});
+        } else {
+            Block &tail = blocks_.back();
+            appendGap(tail.gaps, value - tail.last);
+            tail.last = value;
+            ++tail.count;
+        }
+        ++size_;
+        return true;
+    }
+
+    std::size_t index = findBlock(value);
+    std::vector<std::uint32_t> values = decode(blocks_[index]);
+    auto pos = std::lower_bound(values.begin(), values.end(), value);
+    if (pos != values.end() && *pos == value) {
+        return false;
+    }
+    values.insert(pos, value);
+    if (values.size() > 2 * kBlockSize) {
+        std::size_t half = values.size() / 2;
+        blocks_[index] = encode(values.data(), half);
+        blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(index) + 1,
+                       encode(values.data() + half, values.size() - half));
+    } else {
+        blocks_[index] = encode(values.data(), values.size());
+    }
+    ++size_;
+    return true;
+}
+
+bool PostingList::remove(std::uint32_t value) {
+    if (blocks_.empty() || value > blocks_.back().last) {
+        return false;
+    }
+    std::size_t index = findBlock(value);
+    if (value < blocks_[index].first) {
+        return false;
+    }
+    std::vector<std::uint32_t> values = decode(blocks_[index]);
+    auto pos = std::lower_bound(values.begin(), values.end(), value);
+    if (pos == values.end() || *pos != value) {
+        return false;
+    }
+    values.erase(pos);
+    if (values.empty()) {
+        blocks_.erase(blocks_.begin() + static_cast<std::ptrdiff_t>(index));
+    } else {
+        blocks_[index] = encode(values.data(), values.size());
+    }
+    --size_;
+    return true;
+}
+
+void PostingList::clear() noexcept {
+    blocks_.clear();
+    size_ = 0;
+}
+
+std::size_t PostingList::memoryBytes() const noexcept {
+    std::size_t bytes = sizeof(*this) + memory::vectorBytes(blocks_);
+    for (const auto &block : blocks_) {
+        bytes += memory::vectorBytes(block.gaps);
+    }
+    return bytes;
+}
+
+std::vector<std::uint32_t> PostingList::decode(const Block &block) {
+    std::vector<std::uint32_t> values;
+    values.reserve(block.count + 1);
+    values.push_back(block.first);
+    for (std::size_t offset = 0; offset < block.gaps.size();) {
+        values.push_back(values.back() + readGap(block.gaps, offset));
+    }
+    return values;
+}
+
+PostingList::Block PostingList::encode(const std::uint32_t *values, std::size_t count) {
+    Block block{values[0], values[count - 1], static_cast<std::uint32_t>(count), {}};
+    for (std::size_t i = 1; i < count; ++i) {
+        appendGap(block.gaps, values[i] - values[i - 1]);
+    }
+    block.gaps.shrink_to_fit();
+    return block;
+}
+
+void PostingList::appendGap(std::vector<std::uint8_t> &bytes, std::uint32_t gap) {
+    while (gap >= 0x80) {
+        bytes.push_back(static_cast<std::uint8_t>(gap | 0x80));
+        gap >>= 7;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(gap));
+}
+
+std::uint32_t PostingList::readGap(const std::vector<std::uint8_t> &bytes, std::size_t &offset) {
+    std::uint32_t gap = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        std::uint8_t byte = bytes[offset++];
+        gap |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return gap;
+        }
+    }
+}
+
+std::size_t PostingList::findBlock(std::uint32_t value) const noexcept {
+    // Last block whose first value is <= value (or the first block when value precedes everything).
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), value,
+                               [](std::uint32_t v, const Block &block) { return v < block.first; });
+    return it == blocks_.begin() ? 0 : static_cast<std::size_t>(it - blocks_.begin()) - 1;
+}
@@ -0,0 +1,130 @@
+#include "recurring_expense.hpp"
+
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "memory_usage.hpp"
+
+std::uint64_t RecurrenceSchedule::countUpTo(std::int64_t timestamp) const noexcept {
+    const std::int64_t last = timestamp < end ? timestamp : end;
+    if (last < start || interval <= 0) {
+        return 0;
+    }
+    // Unsigned difference: exact even when start and last are far apart.
+    const std::uint64_t span = static_cast<std::uint64_t>(last) - static_cast<std::uint64_t>(start);
+    return span / static_cast<std::uint64_t>(interval) + 1;
+}
+
+RecurringExpense::RecurringExpense(std::string id,
+                                   std::string groupId,
+                                   std::string description,
+                                   SplitInput input,
+                                   std::shared_ptr<SplitStrategy> strategy,
+                                   RecurrenceSchedule schedule)
+    : id_(std::move(id)),
+      groupId_(std::move(groupId)),
+      description_(std::move(description)),
+      input_(std::move(input)),
+      strategy_(std::move(strategy)),
+      schedule_(schedule) {
+    if (!strategy_) {
+        throw std::invalid_argument("Strategy must not be null");
+    }
+    if (schedule_.interval <= 0) {
+        throw std::invalid_argument("Recurrence interval must be positive");
+    }
+    delta_ = strategy_->computeSplits(input_);
+}
+
+std::uint64_t RecurringExpense::countBetween(std::int64_t after, std::int64_t upTo) const {
+    if (upTo <= after) {
+        return 0;
+    }
+    const std::uint64_t first = schedule_.countUpTo(after);
+    const std::uint64_t last = schedule_.countUpTo(upTo);
+    if (last <= first) {
+        return 0;
+    }
+    const auto skipped = std::distance(skipped_.lower_bound(first), skipped_.lower_bound(last));
+    return last - first - static_cast<std::uint64_t>(skipped);
+}
+
+bool RecurringExpense::hasOccurrence(std::uint64_t index) const {
+    return index < schedule_.countUpTo(schedule_.end) && !skipped_.count(index);
+}
+
+Expense RecurringExpense::occurrence(std::uint64_t index) const {
+    return Expense{occurrenceId(id_, index), groupId_, description_, input_, strategy_,
+                   schedule_.occurrenceTime(index)};
+}
+
+nlohmann::json RecurringExpense::toJson() const {
+    // Same fields as an expense record, with the schedule in place of a single timestamp.
+    nlohmann::json j = Expense{id_, groupId_, description_, input_, strategy_, schedule_.start}.toJson();
+    j["start"] = static_cast<double>(schedule_.start);
+    j["interval"] = static_cast<double>(schedule_.interval);
+    if (schedule_.end != std::numeric_limits<std::int64_t>::max()) {
+        j["end"] = static_cast<double>(schedule_.end);
+    }
+    auto skipped = nlohmann::json::array();
+    for (std::uint64_t index : skipped_) {
+        skipped.push_back(static_cast<double>(index));
+    }
+    j["skipped"] = skipped;
+    return j;
+}
+
+RecurringExpense RecurringExpense::fromJson(const nlohmann::json &j, const std::shared_ptr<SplitStrategy> &strategy) {
+    Expense fields = Expense::fromJson(j, strategy);
+    RecurrenceSchedule schedule;
+    schedule.start = static_cast<std::int64_t>(j.at("start").get<double>());
+    schedule.interval = static_cast<std::int64_t>(j.at("interval").get<double>());
+    if (j.contains("end")) {
+        schedule.end = static_cast<std::int64_t>(j.at("end").get<double>());
+    }
+    RecurringExpense recurring{fields.getId(), fields.getGroupId(), fields.getDescription(), fields.getInput(),
+                               strategy, schedule};
+    if (j.contains("skipped")) {
+        for (double index : j.at("skipped").get<std::vector<double>>()) {
+            recurring.skip(static_cast<std::uint64_t>(index));
+        }
+    }
+    return recurring;
+}
+
+std::size_t RecurringExpense::memoryBytes() const noexcept {
+    using memory::stringBytes;
+    std::size_t bytes = sizeof(*this) + stringBytes(id_) + stringBytes(groupId_) + stringBytes(description_) +
+                        stringBytes(input_.payerId) + stringBytes(input_.currency) +
+                        memory::vectorBytes(input_.participantIds) + memory::vectorBytes(input_.exactShares) +
+                        memory::vectorBytes(input_.percentShares);
+    for (const auto &participantId : input_.participantIds) {
+        bytes += stringBytes(participantId);
+    }
+    bytes += skipped_.size() * memory::treeNodeBytes<std::uint64_t>();
+    for (const auto &[userId, share] : delta_) {
+        bytes += memory::treeNodeBytes<BalanceSheet::BalanceMap::value_type>() + stringBytes(userId);
+    }
+    return bytes;
+}
+
+std::string RecurringExpense::occurrenceId(const std::string &templateId, std::uint64_t index) {
+    return templateId + "#" + std::to_string(index);
+}
+
+bool RecurringExpense::parseOccurrenceId(const std::string &id, std::string &templateId, std::uint64_t &index) {
+    const std::size_t hash = id.rfind('#');
+    if (hash == std::string::npos || hash == 0 || hash + 1 == id.size()) {
+        return false;
+    }
+    const char *end = id.data() + id.size();
+    auto [ptr, ec] = std::from_chars(id.data() + hash + 1, end, index);
+    if (ec != std::errc{} || ptr != end) {
+        return false;
+    }
+    templateId = id.substr(0, hash);
+    return true;
+}
@@ -0,0 +1,120 @@
+#include "replication_follower.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "tracing.hpp"
+
+ReplicationFollower::ReplicationFollower(SplitwiseManager &manager, FollowerOptions options)
+    : manager_(manager), options_(std::move(options)) {}
+
+ReplicationFollower::~ReplicationFollower() { stop(); }
+
+void ReplicationFollower::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    thread_ = std::thread([this] { loop(); });
+}
+
+void ReplicationFollower::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::size_t ReplicationFollower::syncOnce() {
+    tracing::Span span("follower.sync");
+    std::size_t applied = 0;
+    try {
+        if (!client_) {
+            client_ = std::make_unique<DaemonClient>(DaemonClient::connectUnix(options_.leaderSocket));
+        }
+        while (true) {
+            const std::uint64_t sequence = manager_.getReplicationSequence();
+            protocol::Response response =
+                client_->call("log-since " + std::to_string(sequence) + " " + std::to_string(options_.batchSize));
+            if (!response.ok && response.body.find(ReplicationLog::kNotRetained) != std::string::npos) {
+                bootstrap();
+                continue;
+            }
+            if (!response.ok) {
+                throw std::runtime_error("Leader refused log-since " + std::to_string(sequence) + ": " +
+                                         response.body.substr(0, response.body.find('\n')));
+            }
+            const ReplicationBatch batch = ReplicationBatch::decode(response.body);
+            applied += manager_.applyReplicatedBatch(batch);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                connected_ = true;
+                lastError_.clear();
+            }
+            changed_.notify_all();
+            if (batch.operations.empty() || manager_.getReplicationSequence() >= batch.leaderSequence) {
+                return applied;
+            }
+        }
+    } catch (const std::exception &ex) {
+        // Start over on a fresh connection: the old one may hold a half-read response.
+        client_.reset();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connected_ = false;
+            lastError_ = ex.what();
+        }
+        changed_.notify_all();
+        throw;
+    }
+}
+
+void ReplicationFollower::bootstrap() {
+    tracing::Span span("follower.bootstrap");
+    protocol::Response snapshot = client_->call("snapshot");
+    if (!snapshot.ok) {
+        throw std::runtime_error("Leader refused snapshot: " + snapshot.body.substr(0, snapshot.body.find('\n')));
+    }
+    manager_.loadFromJsonText(snapshot.body);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++bootstraps_;
+}
+
+bool ReplicationFollower::waitFor(std::uint64_t sequence, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, timeout, [&] { return manager_.getReplicationSequence() >= sequence; });
+}
+
+bool ReplicationFollower::connected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connected_;
+}
+
+std::size_t ReplicationFollower::bootstraps() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bootstraps_;
+}
+
+std::string ReplicationFollower::lastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastError_;
+}
+
+void ReplicationFollower::loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        lock.unlock();
+        try {
+            syncOnce();
+        } catch (const std::exception &) {
+            // Recorded in lastError(); retried after the poll interval.
+        }
+        lock.lock();
+        changed_.wait_for(lock, options_.pollInterval, [this] { return stopping_; });
+    }
+}
@@ -0,0 +1,96 @@
+#include "replication_log.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "memory_usage.hpp"
+
+std::string ReplicationBatch::encode() const {
+    nlohmann::json j;
+    j["sequence"] = static_cast<double>(leaderSequence);
+    j["time"] = static_cast<double>(leaderTime);
+    auto entries = nlohmann::json::array();
+    for (const auto &entry : operations) {
+        nlohmann::json record;
+        record["sequence"] = static_cast<double>(entry.sequence);
+        record["time"] = static_cast<double>(entry.time);
+        record["operation"] = entry.operation;
+        entries.push_back(record);
+    }
+    j["operations"] = entries;
+    return j.dump();
+}
+
+ReplicationBatch ReplicationBatch::decode(const std::string &text) {
+    ReplicationBatch batch;
+    try {
+        std::istringstream in(text);
+        nlohmann::json j;
+        in >> j;
+        batch.leaderSequence = static_cast<std::uint64_t>(j.at("sequence").get<double>());
+        batch.leaderTime = static_cast<std::int64_t>(j.at("time").get<double>());
+        for (const auto &record : j.at("operations")) {
+            batch.operations.push_back({static_cast<std::uint64_t>(record.at("sequence").get<double>()),
+                                        static_cast<std::int64_t>(record.at("time").get<double>()),
+                                        record.at("operation")});
+        }
+    } catch (const std::exception &ex) {
+        throw std::runtime_error(std::string("Invalid replication batch: ") + ex.what());
+    }
+    return batch;
+}
+
+nlohmann::json ReplicationStatus::toJson() const {
+    nlohmann::json j;
+    j["role"] = role;
+    j["sequence"] = static_cast<double>(sequence);
+    j["leaderSequence"] = static_cast<double>(leaderSequence);
+    j["lagOperations"] = static_cast<double>(lagOperations);
+    j["lagMillis"] = static_cast<double>(lagMillis);
+    return j;
+}
+
+ReplicationLog::ReplicationLog(std::uint64_t start, std::size_t retain) : start_(start), retain_(retain) {
+    if (retain_ == 0) {
+        throw std::invalid_argument("Replication log must retain at least one operation");
+    }
+}
+
+std::uint64_t ReplicationLog::append(nlohmann::json operation, std::int64_t time) {
+    const std::uint64_t sequence = latest() + 1;
+    entries_.push_back({sequence, time, std::move(operation)});
+    if (entries_.size() > retain_) {
+        entries_.pop_front();
+        ++start_;
+    }
+    return sequence;
+}
+
+ReplicationBatch ReplicationLog::after(std::uint64_t sequence, std::size_t limit) const {
+    if (sequence < start_) {
+        throw std::invalid_argument("Operations after " + std::to_string(sequence) +
+                                    " are " + kNotRetained + "; the log starts after " + std::to_string(start_));
+    }
+    if (sequence > latest()) {
+        throw std::invalid_argument("Sequence " + std::to_string(sequence) + " is ahead of the leader at " +
+                                    std::to_string(latest()));
+    }
+    ReplicationBatch batch;
+    batch.leaderSequence = latest();
+    batch.leaderTime = latestTime();
+    const auto first = entries_.begin() + static_cast<std::ptrdiff_t>(sequence - start_);
+    const auto last = first + static_cast<std::ptrdiff_t>(std::min<std::uint64_t>(limit, latest() - sequence));
+    batch.operations.assign(first, last);
+    return batch;
+}
+
+std::size_t ReplicationLog::memoryBytes() const noexcept {
+    // A deque allocates its elements in 512-byte blocks.
+    const std::size_t perBlock = std::max<std::size_t>(1, 512 / sizeof(ReplicatedOperation));
+    std::size_t bytes = (entries_.size() / perBlock + 1) * memory::allocationBytes(perBlock * sizeof(ReplicatedOperation));
+    for (const auto &entry : entries_) {
+        bytes += entry.operation.heap_bytes(memory::allocationBytes);
+    }
+    return bytes;
+}
@@ -0,0 +1,589 @@
+#include "script_runner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "csv_importer.hpp"
+#include "fx_table.hpp"
+#include "split_strategy_factory.hpp"
+#include "tracing.hpp"
+
+namespace {
+constexpr std::size_t FLUSH_THRESHOLD = 64 * 1024;
+
+std::string formatAmount(double value) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.2f", value);
+    return text;
+}
+
+double parseNumber(const std::string &token, const std::string &what) {
+    std::size_t consumed = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(token, &consumed);
+    } catch (const std::exception &) {
+        consumed = 0;
+    }
+    if (consumed != token.size()) {
+        throw std::invalid_argument(what + " must be a number: " + token);
+    }
+    return value;
+}
+
+std::string formatExpense(const Expense &expense) {
+    return expense.getId() + " " + std::to_string(expense.getTimestamp()) + " " + expense.getGroupId() + " " +
+           formatAmount(expense.getInput().amount) + "\n";
+}
+
+std::size_t parseCount(const std::string &token, const std::string &what) {
+    double value = parseNumber(token, what);
+    if (value < 1.0 || value != static_cast<double>(static_cast<std::size_t>(value))) {
+        throw std::invalid_argument(what + " must be a positive integer: " + token);
+    }
+    return static_cast<std::size_t>(value);
+}
+
+// Seconds, or a count with an s/m/h/d/w suffix (30d = thirty days).
+std::int64_t parseInterval(const std::string &token) {
+    static const std::pair<char, std::int64_t> units[] = {
+        {'s', 1}, {'m', 60}, {'h', 3600}, {'d', 86400}, {'w', 604800}};
+    std::int64_t scale = 1;
+    std::string digits = token;
+    for (const auto &[suffix, seconds] : units) {
+        if (!token.empty() && token.back() == suffix) {
+            scale = seconds;
+            digits.pop_back();
+        }
+    }
+    return static_cast<std::int64_t>(parseCount(digits, "Interval")) * scale;
+}
+
+// Commands a read-only runner accepts: none of them changes the ledger.
+bool isQuery(const std::string &command) {
+    static const char *const queries[] = {
+        "recurring",    "expenses-between", "user-expenses", "group-expenses", "balances-as-of", "search",
+        "balances",     "balance-summary",  "top-creditors", "top-debtors",    "rank",           "count-balances",
+        "balances-in",  "settle",           "save",          "save-async",     "wait-saves",     "save-partitioned",
+        "partitions",   "stats",            "memory",        "audit",          "log-since",      "replication",
+        "rollup",       "children",         "dedup-stats",   "snapshot"};
+    return std::find(std::begin(queries), std::end(queries), command) != std::end(queries);
+}
+
+void requireArgs(const std::vector<std::string> &tokens, std::size_t count, const char *usage) {
+    if (tokens.size() < count) {
+        throw std::invalid_argument(std::string("usage: ") + usage);
+    }
+}
+}
+
+std::vector<std::string> tokenizeCommand(const std::string &line) {
+    std::vector<std::string> tokens;
+    std::string current;
+    bool inToken = false;
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '\\' && i + 1 < line.size()) {
+                current.push_back(line[++i]);
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                current.push_back(c);
+            }
+        } else if (c == '"') {
+            quoted = true;
+            inToken = true;
+        } else if (c == ' ' || c == '\t' || c == '\r') {
+            if (inToken) {
+                tokens.push_back(std::move(current));
+                current.clear();
+                inToken = false;
+            }
+        } else {
+            current.push_back(c);
+            inToken = true;
+        }
+    }
+    if (quoted) {
+        throw std::invalid_argument("Unterminated quote");
+    }
+    if (inToken) {
+        tokens.push_back(std::move(current));
+    }
+    return tokens;
+}
+
+ScriptRunner::ScriptRunner(SplitwiseManager &manager, std::ostream &out, ScriptOptions options)
+    : manager_(manager), out_(out), options_(options) {
+    options_.batchSize = std::max<std::size_t>(1, options_.batchSize);
+    buffer_.reserve(FLUSH_THRESHOLD * 2);
+}
+
+ScriptRunner::~ScriptRunner() {
+    try {
+        flush();
+    } catch (...) {
+        // Destructors must not throw; callers wanting errors call flush() explicitly.
+    }
+}
+
+ScriptSummary ScriptRunner::run(std::istream &in) {
+    tracing::Span span("script.run");
+    ScriptSummary summary;
+    std::size_t errorsBefore = errors_;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            ++lineNumber_;
+            continue;
+        }
+        ++summary.commands;
+        execute(line);
+        // Batched expenses report failures when their batch is submitted, so check the running total.
+        if (options_.stopOnError && errors_ != errorsBefore) {
+            break;
+        }
+    }
+    flush();
+    summary.errors = errors_ - errorsBefore;
+    return summary;
+}
+
+bool ScriptRunner::execute(const std::string &line) {
+    ++lineNumber_;
+    std::size_t errorsBefore = errors_;
+    try {
+        auto tokens = tokenizeCommand(line);
+        if (tokens.empty() || tokens.front().rfind('#', 0) == 0) {
+            return true;
+        }
+        if (options_.readOnly && !isQuery(tokens.front())) {
+            throw std::invalid_argument("Command " + tokens.front() + " changes the ledger, which is read-only here");
+        }
+        if (tokens.front() == "add-expense") {
+            queueExpense(tokens);
+        } else {
+            submitPending();
+            dispatch(tokens);
+        }
+    } catch (const std::exception &ex) {
+        reportError(lineNumber_, ex.what());
+    }
+    if (buffer_.size() >= FLUSH_THRESHOLD) {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+    return errors_ == errorsBefore;
+}
+
+void ScriptRunner::flush() {
+    submitPending();
+    if (!buffer_.empty()) {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+    out_.flush();
+}
+
+void ScriptRunner::dispatch(const std::vector<std::string> &tokens) {
+    const std::string &command = tokens.front();
+    if (command == "add-user") {
+        requireArgs(tokens, 2, "add-user NAME");
+        std::string name = tokens[1];
+        for (std::size_t i = 2; i < tokens.size(); ++i) {
+            name += " " + tokens[i];
+        }
+        write(manager_.addUser(name) + "\n");
+    } else if (command == "add-user-id") {
+        requireArgs(tokens, 3, "add-user-id ID NAME");
+        std::string name = tokens[2];
+        for (std::size_t i = 3; i < tokens.size(); ++i) {
+            name += " " + tokens[i];
+        }
+        manager_.addUserWithId(tokens[1], name);
+        write(tokens[1] + "\n");
+    } else if (command == "add-group") {
+        requireArgs(tokens, 3, "add-group NAME MEMBER...");
+        std::vector<std::string> members(tokens.begin() + 2, tokens.end());
+        write(manager_.addGroup(tokens[1], members) + "\n");
+    } else if (command == "add-member" || command == "remove-member") {
+        requireArgs(tokens, 3, "add-member|remove-member GROUP USER [@TIMESTAMP]");
+        const bool add = command == "add-member";
+        const std::string &groupId = tokens[1];
+        const std::string &userId = tokens[2];
+        Group::Epoch epoch = 0;
+        if (tokens.size() > 3 && tokens[3].size() > 1 && tokens[3].front() == '@') {
+            const std::int64_t timestamp = parseTimestamp(tokens[3].substr(1));
+            epoch = add ? manager_.addGroupMember(groupId, userId, timestamp)
+                        : manager_.removeGroupMember(groupId, userId, timestamp);
+        } else {
+            epoch = add ? manager_.addGroupMember(groupId, userId) : manager_.removeGroupMember(groupId, userId);
+        }
+        write("epoch " + std::to_string(epoch) + "\n");
+    } else if (command == "set-parent") {
+        requireArgs(tokens, 2, "set-parent GROUP [PARENT]");
+        manager_.setGroupParent(tokens[1], tokens.size() > 2 ? tokens[2] : std::string{});
+        write("ok\n");
+    } else if (command == "update-expense") {
+        requireArgs(tokens, 6, "update-expense EXPENSE PAYER AMOUNT STRATEGY DESCRIPTION [PARTICIPANT[=SHARE]...]");
+        ExpenseRequest request = parseExpense(tokens, manager_.getExpense(tokens[1]).getGroupId());
+        manager_.updateExpense(tokens[1], request.description, request.input, request.strategy);
+        write("ok\n");
+    } else if (command == "add-recurring") {
+        requireArgs(tokens, 7,
+                    "add-recurring GROUP PAYER AMOUNT STRATEGY DESCRIPTION every=INTERVAL [@START] [until=END] "
+                    "[PARTICIPANT[=SHARE]...]");
+        RecurrenceSchedule schedule;
+        std::vector<std::string> expenseTokens;
+        for (const auto &token : tokens) {
+            if (token.rfind("every=", 0) == 0) {
+                schedule.interval = parseInterval(token.substr(6));
+            } else if (token.rfind("until=", 0) == 0) {
+                schedule.end = parseTimestamp(token.substr(6));
+            } else {
+                expenseTokens.push_back(token);
+            }
+        }
+        if (schedule.interval == 0) {
+            throw std::invalid_argument("add-recurring needs every=INTERVAL");
+        }
+        requireArgs(expenseTokens, 6, "add-recurring GROUP PAYER AMOUNT STRATEGY DESCRIPTION every=INTERVAL");
+        ExpenseRequest request = parseExpense(expenseTokens, expenseTokens[1]);
+        schedule.start = request.timestamp.value_or(std::chrono::duration_cast<std::chrono::seconds>(
+                                                        std::chrono::system_clock::now().time_since_epoch())
+                                                        .count());
+        write(manager_.addRecurringExpense(request.groupId, request.description, request.input, request.strategy,
+                                           schedule) +
+              "\n");
+    } else if (command == "end-recurring") {
+        requireArgs(tokens, 3, "end-recurring TEMPLATE END");
+        manager_.endRecurringExpense(tokens[1], parseTimestamp(tokens[2]));
+        write("ok\n");
+    } else if (command == "accrue") {
+        requireArgs(tokens, 2, "accrue TIMESTAMP");
+        manager_.accrueRecurring(parseTimestamp(tokens[1]));
+        write("ok\n");
+    } else if (command == "recurring") {
+        const std::int64_t asOf = manager_.getRecurringAsOf();
+        for (const auto &recurring : manager_.getRecurringExpenses()) {
+            const RecurrenceSchedule &schedule = recurring.getSchedule();
+            write(recurring.getId() + " " + recurring.getGroupId() + " " + formatAmount(recurring.getInput().amount) +
+                  " every " + std::to_string(schedule.interval) + " from " + std::to_string(schedule.start) +
+                  " accrued " +
+                  std::to_string(recurring.countBetween(std::numeric_limits<std::int64_t>::min(), asOf)) + "\n");
+        }
+    } else if (command == "delete-expense") {
+        requireArgs(tokens, 2, "delete-expense EXPENSE");
+        manager_.deleteExpense(tokens[1]);
+        write("ok\n");
+    } else if (command == "expenses-between") {
+        requireArgs(tokens, 4, "expenses-between GROUP|* FROM TO");
+        std::string groupId = tokens[1] == "*" ? std::string{} : tokens[1];
+        for (const auto &expense :
+             manager_.getExpensesBetween(groupId, parseTimestamp(tokens[2]), parseTimestamp(tokens[3]))) {
+            write(formatExpense(expense));
+        }
+    } else if (command == "user-expenses" || command == "group-expenses") {
+        requireArgs(tokens, 2, "user-expenses|group-expenses ID [CURSOR|-] [LIMIT]");
+        std::string cursor = tokens.size() > 2 && tokens[2] != "-" ? tokens[2] : std::string{};
+        std::size_t limit = tokens.size() > 3 ? parseCount(tokens[3], "Limit") : 100;
+        ExpensePage page = command == "user-expenses" ? manager_.getUserExpenses(tokens[1], cursor, limit)
+                                                      : manager_.getGroupExpenses(tokens[1], cursor, limit);
+        for (const auto &expense : page.expenses) {
+            write(formatExpense(expense));
+        }
+        if (!page.nextCursor.empty()) {
+            write("next " + page.nextCursor + "\n");
+        }
+    } else if (command == "balances-as-of") {
+        requireArgs(tokens, 2, "balances-as-of TIMESTAMP");
+        for (const auto &[userId, balance] : manager_.getBalancesAsOf(parseTimestamp(tokens[1]))) {
+            write(userId + " " + formatAmount(balance) + "\n");
+        }
+    } else if (command == "search") {
+        requireArgs(tokens, 2, "search QUERY [group=GROUP] [user=USER] [limit=N]");
+        std::string groupId;
+        std::string userId;
+        std::size_t limit = 20;
+        for (std::size_t i = 2; i < tokens.size(); ++i) {
+            const std::string &option = tokens[i];
+            if (option.rfind("group=", 0) == 0) {
+                groupId = option.substr(6);
+            } else if (option.rfind("user=", 0) == 0) {
+                userId = option.substr(5);
+            } else if (option.rfind("limit=", 0) == 0) {
+                limit = parseCount(option.substr(6), "Limit");
+            } else {
+                throw std::invalid_argument("Unknown search option: " + option);
+            }
+        }
+        for (const auto &hit : manager_.searchExpenses(tokens[1], limit, groupId, userId)) {
+            char score[32];
+            std::snprintf(score, sizeof(score), "%.3f", hit.score);
+            write(hit.expenseId + " " + score + "\n");
+        }
+    } else if (command == "balances") {
+        for (const auto &[userId, balance] : manager_.getAllBalances()) {
+            write(userId + " " + formatAmount(balance) + "\n");
+        }
+    } else if (command == "balance-summary") {
+        // Full precision, so balances summed from several shards match a single ledger's.
+        nlohmann::json summary = nlohmann::json::object_t{};
+        const BalanceSheet::BalanceMap balances =
+            tokens.size() > 1 ? manager_.getBalancesIn(tokens[1]) : manager_.getAllBalances();
+        for (const auto &[userId, balance] : balances) {
+            summary[userId] = balance;
+        }
+        write(summary.dump() + "\n");
+    } else if (command == "top-creditors" || command == "top-debtors") {
+        requireArgs(tokens, 2, "top-creditors|top-debtors N [GROUP]");
+        const std::size_t n = parseCount(tokens[1], "Count");
+        const std::string groupId = tokens.size() > 2 ? tokens[2] : std::string{};
+        auto ranked = command == "top-creditors" ? manager_.getTopCreditors(n, groupId)
+                                                 : manager_.getTopDebtors(n, groupId);
+        for (const auto &entry : ranked) {
+            write(entry.userId + " " + formatAmount(entry.balance) + "\n");
+        }
+    } else if (command == "rank") {
+        requireArgs(tokens, 2, "rank USER [GROUP]");
+        auto rank = manager_.getBalanceRank(tokens[1], tokens.size() > 2 ? tokens[2] : std::string{});
+        write(rank ? std::to_string(*rank) + "\n" : std::string("none\n"));
+    } else if (command == "count-balances") {
+        requireArgs(tokens, 3, "count-balances LOW HIGH [GROUP]");
+        const std::string groupId = tokens.size() > 3 ? tokens[3] : std::string{};
+        const std::size_t count =
+            manager_.countBalancesBetween(parseNumber(tokens[1], "Low"), parseNumber(tokens[2], "High"), groupId);
+        write(std::to_string(count) + "\n");
+    } else if (command == "rollup") {
+        requireArgs(tokens, 2, "rollup GROUP");
+        for (const auto &[userId, balance] : manager_.getRollupBalances(tokens[1])) {
+            write(userId + " " + formatAmount(balance) + "\n");
+        }
+    } else if (command == "children") {
+        requireArgs(tokens, 2, "children GROUP");
+        for (const auto &child : manager_.getChildGroups(tokens[1])) {
+            write(child + "\n");
+        }
+    } else if (command == "balances-in") {
+        requireArgs(tokens, 2, "balances-in CURRENCY");
+        for (const auto &[userId, balance] : manager_.getBalancesIn(tokens[1])) {
+            write(userId + " " + formatAmount(balance) + "\n");
+        }
+    } else if (command == "base-currency") {
+        requireArgs(tokens, 2, "base-currency CODE");
+        manager_.setBaseCurrency(tokens[1]);
+        write("ok\n");
+    } else if (command == "fx-load") {
+        requireArgs(tokens, 2, "fx-load PATH");
+        auto table = FxTable::load(tokens[1]);
+        manager_.setFxTable(table);
+        write("loaded " + std::to_string(table->size()) + " rates\n");
+    } else if (command == "settle") {
+        auto transfers = tokens.size() > 1 ? manager_.settleUpGreedy(tokens[1]) : manager_.settleUpGreedy();
+        for (const auto &tx : transfers) {
+            write(tx.fromUserId + " " + tx.toUserId + " " + formatAmount(tx.amount) + "\n");
+        }
+    } else if (command == "save") {
+        requireArgs(tokens, 2, "save PATH");
+        manager_.saveToJson(tokens[1]);
+        write("ok\n");
+    } else if (command == "save-async") {
+        requireArgs(tokens, 2, "save-async PATH");
+        manager_.saveAsync(tokens[1]);
+        write("queued\n");
+    } else if (command == "wait-saves") {
+        manager_.waitForSaves();
+        write("ok\n");
+    } else if (command == "load") {
+        requireArgs(tokens, 2, "load PATH");
+        manager_.loadFromJson(tokens[1]);
+        write("ok\n");
+    } else if (command == "save-partitioned") {
+        requireArgs(tokens, 2, "save-partitioned DIR");
+        manager_.savePartitioned(tokens[1]);
+        write("ok\n");
+    } else if (command == "open-partitioned") {
+        requireArgs(tokens, 2, "open-partitioned DIR");
+        manager_.openPartitioned(tokens[1]);
+        write("ok\n");
+    } else if (command == "memory-budget") {
+        requireArgs(tokens, 2, "memory-budget BYTES");
+        const double budget = parseNumber(tokens[1], "Budget");
+        if (budget < 0.0) {
+            throw std::invalid_argument("Budget must not be negative: " + tokens[1]);
+        }
+        manager_.setMemoryBudget(static_cast<std::size_t>(budget));
+        write("ok\n");
+    } else if (command == "partitions") {
+        write(manager_.getPartitionStats().toJson().dump() + "\n");
+    } else if (command == "import-csv") {
+        requireArgs(tokens, 2, "import-csv PATH [field=Header,...]");
+        CsvImportOptions options;
+        if (tokens.size() > 2) {
+            options.mapping = CsvColumnMapping::parse(tokens[2]);
+        }
+        CsvImportReport report = CsvImporter(options).importFile(manager_, tokens[1]);
+        for (const auto &error : report.errors) {
+            ++errors_;
+            write("error: " + tokens[1] + ":" + std::to_string(error.line) + ": " + error.message + "\n");
+        }
+        char summary[160];
+        std::snprintf(summary, sizeof(summary), "imported %zu of %zu rows in %.3f s (%.0f rows/s)\n",
+                      report.imported, report.rows, report.seconds, report.rowsPerSecond());
+        write(summary);
+    } else if (command == "log-since") {
+        requireArgs(tokens, 2, "log-since SEQUENCE [LIMIT]");
+        const double after = parseNumber(tokens[1], "Sequence");
+        if (after < 0.0) {
+            throw std::invalid_argument("Sequence must not be negative: " + tokens[1]);
+        }
+        const std::size_t limit = tokens.size() > 2 ? parseCount(tokens[2], "Limit") : 1000;
+        write(manager_.getReplicatedOperations(static_cast<std::uint64_t>(after), limit).encode() + "\n");
+    } else if (command == "snapshot") {
+        write(manager_.saveToJsonText() + "\n");
+    } else if (command == "replication") {
+        write(manager_.getReplicationStatus().toJson().dump() + "\n");
+    } else if (command == "stats") {
+        write(manager_.getStats().toJson().dump() + "\n");
+    } else if (command == "memory") {
+        write(manager_.memoryUsage().toJson().dump() + "\n");
+    } else if (command == "dedup") {
+        requireArgs(tokens, 2, "dedup WINDOW [content]");
+        DeduplicationOptions options = manager_.getDeduplication();
+        options.windowSeconds = parseInterval(tokens[1]);
+        if (tokens.size() > 2 && tokens[2] != "content") {
+            throw std::invalid_argument("usage: dedup WINDOW [content]");
+        }
+        options.contentKeys = tokens.size() > 2;
+        manager_.setDeduplication(options);
+        write("ok\n");
+    } else if (command == "dedup-stats") {
+        write(manager_.getDeduplicationStats().toJson().dump() + "\n");
+    } else if (command == "audit") {
+        AuditReport report = manager_.audit(tokens.size() > 1 ? tokens[1] : std::string{});
+        auto label = [](const std::string &currency) { return currency.empty() ? std::string("-") : currency; };
+        char line[256];
+        for (const auto &violation : report.zeroSumViolations) {
+            std::snprintf(line, sizeof(line), "zero-sum %s %s %.6f\n",
+                          violation.groupId.empty() ? "*" : violation.groupId.c_str(), label(violation.currency).c_str(),
+                          violation.sum);
+            write(line);
+        }
+        for (const auto *found : {&report.live, &report.persisted}) {
+            for (const auto &discrepancy : *found) {
+                std::snprintf(line, sizeof(line), "%s %s %s expected %.6f recorded %.6f\n",
+                              found == &report.live ? "live" : "persisted", label(discrepancy.currency).c_str(),
+                              discrepancy.userId.c_str(), discrepancy.expected, discrepancy.recorded);
+                write(line);
+            }
+        }
+        std::size_t problems = report.zeroSumViolations.size() + report.live.size() + report.persisted.size();
+        if (problems != 0) {
+            throw std::runtime_error("audit found " + std::to_string(problems) + " problem(s) in " +
+                                     std::to_string(report.expensesChecked) + " expenses");
+        }
+        write("ok " + std::to_string(report.expensesChecked) + " expenses\n");
+    } else {
+        throw std::invalid_argument("Unknown command: " + command);
+    }
+}
+
+void ScriptRunner::queueExpense(const std::vector<std::string> &tokens) {
+    requireArgs(tokens, 6,
+                "add-expense GROUP PAYER AMOUNT STRATEGY DESCRIPTION [@TIMESTAMP] [key=KEY] [PARTICIPANT[=SHARE]...]");
+    pending_.push_back(parseExpense(tokens, tokens[1]));
+    pendingLines_.push_back(lineNumber_);
+    if (pending_.size() >= options_.batchSize) {
+        submitPending();
+    }
+}
+
+ExpenseRequest ScriptRunner::parseExpense(const std::vector<std::string> &tokens, const std::string &groupId) const {
+    ExpenseRequest request;
+    request.groupId = groupId;
+    request.input.payerId = tokens[2];
+    // AMOUNT may carry a currency suffix, e.g. 12.50EUR.
+    const std::string &amount = tokens[3];
+    std::size_t code = amount.size();
+    while (code > 0 && amount[code - 1] >= 'A' && amount[code - 1] <= 'Z') {
+        --code;
+    }
+    request.input.amount = parseNumber(amount.substr(0, code), "Amount");
+    request.input.currency = amount.substr(code);
+    if (request.input.amount < 0.0) {
+        throw std::invalid_argument("Amount cannot be negative");
+    }
+    request.strategy = SplitStrategyFactory::create(tokens[4]);
+    request.description = tokens[5];
+
+    const std::string strategyName = request.strategy->name();
+    for (std::size_t i = 6; i < tokens.size(); ++i) {
+        const std::string &token = tokens[i];
+        if (token.size() > 1 && token.front() == '@') {
+            request.timestamp = parseTimestamp(token.substr(1));
+            continue;
+        }
+        if (token.rfind("key=", 0) == 0) {
+            request.idempotencyKey = token.substr(4);
+            continue;
+        }
+        std::size_t eq = token.find('=');
+        request.input.participantIds.push_back(token.substr(0, eq));
+        if (eq != std::string::npos) {
+            double share = parseNumber(token.substr(eq + 1), "Share");
+            (strategyName == "percent" ? request.input.percentShares : request.input.exactShares).push_back(share);
+        }
+    }
+    if (request.input.participantIds.empty()) {
+        const Group group = manager_.getGroup(request.groupId);
+        request.input.participantIds =
+            request.timestamp ? group.getMemberIdsAt(*request.timestamp) : group.getMemberIds();
+    }
+    auto &participants = request.input.participantIds;
+    if (std::find(participants.begin(), participants.end(), request.input.payerId) == participants.end()) {
+        participants.push_back(request.input.payerId);
+    }
+    return request;
+}
+
+void ScriptRunner::submitPending() {
+    if (pending_.empty()) {
+        return;
+    }
+    if (pending_.size() == 1) {
+        try {
+            write(manager_.addExpense(pending_.front()) + "\n");
+        } catch (const std::exception &ex) {
+            reportError(pendingLines_.front(), ex.what());
+        }
+    } else {
+        auto results = manager_.addExpenses(pending_);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (results[i].ok()) {
+                write(results[i].id + "\n");
+            } else {
+                reportError(pendingLines_[i], results[i].error);
+            }
+        }
+    }
+    pending_.clear();
+    pendingLines_.clear();
+}
+
+void ScriptRunner::reportError(std::size_t line, const std::string &message) {
+    ++errors_;
+    write("error: line " + std::to_string(line) + ": " + message + "\n");
+}
+
+void ScriptRunner::write(const std::string &text) { buffer_ += text; }
@@ -0,0 +1,334 @@
+#include "shard_coordinator.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+#include "script_runner.hpp"
+#include "tracing.hpp"
+
+namespace {
+constexpr auto SPAWN_TIMEOUT = std::chrono::seconds(10);
+constexpr auto SPAWN_POLL = std::chrono::milliseconds(10);
+
+std::string shardPath(const std::string &directory, std::size_t shard, const char *extension) {
+    return (std::filesystem::path(directory) / ("shard-" + std::to_string(shard) + extension)).string();
+}
+
+// Re-quote a token so the shard's tokenizer reads it back unchanged.
+std::string quote(const std::string &token) {
+    std::string quoted = "\"";
+    for (char c : token) {
+        if (c == '"' || c == '\\') {
+            quoted.push_back('\\');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+std::string joinFrom(const std::vector<std::string> &tokens, std::size_t first) {
+    std::string name;
+    for (std::size_t i = first; i < tokens.size(); ++i) {
+        name += (i == first ? "" : " ") + tokens[i];
+    }
+    return name;
+}
+
+std::string formatAmount(double value) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.2f", value);
+    return text;
+}
+
+protocol::Response failure(const std::string &message) { return {0, false, "error: " + message + "\n"}; }
+
+std::string firstLine(const std::string &body) { return body.substr(0, body.find('\n')); }
+}
+
+ShardCoordinator::ShardCoordinator(const std::vector<std::string> &socketPaths) {
+    if (socketPaths.empty()) {
+        throw std::invalid_argument("A sharded ledger needs at least one shard");
+    }
+    shards_.reserve(socketPaths.size());
+    for (const auto &path : socketPaths) {
+        shards_.push_back(DaemonClient::connectUnix(path));
+    }
+}
+
+ShardCoordinator::ShardCoordinator(const ShardSpawnOptions &options) {
+    if (options.shards == 0) {
+        throw std::invalid_argument("A sharded ledger needs at least one shard");
+    }
+    tracing::Span span("shards.spawn");
+    std::filesystem::create_directories(options.directory);
+    try {
+        for (std::size_t k = 0; k < options.shards; ++k) {
+            const std::string socket = shardPath(options.directory, k, ".sock");
+            const std::string ledger = shardPath(options.directory, k, ".json");
+            std::vector<std::string> args{options.binary,
+                                          "--daemon",
+                                          "--socket",
+                                          socket,
+                                          "--shard",
+                                          std::to_string(k) + "/" + std::to_string(options.shards),
+                                          "--workers",
+                                          std::to_string(options.workers)};
+            if (std::filesystem::exists(ledger)) {
+                args.insert(args.end(), {"--load", ledger});
+            }
+            std::vector<char *> argv;
+            for (auto &arg : args) {
+                argv.push_back(arg.data());
+            }
+            argv.push_back(nullptr);
+            std::filesystem::remove(socket);
+
+            // Only async-signal-safe calls between fork and exec: the parent may be multi-threaded.
+            const pid_t pid = ::fork();
+            if (pid < 0) {
+                throw std::runtime_error("Failed to start shard " + std::to_string(k));
+            }
+            if (pid == 0) {
+                ::execv(argv[0], argv.data());
+                ::_exit(127);
+            }
+            workers_.push_back(pid);
+
+            const auto deadline = std::chrono::steady_clock::now() + SPAWN_TIMEOUT;
+            while (true) {
+                try {
+                    shards_.push_back(DaemonClient::connectUnix(socket));
+                    break;
+                } catch (const std::runtime_error &) {
+                    int status = 0;
+                    if (::waitpid(pid, &status, WNOHANG) == pid) {
+                        workers_.pop_back();
+                        throw std::runtime_error("Shard " + std::to_string(k) + " exited before listening on " +
+                                                 socket);
+                    }
+                    if (std::chrono::steady_clock::now() > deadline) {
+                        throw std::runtime_error("Timed out waiting for shard " + std::to_string(k) + " on " +
+                                                 socket);
+                    }
+                    std::this_thread::sleep_for(SPAWN_POLL);
+                }
+            }
+        }
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+}
+
+ShardCoordinator::~ShardCoordinator() { stopWorkers(); }
+
+void ShardCoordinator::stopWorkers() noexcept {
+    shards_.clear();
+    for (pid_t pid : workers_) {
+        ::kill(pid, SIGTERM);
+    }
+    for (pid_t pid : workers_) {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+    }
+    workers_.clear();
+}
+
+std::size_t ShardCoordinator::shardOf(const std::string &id, std::size_t shards) {
+    std::size_t begin = 0;
+    while (begin < id.size() && !std::isdigit(static_cast<unsigned char>(id[begin]))) {
+        ++begin;
+    }
+    std::size_t end = begin;
+    while (end < id.size() && std::isdigit(static_cast<unsigned char>(id[end]))) {
+        ++end;
+    }
+    // Only the remainder matters, so arbitrarily long numbers are reduced digit by digit.
+    std::size_t remainder = 0;
+    bool positive = false;
+    for (std::size_t i = begin; i < end; ++i) {
+        remainder = (remainder * 10 + static_cast<std::size_t>(id[i] - '0')) % shards;
+        positive = positive || id[i] != '0';
+    }
+    if (!positive) {
+        throw std::invalid_argument("Id does not name a shard: " + id);
+    }
+    return (remainder + shards - 1) % shards;
+}
+
+protocol::Response ShardCoordinator::execute(const std::string &command) {
+    tracing::Span span("shards.execute");
+    try {
+        const std::vector<std::string> tokens = tokenizeCommand(command);
+        if (tokens.empty() || tokens.front().rfind('#', 0) == 0) {
+            return {};
+        }
+        const std::string &name = tokens.front();
+        const std::size_t count = shards_.size();
+        auto routeBy = [&](std::size_t index) { return forward(shardOf(tokens.at(index), count), command); };
+
+        if (name == "add-user" || name == "add-user-id") {
+            return replicateUser(tokens, name == "add-user-id");
+        }
+        if (name == "add-group") {
+            const std::size_t shard = nextGroupShard_;
+            nextGroupShard_ = (nextGroupShard_ + 1) % count;
+            return forward(shard, command);
+        }
+        if (name == "add-expense" || name == "add-member" || name == "remove-member" || name == "add-recurring" ||
+            name == "end-recurring" || name == "update-expense" || name == "delete-expense" ||
+            name == "group-expenses" || name == "set-parent" || name == "rollup" || name == "children") {
+            if (tokens.size() < 2) {
+                return forward(0, command);  // the shard reports the usage error
+            }
+            return routeBy(1);
+        }
+        if (name == "expenses-between" && tokens.size() > 1 && tokens[1] != "*") {
+            return routeBy(1);
+        }
+        if ((name == "top-creditors" || name == "top-debtors" || name == "rank") && tokens.size() > 2) {
+            return routeBy(2);
+        }
+        if (name == "count-balances" && tokens.size() > 3) {
+            return routeBy(3);
+        }
+        if (name == "accrue" || name == "base-currency" || name == "fx-load" || name == "dedup") {
+            return broadcast(std::vector<std::string>(count, command));
+        }
+        if ((name == "save" || name == "load") && tokens.size() > 1) {
+            if (name == "save") {
+                std::filesystem::create_directories(tokens[1]);
+            }
+            std::vector<std::string> commands;
+            for (std::size_t k = 0; k < count; ++k) {
+                commands.push_back(name + " " + quote(shardPath(tokens[1], k, ".json")));
+            }
+            return broadcast(commands);
+        }
+        if (name == "balances" || name == "balance-summary") {
+            const BalanceSheet::BalanceMap balances = getAllBalances(tokens.size() > 1 ? tokens[1] : std::string{});
+            std::string body;
+            if (name == "balances") {
+                for (const auto &[userId, balance] : balances) {
+                    body += userId + " " + formatAmount(balance) + "\n";
+                }
+            } else {
+                nlohmann::json summary = nlohmann::json::object_t{};
+                for (const auto &[userId, balance] : balances) {
+                    summary[userId] = balance;
+                }
+                body = summary.dump() + "\n";
+            }
+            return {0, true, body};
+        }
+        if (name == "settle") {
+            std::string body;
+            for (const auto &tx : settleUpGreedy(tokens.size() > 1 ? tokens[1] : std::string{})) {
+                body += tx.fromUserId + " " + tx.toUserId + " " + formatAmount(tx.amount) + "\n";
+            }
+            return {0, true, body};
+        }
+        return failure("Command " + name + " spans shards and is not supported by the coordinator");
+    } catch (const std::exception &ex) {
+        return failure(ex.what());
+    }
+}
+
+BalanceSheet::BalanceMap ShardCoordinator::getAllBalances(const std::string &currency) {
+    tracing::Span span("shards.balances");
+    const std::string command = currency.empty() ? "balance-summary" : "balance-summary " + currency;
+    // Send to every shard before reading any reply, so the shards work at the same time.
+    for (auto &shard : shards_) {
+        shard.send(command);
+    }
+    for (auto &shard : shards_) {
+        shard.flush();
+    }
+    BalanceSheet total;
+    std::string error;
+    for (std::size_t k = 0; k < shards_.size(); ++k) {
+        protocol::Response response = shards_[k].receive();
+        if (!response.ok) {
+            error = error.empty() ? "Shard " + std::to_string(k) + ": " + firstLine(response.body) : error;
+            continue;
+        }
+        std::istringstream body(response.body);
+        nlohmann::json summary;
+        body >> summary;
+        total.applyDelta(summary.get<std::map<std::string, double>>());
+    }
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+    return total.getBalances();
+}
+
+std::vector<SettlementTransaction> ShardCoordinator::settleUpGreedy(const std::string &currency) {
+    const BalanceSheet::BalanceMap balances = getAllBalances(currency);
+    tracing::Span span("shards.settle");
+    return settleGreedy(balances);
+}
+
+protocol::Response ShardCoordinator::forward(std::size_t shard, const std::string &command) {
+    return shards_.at(shard).call(command);
+}
+
+protocol::Response ShardCoordinator::broadcast(const std::vector<std::string> &commands) {
+    for (std::size_t k = 0; k < shards_.size(); ++k) {
+        shards_[k].send(commands[k]);
+    }
+    for (auto &shard : shards_) {
+        shard.flush();
+    }
+    std::vector<protocol::Response> responses;
+    for (auto &shard : shards_) {
+        responses.push_back(shard.receive());
+    }
+    for (const auto &response : responses) {
+        if (!response.ok) {
+            return response;
+        }
+    }
+    return responses.front();
+}
+
+protocol::Response ShardCoordinator::replicateUser(const std::vector<std::string> &tokens, bool explicitId) {
+    if (tokens.size() < (explicitId ? 3u : 2u)) {
+        return forward(0, joinFrom(tokens, 0));  // the shard reports the usage error
+    }
+    const std::string name = joinFrom(tokens, explicitId ? 2 : 1);
+    // Shard 0 assigns the id (or checks a given one); the others copy it.
+    protocol::Response first = forward(0, explicitId ? "add-user-id " + quote(tokens[1]) + " " + quote(name)
+                                                     : "add-user " + quote(name));
+    if (!first.ok) {
+        return first;
+    }
+    const std::string userId = firstLine(first.body);
+    const std::string copy = "add-user-id " + quote(userId) + " " + quote(name);
+    for (std::size_t k = 1; k < shards_.size(); ++k) {
+        shards_[k].send(copy);
+    }
+    for (std::size_t k = 1; k < shards_.size(); ++k) {
+        shards_[k].flush();
+    }
+    for (std::size_t k = 1; k < shards_.size(); ++k) {
+        protocol::Response response = shards_[k].receive();
+        if (!response.ok) {
+            return {0, false, "error: user " + userId + " was not replicated to shard " + std::to_string(k) + ": " +
+                                  firstLine(response.body) + "\n"};
+        }
+    }
+    return first;
+}
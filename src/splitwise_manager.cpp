@@ -1,124 +1,890 @@
 #include "splitwise_manager.hpp"
+#include "tracing.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <exception>
+#include <filesystem>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
-#include <queue>
+#include <limits>
+#include <set>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 #include <nlohmann/json.hpp>
 
 namespace {
 constexpr double EPSILON = 1e-6;
+// Work sizes for the parallel phases: large enough to amortise scheduling, small enough to balance across workers.
+constexpr std::size_t LOAD_GRAIN = 2048;
+constexpr std::size_t SPLIT_GRAIN = 1024;
+constexpr std::size_t SPLIT_WINDOW = 64 * 1024;
+constexpr std::size_t SETTLE_GRAIN = 16 * 1024;
+
+std::int64_t currentTimestamp() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+std::int64_t currentMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// Resident footprint of one expense of a partitioned ledger: the record plus its nodes in the expense map and the
+// global and per-group time indexes.
+std::size_t residentExpenseBytes(const Expense &expense) {
+    return expense.memoryBytes() - sizeof(Expense) +
+           memory::treeNodeBytes<std::pair<const std::string, Expense>>() + memory::stringBytes(expense.getId()) +
+           2 * (memory::treeNodeBytes<ExpenseTimeIndex::Entry>() + memory::stringBytes(expense.getId()));
+}
+
+BalanceSheet::BalanceMap scaledDelta(const BalanceSheet::BalanceMap &delta, double factor) {
+    BalanceSheet::BalanceMap scaled = delta;
+    for (auto &[userId, change] : scaled) {
+        change *= factor;
+    }
+    return scaled;
+}
+
+// Fold `count x delta` of every recurring expense into a recount, flagging templates whose splits do not net to zero.
+void addRecurringToRecount(LedgerRecount &recount,
+                           const std::vector<RecurringExpense> &recurring,
+                           std::int64_t asOf,
+                           const std::string &baseCurrency,
+                           double tolerance) {
+    for (const auto &expense : recurring) {
+        const double count =
+            static_cast<double>(expense.countBetween(std::numeric_limits<std::int64_t>::min(), asOf));
+        const std::string &code = expense.getInput().currency.empty() ? baseCurrency : expense.getInput().currency;
+        CompensatedSum net;
+        for (const auto &[userId, share] : expense.getDelta()) {
+            net.add(share);
+            if (count != 0.0) {
+                recount.balances[code][userId] += share * count;
+            }
+        }
+        if (std::abs(net.value()) > tolerance) {
+            recount.violations.push_back({expense.getGroupId(), code, net.value()});
+        }
+    }
+}
+
+std::size_t residentGroupBytes(const Group &group) {
+    return memory::treeNodeBytes<std::pair<const std::string, Group>>() + memory::stringBytes(group.getId()) +
+           group.memoryBytes();
 }
 
-SplitwiseManager::SplitwiseManager() = default;
+// Current members plus everyone who has left; loads require all of them to be known users.
+std::vector<std::string> everyMemberOf(const Group &group) {
+    std::vector<std::string> members = group.getMemberIds();
+    for (const auto &change : group.getHistory()) {
+        if (!change.joined) {
+            members.push_back(change.userId);
+        }
+    }
+    return members;
+}
+
+// Saved hierarchy links (child -> parent), checked against the groups of the ledger they were read with.
+template <typename Groups>
+const std::map<std::string, std::string> &linkedGroups(const std::map<std::string, std::string> &parents,
+                                                       const Groups &groups) {
+    for (const auto &[groupId, parentId] : parents) {
+        for (const std::string *id : {&groupId, &parentId}) {
+            if (!groups.count(*id)) {
+                throw std::runtime_error("Group hierarchy references unknown group '" + *id + "'");
+            }
+        }
+    }
+    return parents;
+}
+}
+
+SplitwiseManager::SplitwiseManager() : saver_([this](const std::string &path) { saveToJson(path); }) {}
+
+SplitwiseManager::~SplitwiseManager() = default;
 
 std::string SplitwiseManager::addUser(const std::string &name) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddUser);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
     std::string id = generateId("USR");
     users_.emplace(id, User{id, name});
+    usersDirty_ = true;
+    logOperationLocked({{"op", "user"}, {"id", id}, {"name", name}});
     return id;
 }
 
+void SplitwiseManager::addUserWithId(const std::string &userId, const std::string &name) {
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddUser);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (userId.empty() || users_.count(userId)) {
+        throw std::invalid_argument("User id is empty or already taken: " + userId);
+    }
+    users_.emplace(userId, User{userId, name});
+    usersDirty_ = true;
+    reserveIdLocked("USR", userId);
+    logOperationLocked({{"op", "user"}, {"id", userId}, {"name", name}});
+}
+
+void SplitwiseManager::setIdSequence(std::size_t shard, std::size_t shards) {
+    if (shards == 0 || shard >= shards) {
+        throw std::invalid_argument("Shard index must be below the shard count");
+    }
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    idShard_ = shard;
+    idShards_ = shards;
+}
+
 std::string SplitwiseManager::addGroup(const std::string &name, const std::vector<std::string> &memberIds) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddGroup);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    std::string id = addGroupLocked(name, memberIds);
+    auto members = nlohmann::json::array();
+    for (const auto &member : memberIds) {
+        members.push_back(member);
+    }
+    logOperationLocked({{"op", "group"}, {"id", id}, {"name", name}, {"members", members}});
+    return id;
+}
+
+std::string SplitwiseManager::addGroupLocked(const std::string &name,
+                                             const std::vector<std::string> &memberIds,
+                                             std::string id) {
     for (const auto &member : memberIds) {
         if (!users_.count(member)) {
             throw std::invalid_argument("Unknown user id: " + member);
         }
     }
-    std::string id = generateId("GRP");
-    groups_.emplace(id, Group{id, name, memberIds});
+    if (id.empty()) {
+        id = generateId("GRP");
+    } else if (groups_.count(id) || partitions_.count(id)) {
+        throw std::invalid_argument("Group id already taken: " + id);
+    }
+    const Group &group = groups_.emplace(id, Group{id, name, memberIds}).first->second;
+    if (!partitionDir_.empty()) {
+        Partition &partition = partitions_[id];
+        partition.name = name;
+        partition.segment = partitioned::segmentFileName(id);
+        partition.resident = true;
+        recentGroups_.push_front(id);
+        partition.recent = recentGroups_.begin();
+        notePartitionChangeLocked(id, static_cast<std::ptrdiff_t>(residentGroupBytes(group)));
+    }
     return id;
 }
 
+Group::Epoch SplitwiseManager::addGroupMember(const std::string &groupId, const std::string &userId) {
+    return addGroupMember(groupId, userId, currentTimestamp());
+}
+
+Group::Epoch SplitwiseManager::addGroupMember(const std::string &groupId,
+                                              const std::string &userId,
+                                              std::int64_t timestamp) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (!users_.count(userId)) {
+        throw std::invalid_argument("Unknown user id: " + userId);
+    }
+    return changeMembershipLocked(groupId, userId, timestamp, true);
+}
+
+Group::Epoch SplitwiseManager::removeGroupMember(const std::string &groupId, const std::string &userId) {
+    return removeGroupMember(groupId, userId, currentTimestamp());
+}
+
+Group::Epoch SplitwiseManager::removeGroupMember(const std::string &groupId,
+                                                 const std::string &userId,
+                                                 std::int64_t timestamp) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    Group &group = groupLocked(groupId);
+    if (!group.hasMember(userId)) {
+        throw std::invalid_argument("User " + userId + " is not a member of group " + groupId);
+    }
+    // Expenses and recurring occurrences from `timestamp` on would stop validating on the next load.
+    const std::int64_t latest = std::numeric_limits<std::int64_t>::max();
+    timeIndex_.forEachInRange(groupId, timestamp, latest, [&](const std::string &id) {
+        const auto &participants = expenses_.at(id).getInput().participantIds;
+        if (std::find(participants.begin(), participants.end(), userId) != participants.end()) {
+            throw std::invalid_argument("User " + userId + " takes part in expense " + id + " at or after " +
+                                        std::to_string(timestamp));
+        }
+    });
+    const std::int64_t before = timestamp == std::numeric_limits<std::int64_t>::min() ? timestamp : timestamp - 1;
+    for (const auto &[id, recurring] : recurring_) {
+        const auto &participants = recurring.getInput().participantIds;
+        if (recurring.getGroupId() == groupId &&
+            std::find(participants.begin(), participants.end(), userId) != participants.end() &&
+            recurring.countBetween(before, latest) != 0) {
+            throw std::invalid_argument("User " + userId + " takes part in recurring expense " + id +
+                                        "; end it before removing the member");
+        }
+    }
+    return changeMembershipLocked(groupId, userId, timestamp, false);
+}
+
+Group::Epoch SplitwiseManager::changeMembershipLocked(const std::string &groupId,
+                                                      const std::string &userId,
+                                                      std::int64_t timestamp,
+                                                      bool joined) {
+    Group &group = groupLocked(groupId);
+    const auto bytesBefore = static_cast<std::ptrdiff_t>(group.memoryBytes());
+    const Group::Epoch epoch = joined ? group.addMember(userId, timestamp) : group.removeMember(userId, timestamp);
+    notePartitionChangeLocked(groupId, static_cast<std::ptrdiff_t>(group.memoryBytes()) - bytesBefore);
+    logOperationLocked({{"op", "member"},
+                        {"group", groupId},
+                        {"user", userId},
+                        {"timestamp", static_cast<double>(timestamp)},
+                        {"joined", joined}});
+    return epoch;
+}
+
+void SplitwiseManager::setGroupParent(const std::string &groupId, const std::string &parentId) {
+    tracing::Span span("setGroupParent");
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    setGroupParentLocked(groupId, parentId);
+}
+
+void SplitwiseManager::setGroupParentLocked(const std::string &groupId, const std::string &parentId) {
+    requireGroupLocked(groupId);
+    if (!parentId.empty()) {
+        requireGroupLocked(parentId);
+    }
+    groupHierarchy_.setParent(groupId, parentId, balanceRanks_);
+    logOperationLocked({{"op", "parent"}, {"group", groupId}, {"parent", parentId}});
+}
+
+std::string SplitwiseManager::getGroupParent(const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    requireGroupLocked(groupId);
+    return groupHierarchy_.parentOf(groupId);
+}
+
+std::vector<std::string> SplitwiseManager::getChildGroups(const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    requireGroupLocked(groupId);
+    return groupHierarchy_.childrenOf(groupId);
+}
+
 std::string SplitwiseManager::addExpense(const std::string &groupId,
                                          const std::string &description,
                                          const SplitInput &input,
                                          const std::shared_ptr<SplitStrategy> &strategy) {
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddExpense);
     if (!strategy) {
         throw std::invalid_argument("Strategy must not be null");
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!groups_.count(groupId)) {
-        throw std::invalid_argument("Unknown group id: " + groupId);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    const std::int64_t now = currentTimestamp();
+    accrueRecurringLocked(now);
+    bool duplicate = false;
+    return ingestExpenseLocked(groupId, description, input, strategy, now, {}, now, duplicate);
+}
+
+std::string SplitwiseManager::addExpense(const std::string &groupId,
+                                         const std::string &description,
+                                         const SplitInput &input,
+                                         const std::shared_ptr<SplitStrategy> &strategy,
+                                         std::int64_t timestamp) {
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddExpense);
+    if (!strategy) {
+        throw std::invalid_argument("Strategy must not be null");
     }
-    const auto &group = groups_.at(groupId);
-    if (input.participantIds.empty()) {
-        throw std::invalid_argument("Expense must include at least one participant");
+
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    const std::int64_t now = currentTimestamp();
+    accrueRecurringLocked(now);
+    bool duplicate = false;
+    return ingestExpenseLocked(groupId, description, input, strategy, timestamp, {}, now, duplicate);
+}
+
+std::string SplitwiseManager::addExpense(const ExpenseRequest &request) {
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddExpense);
+    if (!request.strategy) {
+        throw std::invalid_argument("Strategy must not be null");
     }
-    if (!group.hasMember(input.payerId)) {
-        throw std::invalid_argument("Payer must be part of the group");
+
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    const std::int64_t now = currentTimestamp();
+    accrueRecurringLocked(now);
+    bool duplicate = false;
+    return ingestExpenseLocked(request.groupId, request.description, request.input, request.strategy,
+                               request.timestamp.value_or(now), request.idempotencyKey, now, duplicate);
+}
+
+std::vector<BatchResult> SplitwiseManager::addExpenses(const std::vector<ExpenseRequest> &requests) {
+    tracing::Span span("addExpenses");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddExpenses);
+    std::vector<BatchResult> results(requests.size());
+    const std::int64_t now = currentTimestamp();
+
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    accrueRecurringLocked(now);
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        const auto &request = requests[i];
+        try {
+            if (!request.strategy) {
+                throw std::invalid_argument("Strategy must not be null");
+            }
+            results[i].id = ingestExpenseLocked(request.groupId,
+                                                request.description,
+                                                request.input,
+                                                request.strategy,
+                                                request.timestamp.value_or(now),
+                                                request.idempotencyKey,
+                                                now,
+                                                results[i].duplicate);
+        } catch (const std::exception &ex) {
+            results[i].error = ex.what();
+        }
     }
-    if (std::find(input.participantIds.begin(), input.participantIds.end(), input.payerId) ==
-        input.participantIds.end()) {
-        throw std::invalid_argument("Participants must include the payer");
+    return results;
+}
+
+std::string SplitwiseManager::ingestExpenseLocked(const std::string &groupId,
+                                                  const std::string &description,
+                                                  const SplitInput &input,
+                                                  const std::shared_ptr<SplitStrategy> &strategy,
+                                                  std::int64_t timestamp,
+                                                  const std::string &clientKey,
+                                                  std::int64_t now,
+                                                  bool &duplicate) {
+    std::string key = clientKey;
+    if (key.empty() && idempotency_.options().contentKeys) {
+        key = IdempotencyFilter::contentKey(groupId, input, strategy->name());
     }
-    for (const auto &participant : input.participantIds) {
-        if (!group.hasMember(participant)) {
-            throw std::invalid_argument("Participant not in group: " + participant);
+    if (!key.empty()) {
+        if (const std::string *original = idempotency_.find(key, now)) {
+            duplicate = true;
+            return *original;
         }
     }
+    std::string id = addExpenseLocked(groupId, description, input, strategy, timestamp);
+    if (!key.empty()) {
+        idempotency_.insert(key, id, now);
+    }
+    logExpenseLocked("expense", id, key, now);
+    return id;
+}
+
+std::string SplitwiseManager::addExpenseLocked(const std::string &groupId,
+                                               const std::string &description,
+                                               const SplitInput &input,
+                                               const std::shared_ptr<SplitStrategy> &strategy,
+                                               std::int64_t timestamp,
+                                               std::string id) {
+    pageInLocked(groupId, false);
+    validateExpenseLocked(groupId, input, timestamp);
 
     BalanceSheet::BalanceMap delta = strategy->computeSplits(input);
-    std::string id = generateId("EXP");
-    expenses_.emplace(id, Expense{id, groupId, description, input, strategy});
-    balanceSheet_.applyDelta(delta);
+    if (id.empty()) {
+        id = generateId("EXP");
+    }
+    const Expense &expense = expenses_.emplace(id, Expense{id, groupId, description, input, strategy, timestamp})
+                                 .first->second;
+    timeIndex_.insert(expense);
+    expenseIndex_.insert(expense);
+    descriptionIndex_.add(expenseIndex_.handleOf(id), description);
+    latestTimestamp_ = std::max(latestTimestamp_, timestamp);
+    if (isBaseCurrencyLocked(input.currency)) {
+        balanceSheet_.applyDelta(delta);
+        balanceRanks_.apply(groupId, delta);
+        groupHierarchy_.apply(groupId, delta);
+        balanceHistory_.record(timestamp, delta, balanceSheet_, historyBoundaryLocked());
+    } else {
+        currencyBalances_[input.currency].applyDelta(delta);
+    }
+    metrics_.addExpensesApplied(1);
+    metrics_.addBalancesTouched(delta.size());
+    notePartitionChangeLocked(groupId, static_cast<std::ptrdiff_t>(residentExpenseBytes(expense)));
 
     if (notifier_ && input.amount > notificationThreshold_) {
-        notifier_->notifyLargeExpense(expenses_.at(id), notificationThreshold_);
+        notifier_->notifyLargeExpense(expense, notificationThreshold_);
+    }
+
+    return id;
+}
+
+void SplitwiseManager::updateExpense(const std::string &expenseId,
+                                     const std::string &description,
+                                     const SplitInput &input,
+                                     const std::shared_ptr<SplitStrategy> &strategy) {
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::UpdateExpense);
+    if (!strategy) {
+        throw std::invalid_argument("Strategy must not be null");
+    }
+
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    accrueRecurringLocked(currentTimestamp());
+    updateExpenseLocked(expenseId, description, input, strategy);
+    logExpenseLocked("update", expenseId);
+}
+
+void SplitwiseManager::updateExpenseLocked(const std::string &expenseId,
+                                           const std::string &description,
+                                           const SplitInput &input,
+                                           const std::shared_ptr<SplitStrategy> &strategy) {
+    auto it = expenses_.find(expenseId);
+    if (it == expenses_.end() && materializeOccurrenceLocked(expenseId)) {
+        it = expenses_.find(expenseId);
+    }
+    if (it == expenses_.end() && !partitionDir_.empty()) {
+        ensureAllResidentLocked();
+        it = expenses_.find(expenseId);
+    }
+    if (it == expenses_.end()) {
+        throw std::invalid_argument("Unknown expense id: " + expenseId);
+    }
+    Expense &expense = it->second;
+    const auto bytesBefore = static_cast<std::ptrdiff_t>(residentExpenseBytes(expense));
+    validateExpenseLocked(expense.getGroupId(), input, expense.getTimestamp());
+
+    // Compute both deltas before mutating anything so a failing strategy leaves the ledger untouched.
+    BalanceSheet::BalanceMap delta = strategy->computeSplits(input);
+    BalanceSheet::BalanceMap reversal = expense.getStrategy()->computeSplits(expense.getInput());
+    for (auto &[userId, change] : reversal) {
+        change = -change;
+    }
+    const std::string oldCurrency = expense.getInput().currency;
+    const bool sameCurrency = isBaseCurrencyLocked(oldCurrency) ? isBaseCurrencyLocked(input.currency)
+                                                                : oldCurrency == input.currency;
+    if (sameCurrency) {
+        for (const auto &[userId, change] : reversal) {
+            delta[userId] += change;
+        }
+        reversal.clear();
+    }
+    Expense updated{expenseId, expense.getGroupId(), description, input, strategy, expense.getTimestamp()};
+    expenseIndex_.update(expense, updated);
+    if (updated.getDescription() != expense.getDescription()) {
+        const auto handle = expenseIndex_.handleOf(expenseId);
+        descriptionIndex_.remove(handle, expense.getDescription());
+        descriptionIndex_.add(handle, updated.getDescription());
+    }
+    expense = std::move(updated);
+    applyCurrencyDeltaLocked(expense.getGroupId(), oldCurrency, expense.getTimestamp(), reversal);
+    applyCurrencyDeltaLocked(expense.getGroupId(), input.currency, expense.getTimestamp(), delta);
+    metrics_.addBalancesTouched(delta.size() + reversal.size());
+    notePartitionChangeLocked(expense.getGroupId(),
+                              static_cast<std::ptrdiff_t>(residentExpenseBytes(expense)) - bytesBefore);
+}
+
+void SplitwiseManager::deleteExpense(const std::string &expenseId) {
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::DeleteExpense);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    accrueRecurringLocked(currentTimestamp());
+    deleteExpenseLocked(expenseId);
+    logOperationLocked({{"op", "delete"}, {"id", expenseId}});
+}
+
+void SplitwiseManager::deleteExpenseLocked(const std::string &expenseId) {
+    auto it = expenses_.find(expenseId);
+    if (it == expenses_.end() && materializeOccurrenceLocked(expenseId)) {
+        it = expenses_.find(expenseId);
+    }
+    if (it == expenses_.end() && !partitionDir_.empty()) {
+        ensureAllResidentLocked();
+        it = expenses_.find(expenseId);
+    }
+    if (it == expenses_.end()) {
+        throw std::invalid_argument("Unknown expense id: " + expenseId);
+    }
+    const std::string groupId = it->second.getGroupId();
+    const auto bytes = static_cast<std::ptrdiff_t>(residentExpenseBytes(it->second));
+    BalanceSheet::BalanceMap delta = it->second.getStrategy()->computeSplits(it->second.getInput());
+    for (auto &[userId, change] : delta) {
+        change = -change;
+    }
+    applyCurrencyDeltaLocked(groupId, it->second.getInput().currency, it->second.getTimestamp(), delta);
+    timeIndex_.erase(it->second);
+    descriptionIndex_.remove(expenseIndex_.handleOf(expenseId), it->second.getDescription());
+    expenseIndex_.erase(it->second);
+    expenses_.erase(it);
+    metrics_.addBalancesTouched(delta.size());
+    notePartitionChangeLocked(groupId, -bytes);
+}
+
+std::string SplitwiseManager::addRecurringExpense(const std::string &groupId,
+                                                  const std::string &description,
+                                                  const SplitInput &input,
+                                                  const std::shared_ptr<SplitStrategy> &strategy,
+                                                  const RecurrenceSchedule &schedule) {
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::AddExpense);
+    if (!strategy) {
+        throw std::invalid_argument("Strategy must not be null");
+    }
+    if (schedule.interval <= 0) {
+        throw std::invalid_argument("Recurrence interval must be positive");
     }
 
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    refuseWhileLeaderLocked("Recurring expenses");
+    const std::int64_t now = currentTimestamp();
+    accrueRecurringLocked(now);
+    pageInLocked(groupId, false);
+    // Occurrences keep their participants, so they must be members from the start and still be members now.
+    validateExpenseLocked(groupId, input, schedule.start);
+    validateExpenseLocked(groupId, input, now);
+    // Validate the split before an id is consumed.
+    strategy->computeSplits(input);
+    std::string id = generateId("REC");
+    const RecurringExpense &recurring =
+        recurring_.emplace(id, RecurringExpense{id, groupId, description, input, strategy, schedule}).first->second;
+    recurringAsOf_ = std::max(recurringAsOf_, now);
+    applyRecurringLocked(recurring, std::numeric_limits<std::int64_t>::min(), recurringAsOf_, 1.0);
     return id;
 }
 
-const std::map<std::string, User> &SplitwiseManager::getUsers() const noexcept { return users_; }
+void SplitwiseManager::endRecurringExpense(const std::string &templateId, std::int64_t end) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    refuseWhileLeaderLocked("Recurring expenses");
+    accrueRecurringLocked(currentTimestamp());
+    auto it = recurring_.find(templateId);
+    if (it == recurring_.end()) {
+        throw std::invalid_argument("Unknown recurring expense id: " + templateId);
+    }
+    RecurringExpense &recurring = it->second;
+    const std::int64_t previous = recurring.getSchedule().end;
+    if (end < previous) {
+        // Reverse the accrued occurrences the new end cuts off.
+        applyRecurringLocked(recurring, end, recurringAsOf_, -1.0);
+        recurring.setEnd(end);
+    } else if (end > previous) {
+        recurring.setEnd(end);
+        applyRecurringLocked(recurring, previous, recurringAsOf_, 1.0);
+    }
+}
+
+void SplitwiseManager::accrueRecurring(std::int64_t asOf) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    accrueRecurringLocked(asOf);
+}
+
+std::vector<RecurringExpense> SplitwiseManager::getRecurringExpenses() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    std::vector<RecurringExpense> result;
+    result.reserve(recurring_.size());
+    for (const auto &[id, recurring] : recurring_) {
+        result.push_back(recurring);
+    }
+    return result;
+}
+
+std::int64_t SplitwiseManager::getRecurringAsOf() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return recurringAsOf_;
+}
+
+void SplitwiseManager::setBaseCurrency(const std::string &currency) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    validateCurrency(currency);
+    baseCurrency_ = currency;
+    recomputeBalances();
+    logOperationLocked({{"op", "base-currency"}, {"code", currency}});
+}
+
+std::string SplitwiseManager::getBaseCurrency() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return baseCurrency_;
+}
+
+void SplitwiseManager::setFxTable(std::shared_ptr<const FxTable> table) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    fxTable_ = std::move(table);
+}
+
+std::map<std::string, BalanceSheet::BalanceMap> SplitwiseManager::getBalancesByCurrency() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    std::map<std::string, BalanceSheet::BalanceMap> result;
+    if (!balanceSheet_.getBalances().empty()) {
+        result.emplace(baseCurrency_, balanceSheet_.getBalances());
+    }
+    for (const auto &[currency, sheet] : currencyBalances_) {
+        // Currencies whose expenses were all edited away or deleted leave only zero entries behind.
+        const auto &balances = sheet.getBalances();
+        if (std::any_of(balances.begin(), balances.end(), [](const auto &entry) { return entry.second != 0.0; })) {
+            result.emplace(currency, balances);
+        }
+    }
+    return result;
+}
+
+BalanceSheet::BalanceMap SplitwiseManager::getBalancesIn(const std::string &currency) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return balancesInLocked(currency);
+}
+
+BalanceSheet::BalanceMap SplitwiseManager::balancesInLocked(const std::string &currency) const {
+    const std::string &target = currency.empty() ? baseCurrency_ : currency;
+    BalanceSheet::BalanceMap result;
+    // One rate lookup per currency, then a straight pass over that currency's balances.
+    auto convert = [&](const BalanceSheet::BalanceMap &balances, const std::string &from) {
+        if (balances.empty()) {
+            return;
+        }
+        if (from == target) {
+            for (const auto &[userId, balance] : balances) {
+                result[userId] += balance;
+            }
+            return;
+        }
+        if (from.empty() || target.empty()) {
+            throw std::invalid_argument("Set a base currency before converting between currencies");
+        }
+        if (!fxTable_) {
+            throw std::invalid_argument("No FX table loaded");
+        }
+        fxTable_->convertInto(balances, from, target, result);
+    };
+    convert(balanceSheet_.getBalances(), baseCurrency_);
+    for (const auto &[code, sheet] : currencyBalances_) {
+        convert(sheet.getBalances(), code);
+    }
+    return result;
+}
+
+std::vector<Expense> SplitwiseManager::getExpensesBetween(const std::string &groupId,
+                                                         std::int64_t from,
+                                                         std::int64_t to) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (groupId.empty()) {
+        ensureAllResidentLocked();
+    } else {
+        ensureResidentLocked(groupId);
+    }
+    std::vector<Expense> result;
+    timeIndex_.forEachInRange(groupId, from, to, [&](const std::string &id) { result.push_back(expenses_.at(id)); });
+
+    // Occurrences of recurring expenses exist only for the duration of the query.
+    const std::size_t stored = result.size();
+    const std::int64_t upTo = std::min(to, recurringAsOf_);
+    for (const auto &[id, recurring] : recurring_) {
+        if (upTo < from || (!groupId.empty() && recurring.getGroupId() != groupId)) {
+            continue;
+        }
+        const RecurrenceSchedule &schedule = recurring.getSchedule();
+        const std::uint64_t last = schedule.countUpTo(upTo);
+        for (std::uint64_t index = from == std::numeric_limits<std::int64_t>::min() ? 0 : schedule.countUpTo(from - 1);
+             index < last; ++index) {
+            if (recurring.hasOccurrence(index)) {
+                result.push_back(recurring.occurrence(index));
+            }
+        }
+    }
+    if (result.size() > stored) {
+        std::sort(result.begin(), result.end(), [](const Expense &a, const Expense &b) {
+            return a.getTimestamp() != b.getTimestamp() ? a.getTimestamp() < b.getTimestamp() : a.getId() < b.getId();
+        });
+    }
+    return result;
+}
+
+BalanceSheet::BalanceMap SplitwiseManager::getBalancesAsOf(std::int64_t timestamp) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    ensureAllResidentLocked();
+    if (historyStale_) {
+        rebuildHistoryLocked();
+    }
+    const auto *checkpoint = balanceHistory_.latestAtOrBefore(timestamp);
+    BalanceSheet balances = checkpoint ? checkpoint->balances : BalanceSheet{};
+    std::int64_t from = checkpoint ? checkpoint->boundary + 1 : std::numeric_limits<std::int64_t>::min();
+    timeIndex_.forEachInRange({}, from, timestamp, [&](const std::string &id) {
+        const Expense &expense = expenses_.at(id);
+        if (isBaseCurrencyLocked(expense.getInput().currency)) {
+            balances.applyDelta(expense.getStrategy()->computeSplits(expense.getInput()));
+        }
+    });
+    // The checkpoint holds every accrued occurrence up to its boundary; add those after it in closed form.
+    const std::int64_t upTo = std::min(timestamp, recurringAsOf_);
+    for (const auto &[id, recurring] : recurring_) {
+        if (isBaseCurrencyLocked(recurring.getInput().currency)) {
+            const std::uint64_t count = recurring.countBetween(from == std::numeric_limits<std::int64_t>::min()
+                                                                   ? from
+                                                                   : from - 1,
+                                                               upTo);
+            if (count != 0) {
+                balances.applyDelta(scaledDelta(recurring.getDelta(), static_cast<double>(count)));
+            }
+        }
+    }
+    return balances.getBalances();
+}
+
+ExpensePage SplitwiseManager::getUserExpenses(const std::string &userId,
+                                              const std::string &cursor,
+                                              std::size_t limit) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (!users_.count(userId)) {
+        throw std::invalid_argument("Unknown user id: " + userId);
+    }
+    ensureAllResidentLocked();
+    return pageLocked(expenseIndex_.userPostings(userId), cursor, limit);
+}
+
+ExpensePage SplitwiseManager::getGroupExpenses(const std::string &groupId,
+                                               const std::string &cursor,
+                                               std::size_t limit) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    ensureResidentLocked(groupId);
+    if (!groups_.count(groupId)) {
+        throw std::invalid_argument("Unknown group id: " + groupId);
+    }
+    return pageLocked(expenseIndex_.groupPostings(groupId), cursor, limit);
+}
+
+std::vector<ExpenseSearchHit> SplitwiseManager::searchExpenses(const std::string &query,
+                                                               std::size_t limit,
+                                                               const std::string &groupId,
+                                                               const std::string &userId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (groupId.empty()) {
+        ensureAllResidentLocked();
+    } else {
+        ensureResidentLocked(groupId);
+    }
+    std::vector<const PostingList *> filters;
+    if (!groupId.empty()) {
+        if (!groups_.count(groupId)) {
+            throw std::invalid_argument("Unknown group id: " + groupId);
+        }
+        filters.push_back(expenseIndex_.groupPostings(groupId));
+    }
+    if (!userId.empty()) {
+        if (!users_.count(userId)) {
+            throw std::invalid_argument("Unknown user id: " + userId);
+        }
+        filters.push_back(expenseIndex_.userPostings(userId));
+    }
+    std::vector<ExpenseSearchHit> hits;
+    if (std::find(filters.begin(), filters.end(), nullptr) != filters.end()) {
+        return hits;
+    }
+    for (const auto &match : descriptionIndex_.search(query, limit, filters)) {
+        hits.push_back({expenseIndex_.idOf(match.handle), match.score});
+    }
+    return hits;
+}
+
+ExpensePage SplitwiseManager::pageLocked(const PostingList *postings,
+                                         const std::string &cursor,
+                                         std::size_t limit) const {
+    ExpensePage page;
+    for (const auto &id : expenseIndex_.page(postings, cursor, limit, page.nextCursor)) {
+        page.expenses.push_back(expenses_.at(id));
+    }
+    return page;
+}
+
+std::map<std::string, User> SplitwiseManager::getUsers() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return users_;
+}
 
-const std::map<std::string, Group> &SplitwiseManager::getGroups() const noexcept { return groups_; }
+std::map<std::string, Group> SplitwiseManager::getGroups() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return groups_;
+}
 
-const std::map<std::string, Expense> &SplitwiseManager::getExpenses() const noexcept { return expenses_; }
+std::map<std::string, Expense> SplitwiseManager::getExpenses() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return expenses_;
+}
 
-const BalanceSheet::BalanceMap &SplitwiseManager::getAllBalances() const noexcept {
+BalanceSheet::BalanceMap SplitwiseManager::getAllBalances() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
     return balanceSheet_.getBalances();
 }
 
 void SplitwiseManager::saveToJson(const std::string &path) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    nlohmann::json j;
-    j["users"] = nlohmann::json::array();
+    tracing::Span span("saveToJson");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::SaveToJson);
+    LedgerSnapshot snapshot = captureSnapshot();
+    std::string text;
+    {
+        tracing::Span serialiseSpan("saveToJson.serialise");
+        text = snapshot.dump(2, threadPool().get());
+    }
+
+    tracing::Span writeSpan("saveToJson.write");
+    writeFileAtomically(path, text);
+}
+
+std::shared_future<void> SplitwiseManager::saveAsync(const std::string &path) { return saver_.request(path); }
+
+void SplitwiseManager::waitForSaves() { saver_.waitIdle(); }
+
+LedgerSnapshot SplitwiseManager::captureSnapshot() const {
+    tracing::Span span("saveToJson.capture");
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    ensureAllResidentLocked();
+    LedgerSnapshot snapshot;
+    snapshot.users.reserve(users_.size());
     for (const auto &[id, user] : users_) {
-        j["users"].push_back(user.toJson());
+        snapshot.users.push_back(user);
     }
-    j["groups"] = nlohmann::json::array();
+    snapshot.groups.reserve(groups_.size());
     for (const auto &[id, group] : groups_) {
-        j["groups"].push_back(group.toJson());
+        snapshot.groups.push_back(group);
     }
-    j["expenses"] = nlohmann::json::array();
+    snapshot.expenses.reserve(expenses_.size());
     for (const auto &[id, expense] : expenses_) {
-        j["expenses"].push_back(expense.toJson());
+        snapshot.expenses.push_back(expense);
     }
-    j["balances"] = balanceSheet_.toJson();
-
-    std::ofstream out(path);
-    if (!out) {
-        throw std::runtime_error("Failed to open file for writing: " + path);
+    snapshot.balances = balanceSheet_;
+    snapshot.baseCurrency = baseCurrency_;
+    snapshot.counters = counters_;
+    snapshot.recurring.reserve(recurring_.size());
+    for (const auto &[id, recurring] : recurring_) {
+        snapshot.recurring.push_back(recurring);
     }
-    out << std::setw(2) << j;
+    snapshot.groupParents = groupHierarchy_.parents();
+    snapshot.idempotencyKeys = idempotency_.records();
+    snapshot.recurringAsOf = recurringAsOf_;
+    snapshot.replicationSequence = replicationSequence_;
+    return snapshot;
 }
 
 void SplitwiseManager::loadFromJson(const std::string &path) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    tracing::Span span("loadFromJson");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::LoadFromJson);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    refuseWhileLeaderLocked("Loads");
     std::ifstream in(path);
     if (!in) {
         throw std::runtime_error("Failed to open file for reading: " + path);
     }
+    loadLocked(in);
+}
+
+void SplitwiseManager::loadFromJsonText(const std::string &text) {
+    tracing::Span span("loadFromJson");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::LoadFromJson);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    refuseWhileLeaderLocked("Loads");
+    std::istringstream in(text);
+    loadLocked(in);
+}
+
+std::string SplitwiseManager::saveToJsonText() const {
+    tracing::Span span("saveToJson");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::SaveToJson);
+    return captureSnapshot().dump(-1, threadPool().get());
+}
+
+void SplitwiseManager::loadLocked(std::istream &in) {
     nlohmann::json j;
-    in >> j;
+    {
+        tracing::Span parseSpan("loadFromJson.parse");
+        in >> j;
+    }
+    lastLoadJson_.objects = j.is_object() && j.contains("expenses") && j.at("expenses").is_array()
+                                ? static_cast<std::size_t>(j.at("expenses").end() - j.at("expenses").begin())
+                                : 0;
+    lastLoadJson_.bytes = sizeof(j) + j.heap_bytes(memory::allocationBytes);
 
     if (!j.is_object()) {
         throw std::runtime_error("Invalid JSON format: expected an object at the root");
@@ -141,122 +907,948 @@ void SplitwiseManager::loadFromJson(const std::string &path) {
     groups_.clear();
     expenses_.clear();
     balanceSheet_.clear();
+    balanceRanks_.clear();
+    groupHierarchy_.clear();
+    idempotency_.clear();
+    currencyBalances_.clear();
+    baseCurrency_ = j.value("baseCurrency", std::string{});
+    timeIndex_.clear();
+    expenseIndex_.clear();
+    descriptionIndex_.clear();
+    balanceHistory_.clear();
+    latestTimestamp_ = std::numeric_limits<std::int64_t>::min();
+    recurring_.clear();
+    recurringAsOf_ = std::numeric_limits<std::int64_t>::min();
+    replicationSequence_ = static_cast<std::uint64_t>(j.value("replicationSequence", 0.0));
+    resetPartitionsLocked();
 
-    for (const auto &userJson : j.at("users")) {
-        User user = User::fromJson(userJson);
-        users_.emplace(user.getId(), user);
-    }
-    for (const auto &groupJson : j.at("groups")) {
-        Group group = Group::fromJson(groupJson);
-        for (const auto &member : group.getMemberIds()) {
-            if (!users_.count(member)) {
-                throw std::runtime_error("Group '" + group.getId() + "' references unknown user '" + member + "'");
+    {
+        tracing::Span validateSpan("loadFromJson.validate");
+        {
+            tracing::Span usersSpan("loadFromJson.users");
+            for (const auto &userJson : j.at("users")) {
+                User user = User::fromJson(userJson);
+                users_.emplace(user.getId(), user);
             }
         }
-        groups_.emplace(group.getId(), group);
-    }
-    for (const auto &expenseJson : j.at("expenses")) {
-        std::string strategyType = expenseJson.at("strategy").get<std::string>();
-        auto strategy = SplitStrategyFactory::create(strategyType);
-        Expense expense = Expense::fromJson(expenseJson, strategy);
-        const auto groupIt = groups_.find(expense.getGroupId());
-        if (groupIt == groups_.end()) {
-            throw std::runtime_error("Expense '" + expense.getId() + "' references unknown group");
-        }
-        const auto &group = groupIt->second;
-        const auto &input = expense.getInput();
-        if (!users_.count(input.payerId)) {
-            throw std::runtime_error("Expense '" + expense.getId() + "' references unknown payer");
+        {
+            tracing::Span groupsSpan("loadFromJson.groups");
+            for (const auto &groupJson : j.at("groups")) {
+                Group group = Group::fromJson(groupJson);
+                for (const auto &member : everyMemberOf(group)) {
+                    if (!users_.count(member)) {
+                        throw std::runtime_error("Group '" + group.getId() + "' references unknown user '" + member +
+                                                 "'");
+                    }
+                }
+                groups_.emplace(group.getId(), group);
+            }
+            if (j.contains("groupParents")) {
+                groupHierarchy_.assign(
+                    linkedGroups(j.at("groupParents").get<std::map<std::string, std::string>>(), groups_));
+            }
         }
-        if (input.participantIds.empty()) {
-            throw std::runtime_error("Expense '" + expense.getId() + "' must include participants");
+        if (j.contains("recurring")) {
+            tracing::Span recurringSpan("loadFromJson.recurring");
+            ensureArray(j.at("recurring"), "recurring");
+            for (const auto &record : j.at("recurring")) {
+                auto strategy = SplitStrategyFactory::create(record.at("strategy").get<std::string>());
+                RecurringExpense recurring = RecurringExpense::fromJson(record, strategy);
+                const auto groupIt = groups_.find(recurring.getGroupId());
+                if (groupIt == groups_.end()) {
+                    throw std::runtime_error("Recurring expense '" + recurring.getId() + "' references unknown group");
+                }
+                validateLoadedExpenseLocked(recurring.occurrence(0), groupIt->second);
+                std::string id = recurring.getId();
+                recurring_.emplace(std::move(id), std::move(recurring));
+            }
+            recurringAsOf_ = static_cast<std::int64_t>(
+                j.value("recurringAsOf", static_cast<double>(std::numeric_limits<std::int64_t>::min())));
         }
-        if (std::find(input.participantIds.begin(), input.participantIds.end(), input.payerId) ==
-            input.participantIds.end()) {
-            throw std::runtime_error("Expense '" + expense.getId() + "' participants must include payer");
+        if (j.contains("idempotencyKeys")) {
+            ensureArray(j.at("idempotencyKeys"), "idempotencyKeys");
+            std::vector<IdempotencyRecord> records;
+            for (const auto &record : j.at("idempotencyKeys")) {
+                records.push_back(IdempotencyRecord::fromJson(record));
+            }
+            idempotency_.restore(records);
         }
-        for (const auto &participant : input.participantIds) {
-            if (!group.hasMember(participant)) {
-                throw std::runtime_error(
-                    "Expense '" + expense.getId() + "' includes participant not in group: " + participant);
+        {
+            tracing::Span expensesSpan("loadFromJson.expenses");
+            // Records are rebuilt and validated in parallel chunks, then inserted in file order. Each chunk stops at
+            // its first bad record; the earliest failing chunk is reported, matching a sequential scan.
+            auto rebuild = [this](const nlohmann::json &expenseJson) {
+                std::string strategyType = expenseJson.at("strategy").get<std::string>();
+                auto strategy = SplitStrategyFactory::create(strategyType);
+                Expense expense = Expense::fromJson(expenseJson, strategy);
+                const auto groupIt = groups_.find(expense.getGroupId());
+                if (groupIt == groups_.end()) {
+                    throw std::runtime_error("Expense '" + expense.getId() + "' references unknown group");
+                }
+                validateLoadedExpenseLocked(expense, groupIt->second);
+                return expense;
+            };
+            const auto records = j.at("expenses").begin();
+            const std::size_t count = static_cast<std::size_t>(j.at("expenses").end() - records);
+            std::vector<Expense> parsed(count);
+            std::vector<std::exception_ptr> errors((count + LOAD_GRAIN - 1) / LOAD_GRAIN);
+            parallelFor(threadPool().get(), count, LOAD_GRAIN, [&](std::size_t begin, std::size_t end) {
+                try {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        parsed[i] = rebuild(records[static_cast<std::ptrdiff_t>(i)]);
+                    }
+                } catch (...) {
+                    errors[begin / LOAD_GRAIN] = std::current_exception();
+                }
+            });
+            for (const auto &error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+            for (auto &expense : parsed) {
+                latestTimestamp_ = std::max(latestTimestamp_, expense.getTimestamp());
+                std::string id = expense.getId();
+                timeIndex_.insert(expenses_.emplace(std::move(id), std::move(expense)).first->second);
             }
         }
-        expenses_.emplace(expense.getId(), expense);
     }
 
-    auto updateCounter = [this](const auto &container, const std::string &prefix) {
-        std::size_t maxCounter = 0;
-        for (const auto &entry : container) {
-            const std::string &id = entry.first;
-            if (id.rfind(prefix, 0) == 0) {
-                try {
-                    std::size_t value = std::stoul(id.substr(prefix.size()));
-                    maxCounter = std::max(maxCounter, value);
-                } catch (const std::exception &) {
-                    // Ignore ids that do not follow the expected pattern.
+    {
+        tracing::Span countersSpan("loadFromJson.counters");
+        // Saved counters cover ids of deleted records, which must never be handed out again.
+        std::map<std::string, double> savedCounters;
+        if (j.contains("counters")) {
+            savedCounters = j.at("counters").get<std::map<std::string, double>>();
+        }
+        auto updateCounter = [this, &savedCounters](const auto &container, const std::string &prefix) {
+            auto saved = savedCounters.find(prefix);
+            std::size_t maxCounter = saved != savedCounters.end() ? static_cast<std::size_t>(saved->second) : 0;
+            for (const auto &entry : container) {
+                const std::string &id = entry.first;
+                if (id.rfind(prefix, 0) == 0) {
+                    try {
+                        std::size_t value = std::stoul(id.substr(prefix.size()));
+                        maxCounter = std::max(maxCounter, value);
+                    } catch (const std::exception &) {
+                        // Ignore ids that do not follow the expected pattern.
+                    }
                 }
             }
-        }
-        counters_[prefix] = maxCounter;
-    };
-    updateCounter(users_, "USR");
-    updateCounter(groups_, "GRP");
-    updateCounter(expenses_, "EXP");
+            counters_[prefix] = maxCounter;
+        };
+        updateCounter(users_, "USR");
+        updateCounter(groups_, "GRP");
+        updateCounter(expenses_, "EXP");
+        updateCounter(recurring_, "REC");
+    }
+    {
+        tracing::Span indexSpan("loadFromJson.index");
+        rebuildIndexesLocked();
+    }
 
     recomputeBalances();
+    accrueRecurringLocked(currentTimestamp());
 }
 
-std::vector<SettlementTransaction> SplitwiseManager::settleUpGreedy() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    struct Entry {
-        std::string userId;
-        double amount;
-    };
-
-    std::vector<Entry> creditors;
-    std::vector<Entry> debtors;
-    for (const auto &[userId, balance] : balanceSheet_.getBalances()) {
-        if (balance > EPSILON) {
-            creditors.push_back({userId, balance});
-        } else if (balance < -EPSILON) {
-            debtors.push_back({userId, balance});
-        }
+void SplitwiseManager::rebuildIndexesLocked() const {
+    expenseIndex_.build(expenses_);
+    std::vector<const std::string *> descriptions(expenseIndex_.handleCount(), nullptr);
+    for (std::size_t handle = 0; handle < descriptions.size(); ++handle) {
+        descriptions[handle] =
+            &expenses_.at(expenseIndex_.idOf(static_cast<ExpenseIndex::Handle>(handle))).getDescription();
     }
+    descriptionIndex_.build(descriptions, getParallelism());
+}
 
-    auto creditorCmp = [](const Entry &a, const Entry &b) { return a.amount < b.amount; };
-    auto debtorCmp = [](const Entry &a, const Entry &b) { return a.amount > b.amount; };
-    std::priority_queue<Entry, std::vector<Entry>, decltype(creditorCmp)> creditorQueue(creditorCmp, creditors);
-    std::priority_queue<Entry, std::vector<Entry>, decltype(debtorCmp)> debtorQueue(debtorCmp, debtors);
-
+void SplitwiseManager::validateLoadedExpenseLocked(const Expense &expense, const Group &group) const {
+    const auto &input = expense.getInput();
+    if (!users_.count(input.payerId)) {
+        throw std::runtime_error("Expense '" + expense.getId() + "' references unknown payer");
+    }
+    if (input.participantIds.empty()) {
+        throw std::runtime_error("Expense '" + expense.getId() + "' must include participants");
+    }
+    if (std::find(input.participantIds.begin(), input.participantIds.end(), input.payerId) ==
+        input.participantIds.end()) {
+        throw std::runtime_error("Expense '" + expense.getId() + "' participants must include payer");
+    }
+    // Membership as it was when the expense happened, so members who left since keep their history.
+    const Group::Epoch epoch = group.epochAt(expense.getTimestamp());
+    for (const auto &participant : input.participantIds) {
+        if (!group.hasMemberAtEpoch(participant, epoch)) {
+            throw std::runtime_error("Expense '" + expense.getId() + "' includes participant not in group: " +
+                                     participant);
+        }
+    }
+}
+
+void SplitwiseManager::savePartitioned(const std::string &directory) {
+    tracing::Span span("savePartitioned");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::SaveToJson);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    partitioned::ensureDirectory(directory);
+    std::error_code error;
+    if (!partitionDir_.empty() && std::filesystem::equivalent(directory, partitionDir_, error)) {
+        for (const auto &[id, partition] : partitions_) {
+            if (partition.resident && (partition.dirty || !partition.onDisk)) {
+                writeBackLocked(id);
+            }
+        }
+        syncManifestLocked();
+        return;
+    }
+
+    // Segments first, the manifest last, so the target never lists a segment that was not written.
+    LedgerManifest manifest = manifestHeaderLocked();
+    for (const auto &[id, group] : groups_) {
+        GroupSegment segment = segmentLocked(id);
+        const std::string file = partitioned::segmentFileName(id);
+        partitioned::writeSegment(directory, file, segment);
+        manifest.groups.push_back({id, group.getName(), file, segment.expenses.size(),
+                                   partitioned::summarize(segment.expenses)});
+    }
+    for (const auto &[id, partition] : partitions_) {
+        if (!partition.resident) {
+            partitioned::copySegment(partitionDir_, directory, partition.segment);
+            manifest.groups.push_back({id, partition.name, partition.segment, partition.storedExpenses,
+                                       partition.stored});
+        }
+    }
+    std::sort(manifest.groups.begin(), manifest.groups.end(),
+              [](const GroupManifestEntry &a, const GroupManifestEntry &b) { return a.id < b.id; });
+    std::vector<User> users;
+    users.reserve(users_.size());
+    for (const auto &[id, user] : users_) {
+        users.push_back(user);
+    }
+    partitioned::writeUsers(directory, users);
+    partitioned::writeManifest(directory, manifest);
+}
+
+void SplitwiseManager::openPartitioned(const std::string &directory) {
+    tracing::Span span("openPartitioned");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::LoadFromJson);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    refuseWhileLeaderLocked("Loads");
+    // Read everything that can fail before touching the current ledger.
+    LedgerManifest manifest = partitioned::readManifest(directory);
+    std::vector<User> users = partitioned::readUsers(directory);
+    std::set<std::string> groupIds;
+    for (const auto &entry : manifest.groups) {
+        if (!groupIds.insert(entry.id).second) {
+            throw std::runtime_error("Manifest lists group '" + entry.id + "' twice");
+        }
+    }
+    GroupHierarchy hierarchy;
+    hierarchy.assign(linkedGroups(manifest.groupParents, groupIds));
+
+    users_.clear();
+    groups_.clear();
+    expenses_.clear();
+    balanceSheet_.clear();
+    balanceRanks_.clear();
+    currencyBalances_.clear();
+    timeIndex_.clear();
+    expenseIndex_.clear();
+    descriptionIndex_.clear();
+    balanceHistory_.clear();
+    recurring_.clear();
+    resetPartitionsLocked();
+    lastLoadJson_ = {};
+    baseCurrency_ = manifest.baseCurrency;
+    counters_ = manifest.counters;
+    latestTimestamp_ = manifest.latestTimestamp;
+    for (auto &user : users) {
+        std::string id = user.getId();
+        users_.emplace(std::move(id), std::move(user));
+    }
+
+    partitionDir_ = directory;
+    for (auto &entry : manifest.groups) {
+        for (const auto &[currency, balances] : entry.balances) {
+            if (isBaseCurrencyLocked(currency)) {
+                balanceSheet_.applyDelta(balances);
+                balanceRanks_.apply(entry.id, balances);
+            } else {
+                currencyBalances_[currency].applyDelta(balances);
+            }
+        }
+        Partition &partition = partitions_[entry.id];
+        partition.name = std::move(entry.name);
+        partition.segment = std::move(entry.segment);
+        partition.stored = std::move(entry.balances);
+        partition.storedExpenses = entry.expenseCount;
+        partition.onDisk = true;
+    }
+    // Summaries cover stored expenses only; recurring expenses add their accrued occurrences on top.
+    recurringAsOf_ = manifest.recurringAsOf;
+    for (auto &recurring : manifest.recurring) {
+        std::string id = recurring.getId();
+        const RecurringExpense &added = recurring_.emplace(std::move(id), std::move(recurring)).first->second;
+        applyRecurringLocked(added, std::numeric_limits<std::int64_t>::min(), recurringAsOf_, 1.0);
+    }
+    groupHierarchy_ = std::move(hierarchy);
+    groupHierarchy_.rebuild(balanceRanks_);
+    idempotency_.restore(manifest.idempotencyKeys);
+    replicationSequence_ = manifest.replicationSequence;
+    historyStale_ = true;
+    accrueRecurringLocked(currentTimestamp());
+}
+
+void SplitwiseManager::setMemoryBudget(std::size_t bytes) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    memoryBudget_ = bytes;
+    enforceBudgetLocked({});
+}
+
+PartitionStats SplitwiseManager::getPartitionStats() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    PartitionStats stats;
+    stats.open = !partitionDir_.empty();
+    stats.directory = partitionDir_;
+    stats.groups = partitions_.size();
+    stats.residentGroups = recentGroups_.size();
+    stats.residentBytes = residentBytes_;
+    stats.budgetBytes = memoryBudget_;
+    stats.pageIns = pageIns_;
+    stats.evictions = evictions_;
+    stats.segmentWrites = segmentWrites_;
+    return stats;
+}
+
+Group SplitwiseManager::getGroup(const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    ensureResidentLocked(groupId);
+    auto it = groups_.find(groupId);
+    if (it == groups_.end()) {
+        throw std::invalid_argument("Unknown group id: " + groupId);
+    }
+    return it->second;
+}
+
+Expense SplitwiseManager::getExpense(const std::string &expenseId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    std::string templateId;
+    std::uint64_t index = 0;
+    if (RecurringExpense::parseOccurrenceId(expenseId, templateId, index)) {
+        auto found = recurring_.find(templateId);
+        if (found != recurring_.end() && found->second.hasOccurrence(index) &&
+            found->second.getSchedule().occurrenceTime(index) <= recurringAsOf_) {
+            return found->second.occurrence(index);
+        }
+    }
+    auto it = expenses_.find(expenseId);
+    if (it == expenses_.end() && !partitionDir_.empty()) {
+        ensureAllResidentLocked();
+        it = expenses_.find(expenseId);
+    }
+    if (it == expenses_.end()) {
+        throw std::invalid_argument("Unknown expense id: " + expenseId);
+    }
+    return it->second;
+}
+
+void SplitwiseManager::resetPartitionsLocked() {
+    partitionDir_.clear();
+    partitions_.clear();
+    recentGroups_.clear();
+    residentBytes_ = 0;
+    usersDirty_ = false;
+    historyStale_ = false;
+    pageIns_ = 0;
+    evictions_ = 0;
+    segmentWrites_ = 0;
+}
+
+// Paging only changes which groups are cached in memory, never the ledger itself, so read-only operations may page.
+void SplitwiseManager::ensureResidentLocked(const std::string &groupId) const {
+    if (!partitionDir_.empty()) {
+        pageInLocked(groupId, true);
+    }
+}
+
+void SplitwiseManager::ensureAllResidentLocked() const {
+    if (partitionDir_.empty()) {
+        return;
+    }
+    for (const auto &[id, partition] : partitions_) {
+        if (!partition.resident) {
+            pageInLocked(id, false);
+        }
+    }
+}
+
+void SplitwiseManager::pageInLocked(const std::string &groupId, bool enforceBudget) const {
+    auto found = partitions_.find(groupId);
+    if (found == partitions_.end()) {
+        return;
+    }
+    Partition &partition = found->second;
+    if (partition.resident) {
+        recentGroups_.splice(recentGroups_.begin(), recentGroups_, partition.recent);
+        return;
+    }
+
+    tracing::Span span("pageIn");
+    GroupSegment segment = partitioned::readSegment(partitionDir_, partition.segment);
+    if (segment.group.getId() != groupId) {
+        throw std::runtime_error("Segment '" + partition.segment + "' holds group '" + segment.group.getId() +
+                                 "', expected '" + groupId + "'");
+    }
+    for (const auto &member : everyMemberOf(segment.group)) {
+        if (!users_.count(member)) {
+            throw std::runtime_error("Group '" + groupId + "' references unknown user '" + member + "'");
+        }
+    }
+    std::set<std::string> ids;
+    for (const auto &expense : segment.expenses) {
+        if (expenses_.count(expense.getId()) || !ids.insert(expense.getId()).second) {
+            throw std::runtime_error("Duplicate expense id: " + expense.getId());
+        }
+        validateLoadedExpenseLocked(expense, segment.group);
+    }
+
+    std::size_t bytes = residentGroupBytes(segment.group);
+    groups_.emplace(groupId, std::move(segment.group));
+    for (auto &loaded : segment.expenses) {
+        std::string id = loaded.getId();
+        const Expense &expense = expenses_.emplace(id, std::move(loaded)).first->second;
+        timeIndex_.insert(expense);
+        expenseIndex_.insert(expense);
+        descriptionIndex_.add(expenseIndex_.handleOf(id), expense.getDescription());
+        bytes += residentExpenseBytes(expense);
+    }
+    partition.resident = true;
+    partition.bytes = bytes;
+    residentBytes_ += bytes;
+    recentGroups_.push_front(groupId);
+    partition.recent = recentGroups_.begin();
+    ++pageIns_;
+    if (enforceBudget) {
+        enforceBudgetLocked(groupId);
+    }
+}
+
+void SplitwiseManager::evictLocked(const std::string &groupId) const {
+    Partition &partition = partitions_.at(groupId);
+    std::vector<std::string> ids;
+    timeIndex_.forEachInRange(groupId, std::numeric_limits<std::int64_t>::min(),
+                              std::numeric_limits<std::int64_t>::max(),
+                              [&](const std::string &id) { ids.push_back(id); });
+    for (const auto &id : ids) {
+        auto it = expenses_.find(id);
+        timeIndex_.erase(it->second);
+        descriptionIndex_.remove(expenseIndex_.handleOf(id), it->second.getDescription());
+        expenseIndex_.erase(it->second);
+        expenses_.erase(it);
+    }
+    groups_.erase(groupId);
+    recentGroups_.erase(partition.recent);
+    partition.resident = false;
+    residentBytes_ -= partition.bytes;
+    partition.bytes = 0;
+    ++evictions_;
+    // Handles of erased expenses are never reused; compact once they outnumber the live ones.
+    if (expenseIndex_.handleCount() > 2 * expenses_.size() + 1024) {
+        rebuildIndexesLocked();
+    }
+}
+
+void SplitwiseManager::enforceBudgetLocked(const std::string &pinned) const {
+    if (partitionDir_.empty() || memoryBudget_ == 0) {
+        return;
+    }
+    std::vector<std::string> victims;
+    std::size_t remaining = residentBytes_;
+    for (auto it = recentGroups_.rbegin(); it != recentGroups_.rend() && remaining > memoryBudget_; ++it) {
+        if (*it != pinned) {
+            victims.push_back(*it);
+            remaining -= partitions_.at(*it).bytes;
+        }
+    }
+    if (victims.empty()) {
+        return;
+    }
+
+    tracing::Span span("evict");
+    // Changed groups reach their segment and the manifest before they leave memory.
+    bool wrote = false;
+    for (const auto &id : victims) {
+        const Partition &partition = partitions_.at(id);
+        if (partition.dirty || !partition.onDisk) {
+            writeBackLocked(id);
+            wrote = true;
+        }
+    }
+    if (wrote) {
+        syncManifestLocked();
+    }
+    for (const auto &id : victims) {
+        evictLocked(id);
+    }
+}
+
+void SplitwiseManager::writeBackLocked(const std::string &groupId) const {
+    Partition &partition = partitions_.at(groupId);
+    GroupSegment segment = segmentLocked(groupId);
+    partitioned::writeSegment(partitionDir_, partition.segment, segment);
+    partition.stored = partitioned::summarize(segment.expenses);
+    partition.storedExpenses = segment.expenses.size();
+    partition.onDisk = true;
+    partition.dirty = false;
+    ++segmentWrites_;
+}
+
+void SplitwiseManager::syncManifestLocked() const {
+    if (usersDirty_) {
+        std::vector<User> users;
+        users.reserve(users_.size());
+        for (const auto &[id, user] : users_) {
+            users.push_back(user);
+        }
+        partitioned::writeUsers(partitionDir_, users);
+        usersDirty_ = false;
+    }
+    // Summaries describe the segments on disk, so groups changed since their last write keep their old entry.
+    LedgerManifest manifest = manifestHeaderLocked();
+    for (const auto &[id, partition] : partitions_) {
+        if (partition.onDisk) {
+            manifest.groups.push_back({id, partition.name, partition.segment, partition.storedExpenses,
+                                       partition.stored});
+        }
+    }
+    // Links to a group without a segment yet are written along with that segment.
+    for (auto it = manifest.groupParents.begin(); it != manifest.groupParents.end();) {
+        if (partitions_.at(it->first).onDisk && partitions_.at(it->second).onDisk) {
+            ++it;
+        } else {
+            it = manifest.groupParents.erase(it);
+        }
+    }
+    // Likewise a key is written once the expense it names is: a crash in between must not leave a retry answered
+    // with an expense that was never stored.
+    auto &keys = manifest.idempotencyKeys;
+    keys.erase(std::remove_if(keys.begin(), keys.end(),
+                              [this](const IdempotencyRecord &record) {
+                                  auto it = expenses_.find(record.expenseId);
+                                  if (it == expenses_.end()) {
+                                      return false;
+                                  }
+                                  const Partition &partition = partitions_.at(it->second.getGroupId());
+                                  return partition.dirty || !partition.onDisk;
+                              }),
+               keys.end());
+    partitioned::writeManifest(partitionDir_, manifest);
+}
+
+void SplitwiseManager::notePartitionChangeLocked(const std::string &groupId, std::ptrdiff_t bytes) {
+    if (partitionDir_.empty()) {
+        return;
+    }
+    Partition &partition = partitions_.at(groupId);
+    partition.dirty = true;
+    partition.bytes = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(partition.bytes) + bytes);
+    residentBytes_ = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(residentBytes_) + bytes);
+    recentGroups_.splice(recentGroups_.begin(), recentGroups_, partition.recent);
+    enforceBudgetLocked(groupId);
+}
+
+LedgerManifest SplitwiseManager::manifestHeaderLocked() const {
+    LedgerManifest manifest;
+    manifest.baseCurrency = baseCurrency_;
+    manifest.counters = counters_;
+    manifest.latestTimestamp = latestTimestamp_;
+    manifest.recurring.reserve(recurring_.size());
+    for (const auto &[id, recurring] : recurring_) {
+        manifest.recurring.push_back(recurring);
+    }
+    manifest.recurringAsOf = recurringAsOf_;
+    manifest.groupParents = groupHierarchy_.parents();
+    manifest.idempotencyKeys = idempotency_.records();
+    // Written even when some groups are still dirty: a restarted leader must never number a new operation with a
+    // sequence its followers have already applied.
+    manifest.replicationSequence = replicationSequence_;
+    return manifest;
+}
+
+GroupSegment SplitwiseManager::segmentLocked(const std::string &groupId) const {
+    GroupSegment segment;
+    segment.group = groups_.at(groupId);
+    timeIndex_.forEachInRange(groupId, std::numeric_limits<std::int64_t>::min(),
+                              std::numeric_limits<std::int64_t>::max(),
+                              [&](const std::string &id) { segment.expenses.push_back(expenses_.at(id)); });
+    return segment;
+}
+
+std::vector<RankedBalance> SplitwiseManager::getTopCreditors(std::size_t n, const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    std::vector<RankedBalance> top = balanceRankLocked(groupId).top(n);
+    // The walk is in balance order, so entries that are not owed anything can only trail the list.
+    while (!top.empty() && top.back().balance <= 0.0) {
+        top.pop_back();
+    }
+    return top;
+}
+
+std::vector<RankedBalance> SplitwiseManager::getTopDebtors(std::size_t n, const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    std::vector<RankedBalance> bottom = balanceRankLocked(groupId).bottom(n);
+    while (!bottom.empty() && bottom.back().balance >= 0.0) {
+        bottom.pop_back();
+    }
+    return bottom;
+}
+
+std::optional<std::size_t> SplitwiseManager::getBalanceRank(const std::string &userId,
+                                                           const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return balanceRankLocked(groupId).rank(userId);
+}
+
+std::size_t SplitwiseManager::countBalancesBetween(double low, double high, const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return balanceRankLocked(groupId).countBetween(low, high);
+}
+
+BalanceSheet::BalanceMap SplitwiseManager::getRollupBalances(const std::string &groupId) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    requireGroupLocked(groupId);
+    if (const BalanceSheet::BalanceMap *rollup = groupHierarchy_.rollup(groupId)) {
+        return *rollup;
+    }
+    // A group outside the hierarchy rolls up to its own balances.
+    const auto &own = balanceRankLocked(groupId).balances();
+    return BalanceSheet::BalanceMap(own.begin(), own.end());
+}
+
+void SplitwiseManager::requireGroupLocked(const std::string &groupId) const {
+    // Partitioned groups count whether or not they are resident.
+    if (!groups_.count(groupId) && !partitions_.count(groupId)) {
+        throw std::invalid_argument("Unknown group id: " + groupId);
+    }
+}
+
+const BalanceRank &SplitwiseManager::balanceRankLocked(const std::string &groupId) const {
+    static const BalanceRank empty;
+    if (const BalanceRank *rank = balanceRanks_.find(groupId)) {
+        return *rank;
+    }
+    // Group rankings survive eviction, so a partitioned group never needs paging in to be ranked.
+    if (!groups_.count(groupId) && !partitions_.count(groupId)) {
+        throw std::invalid_argument("Unknown group id: " + groupId);
+    }
+    return empty;
+}
+
+std::vector<SettlementTransaction> SplitwiseManager::settleUpGreedy() const {
+    tracing::Span span("settleUpGreedy");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::SettleUpGreedy);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return settleGreedy(balanceSheet_.getBalances(), threadPool().get());
+}
+
+std::vector<SettlementTransaction> SplitwiseManager::settleUpGreedy(const std::string &currency) const {
+    tracing::Span span("settleUpGreedy");
+    metrics::ScopedTimer timer(metrics_, metrics::Operation::SettleUpGreedy);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return settleGreedy(balancesInLocked(currency), threadPool().get());
+}
+
+std::vector<SettlementTransaction> settleGreedy(const BalanceSheet::BalanceMap &balances, ThreadPool *pool) {
+    struct Entry {
+        const std::string *userId;
+        double amount;
+    };
+    using Sides = std::pair<std::vector<Entry>, std::vector<Entry>>;
+
+    std::vector<Entry> creditors;
+    std::vector<Entry> debtors;
+    auto creditorCmp = [](const Entry &a, const Entry &b) { return a.amount < b.amount; };
+    auto debtorCmp = [](const Entry &a, const Entry &b) { return a.amount > b.amount; };
+    {
+        tracing::Span partitionSpan("settleUpGreedy.partition");
+        std::vector<const BalanceSheet::BalanceMap::value_type *> entries;
+        entries.reserve(balances.size());
+        for (const auto &entry : balances) {
+            entries.push_back(&entry);
+        }
+        // Chunks are concatenated in order, so both sides list users exactly as a sequential scan would.
+        Sides sides = parallelReduce(
+            pool, entries.size(), SETTLE_GRAIN, Sides{},
+            [&](std::size_t begin, std::size_t end) {
+                Sides part;
+                for (std::size_t i = begin; i < end; ++i) {
+                    const auto &[userId, balance] = *entries[i];
+                    if (balance > EPSILON) {
+                        part.first.push_back({&userId, balance});
+                    } else if (balance < -EPSILON) {
+                        part.second.push_back({&userId, balance});
+                    }
+                }
+                return part;
+            },
+            [](Sides total, Sides part) {
+                total.first.insert(total.first.end(), part.first.begin(), part.first.end());
+                total.second.insert(total.second.end(), part.second.begin(), part.second.end());
+                return total;
+            });
+        creditors = std::move(sides.first);
+        debtors = std::move(sides.second);
+        parallelFor(pool, 2, 1, [&](std::size_t side, std::size_t) {
+            if (side == 0) {
+                std::make_heap(creditors.begin(), creditors.end(), creditorCmp);
+            } else {
+                std::make_heap(debtors.begin(), debtors.end(), debtorCmp);
+            }
+        });
+    }
+
+    // Each step depends on the previous one, so matching stays sequential.
+    tracing::Span matchSpan("settleUpGreedy.match");
     std::vector<SettlementTransaction> result;
-    while (!creditorQueue.empty() && !debtorQueue.empty()) {
-        Entry creditor = creditorQueue.top();
-        creditorQueue.pop();
-        Entry debtor = debtorQueue.top();
-        debtorQueue.pop();
+    while (!creditors.empty() && !debtors.empty()) {
+        std::pop_heap(creditors.begin(), creditors.end(), creditorCmp);
+        Entry creditor = creditors.back();
+        creditors.pop_back();
+        std::pop_heap(debtors.begin(), debtors.end(), debtorCmp);
+        Entry debtor = debtors.back();
+        debtors.pop_back();
 
         double settlement = std::min(creditor.amount, -debtor.amount);
         creditor.amount -= settlement;
         debtor.amount += settlement;
-        result.push_back({debtor.userId, creditor.userId, settlement});
+        result.push_back({*debtor.userId, *creditor.userId, settlement});
 
         if (creditor.amount > EPSILON) {
-            creditorQueue.push(creditor);
+            creditors.push_back(creditor);
+            std::push_heap(creditors.begin(), creditors.end(), creditorCmp);
         }
         if (debtor.amount < -EPSILON) {
-            debtorQueue.push(debtor);
+            debtors.push_back(debtor);
+            std::push_heap(debtors.begin(), debtors.end(), debtorCmp);
         }
     }
     return result;
 }
 
+AuditReport SplitwiseManager::audit(const std::string &ledgerPath, double tolerance) const {
+    tracing::Span span("audit");
+    std::vector<Expense> expenses;
+    std::map<std::string, BalanceSheet::BalanceMap> recorded;
+    std::vector<RecurringExpense> recurring;
+    std::int64_t recurringAsOf = 0;
+    std::string baseCurrency;
+    {
+        tracing::Span captureSpan("audit.capture");
+        metrics::TimedLockGuard lock(mutex_, metrics_);
+        ensureAllResidentLocked();
+        expenses.reserve(expenses_.size());
+        for (const auto &[id, expense] : expenses_) {
+            expenses.push_back(expense);
+        }
+        for (const auto &[id, expense] : recurring_) {
+            recurring.push_back(expense);
+        }
+        recurringAsOf = recurringAsOf_;
+        baseCurrency = baseCurrency_;
+        recorded[baseCurrency_] = balanceSheet_.getBalances();
+        for (const auto &[code, sheet] : currencyBalances_) {
+            recorded[code] = sheet.getBalances();
+        }
+    }
+
+    auto pool = threadPool();
+    AuditReport report;
+    report.expensesChecked = expenses.size();
+    LedgerRecount recount;
+    {
+        tracing::Span recountSpan("audit.recount");
+        recount = recountLedger(expenses, baseCurrency, tolerance, pool.get());
+        addRecurringToRecount(recount, recurring, recurringAsOf, baseCurrency, tolerance);
+    }
+    report.zeroSumViolations = std::move(recount.violations);
+    std::set<std::string> currencies;
+    for (const auto &[code, balances] : recount.balances) {
+        currencies.insert(code);
+    }
+    for (const auto &[code, balances] : recorded) {
+        currencies.insert(code);
+    }
+    for (const auto &code : currencies) {
+        auto found = diffBalances(code, recount.balances[code], recorded[code], tolerance);
+        report.live.insert(report.live.end(), found.begin(), found.end());
+    }
+    report.expected = std::move(recount.balances);
+
+    if (!ledgerPath.empty()) {
+        tracing::Span persistedSpan("audit.persisted");
+        std::ifstream in(ledgerPath);
+        if (!in) {
+            throw std::runtime_error("Failed to open file for reading: " + ledgerPath);
+        }
+        nlohmann::json j;
+        in >> j;
+        if (!j.is_object() || !j.contains("expenses") || !j.at("expenses").is_array()) {
+            throw std::runtime_error("Invalid JSON format: '" + ledgerPath + "' is not a saved ledger");
+        }
+        const auto records = j.at("expenses").begin();
+        std::vector<Expense> saved(static_cast<std::size_t>(j.at("expenses").end() - records));
+        parallelFor(pool.get(), saved.size(), LOAD_GRAIN, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto &record = records[static_cast<std::ptrdiff_t>(i)];
+                auto strategy = SplitStrategyFactory::create(record.at("strategy").get<std::string>());
+                saved[i] = Expense::fromJson(record, strategy);
+            }
+        });
+        // Only base-currency balances are persisted.
+        const std::string savedBase = j.value("baseCurrency", std::string{});
+        BalanceSheet::BalanceMap persisted;
+        if (j.contains("balances")) {
+            persisted = j.at("balances").get<BalanceSheet::BalanceMap>();
+        }
+        LedgerRecount savedRecount = recountLedger(saved, savedBase, tolerance, pool.get());
+        if (j.contains("recurring") && j.at("recurring").is_array()) {
+            std::vector<RecurringExpense> savedRecurring;
+            for (const auto &record : j.at("recurring")) {
+                auto strategy = SplitStrategyFactory::create(record.at("strategy").get<std::string>());
+                savedRecurring.push_back(RecurringExpense::fromJson(record, strategy));
+            }
+            // Defaulted as in loadLocked: a file without an accrual time has not counted any occurrence yet.
+            const double asOf = j.value("recurringAsOf", static_cast<double>(std::numeric_limits<std::int64_t>::min()));
+            addRecurringToRecount(savedRecount, savedRecurring, static_cast<std::int64_t>(asOf), savedBase, tolerance);
+        }
+        report.persistedChecked = true;
+        report.persistedExpensesChecked = saved.size();
+        report.persisted = diffBalances(savedBase, savedRecount.balances[savedBase], persisted, tolerance);
+    }
+    return report;
+}
+
+void SplitwiseManager::setParallelism(unsigned threads) {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    if (threads != parallelism_) {
+        parallelism_ = threads;
+        pool_.reset();
+    }
+}
+
+unsigned SplitwiseManager::getParallelism() const {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    return parallelism_ != 0 ? parallelism_ : std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::shared_ptr<ThreadPool> SplitwiseManager::threadPool() const {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    const unsigned threads = parallelism_ != 0 ? parallelism_ : std::max(1u, std::thread::hardware_concurrency());
+    if (threads <= 1) {
+        return nullptr;
+    }
+    if (!pool_) {
+        pool_ = std::make_shared<ThreadPool>(threads - 1);
+    }
+    return pool_;
+}
+
+metrics::ManagerStats SplitwiseManager::getStats() const { return metrics_.snapshot(); }
+
+memory::MemoryUsage SplitwiseManager::memoryUsage() const {
+    using memory::stringBytes;
+    tracing::Span span("memoryUsage");
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    memory::MemoryUsage usage;
+    auto &components = usage.components;
+
+    auto &users = components["users"];
+    users = {users_.size(), sizeof(users_)};
+    for (const auto &[id, user] : users_) {
+        users.bytes += memory::treeNodeBytes<decltype(users_)::value_type>() + stringBytes(id) +
+                       stringBytes(user.getId()) + stringBytes(user.getName());
+    }
+
+    auto &groups = components["groups"];
+    groups = {groups_.size(), sizeof(groups_)};
+    for (const auto &[id, group] : groups_) {
+        groups.bytes += memory::treeNodeBytes<decltype(groups_)::value_type>() + stringBytes(id) + group.memoryBytes();
+    }
+
+    auto &expenses = components["expenses"];
+    expenses = {expenses_.size(), sizeof(expenses_)};
+    for (const auto &[id, expense] : expenses_) {
+        expenses.bytes += memory::treeNodeBytes<decltype(expenses_)::value_type>() + stringBytes(id) +
+                          expense.memoryBytes() - sizeof(Expense);
+    }
+
+    components["balances"] = {balanceSheet_.getBalances().size(), balanceSheet_.memoryBytes()};
+    components["balanceRanks"] = {balanceSheet_.getBalances().size(), balanceRanks_.memoryBytes()};
+    components["groupHierarchy"] = {groupHierarchy_.size(), groupHierarchy_.memoryBytes()};
+    components["idempotency"] = {idempotency_.size(), idempotency_.memoryBytes()};
+    if (replicationLog_) {
+        components["replicationLog"] = {static_cast<std::size_t>(replicationLog_->latest() - replicationLog_->start()),
+                                        sizeof(ReplicationLog) + replicationLog_->memoryBytes()};
+    }
+    auto &currencies = components["currencyBalances"];
+    currencies.bytes = sizeof(currencyBalances_);
+    for (const auto &[code, sheet] : currencyBalances_) {
+        currencies.objects += sheet.getBalances().size();
+        currencies.bytes += memory::treeNodeBytes<decltype(currencyBalances_)::value_type>() + stringBytes(code) +
+                            sheet.memoryBytes() - sizeof(BalanceSheet);
+    }
+
+    components["timeIndex"] = {timeIndex_.all().size(), timeIndex_.memoryBytes()};
+    components["expenseIndex"] = {expenses_.size(), expenseIndex_.memoryBytes()};
+    components["descriptionIndex"] = {descriptionIndex_.termCount(), descriptionIndex_.memoryBytes()};
+    components["balanceHistory"] = {balanceHistory_.size(), balanceHistory_.memoryBytes()};
+    // The table may be shared with other managers through FxTable::load's cache.
+    components["fxTable"] = fxTable_ ? memory::Footprint{fxTable_->size(), fxTable_->memoryBytes()}
+                                     : memory::Footprint{};
+    components["notifier"] =
+        notifier_ ? memory::Footprint{1, memory::allocationBytes(2 * sizeof(void *) + notifier_->memoryBytes())}
+                  : memory::Footprint{};
+
+    auto &counters = components["counters"];
+    counters = {counters_.size(), sizeof(counters_)};
+    for (const auto &[prefix, value] : counters_) {
+        counters.bytes += memory::treeNodeBytes<decltype(counters_)::value_type>() + stringBytes(prefix);
+    }
+    components["metrics"] = {1, sizeof(metrics_)};
+
+    auto &recurring = components["recurring"];
+    recurring = {recurring_.size(), sizeof(recurring_)};
+    for (const auto &[id, expense] : recurring_) {
+        recurring.bytes += memory::treeNodeBytes<decltype(recurring_)::value_type>() + stringBytes(id) +
+                           expense.memoryBytes() - sizeof(RecurringExpense);
+    }
+
+    auto &partitions = components["partitions"];
+    partitions = {partitions_.size(), sizeof(partitions_) + sizeof(recentGroups_) + stringBytes(partitionDir_)};
+    for (const auto &[id, partition] : partitions_) {
+        partitions.bytes += memory::treeNodeBytes<decltype(partitions_)::value_type>() + stringBytes(id) +
+                            stringBytes(partition.name) + stringBytes(partition.segment);
+        if (partition.resident) {
+            partitions.bytes += memory::allocationBytes(2 * sizeof(void *) + sizeof(std::string)) + stringBytes(id);
+        }
+        for (const auto &[code, balances] : partition.stored) {
+            partitions.bytes += memory::treeNodeBytes<GroupBalanceSummary::value_type>() + stringBytes(code);
+            for (const auto &[userId, balance] : balances) {
+                partitions.bytes += memory::treeNodeBytes<BalanceSheet::BalanceMap::value_type>() +
+                                    stringBytes(userId);
+            }
+        }
+    }
+
+    usage.lastLoadJson = lastLoadJson_;
+    usage.heap = memory::heapStats();
+    return usage;
+}
+
 void SplitwiseManager::setNotifier(std::shared_ptr<INotifier> notifier) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
     notifier_ = std::move(notifier);
 }
 
 void SplitwiseManager::setNotificationThreshold(double threshold) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    metrics::TimedLockGuard lock(mutex_, metrics_);
     notificationThreshold_ = threshold;
 }
 
@@ -265,14 +1857,401 @@ void ConsoleNotifier::notifyLargeExpense(const Expense &expense, double threshol
               << "\n";
 }
 
+Group &SplitwiseManager::groupLocked(const std::string &groupId) {
+    pageInLocked(groupId, false);
+    auto it = groups_.find(groupId);
+    if (it == groups_.end()) {
+        throw std::invalid_argument("Unknown group id: " + groupId);
+    }
+    return it->second;
+}
+
+void SplitwiseManager::validateExpenseLocked(const std::string &groupId,
+                                             const SplitInput &input,
+                                             std::int64_t timestamp) const {
+    validateCurrency(input.currency);
+    auto groupIt = groups_.find(groupId);
+    if (groupIt == groups_.end()) {
+        throw std::invalid_argument("Unknown group id: " + groupId);
+    }
+    const auto &group = groupIt->second;
+    if (input.participantIds.empty()) {
+        throw std::invalid_argument("Expense must include at least one participant");
+    }
+    const Group::Epoch epoch = group.epochAt(timestamp);
+    if (!group.hasMemberAtEpoch(input.payerId, epoch)) {
+        throw std::invalid_argument("Payer must be part of the group");
+    }
+    if (std::find(input.participantIds.begin(), input.participantIds.end(), input.payerId) ==
+        input.participantIds.end()) {
+        throw std::invalid_argument("Participants must include the payer");
+    }
+    for (const auto &participant : input.participantIds) {
+        if (!group.hasMemberAtEpoch(participant, epoch)) {
+            throw std::invalid_argument("Participant not in group: " + participant);
+        }
+    }
+}
+
+bool SplitwiseManager::isBaseCurrencyLocked(const std::string &currency) const noexcept {
+    return currency.empty() || currency == baseCurrency_;
+}
+
+void SplitwiseManager::applyCurrencyDeltaLocked(const std::string &groupId,
+                                                const std::string &currency,
+                                                std::int64_t timestamp,
+                                                const BalanceSheet::BalanceMap &delta) {
+    if (delta.empty()) {
+        return;
+    }
+    if (isBaseCurrencyLocked(currency)) {
+        balanceSheet_.applyDelta(delta);
+        balanceRanks_.apply(groupId, delta);
+        groupHierarchy_.apply(groupId, delta);
+        balanceHistory_.revise(timestamp, delta);
+    } else {
+        currencyBalances_[currency].applyDelta(delta);
+    }
+}
+
+void SplitwiseManager::validateCurrency(const std::string &currency) {
+    if (!std::all_of(currency.begin(), currency.end(), [](char c) { return c >= 'A' && c <= 'Z'; })) {
+        throw std::invalid_argument("Currency must be an upper-case code: " + currency);
+    }
+}
+
+void SplitwiseManager::setDeduplication(const DeduplicationOptions &options) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    idempotency_.configure(options);
+}
+
+DeduplicationOptions SplitwiseManager::getDeduplication() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return idempotency_.options();
+}
+
+DeduplicationStats SplitwiseManager::getDeduplicationStats() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return idempotency_.stats();
+}
+
+void SplitwiseManager::enableReplicationLog(std::size_t retain) {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (following_) {
+        throw std::invalid_argument("A follower cannot log operations; promote it by restarting it as a leader");
+    }
+    if (!replicationLog_) {
+        replicationLog_ = std::make_unique<ReplicationLog>(replicationSequence_, retain);
+    }
+}
+
+ReplicationBatch SplitwiseManager::getReplicatedOperations(std::uint64_t sequence, std::size_t limit) const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (!replicationLog_) {
+        throw std::invalid_argument("This manager does not log operations for replication");
+    }
+    return replicationLog_->after(sequence, limit);
+}
+
+std::size_t SplitwiseManager::applyReplicatedBatch(const ReplicationBatch &batch) {
+    tracing::Span span("applyReplicatedBatch");
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    if (replicationLog_) {
+        throw std::invalid_argument("A leader cannot apply replicated operations");
+    }
+    following_ = true;
+    accrueRecurringLocked(currentTimestamp());
+    std::size_t applied = 0;
+    for (const auto &entry : batch.operations) {
+        if (entry.sequence <= replicationSequence_) {
+            continue;
+        }
+        if (entry.sequence != replicationSequence_ + 1) {
+            throw std::invalid_argument("Replicated operation " + std::to_string(entry.sequence) +
+                                        " does not follow " + std::to_string(replicationSequence_));
+        }
+        try {
+            applyOperationLocked(entry.operation);
+        } catch (const std::exception &ex) {
+            throw std::runtime_error("Cannot apply replicated operation " + std::to_string(entry.sequence) + ": " +
+                                     ex.what());
+        }
+        replicationSequence_ = entry.sequence;
+        replicationTime_ = entry.time;
+        ++applied;
+    }
+    leaderSequence_ = std::max(leaderSequence_, batch.leaderSequence);
+    leaderTime_ = std::max(leaderTime_, batch.leaderTime);
+    return applied;
+}
+
+void SplitwiseManager::applyOperationLocked(const nlohmann::json &operation) {
+    const std::string type = operation.at("op").get<std::string>();
+    if (type == "user") {
+        const std::string id = operation.at("id").get<std::string>();
+        if (!users_.emplace(id, User{id, operation.at("name").get<std::string>()}).second) {
+            throw std::invalid_argument("User id already taken: " + id);
+        }
+        usersDirty_ = true;
+        reserveIdLocked("USR", id);
+    } else if (type == "group") {
+        const std::string id = addGroupLocked(operation.at("name").get<std::string>(),
+                                              operation.at("members").get<std::vector<std::string>>(),
+                                              operation.at("id").get<std::string>());
+        reserveIdLocked("GRP", id);
+    } else if (type == "member") {
+        changeMembershipLocked(operation.at("group").get<std::string>(), operation.at("user").get<std::string>(),
+                               static_cast<std::int64_t>(operation.at("timestamp").get<double>()),
+                               operation.at("joined").get<bool>());
+    } else if (type == "expense" || type == "update") {
+        const nlohmann::json &record = operation.at("expense");
+        auto strategy = SplitStrategyFactory::create(record.at("strategy").get<std::string>());
+        const Expense expense = Expense::fromJson(record, strategy);
+        if (type == "update") {
+            updateExpenseLocked(expense.getId(), expense.getDescription(), expense.getInput(), strategy);
+        } else if (expenses_.count(expense.getId())) {
+            throw std::invalid_argument("Expense id already taken: " + expense.getId());
+        } else {
+            addExpenseLocked(expense.getGroupId(), expense.getDescription(), expense.getInput(), strategy,
+                             expense.getTimestamp(), expense.getId());
+            reserveIdLocked("EXP", expense.getId());
+            // The leader's keys are remembered too, so a promoted follower still rejects resubmissions.
+            if (operation.contains("key")) {
+                idempotency_.insert(operation.at("key").get<std::string>(), expense.getId(),
+                                    static_cast<std::int64_t>(operation.at("ingested").get<double>()));
+            }
+        }
+    } else if (type == "delete") {
+        deleteExpenseLocked(operation.at("id").get<std::string>());
+    } else if (type == "base-currency") {
+        const std::string code = operation.at("code").get<std::string>();
+        validateCurrency(code);
+        baseCurrency_ = code;
+        recomputeBalances();
+    } else if (type == "parent") {
+        setGroupParentLocked(operation.at("group").get<std::string>(), operation.at("parent").get<std::string>());
+    } else {
+        throw std::invalid_argument("Unknown replicated operation: " + type);
+    }
+}
+
+std::uint64_t SplitwiseManager::getReplicationSequence() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    return replicationSequence_;
+}
+
+ReplicationStatus SplitwiseManager::getReplicationStatus() const {
+    metrics::TimedLockGuard lock(mutex_, metrics_);
+    ReplicationStatus status;
+    status.sequence = replicationSequence_;
+    status.leaderSequence = replicationSequence_;
+    if (replicationLog_) {
+        status.role = "leader";
+    } else if (following_) {
+        status.role = "follower";
+        status.leaderSequence = std::max(leaderSequence_, replicationSequence_);
+        status.lagOperations = status.leaderSequence - replicationSequence_;
+        status.lagMillis = status.lagOperations == 0 ? 0 : std::max<std::int64_t>(0, leaderTime_ - replicationTime_);
+    }
+    return status;
+}
+
+void SplitwiseManager::logOperationLocked(nlohmann::json operation) {
+    if (replicationLog_) {
+        replicationTime_ = currentMillis();
+        replicationSequence_ = replicationLog_->append(std::move(operation), replicationTime_);
+    }
+}
+
+void SplitwiseManager::logExpenseLocked(const char *op,
+                                        const std::string &expenseId,
+                                        const std::string &idempotencyKey,
+                                        std::int64_t ingested) {
+    if (replicationLog_) {
+        nlohmann::json operation = {{"op", op}, {"expense", expenses_.at(expenseId).toJson()}};
+        if (!idempotencyKey.empty()) {
+            operation["key"] = idempotencyKey;
+            operation["ingested"] = static_cast<double>(ingested);
+        }
+        logOperationLocked(std::move(operation));
+    }
+}
+
+void SplitwiseManager::refuseWhileLeaderLocked(const std::string &what) const {
+    if (replicationLog_) {
+        throw std::invalid_argument(what + " are not replicated and cannot be used on a replication leader");
+    }
+}
+
+void SplitwiseManager::reserveIdLocked(const std::string &prefix, const std::string &id) {
+    // Keep generated ids clear of ids assigned elsewhere, so a replica promoted to leader continues the sequence.
+    if (id.size() > prefix.size() && id.rfind(prefix, 0) == 0 &&
+        id.find_first_not_of("0123456789", prefix.size()) == std::string::npos) {
+        std::size_t &counter = counters_[prefix];
+        counter = std::max<std::size_t>(counter, std::stoul(id.substr(prefix.size())));
+    }
+}
+
 std::string SplitwiseManager::generateId(const std::string &prefix) {
-    std::size_t count = ++counters_[prefix];
-    return prefix + std::to_string(count);
+    std::size_t &counter = counters_[prefix];
+    // Users are replicated to every shard under the ids shard 0 hands out; other records live on one shard, which
+    // takes the next number congruent to its index.
+    if (idShards_ == 1 || prefix == "USR") {
+        return prefix + std::to_string(++counter);
+    }
+    counter += 1 + (idShard_ + idShards_ - counter % idShards_) % idShards_;
+    return prefix + std::to_string(counter);
 }
 
 void SplitwiseManager::recomputeBalances() {
+    tracing::Span span("recomputeBalances");
+    ensureAllResidentLocked();
+    historyStale_ = false;
     balanceSheet_.clear();
-    for (const auto &[id, expense] : expenses_) {
-        balanceSheet_.applyDelta(expense.getStrategy()->computeSplits(expense.getInput()));
+    balanceRanks_.clear();
+    groupHierarchy_.invalidate();
+    currencyBalances_.clear();
+    balanceHistory_.clear();
+    std::vector<const Expense *> ordered;
+    ordered.reserve(expenses_.size());
+    for (const auto &[timestamp, id] : timeIndex_.all()) {
+        ordered.push_back(&expenses_.at(id));
+    }
+
+    // Splits are computed in parallel one window at a time, then applied in time order on this thread so balance
+    // checkpoints are produced in the same pass and sums match a sequential replay exactly.
+    auto pool = threadPool();
+    std::vector<BalanceSheet::BalanceMap> deltas(std::min(ordered.size(), SPLIT_WINDOW));
+    for (std::size_t window = 0; window < ordered.size(); window += SPLIT_WINDOW) {
+        const std::size_t size = std::min(SPLIT_WINDOW, ordered.size() - window);
+        parallelFor(pool.get(), size, SPLIT_GRAIN, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const Expense &expense = *ordered[window + i];
+                deltas[i] = expense.getStrategy()->computeSplits(expense.getInput());
+            }
+        });
+        for (std::size_t i = 0; i < size; ++i) {
+            const Expense &expense = *ordered[window + i];
+            const BalanceSheet::BalanceMap &delta = deltas[i];
+            if (isBaseCurrencyLocked(expense.getInput().currency)) {
+                balanceSheet_.applyDelta(delta);
+                balanceRanks_.apply(expense.getGroupId(), delta);
+                balanceHistory_.record(expense.getTimestamp(), delta, balanceSheet_, historyBoundaryLocked());
+            } else {
+                currencyBalances_[expense.getInput().currency].applyDelta(delta);
+            }
+            metrics_.addBalancesTouched(delta.size());
+        }
+    }
+    metrics_.addExpensesApplied(expenses_.size());
+    for (const auto &[id, recurring] : recurring_) {
+        applyRecurringLocked(recurring, std::numeric_limits<std::int64_t>::min(), recurringAsOf_, 1.0);
+    }
+    groupHierarchy_.rebuild(balanceRanks_);
+}
+
+void SplitwiseManager::accrueRecurringLocked(std::int64_t asOf) {
+    if (recurring_.empty() || asOf <= recurringAsOf_) {
+        return;
+    }
+    const std::int64_t from = recurringAsOf_;
+    recurringAsOf_ = asOf;
+    for (const auto &[id, recurring] : recurring_) {
+        applyRecurringLocked(recurring, from, asOf, 1.0);
+    }
+}
+
+void SplitwiseManager::applyRecurringLocked(const RecurringExpense &recurring,
+                                            std::int64_t after,
+                                            std::int64_t upTo,
+                                            double sign) {
+    const std::uint64_t count = recurring.countBetween(after, upTo);
+    if (count == 0) {
+        return;
+    }
+    const BalanceSheet::BalanceMap &delta = recurring.getDelta();
+    BalanceSheet::BalanceMap scaled = scaledDelta(delta, sign * static_cast<double>(count));
+    const std::string &currency = recurring.getInput().currency;
+    if (isBaseCurrencyLocked(currency)) {
+        balanceSheet_.applyDelta(scaled);
+        balanceRanks_.apply(recurring.getGroupId(), scaled);
+        groupHierarchy_.apply(recurring.getGroupId(), scaled);
+        // Each checkpoint receives only the occurrences up to its own boundary.
+        const std::int64_t first = after == std::numeric_limits<std::int64_t>::min() ? after : after + 1;
+        balanceHistory_.reviseScaled(first, delta, [&](std::int64_t boundary) {
+            return sign * static_cast<double>(recurring.countBetween(after, std::min(boundary, upTo)));
+        });
+    } else {
+        currencyBalances_[currency].applyDelta(scaled);
+    }
+    metrics_.addBalancesTouched(delta.size());
+}
+
+bool SplitwiseManager::materializeOccurrenceLocked(const std::string &expenseId) {
+    std::string templateId;
+    std::uint64_t index = 0;
+    if (!RecurringExpense::parseOccurrenceId(expenseId, templateId, index)) {
+        return false;
+    }
+    auto found = recurring_.find(templateId);
+    // Only accrued occurrences exist; later ones can be changed by ending the template instead.
+    if (found == recurring_.end() || !found->second.hasOccurrence(index) ||
+        found->second.getSchedule().occurrenceTime(index) > recurringAsOf_) {
+        return false;
+    }
+    // The occurrence moves from the template's count into the ledger as a regular expense with the same splits, so
+    // balances do not change.
+    RecurringExpense &recurring = found->second;
+    const Expense occurrence = recurring.occurrence(index);
+    addExpenseLocked(occurrence.getGroupId(), occurrence.getDescription(), occurrence.getInput(),
+                     occurrence.getStrategy(), occurrence.getTimestamp(), expenseId);
+    recurring.skip(index);
+    applyCurrencyDeltaLocked(occurrence.getGroupId(), occurrence.getInput().currency, occurrence.getTimestamp(),
+                             scaledDelta(recurring.getDelta(), -1.0));
+    return true;
+}
+
+void SplitwiseManager::rebuildHistoryLocked() const {
+    tracing::Span span("rebuildHistory");
+    historyStale_ = false;
+    balanceHistory_.clear();
+    std::vector<const Expense *> ordered;
+    ordered.reserve(expenses_.size());
+    for (const auto &[timestamp, id] : timeIndex_.all()) {
+        const Expense &expense = expenses_.at(id);
+        if (isBaseCurrencyLocked(expense.getInput().currency)) {
+            ordered.push_back(&expense);
+        }
     }
-}
\ No newline at end of file
+
+    // The same replay as recomputeBalances, into a scratch sheet: the live balances are already correct.
+    BalanceSheet running;
+    auto pool = threadPool();
+    std::vector<BalanceSheet::BalanceMap> deltas(std::min(ordered.size(), SPLIT_WINDOW));
+    for (std::size_t window = 0; window < ordered.size(); window += SPLIT_WINDOW) {
+        const std::size_t size = std::min(SPLIT_WINDOW, ordered.size() - window);
+        parallelFor(pool.get(), size, SPLIT_GRAIN, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const Expense &expense = *ordered[window + i];
+                deltas[i] = expense.getStrategy()->computeSplits(expense.getInput());
+            }
+        });
+        for (std::size_t i = 0; i < size; ++i) {
+            running.applyDelta(deltas[i]);
+            balanceHistory_.record(ordered[window + i]->getTimestamp(), deltas[i], running, historyBoundaryLocked());
+        }
+    }
+    const std::int64_t first = std::numeric_limits<std::int64_t>::min();
+    for (const auto &[id, recurring] : recurring_) {
+        if (isBaseCurrencyLocked(recurring.getInput().currency)) {
+            balanceHistory_.reviseScaled(first, recurring.getDelta(), [&](std::int64_t boundary) {
+                return static_cast<double>(recurring.countBetween(first, std::min(boundary, recurringAsOf_)));
+            });
+        }
+    }
+}
+
+std::int64_t SplitwiseManager::historyBoundaryLocked() const noexcept {
+    // Live balances hold every expense and every occurrence accrued so far.
+    return std::max(latestTimestamp_, recurringAsOf_);
+}
@@ -0,0 +1,38 @@
+#include "strand.hpp"
+
+#include <utility>
+
+void Strand::post(ThreadPool::Task task) {
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(task));
+        schedule = !scheduled_;
+        scheduled_ = true;
+    }
+    if (schedule) {
+        pool_.submit([self = shared_from_this()] { self->drain(); });
+    }
+}
+
+std::size_t Strand::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void Strand::drain() {
+    while (true) {
+        std::deque<ThreadPool::Task> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty()) {
+                scheduled_ = false;
+                return;
+            }
+            batch.swap(queue_);
+        }
+        for (auto &task : batch) {
+            task();
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#include "thread_pool.hpp"
+
+#include <exception>
+
+namespace {
+// Identifies the pool worker running on this thread, so nested submissions land on the worker's own deque.
+thread_local const ThreadPool *tCurrentPool = nullptr;
+thread_local unsigned tWorkerIndex = 0;
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    if (tCurrentPool == this) {
+        WorkerQueue &own = *queues_[tWorkerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        injected_.push_back(std::move(task));
+    }
+    // Counted after the push so a worker that sees the count can always find the task; the sleep mutex orders the
+    // increment against a worker's check-then-wait.
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        ++queued_;
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::forEachChunk(std::size_t count, const std::function<void(std::size_t)> &chunk) {
+    if (count == 0) {
+        return;
+    }
+    struct State {
+        std::size_t count{0};
+        const std::function<void(std::size_t)> *chunk{nullptr};
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::atomic<bool> failed{false};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->chunk = &chunk;
+
+    // Helpers and caller claim chunks from one counter. A helper that starts after every chunk was claimed returns
+    // without touching `chunk`, which only lives as long as this call.
+    auto work = [](State &s) {
+        for (std::size_t index = s.next.fetch_add(1); index < s.count; index = s.next.fetch_add(1)) {
+            if (!s.failed.load(std::memory_order_relaxed)) {
+                try {
+                    (*s.chunk)(index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(s.mutex);
+                    if (!s.error) {
+                        s.error = std::current_exception();
+                    }
+                    s.failed = true;
+                }
+            }
+            if (s.done.fetch_add(1) + 1 == s.count) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.finished.notify_all();
+            }
+        }
+    };
+    const std::size_t helpers = std::min<std::size_t>(size(), count - 1);
+    for (std::size_t i = 0; i < helpers; ++i) {
+        submit([state, work] { work(*state); });
+    }
+    work(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load() == count; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    tCurrentPool = this;
+    tWorkerIndex = index;
+    while (true) {
+        Task task;
+        if (takeTask(index, task)) {
+            --queued_;
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::takeTask(unsigned index, Task &task) {
+    {
+        WorkerQueue &own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        if (!injected_.empty()) {
+            task = std::move(injected_.front());
+            injected_.pop_front();
+            return true;
+        }
+    }
+    const unsigned count = static_cast<unsigned>(queues_.size());
+    for (unsigned offset = 1; offset < count; ++offset) {
+        WorkerQueue &victim = *queues_[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
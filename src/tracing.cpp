@@ -0,0 +1,154 @@
+#include "tracing.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+namespace tracing {
+
+namespace detail {
+std::atomic<bool> gEnabled{false};
+}
+
+namespace {
+struct Event {
+    const char *name;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+    std::uint32_t depth;
+};
+
+/**
+ * @brief Events recorded by one thread; only the owning thread appends, `flush()` reads under the same mutex.
+ */
+struct ThreadBuffer {
+    std::uint32_t tid{0};
+    std::mutex mutex;
+    std::vector<Event> events;
+};
+
+class Collector {
+public:
+    Collector() : epoch_(std::chrono::steady_clock::now()) {
+        if (const char *path = std::getenv("SPLITWISE_TRACE"); path && *path) {
+            start(path);
+        }
+    }
+
+    ~Collector() {
+        if (!path_.empty()) {
+            try {
+                flush();
+            } catch (...) {
+                // Never throw from static destruction; a missing trace is preferable to terminate().
+            }
+        }
+    }
+
+    void start(const std::string &path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path_ = path;
+        detail::gEnabled.store(true, std::memory_order_relaxed);
+    }
+
+    ThreadBuffer &buffer() {
+        thread_local std::shared_ptr<ThreadBuffer> local;
+        if (!local) {
+            local = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(mutex_);
+            local->tid = static_cast<std::uint32_t>(buffers_.size() + 1);
+            buffers_.push_back(local);
+        }
+        return *local;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &buffer : buffers_) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+        }
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (path_.empty()) {
+            return;
+        }
+        std::ofstream out(path_);
+        if (!out) {
+            throw std::runtime_error("Failed to open trace file for writing: " + path_);
+        }
+        const long pid = static_cast<long>(::getpid());
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << std::fixed << std::setprecision(3);
+        bool first = true;
+        for (const auto &buffer : buffers_) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+                << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":\"thread-" << buffer->tid << "\"}}";
+            first = false;
+            for (const auto &event : buffer->events) {
+                out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"splitwise\",\"ph\":\"X\",\"ts\":"
+                    << micros(event.start - epoch_) << ",\"dur\":" << micros(event.end - event.start)
+                    << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid << ",\"args\":{\"depth\":" << event.depth
+                    << "}}";
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    void stop() {
+        detail::gEnabled.store(false, std::memory_order_relaxed);
+        flush();
+    }
+
+private:
+    static double micros(std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    std::chrono::steady_clock::time_point epoch_;
+    std::mutex mutex_;
+    std::string path_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+Collector &collector() {
+    static Collector instance;
+    return instance;
+}
+
+// Construct eagerly so SPLITWISE_TRACE takes effect before the first span.
+[[maybe_unused]] const bool gEnvironmentChecked = (collector(), true);
+}
+
+namespace detail {
+void recordSpan(const char *name, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end, std::uint32_t depth) {
+    ThreadBuffer &buffer = collector().buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({name, start, end, depth});
+}
+
+std::uint32_t &threadDepth() noexcept {
+    thread_local std::uint32_t depth = 0;
+    return depth;
+}
+}
+
+void start(const std::string &path) { collector().start(path); }
+
+void stop() { collector().stop(); }
+
+void flush() { collector().flush(); }
+
+void clear() { collector().clear(); }
+
+} // namespace tracing
@@ -0,0 +1,121 @@
+#include "../third_party/catch2.hpp"
+
+#include "async_manager.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+ExpenseRequest makeRequest(const std::string &groupId,
+                           const std::string &payerId,
+                           double amount,
+                           std::vector<std::string> participantIds) {
+    ExpenseRequest request;
+    request.groupId = groupId;
+    request.description = "Async";
+    request.input.payerId = payerId;
+    request.input.amount = amount;
+    request.input.participantIds = std::move(participantIds);
+    request.strategy = SplitStrategyFactory::create("equal");
+    return request;
+}
+
+long idNumber(const std::string &expenseId) {
+    return std::stol(expenseId.substr(3));
+}
+}
+
+TEST_CASE("Async expenses keep per-group order and settle after earlier submissions", "[async]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string carol = manager.addUser("Carol");
+    std::string trip = manager.addGroup("Trip", {alice, bob});
+    std::string flat = manager.addGroup("Flat", {bob, carol});
+
+    AsyncSplitwiseManager async(manager, 4);
+    std::mutex mutex;
+    std::vector<std::string> tripIds;
+    std::vector<std::future<std::string>> flatIds;
+    for (int i = 0; i < 200; ++i) {
+        async.addExpenseAsync(makeRequest(trip, alice, 10.0, {alice, bob}),
+                              [&](const std::string &id, std::exception_ptr error) {
+            std::lock_guard<std::mutex> lock(mutex);
+            tripIds.push_back(error ? std::string("failed") : id);
+        });
+        flatIds.push_back(async.addExpenseAsync(makeRequest(flat, carol, 4.0, {bob, carol})));
+    }
+    auto settlement = async.settleUpAsync().get();
+    REQUIRE(async.strandCount() == 2);
+
+    // Ids come from one counter, so submission order within a group shows up as increasing ids.
+    REQUIRE(tripIds.size() == 200);
+    for (std::size_t i = 1; i < tripIds.size(); ++i) {
+        REQUIRE(idNumber(tripIds[i - 1]) < idNumber(tripIds[i]));
+    }
+    long previous = 0;
+    for (auto &future : flatIds) {
+        long current = idNumber(future.get());
+        REQUIRE(previous < current);
+        previous = current;
+    }
+
+    // The settlement saw all 400 expenses: Alice is owed 1000, Carol 400, Bob owes 1400.
+    double owedByBob = 0.0;
+    for (const auto &tx : settlement) {
+        REQUIRE(tx.fromUserId == bob);
+        owedByBob += tx.amount;
+    }
+    REQUIRE(owedByBob == Approx(1400.0));
+}
+
+TEST_CASE("Async failures surface through futures and callbacks", "[async]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string group = manager.addGroup("Trip", {alice, bob});
+
+    ThreadPool pool(2);
+    AsyncSplitwiseManager async(manager, pool);
+    auto missing = async.addExpenseAsync(makeRequest("GRP404", alice, 10.0, {alice, bob}));
+    REQUIRE_THROWS_AS(missing.get(), std::invalid_argument);
+
+    async.addExpenseAsync(makeRequest(group, alice, 30.0, {alice, bob}));
+    // No base currency is set, so converting the balances into EUR fails.
+    std::exception_ptr settleError;
+    async.settleUpAsync("EUR", [&](std::vector<SettlementTransaction>, std::exception_ptr error) { settleError = error; });
+    async.waitIdle();
+    REQUIRE(settleError);
+
+    auto saved = async.saveAsync("async_save_test.json");
+    saved.get();
+    SplitwiseManager reloaded;
+    reloaded.loadFromJson("async_save_test.json");
+    REQUIRE(reloaded.getExpenses().size() == 1);
+    std::remove("async_save_test.json");
+
+    REQUIRE_THROWS_AS(async.saveAsync("no_such_dir/ledger.json").get(), std::runtime_error);
+}
+
+TEST_CASE("Async resubmissions with the same idempotency key are applied once", "[async]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string trip = manager.addGroup("Trip", {alice, bob});
+
+    AsyncSplitwiseManager async(manager, 4);
+    ExpenseRequest taxi = makeRequest(trip, alice, 30.0, {alice, bob});
+    taxi.idempotencyKey = "taxi-1";
+    auto first = async.addExpenseAsync(taxi);
+    auto retry = async.addExpenseAsync(taxi);
+    const std::string id = first.get();
+    REQUIRE(retry.get() == id);
+    REQUIRE(manager.getExpenses().size() == 1);
+    REQUIRE(manager.getAllBalances().at(alice) == Approx(15.0));
+    REQUIRE(manager.getDeduplicationStats().duplicates == 1);
+}
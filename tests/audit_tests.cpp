@@ -0,0 +1,199 @@
+#include "../third_party/catch2.hpp"
+
+#include "ledger_audit.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+/**
+ * @brief Credits the payer with the full amount but charges nobody, so every expense leaves money unaccounted for.
+ */
+class LeakySplitStrategy : public SplitStrategy {
+public:
+    BalanceSheet::BalanceMap computeSplits(const SplitInput &input) const override {
+        return {{input.payerId, input.amount}};
+    }
+    std::string name() const override { return "leaky"; }
+};
+
+void tamperBalance(const std::string &path, const std::string &userId, double value) {
+    nlohmann::json j;
+    {
+        std::ifstream in(path);
+        in >> j;
+    }
+    j["balances"][userId] = value;
+    std::ofstream out(path);
+    out << j.dump(2);
+}
+}
+
+TEST_CASE("Compensated sums keep digits a naive sum loses", "[audit]") {
+    CompensatedSum sum;
+    double naive = 1e16;
+    sum.add(1e16);
+    for (int i = 0; i < 10; ++i) {
+        sum.add(1.0);
+        naive += 1.0;
+    }
+    sum.add(-1e16);
+    naive -= 1e16;
+    REQUIRE(sum.value() == 10.0);
+    REQUIRE(naive != 10.0);
+
+    CompensatedSum other;
+    other.add(0.1);
+    other.add(0.2);
+    sum.add(other);
+    REQUIRE(sum.value() == Approx(10.3));
+}
+
+TEST_CASE("Balance diffs report users missing on either side", "[audit]") {
+    BalanceSheet::BalanceMap expected{{"USR1", 10.0}, {"USR2", -10.0}, {"USR4", 1e-9}};
+    BalanceSheet::BalanceMap recorded{{"USR2", -10.0}, {"USR3", 5.0}};
+    auto found = diffBalances("EUR", expected, recorded, 1e-6);
+    REQUIRE(found.size() == 2);
+    REQUIRE(found[0].userId == "USR1");
+    REQUIRE(found[0].expected == 10.0);
+    REQUIRE(found[0].recorded == 0.0);
+    REQUIRE(found[1].userId == "USR3");
+    REQUIRE(found[1].expected == 0.0);
+    REQUIRE(found[1].recorded == 5.0);
+    REQUIRE(found[1].currency == "EUR");
+}
+
+TEST_CASE("Audit agrees with live and persisted balances of a clean ledger", "[audit][manager]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string carol = manager.addUser("Carol");
+    std::string groupId = manager.addGroup("Trip", {alice, bob, carol});
+    auto equal = SplitStrategyFactory::create("equal");
+    for (int i = 0; i < 300; ++i) {
+        SplitInput input;
+        input.payerId = i % 2 ? alice : bob;
+        input.amount = 10.0 / 3.0 + i;
+        input.participantIds = {alice, bob, carol};
+        input.currency = i % 3 == 0 ? "EUR" : "";
+        manager.addExpense(groupId, "Expense " + std::to_string(i), input, equal);
+    }
+
+    manager.setParallelism(4);
+    AuditReport report = manager.audit();
+    REQUIRE(report.ok());
+    REQUIRE(report.expensesChecked == 300);
+    REQUIRE(!report.persistedChecked);
+    auto live = manager.getBalancesByCurrency();
+    REQUIRE(report.expected.at("EUR").at(bob) == Approx(live.at("EUR").at(bob)));
+    REQUIRE(report.expected.at("").at(carol) == Approx(live.at("").at(carol)));
+
+    manager.saveToJson("audit_clean.json");
+    report = manager.audit("audit_clean.json");
+    REQUIRE(report.ok());
+    REQUIRE(report.persistedChecked);
+    REQUIRE(report.persistedExpensesChecked == 300);
+
+    tamperBalance("audit_clean.json", carol, 12345.0);
+    report = manager.audit("audit_clean.json");
+    REQUIRE(!report.ok());
+    REQUIRE(report.live.empty());
+    REQUIRE(report.persisted.size() == 1);
+    REQUIRE(report.persisted[0].userId == carol);
+    REQUIRE(report.persisted[0].recorded == 12345.0);
+
+    REQUIRE_THROWS_AS(manager.audit("audit_missing.json"), std::runtime_error);
+    std::remove("audit_clean.json");
+}
+
+TEST_CASE("Audit reads saved ledgers whose recurring expenses have no accrual time", "[audit][manager]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string groupId = manager.addGroup("Flat", {alice, bob});
+    SplitInput rent;
+    rent.payerId = alice;
+    rent.amount = 800.0;
+    rent.participantIds = {alice, bob};
+    manager.addExpense(groupId, "Deposit", rent, SplitStrategyFactory::create("equal"));
+    // Starts in 2100, so no occurrence has been counted yet whichever accrual time the file records.
+    manager.addRecurringExpense(groupId, "Rent", rent, SplitStrategyFactory::create("equal"),
+                                RecurrenceSchedule{4102444800, 30 * 86400});
+    manager.saveToJson("audit_recurring.json");
+
+    // Older and hand-written files may carry templates without "recurringAsOf"; loading accepts them.
+    std::string text;
+    {
+        std::ifstream in("audit_recurring.json");
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        text = contents.str();
+    }
+    const std::size_t key = text.find("\"recurringAsOf\"");
+    REQUIRE(key != std::string::npos);
+    text.erase(key, text.find('"', text.find(',', key)) - key);
+    {
+        std::ofstream out("audit_recurring.json");
+        out << text;
+    }
+    SplitwiseManager loaded;
+    loaded.loadFromJson("audit_recurring.json");
+
+    AuditReport report = manager.audit("audit_recurring.json");
+    REQUIRE(report.ok());
+    REQUIRE(report.persistedChecked);
+    REQUIRE(report.persistedExpensesChecked == 1);
+    std::remove("audit_recurring.json");
+}
+
+TEST_CASE("Audit flags groups whose splits do not net to zero", "[audit][manager]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string trip = manager.addGroup("Trip", {alice, bob});
+    std::string home = manager.addGroup("Home", {alice, bob});
+
+    SplitInput input;
+    input.payerId = alice;
+    input.amount = 40.0;
+    input.participantIds = {alice, bob};
+    manager.addExpense(trip, "Dinner", input, SplitStrategyFactory::create("equal"));
+    manager.addExpense(home, "Rent", input, std::make_shared<LeakySplitStrategy>());
+
+    AuditReport report = manager.audit();
+    REQUIRE(!report.ok());
+    // The balance sheet applied the same skewed split, so only the zero-sum checks notice.
+    REQUIRE(report.live.empty());
+    REQUIRE(report.zeroSumViolations.size() == 2);
+    REQUIRE(report.zeroSumViolations[0].groupId.empty());
+    REQUIRE(report.zeroSumViolations[0].sum == Approx(40.0));
+    REQUIRE(report.zeroSumViolations[1].groupId == home);
+}
+
+TEST_CASE("Scripts audit the live ledger and a saved file", "[audit][script]") {
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-group G USR1 USR2\n"
+                          "add-expense GRP1 USR1 30 equal Lunch\nadd-expense GRP1 USR2 12 equal Taxi\n"
+                          "save audit_script.json\naudit audit_script.json\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+    REQUIRE(summary.errors == 0);
+    REQUIRE(out.str().find("ok 2 expenses\n") != std::string::npos);
+
+    tamperBalance("audit_script.json", "USR2", 0.0);
+    std::istringstream tampered("audit audit_script.json\n");
+    std::ostringstream report;
+    ScriptRunner auditor(manager, report);
+    summary = auditor.run(tampered);
+    REQUIRE(summary.errors == 1);
+    REQUIRE(report.str().find("persisted - USR2 expected -9.000000 recorded 0.000000\n") != std::string::npos);
+    REQUIRE(report.str().find("audit found 1 problem(s) in 2 expenses") != std::string::npos);
+    std::remove("audit_script.json");
+}
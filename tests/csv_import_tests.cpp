@@ -0,0 +1,99 @@
+#include "../third_party/catch2.hpp"
+
+#include "csv_importer.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("CSV import applies rows in order and reports bad lines", "[csv]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string carol = manager.addUser("Carol");
+    std::string groupId = manager.addGroup("Flat", {alice, bob, carol});
+
+    {
+        std::ofstream out("import_test.csv");
+        out << "Account,Paid By,Total,Who,Split,Shares,Memo\n";
+        for (int i = 0; i < 40; ++i) {
+            out << groupId << "," << alice << ",30,,equal,,\"Groceries, week " << i << "\"\n";
+        }
+        out << groupId << "," << bob << ",abc,,equal,,Broken amount\n";
+        out << "\n";
+        out << groupId << "," << carol << ",50," << bob << ";" << carol << ",exact,20;30,Taxi\n";
+        out << groupId << "," << carol << ",50," << bob << ";" << carol << ",percent,20;30,Bad percent\n";
+        out << "GRP99," << alice << ",10,,equal,,Unknown group\n";
+    }
+
+    CsvImportOptions options;
+    options.mapping = CsvColumnMapping::parse(
+        "group=Account,payer=Paid By,amount=Total,participants=Who,strategy=Split,shares=Shares,description=Memo");
+    options.threads = 3;
+    options.chunkBytes = 64;
+    options.batchSize = 7;
+    CsvImportReport report = CsvImporter(options).importFile(manager, "import_test.csv");
+
+    REQUIRE(report.rows == 44);
+    REQUIRE(report.imported == 41);
+    REQUIRE(report.errors.size() == 3);
+    REQUIRE(report.errors[0].line == 42);
+    REQUIRE(report.errors[1].line == 45);
+    REQUIRE(report.errors[2].line == 46);
+    REQUIRE(report.errors[2].message.find("Unknown group id") != std::string::npos);
+    REQUIRE(manager.getExpenses().at("EXP1").getDescription() == "Groceries, week 0");
+    REQUIRE(manager.getExpenses().at("EXP41").getDescription() == "Taxi");
+    REQUIRE(manager.getAllBalances().at(alice) == Approx(800.0));
+    REQUIRE(manager.getAllBalances().at(bob) == Approx(-420.0));
+    REQUIRE(manager.getAllBalances().at(carol) == Approx(-380.0));
+
+    std::remove("import_test.csv");
+}
+
+TEST_CASE("CSV import requires mapped columns", "[csv]") {
+    {
+        std::ofstream out("import_missing.csv");
+        out << "group,amount\nGRP1,10\n";
+    }
+    SplitwiseManager manager;
+    REQUIRE_THROWS_AS(CsvImporter().importFile(manager, "import_missing.csv"), std::runtime_error);
+    REQUIRE_THROWS_AS(CsvColumnMapping::parse("payer"), std::invalid_argument);
+    std::remove("import_missing.csv");
+}
+
+TEST_CASE("CSV rows without participants split among the group's members at their date", "[csv]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string carol = manager.addUser("Carol");
+    std::string flat = manager.addGroup("Flat", {alice, bob});
+    std::string trip = manager.addGroup("Trip", {alice, carol});
+    manager.addGroupMember(flat, carol, 1000);
+    const std::string dir = "csv_import_partitioned";
+    manager.savePartitioned(dir);
+
+    // Reopened from disk, no group is resident until a row names it.
+    SplitwiseManager opened;
+    opened.openPartitioned(dir);
+    REQUIRE(opened.getGroups().empty());
+    {
+        std::ofstream out("import_members.csv");
+        out << "group,payer,amount,date\n";
+        out << flat << "," << alice << ",30,500\n";
+        out << flat << "," << alice << ",30,1500\n";
+        out << flat << "," << alice << ",30,\n";
+        out << trip << "," << carol << ",10,\n";
+    }
+    CsvImportReport report = CsvImporter().importFile(opened, "import_members.csv");
+    REQUIRE(report.imported == 4);
+    REQUIRE(report.errors.empty());
+    // Carol only shares the expenses dated after she joined the flat.
+    REQUIRE(opened.getExpense("EXP1").getInput().participantIds.size() == 2);
+    REQUIRE(opened.getExpense("EXP2").getInput().participantIds.size() == 3);
+    REQUIRE(opened.getExpense("EXP3").getInput().participantIds.size() == 3);
+    REQUIRE(opened.getAllBalances().at(bob) == Approx(-35.0));
+    REQUIRE(opened.getAllBalances().at(carol) == Approx(-15.0));
+
+    std::remove("import_members.csv");
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,115 @@
+#include "../third_party/catch2.hpp"
+
+#include "fx_table.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("FX tables parse rates and cache loaded files", "[currency]") {
+    std::istringstream in("# value in USD\nUSD 1\nEUR 1.25   # generous\n\nJPY 0.01\n");
+    FxTable table = FxTable::parse(in);
+    REQUIRE(table.size() == 3);
+    REQUIRE(table.rate("EUR", "USD") == Approx(1.25));
+    REQUIRE(table.rate("USD", "JPY") == Approx(100.0));
+    REQUIRE(table.rate("EUR", "EUR") == Approx(1.0));
+    REQUIRE_THROWS_AS(table.rate("GBP", "USD"), std::invalid_argument);
+
+    BalanceSheet::BalanceMap out{{"USR1", 1.0}};
+    table.convertInto({{"USR1", 10.0}, {"USR2", -10.0}}, "EUR", "USD", out);
+    REQUIRE(out.at("USR1") == Approx(13.5));
+    REQUIRE(out.at("USR2") == Approx(-12.5));
+
+    std::istringstream bad("EUR -1\n");
+    REQUIRE_THROWS_AS(FxTable::parse(bad), std::runtime_error);
+
+    {
+        std::ofstream file("fx_test.txt");
+        file << "USD 1\nEUR 1.25\n";
+    }
+    auto first = FxTable::load("fx_test.txt");
+    REQUIRE(FxTable::load("fx_test.txt") == first);
+    std::remove("fx_test.txt");
+    REQUIRE_THROWS_AS(FxTable::load("fx_test.txt"), std::runtime_error);
+}
+
+TEST_CASE("Balances are kept per currency and settle in a chosen currency", "[currency][manager]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string groupId = manager.addGroup("Trip", {alice, bob});
+    auto equal = SplitStrategyFactory::create("equal");
+
+    SplitInput dinner;
+    dinner.payerId = alice;
+    dinner.amount = 100.0;
+    dinner.participantIds = {alice, bob};
+    manager.addExpense(groupId, "Dinner", dinner, equal);
+
+    SplitInput hotel = dinner;
+    hotel.payerId = bob;
+    hotel.amount = 400.0;
+    hotel.currency = "EUR";
+    std::string hotelId = manager.addExpense(groupId, "Hotel", hotel, equal);
+
+    REQUIRE(manager.getAllBalances().at(alice) == Approx(50.0));
+    auto byCurrency = manager.getBalancesByCurrency();
+    REQUIRE(byCurrency.at("EUR").at(bob) == Approx(200.0));
+    REQUIRE(byCurrency.at("").at(bob) == Approx(-50.0));
+    REQUIRE_THROWS_AS(manager.getBalancesIn("EUR"), std::invalid_argument);
+
+    std::istringstream rates("USD 1\nEUR 1.25\n");
+    manager.setFxTable(std::make_shared<const FxTable>(FxTable::parse(rates)));
+    manager.setBaseCurrency("USD");
+    REQUIRE(manager.getBalancesIn("USD").at(alice) == Approx(50.0 - 250.0));
+    REQUIRE(manager.getBalancesIn("EUR").at(bob) == Approx(200.0 - 40.0));
+
+    auto transfers = manager.settleUpGreedy("EUR");
+    REQUIRE(transfers.size() == 1);
+    REQUIRE(transfers[0].fromUserId == alice);
+    REQUIRE(transfers[0].amount == Approx(160.0));
+    REQUIRE(manager.settleUpGreedy().front().fromUserId == bob);
+
+    SplitInput relabelled = hotel;
+    relabelled.currency = "USD";
+    manager.updateExpense(hotelId, "Hotel", relabelled, equal);
+    REQUIRE(manager.getAllBalances().at(bob) == Approx(150.0));
+    REQUIRE(manager.getBalancesByCurrency().count("EUR") == 0);
+    manager.updateExpense(hotelId, "Hotel", hotel, equal);
+
+    SplitInput lowercase = hotel;
+    lowercase.currency = "eur";
+    REQUIRE_THROWS_AS(manager.addExpense(groupId, "Bad", lowercase, equal), std::invalid_argument);
+
+    manager.saveToJson("currency_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("currency_test.json");
+    REQUIRE(loaded.getBaseCurrency() == "USD");
+    REQUIRE(loaded.getExpenses().at(hotelId).getInput().currency == "EUR");
+    REQUIRE(loaded.getBalancesByCurrency().at("EUR").at(bob) == Approx(200.0));
+    REQUIRE(loaded.getAllBalances().at(alice) == Approx(50.0));
+    std::remove("currency_test.json");
+}
+
+TEST_CASE("Scripts record currencies and convert with a loaded table", "[currency][script]") {
+    {
+        std::ofstream file("fx_script.txt");
+        file << "GBP 1.5\nUSD 1\n";
+    }
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-group G USR1 USR2\nbase-currency USD\n"
+                          "add-expense GRP1 USR1 10 equal Lunch\n"
+                          "add-expense GRP1 USR2 40GBP equal Train\n"
+                          "fx-load fx_script.txt\nbalances-in USD\nsettle GBP\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+    std::remove("fx_script.txt");
+
+    REQUIRE(summary.errors == 0);
+    REQUIRE(manager.getExpenses().at("EXP2").getInput().currency == "GBP");
+    REQUIRE(out.str().find("loaded 2 rates\nUSR1 -25.00\nUSR2 25.00\nUSR1 USR2 16.67\n") != std::string::npos);
+}
@@ -0,0 +1,203 @@
+#include "../third_party/catch2.hpp"
+
+#include "daemon_client.hpp"
+#include "daemon_protocol.hpp"
+#include "daemon_server.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+TEST_CASE("Protocol frames survive arbitrary stream splits", "[daemon]") {
+    std::string stream;
+    protocol::encodeRequest(stream, 7, "balances");
+    protocol::encodeResponse(stream, {9, false, "error: nope\n"});
+
+    protocol::FrameDecoder decoder;
+    std::vector<std::string> payloads;
+    std::string payload;
+    for (char byte : stream) {
+        decoder.feed(&byte, 1);
+        while (decoder.next(payload)) {
+            payloads.push_back(payload);
+        }
+    }
+    REQUIRE(payloads.size() == 2);
+    protocol::Request request = protocol::decodeRequest(payloads[0]);
+    REQUIRE(request.id == 7);
+    REQUIRE(request.command == "balances");
+    protocol::Response response = protocol::decodeResponse(payloads[1]);
+    REQUIRE(response.id == 9);
+    REQUIRE(!response.ok);
+    REQUIRE(response.body == "error: nope\n");
+
+    REQUIRE_THROWS_AS(protocol::decodeRequest("short"), std::runtime_error);
+    std::string huge("\xff\xff\xff\xff", 4);
+    decoder.feed(huge.data(), huge.size());
+    REQUIRE_THROWS_AS(decoder.next(payload), std::runtime_error);
+}
+
+TEST_CASE("Daemon answers pipelined requests in order over a Unix socket", "[daemon]") {
+    SplitwiseManager manager;
+    const std::string path = "daemon_test_" + std::to_string(::getpid()) + ".sock";
+    DaemonServer server(manager, DaemonOptions{path, 0, 2});
+    server.start();
+
+    DaemonClient client = DaemonClient::connectUnix(path);
+    protocol::Response alice = client.call("add-user Alice");
+    REQUIRE(alice.ok);
+    REQUIRE(alice.body == "USR1\n");
+
+    auto responses = client.callBatch({"add-user Bob", "add-group Trip USR1 USR2", "add-expense GRP1 USR1 30 equal Dinner",
+                                       "no-such-command", "balances"});
+    REQUIRE(responses.size() == 5);
+    REQUIRE(responses[0].body == "USR2\n");
+    REQUIRE(responses[1].body == "GRP1\n");
+    REQUIRE(responses[2].ok);
+    REQUIRE(!responses[3].ok);
+    REQUIRE(responses[4].ok);
+    REQUIRE(responses[4].body == "USR1 15.00\nUSR2 -15.00\n");
+    for (std::size_t i = 1; i < responses.size(); ++i) {
+        REQUIRE(responses[i].id == responses[i - 1].id + 1);
+    }
+
+    server.stop();
+    DaemonStats stats = server.stats();
+    REQUIRE(stats.connectionsAccepted == 1);
+    REQUIRE(stats.requestsServed == 6);
+    REQUIRE(stats.responseBatches <= 6);
+}
+
+TEST_CASE("Daemon serves several TCP clients against one ledger", "[daemon]") {
+    SplitwiseManager manager;
+    DaemonServer server(manager, DaemonOptions{{}, 0, 2});
+    server.start();
+    REQUIRE(server.port() != 0);
+
+    DaemonClient first = DaemonClient::connectTcp("127.0.0.1", server.port());
+    DaemonClient second = DaemonClient::connectTcp("127.0.0.1", server.port());
+    REQUIRE(first.call("add-user Alice").body == "USR1\n");
+    REQUIRE(second.call("add-user Bob").body == "USR2\n");
+    REQUIRE(first.call("add-group Trip USR1 USR2").ok);
+
+    std::vector<std::string> commands(50, "add-expense GRP1 USR2 10 equal Taxi");
+    for (const auto &response : second.callBatch(commands)) {
+        REQUIRE(response.ok);
+    }
+    REQUIRE(manager.getExpenses().size() == 50);
+    REQUIRE(manager.getAllBalances().at("USR2") == Approx(250.0));
+    server.stop();
+}
+
+TEST_CASE("Daemon answers every request sent before a client half-closes", "[daemon]") {
+    SplitwiseManager manager;
+    const std::string path = "daemon_half_close_" + std::to_string(::getpid()) + ".sock";
+    DaemonServer unixServer(manager, DaemonOptions{path, 0, 2});
+    DaemonServer tcpServer(manager, DaemonOptions{{}, 0, 2});
+    unixServer.start();
+    tcpServer.start();
+
+    std::vector<DaemonClient> clients;
+    clients.push_back(DaemonClient::connectUnix(path));
+    clients.push_back(DaemonClient::connectTcp("127.0.0.1", tcpServer.port()));
+    REQUIRE(clients[0].call("add-user Alice").ok);
+    REQUIRE(clients[0].call("add-user Bob").ok);
+    REQUIRE(clients[0].call("add-group Trip USR1 USR2").ok);
+    for (auto &client : clients) {
+        for (int i = 0; i < 100; ++i) {
+            client.send("add-expense GRP1 USR1 10 equal Taxi");
+        }
+        client.send("no-such-command");
+        client.finishSending();
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(client.receive().ok);
+        }
+        REQUIRE(!client.receive().ok);
+        // With everything answered, the server closes its side too.
+        REQUIRE_THROWS_AS(client.receive(), std::runtime_error);
+    }
+    REQUIRE(manager.getExpenses().size() == 200);
+    REQUIRE(manager.getAllBalances().at("USR1") == Approx(1000.0));
+    unixServer.stop();
+    tcpServer.stop();
+}
+
+TEST_CASE("Daemon balance reads run safely alongside writes from other clients", "[daemon]") {
+    SplitwiseManager manager;
+    DaemonServer server(manager, DaemonOptions{{}, 0, 4});
+    server.start();
+    DaemonClient setup = DaemonClient::connectTcp("127.0.0.1", server.port());
+    for (const auto &response : setup.callBatch({"add-user A", "add-user B", "add-group Flat USR1 USR2"})) {
+        REQUIRE(response.ok);
+    }
+
+    // New users keep joining, so the balance map grows while it is being read.
+    std::thread writer([&] {
+        DaemonClient client = DaemonClient::connectTcp("127.0.0.1", server.port());
+        for (int i = 0; i < 200; ++i) {
+            const std::string user = "USR" + std::to_string(i + 3);
+            client.callBatch({"add-user U" + std::to_string(i), "add-member GRP1 " + user,
+                              "add-expense GRP1 USR1 10 equal Snacks USR1 " + user});
+        }
+    });
+    // Imported rows without participants split among the group's members, which the writer keeps changing.
+    const std::string csv = "daemon_import_" + std::to_string(::getpid()) + ".csv";
+    {
+        std::ofstream out(csv);
+        out << "group,payer,amount,participants,strategy,description\n";
+        for (int i = 0; i < 20; ++i) {
+            out << "GRP1,USR2,12,,equal,Imported " << i << "\n";
+        }
+    }
+    std::vector<std::string> failures;
+    std::thread importer([&] {
+        DaemonClient client = DaemonClient::connectTcp("127.0.0.1", server.port());
+        for (int i = 0; i < 5; ++i) {
+            protocol::Response response = client.call("import-csv " + csv);
+            if (!response.ok || response.body.find("imported 20 of 20 rows") == std::string::npos) {
+                failures.push_back(response.body);
+            }
+        }
+    });
+    std::thread reader([&] {
+        DaemonClient client = DaemonClient::connectTcp("127.0.0.1", server.port());
+        for (int i = 0; i < 200; ++i) {
+            auto responses = client.callBatch({"balances", "balance-summary"});
+            if (!responses[0].ok || !responses[1].ok) {
+                failures.push_back(responses[0].body + responses[1].body);
+                continue;
+            }
+            // Every snapshot is a consistent ledger state: each expense is either fully in it or not at all. The
+            // summary is read rather than the two-decimal listing, whose rounding adds up across many users.
+            std::istringstream text(responses[1].body);
+            nlohmann::json summary;
+            text >> summary;
+            double total = 0.0;
+            for (const auto &[userId, balance] : summary.get<std::map<std::string, double>>()) {
+                total += balance;
+            }
+            if (std::fabs(total) > 1e-6) {
+                failures.push_back("unbalanced snapshot: " + std::to_string(total));
+            }
+        }
+    });
+    writer.join();
+    importer.join();
+    reader.join();
+    std::remove(csv.c_str());
+    REQUIRE(failures.empty());
+    REQUIRE(manager.getExpenses().size() == 300);
+    double total = 0.0;
+    for (const auto &[userId, balance] : manager.getAllBalances()) {
+        total += balance;
+    }
+    REQUIRE(std::fabs(total) < 1e-6);
+    server.stop();
+}
@@ -0,0 +1,180 @@
+#include "../third_party/catch2.hpp"
+
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+SplitInput split(const std::string &payer, const std::vector<std::string> &participants, double amount) {
+    SplitInput input;
+    input.payerId = payer;
+    input.amount = amount;
+    input.participantIds = participants;
+    return input;
+}
+
+// Sum of the rollups of `groupIds`; for leaves that is the sum of their own balances.
+BalanceSheet::BalanceMap sumOf(const SplitwiseManager &manager, const std::vector<std::string> &groupIds) {
+    BalanceSheet total;
+    for (const auto &groupId : groupIds) {
+        total.applyDelta(manager.getRollupBalances(groupId));
+    }
+    return total.getBalances();
+}
+
+void requireBalances(const BalanceSheet::BalanceMap &actual, const BalanceSheet::BalanceMap &expected) {
+    for (const auto &[userId, balance] : expected) {
+        auto it = actual.find(userId);
+        REQUIRE((it != actual.end() ? it->second : 0.0) == Approx(balance));
+    }
+    for (const auto &[userId, balance] : actual) {
+        if (!expected.count(userId)) {
+            REQUIRE(balance == Approx(0.0));
+        }
+    }
+}
+
+// Company -> {Engineering -> {Platform, Mobile}, Sales}, each leaf with its own expenses.
+struct Company {
+    std::vector<std::string> users;
+    std::string company, engineering, platform, mobile, sales;
+};
+
+Company populate(SplitwiseManager &manager) {
+    Company c;
+    for (int i = 0; i < 5; ++i) {
+        c.users.push_back(manager.addUser("user" + std::to_string(i)));
+    }
+    const auto &u = c.users;
+    c.company = manager.addGroup("Company", {u[0]});
+    c.engineering = manager.addGroup("Engineering", {u[0]});
+    c.platform = manager.addGroup("Platform", {u[0], u[1], u[2]});
+    c.mobile = manager.addGroup("Mobile", {u[1], u[3]});
+    c.sales = manager.addGroup("Sales", {u[3], u[4]});
+    manager.setGroupParent(c.engineering, c.company);
+    manager.setGroupParent(c.platform, c.engineering);
+    manager.setGroupParent(c.mobile, c.engineering);
+    manager.setGroupParent(c.sales, c.company);
+    auto equal = SplitStrategyFactory::create("equal");
+    manager.addExpense(c.platform, "Servers", split(u[0], {u[0], u[1], u[2]}, 90.0), equal, 100);
+    manager.addExpense(c.mobile, "Devices", split(u[3], {u[1], u[3]}, 40.0), equal, 200);
+    manager.addExpense(c.sales, "Dinner", split(u[4], {u[3], u[4]}, 30.0), equal, 300);
+    return c;
+}
+}
+
+TEST_CASE("Rollups follow every change to a group below them", "[hierarchy]") {
+    SplitwiseManager manager;
+    Company c = populate(manager);
+    const auto &u = c.users;
+    REQUIRE(manager.getGroupParent(c.platform) == c.engineering);
+    REQUIRE(manager.getGroupParent(c.company).empty());
+    REQUIRE(manager.getChildGroups(c.engineering) == (std::vector<std::string>{c.platform, c.mobile}));
+
+    requireBalances(manager.getRollupBalances(c.engineering),
+                    {{u[0], 60.0}, {u[1], -50.0}, {u[2], -30.0}, {u[3], 20.0}});
+    requireBalances(manager.getRollupBalances(c.company), manager.getAllBalances());
+    // A group outside the hierarchy rolls up to its own balances.
+    const std::string loose = manager.addGroup("Loose", {u[0], u[4]});
+    auto equal = SplitStrategyFactory::create("equal");
+    manager.addExpense(loose, "Taxi", split(u[4], {u[0], u[4]}, 10.0), equal, 400);
+    requireBalances(manager.getRollupBalances(loose), {{u[0], -5.0}, {u[4], 5.0}});
+
+    // Edits, deletions and recurring occurrences reach every ancestor.
+    const std::string servers = manager.getGroupExpenses(c.platform, "", 10).expenses.front().getId();
+    manager.updateExpense(servers, "Servers", split(u[1], {u[0], u[1], u[2]}, 60.0), equal);
+    manager.addRecurringExpense(c.mobile, "Plan", split(u[1], {u[1], u[3]}, 10.0), equal, {0, 60, 540});
+    manager.deleteExpense(manager.getGroupExpenses(c.sales, "", 10).expenses.front().getId());
+    requireBalances(manager.getRollupBalances(c.engineering), sumOf(manager, {c.platform, c.mobile}));
+    requireBalances(manager.getRollupBalances(c.company), sumOf(manager, {c.platform, c.mobile, c.sales}));
+
+    // Moving a subtree adjusts the old and the new ancestors.
+    manager.setGroupParent(c.mobile, c.sales);
+    requireBalances(manager.getRollupBalances(c.engineering), manager.getRollupBalances(c.platform));
+    requireBalances(manager.getRollupBalances(c.sales), sumOf(manager, {c.mobile}));
+    manager.setGroupParent(loose, c.mobile);
+    requireBalances(manager.getRollupBalances(c.company), manager.getAllBalances());
+    manager.setGroupParent(c.engineering, "");
+    requireBalances(manager.getRollupBalances(c.company), manager.getRollupBalances(c.sales));
+    REQUIRE(manager.getChildGroups(c.company) == std::vector<std::string>{c.sales});
+
+    REQUIRE_THROWS_AS(manager.setGroupParent(c.sales, c.sales), std::invalid_argument);
+    REQUIRE_THROWS_AS(manager.setGroupParent(c.sales, loose), std::invalid_argument);
+    REQUIRE_THROWS_AS(manager.setGroupParent(c.sales, "GRP99"), std::invalid_argument);
+    REQUIRE_THROWS_AS(manager.getRollupBalances("GRP99"), std::invalid_argument);
+    REQUIRE(manager.getGroupParent(c.sales) == c.company);
+    REQUIRE(manager.memoryUsage().components.at("groupHierarchy").objects == 6);
+}
+
+TEST_CASE("Saved hierarchies are rebuilt on load", "[hierarchy]") {
+    SplitwiseManager manager;
+    Company c = populate(manager);
+    manager.setBaseCurrency("USD");
+    requireBalances(manager.getRollupBalances(c.company), manager.getAllBalances());
+
+    manager.saveToJson("hierarchy_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("hierarchy_test.json");
+    REQUIRE(loaded.getGroupParent(c.mobile) == c.engineering);
+    requireBalances(loaded.getRollupBalances(c.engineering), manager.getRollupBalances(c.engineering));
+    requireBalances(loaded.getRollupBalances(c.company), manager.getRollupBalances(c.company));
+
+    const std::string dir = "hierarchy_test_ledger";
+    manager.savePartitioned(dir);
+    SplitwiseManager partitioned;
+    partitioned.openPartitioned(dir);
+    REQUIRE(partitioned.getPartitionStats().residentGroups == 0);
+    requireBalances(partitioned.getRollupBalances(c.company), manager.getRollupBalances(c.company));
+    REQUIRE(partitioned.getChildGroups(c.company) == (std::vector<std::string>{c.engineering, c.sales}));
+    std::filesystem::remove_all(dir);
+
+    // A saved cycle, or a link to a group that does not exist, is rejected.
+    nlohmann::json ledger;
+    std::ifstream("hierarchy_test.json") >> ledger;
+    const std::pair<std::string, std::string> links[] = {{c.company, c.engineering}, {c.sales, "GRP99"}};
+    for (const auto &[child, parent] : links) {
+        nlohmann::json broken = ledger;
+        broken["groupParents"][child] = parent;
+        std::ofstream("hierarchy_test.json") << broken.dump();
+        REQUIRE_THROWS_AS(loaded.loadFromJson("hierarchy_test.json"), std::runtime_error);
+    }
+    std::remove("hierarchy_test.json");
+}
+
+TEST_CASE("Hierarchy changes replicate and are scriptable", "[hierarchy]") {
+    SplitwiseManager leader;
+    leader.enableReplicationLog();
+    std::ostringstream out;
+    ScriptRunner runner(leader, out);
+    std::istringstream script("add-user A\n"
+                              "add-user B\n"
+                              "add-group Region USR1\n"
+                              "add-group Office USR1 USR2\n"
+                              "set-parent GRP2 GRP1\n"
+                              "add-expense GRP2 USR1 50 equal Rent @10\n"
+                              "rollup GRP1\n"
+                              "children GRP1\n"
+                              "set-parent GRP1 GRP2\n"
+                              "set-parent GRP2\n"
+                              "rollup GRP1\n");
+    ScriptSummary summary = runner.run(script);
+    REQUIRE(summary.errors == 1);
+    const std::string output = out.str();
+    REQUIRE(output.find("USR1 25.00\nUSR2 -25.00\nGRP2\n") != std::string::npos);
+    REQUIRE(output.find("ok\n", output.find("GRP2\n")) != std::string::npos);
+
+    SplitwiseManager follower;
+    follower.applyReplicatedBatch(leader.getReplicatedOperations(0));
+    REQUIRE(follower.getGroupParent("GRP2").empty());
+    REQUIRE(follower.getRollupBalances("GRP1").empty());
+    requireBalances(follower.getRollupBalances("GRP2"), {{"USR1", 25.0}, {"USR2", -25.0}});
+}
@@ -0,0 +1,203 @@
+#include "../third_party/catch2.hpp"
+
+#include "idempotency_filter.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+SplitInput split(const std::string &payer, const std::vector<std::string> &participants, double amount) {
+    SplitInput input;
+    input.payerId = payer;
+    input.amount = amount;
+    input.participantIds = participants;
+    return input;
+}
+
+ExpenseRequest request(const std::string &groupId, const SplitInput &input, const std::string &key) {
+    ExpenseRequest request;
+    request.groupId = groupId;
+    request.description = "Taxi";
+    request.input = input;
+    request.strategy = SplitStrategyFactory::create("equal");
+    request.timestamp = 100;
+    request.idempotencyKey = key;
+    return request;
+}
+}
+
+TEST_CASE("Idempotency filter remembers keys for exactly one window", "[idempotency]") {
+    IdempotencyFilter filter(DeduplicationOptions{100, false, 16});
+    filter.insert("a", "EXP1", 10);
+    REQUIRE(*filter.find("a", 50) == "EXP1");
+    REQUIRE(filter.find("b", 50) == nullptr);
+    REQUIRE(*filter.find("a", 109) == "EXP1");
+    REQUIRE(filter.find("a", 110) == nullptr);
+    REQUIRE(filter.size() == 0);
+
+    // Keys stay found across many generation changes, with the filters loaded well past their expected size.
+    for (std::int64_t t = 200; t < 1200; ++t) {
+        filter.insert("key" + std::to_string(t), "EXP" + std::to_string(t), t);
+        for (std::int64_t back : {0, 1, 50, 99}) {
+            const std::string *found = filter.find("key" + std::to_string(t - back), t);
+            REQUIRE((t - back < 200 ? found == nullptr
+                                    : found != nullptr && *found == "EXP" + std::to_string(t - back)));
+        }
+        REQUIRE(filter.find("key" + std::to_string(t - 100), t) == nullptr);
+    }
+    filter.insert("key1199", "EXP0", 1199);
+    REQUIRE(*filter.find("key1199", 1199) == "EXP1199");
+    DeduplicationStats stats = filter.stats();
+    REQUIRE(stats.keys == 100);
+    REQUIRE(stats.lookups == stats.duplicates + stats.filtered + stats.falsePositives);
+    REQUIRE(stats.filtered > 0);
+    REQUIRE(stats.bytes == filter.memoryBytes());
+
+    // Records come back oldest first, and restoring them (even out of a different clock) loses nothing.
+    std::vector<IdempotencyRecord> records = filter.records();
+    REQUIRE(records.size() == 100);
+    REQUIRE(records.front().key == "key1100");
+    REQUIRE(IdempotencyRecord::fromJson(records.back().toJson()).expenseId == "EXP1199");
+    IdempotencyFilter restored;
+    restored.restore(records);
+    REQUIRE(*restored.find("key1100", 1150) == "EXP1100");
+    restored.configure(DeduplicationOptions{10, false, 4});
+    REQUIRE(restored.find("key1100", 1150) == nullptr);
+    REQUIRE(*restored.find("key1199", 1200) == "EXP1199");
+
+    REQUIRE_THROWS_AS(IdempotencyFilter(DeduplicationOptions{0, false, 16}), std::invalid_argument);
+    REQUIRE_THROWS_AS(restored.configure(DeduplicationOptions{10, false, 0}), std::invalid_argument);
+}
+
+TEST_CASE("Content keys depend on what an expense splits, not how it was listed", "[idempotency]") {
+    SplitInput input = split("USR1", {"USR1", "USR2", "USR3"}, 30.0);
+    const std::string key = IdempotencyFilter::contentKey("GRP1", input, "equal");
+    REQUIRE(key.rfind("hash:", 0) == 0);
+    REQUIRE(IdempotencyFilter::contentKey("GRP1", split("USR1", {"USR3", "USR1", "USR2"}, 30.0), "equal") == key);
+    REQUIRE(IdempotencyFilter::contentKey("GRP2", input, "equal") != key);
+    REQUIRE(IdempotencyFilter::contentKey("GRP1", input, "exact") != key);
+    REQUIRE(IdempotencyFilter::contentKey("GRP1", split("USR2", {"USR1", "USR2", "USR3"}, 30.0), "equal") != key);
+    REQUIRE(IdempotencyFilter::contentKey("GRP1", split("USR1", {"USR1", "USR2", "USR3"}, 30.01), "equal") != key);
+    SplitInput euros = input;
+    euros.currency = "EUR";
+    REQUIRE(IdempotencyFilter::contentKey("GRP1", euros, "equal") != key);
+
+    SplitInput exact = split("USR1", {"USR1", "USR2"}, 30.0);
+    exact.exactShares = {10.0, 20.0};
+    SplitInput swapped = split("USR1", {"USR2", "USR1"}, 30.0);
+    swapped.exactShares = {20.0, 10.0};
+    REQUIRE(IdempotencyFilter::contentKey("GRP1", exact, "exact") ==
+            IdempotencyFilter::contentKey("GRP1", swapped, "exact"));
+    swapped.exactShares = {10.0, 20.0};
+    REQUIRE(IdempotencyFilter::contentKey("GRP1", exact, "exact") !=
+            IdempotencyFilter::contentKey("GRP1", swapped, "exact"));
+}
+
+TEST_CASE("Resubmitted expenses are applied once", "[idempotency]") {
+    SplitwiseManager manager;
+    std::string a = manager.addUser("A");
+    std::string b = manager.addUser("B");
+    std::string trip = manager.addGroup("Trip", {a, b});
+    SplitInput taxi = split(a, {a, b}, 30.0);
+
+    const std::string id = manager.addExpense(request(trip, taxi, "retry-1"));
+    REQUIRE(manager.addExpense(request(trip, taxi, "retry-1")) == id);
+    REQUIRE(manager.getExpenses().size() == 1);
+    REQUIRE(manager.getAllBalances().at(a) == Approx(15.0));
+    // Without a key, or with content keys off, identical expenses are separate expenses.
+    manager.addExpense(trip, "Taxi", taxi, SplitStrategyFactory::create("equal"), 100);
+    manager.addExpense(request(trip, taxi, ""));
+    REQUIRE(manager.getExpenses().size() == 3);
+
+    // A batch reports repeats, including a key repeated within the batch itself.
+    std::vector<BatchResult> results = manager.addExpenses(
+        {request(trip, taxi, "retry-2"), request(trip, taxi, "retry-2"), request(trip, taxi, "retry-1")});
+    REQUIRE(!results[0].duplicate);
+    REQUIRE(results[1].duplicate);
+    REQUIRE(results[1].id == results[0].id);
+    REQUIRE(results[2].id == id);
+    REQUIRE(manager.getExpenses().size() == 4);
+
+    // The key keeps answering with its expense after that expense is deleted.
+    manager.deleteExpense(id);
+    REQUIRE(manager.addExpense(request(trip, taxi, "retry-1")) == id);
+    REQUIRE(manager.getExpenses().size() == 3);
+
+    manager.setDeduplication(DeduplicationOptions{3600, true, 1024});
+    REQUIRE(manager.getDeduplication().contentKeys);
+    SplitInput dinner = split(b, {a, b}, 80.0);
+    const std::string first = manager.addExpense(trip, "Dinner", dinner, SplitStrategyFactory::create("equal"));
+    REQUIRE(manager.addExpense(trip, "Dinner again", split(b, {b, a}, 80.0), SplitStrategyFactory::create("equal"),
+                               200) == first);
+    REQUIRE(manager.addExpense(trip, "Dinner", split(b, {a, b}, 81.0), SplitStrategyFactory::create("equal")) != first);
+    REQUIRE(manager.getExpenses().size() == 5);
+
+    DeduplicationStats stats = manager.getDeduplicationStats();
+    REQUIRE(stats.keys == 4);
+    REQUIRE(stats.duplicates == 5);
+    REQUIRE(manager.memoryUsage().components.at("idempotency").objects == 4);
+    REQUIRE(manager.memoryUsage().components.at("idempotency").bytes == stats.bytes);
+    REQUIRE_THROWS_AS(manager.setDeduplication(DeduplicationOptions{-1, false, 16}), std::invalid_argument);
+}
+
+TEST_CASE("Idempotency keys survive restarts and reach followers", "[idempotency]") {
+    SplitwiseManager leader;
+    leader.enableReplicationLog();
+    std::ostringstream out;
+    ScriptRunner runner(leader, out);
+    std::istringstream script("add-user A\n"
+                              "add-user B\n"
+                              "add-group Flat USR1 USR2\n"
+                              "add-expense GRP1 USR1 40 equal Rent @10 key=rent-10\n"
+                              "add-expense GRP1 USR1 40 equal Rent @10 key=rent-10\n"
+                              "dedup 1h content\n"
+                              "add-expense GRP1 USR2 12 equal Milk\n"
+                              "add-expense GRP1 USR2 12 equal Milk\n"
+                              "dedup 0\n"
+                              "dedup 1h maybe\n"
+                              "dedup-stats\n");
+    ScriptSummary summary = runner.run(script);
+    REQUIRE(summary.errors == 2);
+    const std::string output = out.str();
+    REQUIRE(output.find("GRP1\nEXP1\nEXP1\nok\nEXP2\nEXP2\n") != std::string::npos);
+    std::istringstream statsLine(output.substr(output.rfind('{')));
+    nlohmann::json stats;
+    statsLine >> stats;
+    REQUIRE(stats.at("duplicates").get<double>() == 2.0);
+    REQUIRE(leader.getExpenses().size() == 2);
+
+    SplitwiseManager follower;
+    follower.applyReplicatedBatch(leader.getReplicatedOperations(0));
+    REQUIRE(follower.getDeduplicationStats().keys == 2);
+    SplitInput rent = split("USR1", {"USR1", "USR2"}, 40.0);
+    REQUIRE(follower.addExpense(request("GRP1", rent, "rent-10")) == "EXP1");
+
+    leader.saveToJson("idempotency_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("idempotency_test.json");
+    REQUIRE(loaded.addExpense(request("GRP1", rent, "rent-10")) == "EXP1");
+    REQUIRE(loaded.getExpenses().size() == 2);
+    REQUIRE(loaded.getDeduplicationStats().keys == 2);
+    std::remove("idempotency_test.json");
+
+    const std::string dir = "idempotency_test_ledger";
+    leader.savePartitioned(dir);
+    SplitwiseManager partitioned;
+    partitioned.openPartitioned(dir);
+    REQUIRE(partitioned.getDeduplicationStats().keys == 2);
+    REQUIRE(partitioned.addExpense(request("GRP1", rent, "rent-10")) == "EXP1");
+    // A new key reaches the manifest along with its expense's segment.
+    partitioned.addExpense(request("GRP1", rent, "rent-11"));
+    partitioned.setMemoryBudget(1);
+    SplitwiseManager reopened;
+    reopened.openPartitioned(dir);
+    REQUIRE(reopened.getDeduplicationStats().keys == 3);
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,167 @@
+#include "../third_party/catch2.hpp"
+
+#include "description_index.hpp"
+#include "posting_list.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+TEST_CASE("Posting lists match a sorted set under random edits", "[index]") {
+    PostingList postings;
+    std::set<std::uint32_t> expected;
+    std::mt19937 rng(7);
+    for (std::uint32_t i = 0; i < 5000; ++i) {
+        postings.add(i * 3);
+        expected.insert(i * 3);
+    }
+    for (int i = 0; i < 20000; ++i) {
+        std::uint32_t value = rng() % 20000;
+        if (rng() % 3 == 0) {
+            REQUIRE(postings.remove(value) == (expected.erase(value) == 1));
+        } else {
+            REQUIRE(postings.add(value) == expected.insert(value).second);
+        }
+    }
+    REQUIRE(postings.size() == expected.size());
+
+    std::vector<std::uint32_t> values;
+    for (auto it = postings.begin(); it.valid(); it.next()) {
+        values.push_back(it.value());
+    }
+    REQUIRE(values == std::vector<std::uint32_t>(expected.begin(), expected.end()));
+
+    auto it = postings.begin();
+    for (std::uint32_t target : {0u, 17u, 4999u, 12345u, 19999u}) {
+        it.seek(target);
+        auto lower = expected.lower_bound(target);
+        REQUIRE(it.valid() == (lower != expected.end()));
+        if (it.valid()) {
+            REQUIRE(it.value() == *lower);
+        }
+    }
+    // Roughly one byte per small gap plus per-block headers, far below a plain vector of 32-bit ints.
+    REQUIRE(postings.memoryBytes() < expected.size() * 3);
+}
+
+TEST_CASE("Per-user and per-group listings paginate with cursors", "[index][manager]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string carol = manager.addUser("Carol");
+    std::string flat = manager.addGroup("Flat", {alice, bob, carol});
+    std::string trip = manager.addGroup("Trip", {alice, carol});
+    auto equal = SplitStrategyFactory::create("equal");
+
+    SplitInput input;
+    input.amount = 10.0;
+    std::vector<std::string> bobExpenses;
+    for (int i = 0; i < 250; ++i) {
+        input.payerId = i % 2 == 0 ? alice : carol;
+        input.participantIds = {alice, carol};
+        if (i % 5 == 0) {
+            input.participantIds.push_back(bob);
+        }
+        std::string id = manager.addExpense(i % 5 == 0 ? flat : trip, "Item", input, equal);
+        if (i % 5 == 0) {
+            bobExpenses.push_back(id);
+        }
+    }
+
+    auto collect = [&](SplitwiseManager &source, const std::string &userId) {
+        std::vector<std::string> ids;
+        std::string cursor;
+        do {
+            ExpensePage page = source.getUserExpenses(userId, cursor, 7);
+            REQUIRE(page.expenses.size() <= 7);
+            for (const auto &expense : page.expenses) {
+                ids.push_back(expense.getId());
+            }
+            cursor = page.nextCursor;
+        } while (!cursor.empty());
+        return ids;
+    };
+    REQUIRE(collect(manager, bob) == bobExpenses);
+    REQUIRE(manager.getGroupExpenses(trip, {}, 1000).expenses.size() == 200);
+
+    SplitInput moved;
+    moved.payerId = alice;
+    moved.amount = 10.0;
+    moved.participantIds = {alice, carol};
+    manager.updateExpense(bobExpenses[3], "No Bob", moved, equal);
+    manager.deleteExpense(bobExpenses[4]);
+    bobExpenses.erase(bobExpenses.begin() + 3, bobExpenses.begin() + 5);
+    REQUIRE(collect(manager, bob) == bobExpenses);
+
+    manager.saveToJson("index_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("index_test.json");
+    REQUIRE(collect(loaded, bob) == bobExpenses);
+    REQUIRE(loaded.getGroupExpenses(flat, {}, 1000).expenses.size() == 49);
+    std::remove("index_test.json");
+
+    REQUIRE_THROWS_AS(manager.getUserExpenses("USR404"), std::invalid_argument);
+    REQUIRE_THROWS_AS(manager.getUserExpenses(bob, "not-a-cursor"), std::invalid_argument);
+}
+
+TEST_CASE("Description search ranks exact, prefix and filtered matches", "[index][search]") {
+    REQUIRE(tokenizeDescription("Hotel LISBON, hotel-bar #2") ==
+            std::vector<std::string>({"hotel", "lisbon", "bar", "2"}));
+
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string lisbon = manager.addGroup("Lisbon", {alice, bob});
+    std::string porto = manager.addGroup("Porto", {alice, bob});
+    auto equal = SplitStrategyFactory::create("equal");
+
+    SplitInput both;
+    both.payerId = alice;
+    both.amount = 20.0;
+    both.participantIds = {alice, bob};
+    SplitInput aliceOnly = both;
+    aliceOnly.participantIds = {alice};
+
+    std::string hotel = manager.addExpense(lisbon, "Hotel Lisbon", both, equal);
+    std::string hostel = manager.addExpense(porto, "Hostel near Lisbon station", aliceOnly, equal);
+    std::string taxi = manager.addExpense(lisbon, "Taxi to hotel", both, equal);
+    for (int i = 0; i < 20; ++i) {
+        manager.addExpense(porto, "Groceries", both, equal);
+    }
+
+    std::string booking = manager.addExpense(porto, "Hotels.com booking", both, equal);
+
+    // Both match as prefixes; the rarer "hostel" term scores higher.
+    auto hits = manager.searchExpenses("lisbon ho");
+    REQUIRE(hits.size() == 2);
+    REQUIRE(hits[0].expenseId == hostel);
+    REQUIRE(hits[1].expenseId == hotel);
+    REQUIRE(manager.searchExpenses("LISBON hotel").size() == 1);
+
+    // Exact "hotel" matches outrank the prefix match on "hotels", newest first among equals.
+    hits = manager.searchExpenses("hotel");
+    REQUIRE(hits.size() == 3);
+    REQUIRE(hits[0].expenseId == taxi);
+    REQUIRE(hits[1].expenseId == hotel);
+    REQUIRE(hits[2].expenseId == booking);
+    REQUIRE(manager.searchExpenses("lisbon", 20, porto).size() == 1);
+    REQUIRE(manager.searchExpenses("lisbon", 20, {}, bob).front().expenseId == hotel);
+    REQUIRE(manager.searchExpenses("groceries", 5).size() == 5);
+    REQUIRE(manager.searchExpenses("paris").empty());
+
+    SplitInput renamed = both;
+    manager.updateExpense(taxi, "Airport shuttle", renamed, equal);
+    manager.deleteExpense(hotel);
+    REQUIRE(manager.searchExpenses("hotel").front().expenseId == booking);
+    REQUIRE(manager.searchExpenses("shut").front().expenseId == taxi);
+
+    manager.saveToJson("search_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("search_test.json");
+    REQUIRE(loaded.searchExpenses("lisbon station").front().expenseId == hostel);
+    REQUIRE(loaded.searchExpenses("gro").size() == 20);
+    std::remove("search_test.json");
+}
@@ -0,0 +1,176 @@
+#include "../third_party/catch2.hpp"
+
+#include "group.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+SplitInput equalSplit(const std::string &payer, const std::vector<std::string> &participants, double amount) {
+    SplitInput input;
+    input.payerId = payer;
+    input.amount = amount;
+    input.participantIds = participants;
+    return input;
+}
+
+std::string readFile(const std::string &path) {
+    std::ifstream in(path);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+}
+
+TEST_CASE("Group membership is versioned by epoch", "[membership]") {
+    Group group{"GRP1", "Flat", {"A", "B", "C"}};
+    REQUIRE(group.getEpoch() == 0);
+    REQUIRE(group.hasMemberAt("A", -1000));
+
+    REQUIRE(group.addMember("D", 100) == 1);
+    REQUIRE(group.removeMember("A", 200) == 2);
+    REQUIRE(group.addMember("A", 300) == 3);
+    REQUIRE_THROWS_AS(group.addMember("A", 400), std::invalid_argument);
+    REQUIRE_THROWS_AS(group.removeMember("E", 400), std::invalid_argument);
+    REQUIRE_THROWS_AS(group.addMember("E", 299), std::invalid_argument);
+
+    REQUIRE(group.epochAt(99) == 0);
+    REQUIRE(group.epochAt(100) == 1);
+    REQUIRE(group.epochAt(250) == 2);
+    REQUIRE(!group.hasMemberAt("D", 99));
+    REQUIRE(group.hasMemberAt("D", 100));
+    REQUIRE(group.hasMemberAt("A", 199));
+    REQUIRE(!group.hasMemberAt("A", 200));
+    REQUIRE(group.hasMemberAt("A", 300));
+    REQUIRE(group.hasMember("A"));
+    REQUIRE(group.getMemberIds().size() == 4);
+    REQUIRE(group.getMemberIdsAt(250).size() == 3);
+
+    std::vector<MembershipChange> history = group.getHistory();
+    REQUIRE(history.size() == 3);
+    REQUIRE(history[1].userId == "A");
+    REQUIRE(!history[1].joined);
+    REQUIRE(history[1].timestamp == 200);
+
+    Group restored = Group::fromJson(group.toJson());
+    REQUIRE(restored.getMemberIds() == group.getMemberIds());
+    REQUIRE(restored.getEpoch() == 3);
+    REQUIRE(!restored.hasMemberAt("A", 250));
+    REQUIRE(restored.hasMemberAt("B", 250));
+    REQUIRE(!restored.hasMemberAt("D", 50));
+
+    nlohmann::json broken = group.toJson();
+    broken["members"] = nlohmann::json::array();
+    REQUIRE_THROWS_AS(Group::fromJson(broken), std::runtime_error);
+}
+
+TEST_CASE("Large groups change membership in place", "[membership]") {
+    std::vector<std::string> founders;
+    for (int i = 0; i < 20000; ++i) {
+        founders.push_back("U" + std::to_string(i));
+    }
+    Group group{"GRP1", "Everyone", founders};
+    for (int i = 0; i < 20000; i += 2) {
+        group.removeMember("U" + std::to_string(i), i);
+    }
+    group.addMember("U0", 20000);
+    REQUIRE(group.getMemberIds().size() == 10001);
+    REQUIRE(group.hasMember("U1"));
+    REQUIRE(!group.hasMember("U2"));
+    REQUIRE(group.hasMemberAt("U2", 1));
+    for (const auto &memberId : group.getMemberIds()) {
+        REQUIRE(group.hasMember(memberId));
+    }
+}
+
+TEST_CASE("Expenses are validated against membership at their own time", "[membership]") {
+    SplitwiseManager manager;
+    std::string a = manager.addUser("A");
+    std::string b = manager.addUser("B");
+    std::string c = manager.addUser("C");
+    std::string flat = manager.addGroup("Flat", {a, b});
+    auto equal = SplitStrategyFactory::create("equal");
+    manager.addExpense(flat, "rent", equalSplit(a, {a, b}, 100.0), equal, 1000);
+
+    REQUIRE(manager.addGroupMember(flat, c, 2000) == 1);
+    REQUIRE_THROWS_AS(manager.addExpense(flat, "early", equalSplit(a, {a, c}, 10.0), equal, 1999),
+                      std::invalid_argument);
+    std::string shared = manager.addExpense(flat, "power", equalSplit(c, {a, b, c}, 30.0), equal, 2500);
+
+    // B cannot leave while taking part in a later expense; once that is edited away B can.
+    REQUIRE_THROWS_AS(manager.removeGroupMember(flat, b, 2400), std::invalid_argument);
+    manager.updateExpense(shared, "power", equalSplit(c, {a, c}, 30.0), equal);
+    REQUIRE(manager.removeGroupMember(flat, b, 2400) == 2);
+    REQUIRE_THROWS_AS(manager.addExpense(flat, "late", equalSplit(a, {a, b}, 10.0), equal, 3000),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(manager.addGroupMember(flat, b, 2300), std::invalid_argument);
+    // Earlier expenses that include B stay editable.
+    std::string rent = manager.getGroupExpenses(flat).expenses.front().getId();
+    manager.updateExpense(rent, "rent", equalSplit(b, {a, b}, 120.0), equal);
+    REQUIRE(manager.getGroup(flat).getMemberIds().size() == 2);
+
+    manager.saveToJson("membership_test.json");
+    REQUIRE(readFile("membership_test.json").find("membershipChanges") != std::string::npos);
+    SplitwiseManager loaded;
+    loaded.loadFromJson("membership_test.json");
+    REQUIRE(loaded.getGroup(flat).getEpoch() == 2);
+    REQUIRE(!loaded.getGroup(flat).hasMember(b));
+    REQUIRE(loaded.getAllBalances().at(b) == Approx(60.0));
+
+    // A file whose expense predates a participant's membership is rejected on load.
+    std::string text = readFile("membership_test.json");
+    const std::string power = "\"timestamp\": 2500";
+    REQUIRE(text.find(power) != std::string::npos);
+    text.replace(text.find(power), power.size(), "\"timestamp\": 1500");
+    std::ofstream("membership_test.json") << text;
+    SplitwiseManager rejected;
+    REQUIRE_THROWS_AS(rejected.loadFromJson("membership_test.json"), std::runtime_error);
+    std::remove("membership_test.json");
+}
+
+TEST_CASE("Membership changes are written to partitioned segments", "[membership][partition]") {
+    SplitwiseManager manager;
+    std::string a = manager.addUser("A");
+    std::string b = manager.addUser("B");
+    std::string trip = manager.addGroup("Trip", {a});
+    const std::string dir = (std::filesystem::temp_directory_path() / "splitwise_membership_partitioned").string();
+    std::filesystem::remove_all(dir);
+    manager.savePartitioned(dir);
+
+    SplitwiseManager opened;
+    opened.openPartitioned(dir);
+    opened.addGroupMember(trip, b, 500);
+    opened.savePartitioned(dir);
+    REQUIRE(opened.getPartitionStats().segmentWrites == 1);
+
+    SplitwiseManager reopened;
+    reopened.openPartitioned(dir);
+    REQUIRE(reopened.getGroup(trip).hasMemberAt(b, 500));
+    REQUIRE(!reopened.getGroup(trip).hasMemberAt(b, 499));
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Scripts add and remove group members", "[membership][script]") {
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-user C\nadd-group Trip USR1 USR2\n"
+                          "add-member GRP1 USR3 @100\nadd-expense GRP1 USR1 30 equal Taxi @50\n"
+                          "add-expense GRP1 USR1 30 equal Dinner @150\nremove-member GRP1 USR2 @100\n"
+                          "remove-member GRP1 USR2 @200\nadd-member GRP1 USR2\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+    // Removing USR2 at 100 fails: they took part in the dinner at 150.
+    REQUIRE(summary.errors == 1);
+    REQUIRE(out.str().find("epoch 1\n") != std::string::npos);
+    REQUIRE(out.str().find("epoch 3\n") != std::string::npos);
+    REQUIRE(manager.getAllBalances().at("USR1") == Approx(15.0 + 20.0));
+    REQUIRE(manager.getAllBalances().at("USR3") == Approx(-10.0));
+}
@@ -0,0 +1,107 @@
+#include "../third_party/catch2.hpp"
+
+#include "memory_usage.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("Allocation estimates model allocator rounding and small strings", "[memory]") {
+    REQUIRE(memory::allocationBytes(1) == 32);
+    REQUIRE(memory::allocationBytes(24) == 32);
+    REQUIRE(memory::allocationBytes(25) == 48);
+    REQUIRE(memory::allocationBytes(100) == 112);
+    REQUIRE(memory::stringBytes("short") == 0);
+    REQUIRE(memory::stringBytes(std::string(40, 'x')) == memory::allocationBytes(41));
+
+    std::vector<double> values;
+    REQUIRE(memory::vectorBytes(values) == 0);
+    values.reserve(10);
+    REQUIRE(memory::vectorBytes(values) == memory::allocationBytes(80));
+}
+
+TEST_CASE("Memory usage breaks the ledger down per structure", "[memory][manager]") {
+    SplitwiseManager manager;
+    std::vector<std::string> users;
+    for (int i = 0; i < 8; ++i) {
+        users.push_back(manager.addUser("user" + std::to_string(i)));
+    }
+    std::string groupId = manager.addGroup("Flat", users);
+    memory::MemoryUsage empty = manager.memoryUsage();
+    REQUIRE(empty.components.at("users").objects == 8);
+    REQUIRE(empty.components.at("groups").objects == 1);
+    REQUIRE(empty.components.at("expenses").objects == 0);
+    REQUIRE(empty.components.at("notifier").objects == 0);
+
+    auto equal = SplitStrategyFactory::create("equal");
+    for (int i = 0; i < 1000; ++i) {
+        SplitInput input;
+        input.payerId = users[static_cast<std::size_t>(i) % users.size()];
+        input.amount = 10.0 + i;
+        input.participantIds = users;
+        manager.addExpense(groupId, "Groceries from the corner shop #" + std::to_string(i), input, equal);
+    }
+    manager.setNotifier(std::make_shared<ConsoleNotifier>());
+
+    memory::MemoryUsage usage = manager.memoryUsage();
+    const auto &expenses = usage.components.at("expenses");
+    REQUIRE(expenses.objects == 1000);
+    // Eight participant ids, a long description and the record itself put each expense well above 300 bytes.
+    const std::size_t perExpense = (expenses.bytes - empty.components.at("expenses").bytes) / 1000;
+    REQUIRE(perExpense > 300);
+    REQUIRE(perExpense < 2000);
+    REQUIRE(usage.components.at("balances").objects == 8);
+    REQUIRE(usage.components.at("timeIndex").objects == 1000);
+    REQUIRE(usage.components.at("descriptionIndex").objects > 0);
+    REQUIRE(usage.components.at("notifier").objects == 1);
+
+    std::size_t sum = 0;
+    for (const auto &[name, footprint] : usage.components) {
+        sum += footprint.bytes;
+    }
+    REQUIRE(usage.total().bytes == sum);
+    REQUIRE(usage.total().bytes > empty.total().bytes);
+    REQUIRE(usage.toJson().at("components").at("expenses").at("objects").get<double>() == 1000.0);
+
+    REQUIRE(usage.lastLoadJson.bytes == 0);
+    manager.saveToJson("memory_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("memory_test.json");
+    memory::MemoryUsage afterLoad = loaded.memoryUsage();
+    REQUIRE(afterLoad.lastLoadJson.objects == 1000);
+    REQUIRE(afterLoad.lastLoadJson.bytes > afterLoad.components.at("expenses").bytes / 2);
+    std::remove("memory_test.json");
+}
+
+TEST_CASE("Heap counters follow allocations when tracking is compiled in", "[memory]") {
+    memory::HeapStats before = memory::heapStats();
+    REQUIRE(before.enabled == memory::kHeapTrackingEnabled);
+    auto block = std::make_unique<std::vector<char>>(1 << 20);
+    memory::HeapStats during = memory::heapStats();
+    if (memory::kHeapTrackingEnabled) {
+        REQUIRE(during.liveBytes >= before.liveBytes + (1 << 20));
+        REQUIRE(during.peakBytes >= during.liveBytes);
+        REQUIRE(during.totalAllocations > before.totalAllocations);
+        block.reset();
+        REQUIRE(memory::heapStats().liveBytes < during.liveBytes);
+    } else {
+        REQUIRE(during.liveBytes == 0);
+        REQUIRE(during.totalAllocations == 0);
+    }
+}
+
+TEST_CASE("Scripts print memory usage as JSON", "[memory][script]") {
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nmemory\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+    REQUIRE(summary.errors == 0);
+    REQUIRE(out.str().find("\"users\":{\"bytes\":") != std::string::npos);
+    REQUIRE(out.str().find("\"heap\":") != std::string::npos);
+}
@@ -0,0 +1,57 @@
+#include "../third_party/catch2.hpp"
+
+#include "metrics.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+TEST_CASE("Manager statistics count operations and applied deltas", "[metrics]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string groupId = manager.addGroup("Flat", {alice, bob});
+
+    SplitInput rent;
+    rent.payerId = alice;
+    rent.amount = 900.0;
+    rent.participantIds = {alice, bob};
+    manager.addExpense(groupId, "Rent", rent, SplitStrategyFactory::create("equal"));
+    manager.settleUpGreedy();
+
+    auto stats = manager.getStats();
+    REQUIRE(stats.enabled == metrics::kEnabled);
+    if (!metrics::kEnabled) {
+        return;
+    }
+    REQUIRE(stats.operations.at("addUser").count == 2);
+    REQUIRE(stats.operations.at("addGroup").count == 1);
+    REQUIRE(stats.operations.at("addExpense").count == 1);
+    REQUIRE(stats.operations.at("settleUpGreedy").count == 1);
+    REQUIRE(stats.operations.at("saveToJson").count == 0);
+    REQUIRE(stats.lockWait.count == 5);
+    REQUIRE(stats.lockHold.count == 5);
+    REQUIRE(stats.expensesApplied == 1);
+    REQUIRE(stats.balancesTouched == 2);
+    REQUIRE(stats.toJson().at("operations").at("addUser").at("count").get<double>() == Approx(2.0));
+}
+
+#if SPLITWISE_ENABLE_METRICS
+TEST_CASE("Latency histogram buckets bound recorded values", "[metrics]") {
+    using metrics::LatencyHistogram;
+    for (std::uint64_t value : {0ULL, 7ULL, 8ULL, 15ULL, 1000ULL, 123456789ULL}) {
+        std::size_t index = LatencyHistogram::bucketIndex(value);
+        REQUIRE(LatencyHistogram::bucketLowerBound(index) <= value);
+        REQUIRE(LatencyHistogram::bucketUpperBound(index) >= value);
+    }
+
+    LatencyHistogram histogram;
+    for (std::uint64_t i = 1; i <= 1000; ++i) {
+        histogram.record(i * 1000);
+    }
+    auto snapshot = histogram.snapshot();
+    REQUIRE(snapshot.count == 1000);
+    REQUIRE(snapshot.meanNs == Approx(500500.0));
+    REQUIRE(snapshot.p50Ns == Approx(500000.0).epsilon(0.125));
+    REQUIRE(snapshot.p99Ns == Approx(990000.0).epsilon(0.125));
+    REQUIRE(snapshot.maxNs >= 1000000);
+}
+#endif
@@ -0,0 +1,221 @@
+#include "../third_party/catch2.hpp"
+
+#include "partitioned_ledger.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <filesystem>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+struct Ledger {
+    std::vector<std::string> users;
+    std::vector<std::string> groups;
+};
+
+// Four groups of three users each, with `perGroup` expenses per group and one EUR expense in the first group.
+Ledger populate(SplitwiseManager &manager, int perGroup) {
+    Ledger ledger;
+    for (int i = 0; i < 6; ++i) {
+        ledger.users.push_back(manager.addUser("user" + std::to_string(i)));
+    }
+    auto equal = SplitStrategyFactory::create("equal");
+    for (int g = 0; g < 4; ++g) {
+        std::vector<std::string> members{ledger.users[g], ledger.users[g + 1], ledger.users[g + 2]};
+        ledger.groups.push_back(manager.addGroup("group" + std::to_string(g), members));
+        for (int i = 0; i < perGroup; ++i) {
+            SplitInput input;
+            input.payerId = members[static_cast<std::size_t>(i) % members.size()];
+            input.amount = 30.0 + i;
+            input.participantIds = members;
+            manager.addExpense(ledger.groups.back(), "dinner " + std::to_string(i), input, equal, 1000 + g * 100 + i);
+        }
+    }
+    SplitInput euros;
+    euros.payerId = ledger.users[0];
+    euros.amount = 12.0;
+    euros.currency = "EUR";
+    euros.participantIds = {ledger.users[0], ledger.users[1]};
+    manager.addExpense(ledger.groups[0], "museum", euros, equal, 5000);
+    return ledger;
+}
+
+void requireSameBalances(const BalanceSheet::BalanceMap &a, const BalanceSheet::BalanceMap &b) {
+    REQUIRE(a.size() == b.size());
+    for (const auto &[userId, balance] : a) {
+        REQUIRE(b.at(userId) == Approx(balance));
+    }
+}
+
+std::string scratchDirectory(const std::string &name) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(path);
+    return path.string();
+}
+}
+
+TEST_CASE("Opening a partitioned ledger reads only the manifest and users", "[partition]") {
+    SplitwiseManager original;
+    Ledger ledger = populate(original, 10);
+    SplitInput rent;
+    rent.payerId = ledger.users[3];
+    rent.amount = 50.0;
+    rent.participantIds = {ledger.users[3], ledger.users[4]};
+    original.addRecurringExpense(ledger.groups[2], "rent", rent, SplitStrategyFactory::create("equal"),
+                                 RecurrenceSchedule{1100, 50, 1400});
+    const std::string dir = scratchDirectory("splitwise_partition_open");
+    original.savePartitioned(dir);
+    REQUIRE(std::filesystem::exists(std::filesystem::path(dir) / partitioned::kManifestFile));
+    REQUIRE(std::filesystem::exists(std::filesystem::path(dir) / partitioned::segmentFileName(ledger.groups[2])));
+
+    SplitwiseManager opened;
+    opened.openPartitioned(dir);
+    PartitionStats stats = opened.getPartitionStats();
+    REQUIRE(stats.open);
+    REQUIRE(stats.groups == 4);
+    REQUIRE(stats.residentGroups == 0);
+    REQUIRE(opened.getExpenses().empty());
+    REQUIRE(opened.getUsers().size() == 6);
+    requireSameBalances(opened.getAllBalances(), original.getAllBalances());
+    requireSameBalances(opened.getBalancesByCurrency().at("EUR"), original.getBalancesByCurrency().at("EUR"));
+    REQUIRE(opened.settleUpGreedy().size() == original.settleUpGreedy().size());
+
+    ExpensePage page = opened.getGroupExpenses(ledger.groups[1]);
+    REQUIRE(page.expenses.size() == 10);
+    REQUIRE(opened.getPartitionStats().pageIns == 1);
+    REQUIRE(opened.getGroups().size() == 1);
+
+    // New ids continue after the saved counters.
+    std::string userId = opened.addUser("late joiner");
+    REQUIRE(!original.getUsers().count(userId));
+
+    // Expenses added before the first as-of query reach the checkpoints that query builds; enough of them for the
+    // rebuild to take a checkpoint, which must also hold the recurring occurrences.
+    SplitInput taxi;
+    taxi.payerId = ledger.users[0];
+    taxi.amount = 18.0;
+    taxi.participantIds = {ledger.users[0], ledger.users[1]};
+    for (auto *manager : {&original, &opened}) {
+        for (int i = 0; i < 1100; ++i) {
+            manager->addExpense(ledger.groups[0], "taxi", taxi, SplitStrategyFactory::create("equal"), 1120 + i);
+        }
+    }
+    const BalanceSheet::BalanceMap live = opened.getAllBalances();
+    REQUIRE(opened.getBalancesAsOf(1150).size() == original.getBalancesAsOf(1150).size());
+    REQUIRE(opened.getPartitionStats().residentGroups == 4);
+    REQUIRE(opened.getExpenses().size() == original.getExpenses().size());
+    for (std::int64_t timestamp : {std::int64_t{999}, std::int64_t{1150}, std::int64_t{1399}, std::int64_t{6000},
+                                   std::numeric_limits<std::int64_t>::max()}) {
+        requireSameBalances(opened.getBalancesAsOf(timestamp), original.getBalancesAsOf(timestamp));
+    }
+    // Building the checkpoints leaves the live balances alone.
+    REQUIRE(opened.getAllBalances() == live);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Cold groups are written back and evicted under a memory budget", "[partition]") {
+    SplitwiseManager original;
+    Ledger ledger = populate(original, 20);
+    const std::string dir = scratchDirectory("splitwise_partition_budget");
+    original.savePartitioned(dir);
+
+    SplitwiseManager opened;
+    opened.openPartitioned(dir);
+    opened.getGroupExpenses(ledger.groups[0]);
+    const std::size_t oneGroup = opened.getPartitionStats().residentBytes;
+    REQUIRE(oneGroup > 0);
+    opened.setMemoryBudget(oneGroup * 3 / 2);
+
+    auto equal = SplitStrategyFactory::create("equal");
+    SplitInput input;
+    input.payerId = ledger.users[1];
+    input.amount = 99.0;
+    input.participantIds = {ledger.users[1], ledger.users[2]};
+    std::string added = opened.addExpense(ledger.groups[1], "taxi", input, equal, 9000);
+    PartitionStats stats = opened.getPartitionStats();
+    REQUIRE(stats.residentGroups == 1);
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.residentBytes <= stats.budgetBytes);
+
+    // Editing an expense of an evicted group pages it back in and pushes the dirty group out to disk.
+    opened.getGroupExpenses(ledger.groups[2]);
+    REQUIRE(opened.getPartitionStats().segmentWrites == 1);
+    opened.deleteExpense(original.getGroupExpenses(ledger.groups[3]).expenses.front().getId());
+    REQUIRE(opened.getPartitionStats().residentBytes <= opened.getPartitionStats().budgetBytes);
+    REQUIRE(opened.getExpense(added).getInput().amount == Approx(99.0));
+
+    BalanceSheet::BalanceMap live = opened.getAllBalances();
+    opened.savePartitioned(dir);
+    SplitwiseManager reopened;
+    reopened.openPartitioned(dir);
+    requireSameBalances(reopened.getAllBalances(), live);
+    REQUIRE(reopened.getGroupExpenses(ledger.groups[1]).expenses.size() == 21);
+    REQUIRE(reopened.getGroupExpenses(ledger.groups[3]).expenses.size() == 19);
+    REQUIRE(reopened.audit().ok());
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Saving elsewhere copies segments that are not resident", "[partition]") {
+    SplitwiseManager original;
+    Ledger ledger = populate(original, 5);
+    const std::string dir = scratchDirectory("splitwise_partition_source");
+    const std::string copy = scratchDirectory("splitwise_partition_copy");
+    original.savePartitioned(dir);
+
+    SplitwiseManager opened;
+    opened.openPartitioned(dir);
+    SplitInput input;
+    input.payerId = ledger.users[0];
+    input.amount = 7.0;
+    input.participantIds = {ledger.users[0]};
+    opened.addExpense(ledger.groups[0], "coffee", input, SplitStrategyFactory::create("equal"), 8000);
+    opened.savePartitioned(copy);
+    REQUIRE(opened.getPartitionStats().segmentWrites == 0);
+    REQUIRE(opened.getPartitionStats().directory == dir);
+
+    SplitwiseManager copied;
+    copied.openPartitioned(copy);
+    requireSameBalances(copied.getAllBalances(), opened.getAllBalances());
+    REQUIRE(copied.getUserExpenses(ledger.users[0]).expenses.size() == 7);
+
+    // A plain save of the paged-in ledger contains every group.
+    copied.saveToJson(copy + "/full.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson(copy + "/full.json");
+    REQUIRE(loaded.getExpenses().size() == original.getExpenses().size() + 1);
+    REQUIRE(!loaded.getPartitionStats().open);
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(copy);
+}
+
+TEST_CASE("Opening a directory without a manifest fails and keeps the ledger", "[partition]") {
+    SplitwiseManager manager;
+    populate(manager, 2);
+    const std::string dir = scratchDirectory("splitwise_partition_missing");
+    std::filesystem::create_directories(dir);
+    REQUIRE_THROWS_AS(manager.openPartitioned(dir), std::runtime_error);
+    REQUIRE(manager.getExpenses().size() == 9);
+    REQUIRE(!manager.getPartitionStats().open);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Scripts save, open and page partitioned ledgers", "[partition][script]") {
+    const std::string dir = scratchDirectory("splitwise_partition_script");
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-group Trip USR1 USR2\nadd-expense GRP1 USR1 10 equal Taxi\n"
+                          "save-partitioned " + dir + "\nopen-partitioned " + dir +
+                          "\nmemory-budget 0\nadd-expense GRP1 USR2 4 equal Tip\npartitions\nbalances\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+    REQUIRE(summary.errors == 0);
+    REQUIRE(out.str().find("\"residentGroups\":1") != std::string::npos);
+    REQUIRE(out.str().find("\"pageIns\":1") != std::string::npos);
+    REQUIRE(manager.getAllBalances().at("USR1") == Approx(3.0));
+    std::filesystem::remove_all(dir);
+}
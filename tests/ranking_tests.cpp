@@ -0,0 +1,173 @@
+#include "../third_party/catch2.hpp"
+
+#include "balance_rank.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+// Reference ranking: every balance sorted by (balance, user id) descending.
+std::vector<std::pair<double, std::string>> sortedDescending(const BalanceSheet::BalanceMap &balances) {
+    std::vector<std::pair<double, std::string>> sorted;
+    for (const auto &[userId, balance] : balances) {
+        sorted.emplace_back(balance, userId);
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+    return sorted;
+}
+
+std::string addSplit(SplitwiseManager &manager, const std::string &groupId, const std::string &payer, double amount,
+                     const std::vector<std::string> &participants) {
+    SplitInput input;
+    input.payerId = payer;
+    input.amount = amount;
+    input.participantIds = participants;
+    return manager.addExpense(groupId, "split", input, SplitStrategyFactory::create("equal"));
+}
+}
+
+TEST_CASE("Balance ranks track a balance sheet through random deltas", "[ranking]") {
+    BalanceRank rank;
+    BalanceSheet sheet;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> user(0, 199);
+    std::uniform_int_distribution<int> cents(-5000, 5000);
+    for (int round = 0; round < 2000; ++round) {
+        BalanceSheet::BalanceMap delta;
+        for (int i = 0; i < 4; ++i) {
+            delta["U" + std::to_string(user(rng))] += cents(rng) / 100.0;
+        }
+        // Whole-number balances produce ties, which order by user id.
+        if (round % 50 == 0) {
+            delta["U" + std::to_string(user(rng))] = 10.0;
+        }
+        sheet.applyDelta(delta);
+        rank.applyDelta(delta);
+    }
+
+    const auto expected = sortedDescending(sheet.getBalances());
+    REQUIRE(rank.size() == expected.size());
+    std::vector<RankedBalance> top = rank.top(25);
+    REQUIRE(top.size() == 25);
+    for (std::size_t i = 0; i < top.size(); ++i) {
+        REQUIRE(top[i].userId == expected[i].second);
+        REQUIRE(top[i].balance == expected[i].first);
+    }
+    std::vector<RankedBalance> bottom = rank.bottom(10);
+    REQUIRE(bottom.front().userId == expected.back().second);
+    REQUIRE(bottom[9].userId == expected[expected.size() - 10].second);
+    REQUIRE(rank.top(expected.size() + 5).size() == expected.size());
+
+    for (std::size_t i = 0; i < expected.size(); i += 17) {
+        REQUIRE(rank.rank(expected[i].second) == i + 1);
+    }
+    REQUIRE(!rank.rank("nobody").has_value());
+    auto between = [&](double low, double high) {
+        return static_cast<std::size_t>(std::count_if(expected.begin(), expected.end(), [&](const auto &entry) {
+            return entry.first >= low && entry.first <= high;
+        }));
+    };
+    REQUIRE(rank.countBetween(-20.0, 20.0) == between(-20.0, 20.0));
+    REQUIRE(rank.countBetween(10.0, 10.0) == between(10.0, 10.0));
+    REQUIRE(rank.countBetween(0.0, 1e9) == between(0.0, 1e9));
+    REQUIRE(rank.countBetween(5.0, -5.0) == 0);
+}
+
+TEST_CASE("Manager ranks creditors and debtors globally and per group", "[ranking]") {
+    SplitwiseManager manager;
+    std::vector<std::string> users;
+    for (const char *name : {"A", "B", "C", "D"}) {
+        users.push_back(manager.addUser(name));
+    }
+    std::string trip = manager.addGroup("Trip", {users[0], users[1], users[2]});
+    std::string flat = manager.addGroup("Flat", {users[2], users[3]});
+    std::string empty = manager.addGroup("Empty", {users[0]});
+    addSplit(manager, trip, users[0], 90.0, {users[0], users[1], users[2]});
+    std::string rent = addSplit(manager, flat, users[3], 100.0, {users[2], users[3]});
+
+    // Global: A +60, D +50, B -30, C -80.
+    std::vector<RankedBalance> creditors = manager.getTopCreditors(10);
+    REQUIRE(creditors.size() == 2);
+    REQUIRE(creditors[0].userId == users[0]);
+    REQUIRE(creditors[1].balance == Approx(50.0));
+    std::vector<RankedBalance> debtors = manager.getTopDebtors(1);
+    REQUIRE(debtors.size() == 1);
+    REQUIRE(debtors[0].userId == users[2]);
+    REQUIRE(manager.getBalanceRank(users[1]) == 3);
+    REQUIRE(manager.countBalancesBetween(-50.0, 55.0) == 2);
+
+    // Within the flat, C is the only debtor and A has no balance.
+    REQUIRE(manager.getTopDebtors(5, flat).front().balance == Approx(-50.0));
+    REQUIRE(manager.getBalanceRank(users[3], flat) == 1);
+    REQUIRE(!manager.getBalanceRank(users[0], flat).has_value());
+    REQUIRE(manager.getTopCreditors(5, empty).empty());
+    REQUIRE_THROWS_AS(manager.getTopCreditors(5, "GRP99"), std::invalid_argument);
+
+    manager.deleteExpense(rent);
+    REQUIRE(manager.getTopCreditors(10, flat).empty());
+    REQUIRE(manager.getTopDebtors(10).front().userId == users[1]);
+    REQUIRE(manager.getBalanceRank(users[2]) == 3);
+}
+
+TEST_CASE("Rankings survive loads and cover groups a partitioned ledger has not paged in", "[ranking][persistence]") {
+    SplitwiseManager manager;
+    std::vector<std::string> users;
+    for (int i = 0; i < 5; ++i) {
+        users.push_back(manager.addUser("user" + std::to_string(i)));
+    }
+    std::vector<std::string> groups;
+    for (int g = 0; g < 3; ++g) {
+        groups.push_back(manager.addGroup("group" + std::to_string(g), {users[g], users[g + 1], users[g + 2]}));
+        for (int i = 0; i < 5; ++i) {
+            addSplit(manager, groups.back(), users[g + static_cast<std::size_t>(i) % 3], 12.0 + i * g,
+                     {users[g], users[g + 1], users[g + 2]});
+        }
+    }
+
+    const std::string dir = (std::filesystem::temp_directory_path() / "splitwise_ranking_partitioned").string();
+    std::filesystem::remove_all(dir);
+    manager.savePartitioned(dir);
+    SplitwiseManager opened;
+    opened.openPartitioned(dir);
+    for (const std::string &groupId : {std::string{}, groups[0], groups[2]}) {
+        std::vector<RankedBalance> expected = manager.getTopCreditors(5, groupId);
+        std::vector<RankedBalance> actual = opened.getTopCreditors(5, groupId);
+        REQUIRE(actual.size() == expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i) {
+            REQUIRE(actual[i].userId == expected[i].userId);
+            REQUIRE(actual[i].balance == Approx(expected[i].balance));
+        }
+    }
+    REQUIRE(opened.getPartitionStats().residentGroups == 0);
+    std::filesystem::remove_all(dir);
+
+    manager.saveToJson("ranking_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("ranking_test.json");
+    REQUIRE(loaded.getBalanceRank(users[4], groups[2]) == manager.getBalanceRank(users[4], groups[2]));
+    REQUIRE(loaded.countBalancesBetween(-1e9, 1e9) == loaded.getAllBalances().size());
+    std::remove("ranking_test.json");
+}
+
+TEST_CASE("Scripts list top creditors, debtors and ranks", "[ranking][script]") {
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-user C\nadd-group Trip USR1 USR2 USR3\n"
+                          "add-expense GRP1 USR1 90 equal Hotel\nadd-expense GRP1 USR2 30 equal Taxi\n"
+                          "top-creditors 5\ntop-debtors 1 GRP1\nrank USR2\ncount-balances -100 0\nrank USR9\n"
+                          "top-creditors x\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+    REQUIRE(summary.errors == 1);
+    REQUIRE(out.str().find("USR1 50.00\nUSR3 -40.00\n2\n2\nnone\n") != std::string::npos);
+}
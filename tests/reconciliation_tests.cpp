@@ -4,6 +4,7 @@
 #include "splitwise_manager.hpp"
 
 #include <cstdio>
+#include <future>
 #include <limits>
 #include <memory>
 
@@ -85,3 +86,134 @@ TEST_CASE("Persistence round trip restores balances", "[manager][persistence]")
     std::remove("test_data.json");
 }
 
+
+TEST_CASE("Editing and deleting expenses reverses their balance deltas", "[manager][edit]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string carol = manager.addUser("Carol");
+    std::string groupId = manager.addGroup("Flat", {alice, bob, carol});
+
+    SplitInput rent;
+    rent.payerId = alice;
+    rent.amount = 900.0;
+    rent.participantIds = {alice, bob, carol};
+    std::string rentId = manager.addExpense(groupId, "Rent", rent, SplitStrategyFactory::create("equal"));
+
+    SplitInput power;
+    power.payerId = bob;
+    power.amount = 60.0;
+    power.participantIds = {bob, carol};
+    std::string powerId = manager.addExpense(groupId, "Power", power, SplitStrategyFactory::create("equal"));
+
+    SplitInput corrected;
+    corrected.payerId = alice;
+    corrected.amount = 1000.0;
+    corrected.participantIds = {alice, bob};
+    corrected.exactShares = {400.0, 600.0};
+    manager.updateExpense(rentId, "Rent (corrected)", corrected, SplitStrategyFactory::create("exact"));
+
+    REQUIRE(manager.getExpenses().at(rentId).getDescription() == "Rent (corrected)");
+    REQUIRE(manager.getAllBalances().at(alice) == Approx(600.0));
+    REQUIRE(manager.getAllBalances().at(bob) == Approx(-570.0));
+    REQUIRE(manager.getAllBalances().at(carol) == Approx(-30.0));
+
+    SplitInput invalid = corrected;
+    invalid.exactShares = {1.0, 2.0};
+    REQUIRE_THROWS_AS(manager.updateExpense(rentId, "Broken", invalid, SplitStrategyFactory::create("exact")),
+                      std::invalid_argument);
+    REQUIRE(manager.getAllBalances().at(alice) == Approx(600.0));
+
+    manager.deleteExpense(powerId);
+    REQUIRE(manager.getExpenses().count(powerId) == 0);
+    REQUIRE(manager.getAllBalances().at(bob) == Approx(-600.0));
+    REQUIRE(manager.getAllBalances().at(carol) == Approx(0.0));
+    REQUIRE_THROWS_AS(manager.deleteExpense(powerId), std::invalid_argument);
+
+    manager.saveToJson("edit_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("edit_test.json");
+    REQUIRE(loaded.getExpenses().size() == 1);
+    REQUIRE(loaded.getAllBalances().at(alice) == Approx(600.0));
+    REQUIRE(loaded.addExpense(groupId, "Snacks", power, SplitStrategyFactory::create("equal")) == "EXP3");
+    std::remove("edit_test.json");
+}
+
+TEST_CASE("Time range queries and historical balances follow timestamps", "[manager][time]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string home = manager.addGroup("Home", {alice, bob});
+    std::string trip = manager.addGroup("Trip", {alice, bob});
+    auto equal = SplitStrategyFactory::create("equal");
+
+    SplitInput input;
+    input.payerId = alice;
+    input.amount = 2.0;
+    input.participantIds = {alice, bob};
+    // Enough expenses to cross several checkpoints; every expense moves one unit from Bob to Alice.
+    for (std::int64_t day = 1; day <= 3000; ++day) {
+        manager.addExpense(day % 2 == 0 ? home : trip, "Day", input, equal, day * 86400);
+    }
+    std::string backdated = manager.addExpense(home, "Backdated", input, equal, 100 * 86400 + 1);
+
+    auto homeRange = manager.getExpensesBetween(home, 10 * 86400, 20 * 86400);
+    REQUIRE(homeRange.size() == 6);
+    REQUIRE(homeRange.front().getTimestamp() == 10 * 86400);
+    REQUIRE(manager.getExpensesBetween("", 10 * 86400, 20 * 86400).size() == 11);
+    REQUIRE(manager.getExpensesBetween(home, 100 * 86400, 100 * 86400 + 1).back().getId() == backdated);
+
+    REQUIRE(manager.getBalancesAsOf(0).empty());
+    REQUIRE(manager.getBalancesAsOf(99 * 86400).at(alice) == Approx(99.0));
+    REQUIRE(manager.getBalancesAsOf(2500 * 86400).at(alice) == Approx(2501.0));
+    manager.deleteExpense(backdated);
+    REQUIRE(manager.getBalancesAsOf(2500 * 86400).at(bob) == Approx(-2500.0));
+    REQUIRE(manager.getBalancesAsOf(5000 * 86400).at(alice) == Approx(manager.getAllBalances().at(alice)));
+
+    manager.saveToJson("time_test.json");
+    SplitwiseManager loaded;
+    loaded.loadFromJson("time_test.json");
+    REQUIRE(loaded.getExpensesBetween(trip, 0, 86400).front().getTimestamp() == 86400);
+    REQUIRE(loaded.getBalancesAsOf(1234 * 86400).at(alice) == Approx(1234.0));
+    std::remove("time_test.json");
+
+    REQUIRE(parseTimestamp("1970-01-02") == 86400);
+    REQUIRE(parseTimestamp("2024-03-01T12:30:15") == 1709296215);
+    REQUIRE_THROWS_AS(parseTimestamp("yesterday"), std::invalid_argument);
+}
+
+TEST_CASE("Background saves write a consistent snapshot and coalesce", "[manager][persistence]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string groupId = manager.addGroup("Flat", {alice, bob});
+    SplitInput rent;
+    rent.payerId = alice;
+    rent.amount = 100.0;
+    rent.participantIds = {alice, bob};
+    auto equal = SplitStrategyFactory::create("equal");
+    for (int i = 0; i < 500; ++i) {
+        manager.addExpense(groupId, "Rent", rent, equal);
+    }
+
+    std::vector<std::shared_future<void>> saves;
+    for (int i = 0; i < 20; ++i) {
+        saves.push_back(manager.saveAsync("async_test.json"));
+        manager.addExpense(groupId, "Rent", rent, equal);
+    }
+    manager.waitForSaves();
+    for (auto &save : saves) {
+        save.get();
+    }
+    // The final request was queued after the last expense, so the file must contain all of them.
+    manager.saveAsync("async_test.json").get();
+
+    SplitwiseManager loaded;
+    loaded.loadFromJson("async_test.json");
+    REQUIRE(loaded.getExpenses().size() == 520);
+    REQUIRE(loaded.getAllBalances().at(alice) == Approx(26000.0));
+    std::remove("async_test.json");
+
+    auto failed = manager.saveAsync("missing_dir/async_test.json");
+    REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+}
@@ -0,0 +1,193 @@
+#include "../third_party/catch2.hpp"
+
+#include "recurring_expense.hpp"
+#include "script_runner.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+// Far enough in the future that automatic accrual to the current time never reaches it.
+constexpr std::int64_t START = 4000000000;
+constexpr std::int64_t MONTH = 30 * 86400;
+
+struct Flat {
+    std::vector<std::string> users;
+    std::string groupId;
+    std::string rentId;
+};
+
+Flat makeFlat(SplitwiseManager &manager) {
+    Flat flat;
+    for (const char *name : {"A", "B", "C"}) {
+        flat.users.push_back(manager.addUser(name));
+    }
+    flat.groupId = manager.addGroup("Flat", flat.users);
+    SplitInput rent;
+    rent.payerId = flat.users[0];
+    rent.amount = 900.0;
+    rent.participantIds = flat.users;
+    flat.rentId = manager.addRecurringExpense(flat.groupId, "Rent", rent, SplitStrategyFactory::create("equal"),
+                                              {START, MONTH});
+    return flat;
+}
+
+BalanceSheet::BalanceMap sumSplits(const std::vector<Expense> &expenses) {
+    BalanceSheet sheet;
+    for (const auto &expense : expenses) {
+        sheet.applyDelta(expense.getStrategy()->computeSplits(expense.getInput()));
+    }
+    return sheet.getBalances();
+}
+}
+
+TEST_CASE("Schedules count occurrences in closed form", "[recurring]") {
+    RecurrenceSchedule schedule{100, 10, 150};
+    REQUIRE(schedule.countUpTo(99) == 0);
+    REQUIRE(schedule.countUpTo(100) == 1);
+    REQUIRE(schedule.countUpTo(119) == 2);
+    REQUIRE(schedule.countUpTo(1000) == 6);
+    REQUIRE(schedule.occurrenceTime(5) == 150);
+
+    std::string templateId;
+    std::uint64_t index = 0;
+    REQUIRE(RecurringExpense::parseOccurrenceId("REC12#40", templateId, index));
+    REQUIRE(templateId == "REC12");
+    REQUIRE(index == 40);
+    REQUIRE(!RecurringExpense::parseOccurrenceId("EXP3", templateId, index));
+    REQUIRE(!RecurringExpense::parseOccurrenceId("REC1#x", templateId, index));
+}
+
+TEST_CASE("Recurring expenses accrue into balances without storing occurrences", "[recurring]") {
+    SplitwiseManager manager;
+    Flat flat = makeFlat(manager);
+    REQUIRE(manager.getAllBalances().empty());
+
+    manager.accrueRecurring(START + 11 * MONTH);
+    REQUIRE(manager.getAllBalances().at(flat.users[0]) == Approx(12 * 600.0));
+    REQUIRE(manager.getAllBalances().at(flat.users[1]) == Approx(-12 * 300.0));
+    REQUIRE(manager.getExpenses().empty());
+    REQUIRE(manager.memoryUsage().components.at("recurring").objects == 1);
+
+    std::vector<Expense> listed = manager.getExpensesBetween(flat.groupId, START, START + 5 * MONTH);
+    REQUIRE(listed.size() == 6);
+    REQUIRE(listed[2].getId() == flat.rentId + "#2");
+    REQUIRE(listed[2].getTimestamp() == START + 2 * MONTH);
+    REQUIRE(manager.getExpense(flat.rentId + "#7").getDescription() == "Rent");
+    REQUIRE(manager.getBalancesAsOf(START + 2 * MONTH).at(flat.users[0]) == Approx(1800.0));
+    // Occurrences after the accrual time do not exist yet.
+    REQUIRE(manager.getExpensesBetween({}, START, START + 40 * MONTH).size() == 12);
+    REQUIRE_THROWS_AS(manager.getExpense(flat.rentId + "#12"), std::invalid_argument);
+    REQUIRE(manager.audit().ok());
+}
+
+TEST_CASE("Editing or deleting an occurrence materializes it", "[recurring]") {
+    SplitwiseManager manager;
+    Flat flat = makeFlat(manager);
+    manager.accrueRecurring(START + 11 * MONTH);
+
+    SplitInput discounted;
+    discounted.payerId = flat.users[0];
+    discounted.amount = 600.0;
+    discounted.participantIds = flat.users;
+    manager.updateExpense(flat.rentId + "#3", "Rent (discount)", discounted, SplitStrategyFactory::create("equal"));
+    REQUIRE(manager.getExpenses().size() == 1);
+    REQUIRE(manager.getExpense(flat.rentId + "#3").getInput().amount == Approx(600.0));
+    REQUIRE(manager.getAllBalances().at(flat.users[0]) == Approx(11 * 600.0 + 400.0));
+
+    manager.deleteExpense(flat.rentId + "#4");
+    REQUIRE_THROWS_AS(manager.deleteExpense(flat.rentId + "#4"), std::invalid_argument);
+    REQUIRE(manager.getAllBalances().at(flat.users[0]) == Approx(10 * 600.0 + 400.0));
+    REQUIRE(manager.getBalancesAsOf(START + 4 * MONTH).at(flat.users[0]) == Approx(3 * 600.0 + 400.0));
+    REQUIRE(manager.getExpensesBetween(flat.groupId, START, START + 11 * MONTH).size() == 11);
+    REQUIRE(manager.getRecurringExpenses().front().getSkipped().size() == 2);
+
+    manager.endRecurringExpense(flat.rentId, START + 5 * MONTH);
+    REQUIRE(manager.getAllBalances().at(flat.users[0]) == Approx(4 * 600.0 + 400.0));
+    manager.endRecurringExpense(flat.rentId, START + 7 * MONTH);
+    REQUIRE(manager.getAllBalances().at(flat.users[0]) == Approx(6 * 600.0 + 400.0));
+    REQUIRE(manager.audit().ok());
+}
+
+TEST_CASE("Balance checkpoints include accrued occurrences up to their boundary", "[recurring]") {
+    SplitwiseManager manager;
+    Flat flat = makeFlat(manager);
+    auto equal = SplitStrategyFactory::create("equal");
+    auto addRange = [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            SplitInput input;
+            input.payerId = flat.users[static_cast<std::size_t>(i) % 3];
+            input.amount = 3.0 + i % 7;
+            input.participantIds = flat.users;
+            manager.addExpense(flat.groupId, "shop", input, equal, START + i * 1000);
+        }
+    };
+    addRange(0, 1500);
+    manager.accrueRecurring(START + 1500 * 1000);
+    addRange(1500, 3000);
+    manager.accrueRecurring(START + 3000 * 1000 + 5 * MONTH);
+
+    const std::int64_t probes[] = {START - 1, START + 700 * 1000, START + 2 * MONTH + 5, START + 2999 * 1000,
+                                   START + 4 * MONTH};
+    for (std::int64_t t : probes) {
+        BalanceSheet::BalanceMap expected =
+            sumSplits(manager.getExpensesBetween({}, std::numeric_limits<std::int64_t>::min(), t));
+        BalanceSheet::BalanceMap actual = manager.getBalancesAsOf(t);
+        for (const auto &[userId, balance] : expected) {
+            REQUIRE(actual[userId] == Approx(balance));
+        }
+    }
+}
+
+TEST_CASE("Recurring templates survive JSON and partitioned saves", "[recurring][persistence]") {
+    SplitwiseManager manager;
+    Flat flat = makeFlat(manager);
+    manager.accrueRecurring(START + 11 * MONTH);
+    manager.deleteExpense(flat.rentId + "#0");
+    manager.saveToJson("recurring_test.json");
+
+    SplitwiseManager loaded;
+    loaded.loadFromJson("recurring_test.json");
+    REQUIRE(loaded.getRecurringAsOf() == START + 11 * MONTH);
+    REQUIRE(loaded.getRecurringExpenses().size() == 1);
+    REQUIRE(loaded.getAllBalances().at(flat.users[0]) == Approx(11 * 600.0));
+    REQUIRE(loaded.audit("recurring_test.json").ok());
+    // New templates do not reuse ids.
+    SplitInput power;
+    power.payerId = flat.users[1];
+    power.amount = 60.0;
+    power.participantIds = flat.users;
+    REQUIRE(loaded.addRecurringExpense(flat.groupId, "Power", power, SplitStrategyFactory::create("equal"),
+                                       {START, MONTH}) != flat.rentId);
+    std::remove("recurring_test.json");
+
+    const std::string dir = (std::filesystem::temp_directory_path() / "splitwise_recurring_partitioned").string();
+    std::filesystem::remove_all(dir);
+    manager.savePartitioned(dir);
+    SplitwiseManager opened;
+    opened.openPartitioned(dir);
+    REQUIRE(opened.getAllBalances().at(flat.users[0]) == Approx(11 * 600.0));
+    REQUIRE(opened.getExpensesBetween(flat.groupId, START, START + MONTH).size() == 1);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Scripts add, list and edit recurring expenses", "[recurring][script]") {
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-group Flat USR1 USR2\n"
+                          "add-recurring GRP1 USR1 100 equal Internet every=30d @4000000000\n"
+                          "accrue 4010000000\nrecurring\ndelete-expense REC1#1\nbalances\n"
+                          "add-recurring GRP1 USR1 100 equal Broken\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+    REQUIRE(summary.errors == 1);
+    REQUIRE(out.str().find("REC1 GRP1 100.00 every 2592000 from 4000000000 accrued 4\n") != std::string::npos);
+    REQUIRE(manager.getAllBalances().at("USR1") == Approx(150.0));
+}
@@ -0,0 +1,351 @@
+#include "../third_party/catch2.hpp"
+
+#include "daemon_client.hpp"
+#include "daemon_server.hpp"
+#include "replication_follower.hpp"
+#include "replication_log.hpp"
+#include "script_runner.hpp"
+#include "splitwise_manager.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+SplitInput split(const std::string &payer, const std::vector<std::string> &participants, double amount) {
+    SplitInput input;
+    input.payerId = payer;
+    input.amount = amount;
+    input.participantIds = participants;
+    return input;
+}
+
+void requireSameLedger(const SplitwiseManager &leader, const SplitwiseManager &follower) {
+    REQUIRE(follower.getReplicationSequence() == leader.getReplicationSequence());
+    REQUIRE(follower.getUsers().size() == leader.getUsers().size());
+    REQUIRE(follower.getGroups().size() == leader.getGroups().size());
+    REQUIRE(follower.getExpenses().size() == leader.getExpenses().size());
+    for (const auto &[id, expense] : leader.getExpenses()) {
+        REQUIRE(follower.getExpense(id).getInput().amount == expense.getInput().amount);
+    }
+    REQUIRE(follower.getBalancesByCurrency() == leader.getBalancesByCurrency());
+}
+
+// A `splitwise --daemon` child process, stopped with SIGTERM when it goes out of scope.
+class DaemonProcess {
+public:
+    DaemonProcess(const std::string &socket, std::vector<std::string> args) {
+        args.insert(args.begin(), {SPLITWISE_BINARY, "--daemon", "--socket", socket});
+        std::vector<char *> argv;
+        for (auto &arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        std::filesystem::remove(socket);
+        pid_ = ::fork();
+        if (pid_ == 0) {
+            ::execv(argv[0], argv.data());
+            ::_exit(127);
+        }
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            try {
+                DaemonClient::connectUnix(socket);
+                return;
+            } catch (const std::runtime_error &) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        throw std::runtime_error("daemon did not start on " + socket);
+    }
+
+    ~DaemonProcess() {
+        ::kill(pid_, SIGTERM);
+        int status = 0;
+        ::waitpid(pid_, &status, 0);
+    }
+
+private:
+    pid_t pid_{-1};
+};
+
+// Poll a follower until it reports `sequence` as applied.
+bool waitForSequence(DaemonClient &follower, std::uint64_t sequence) {
+    for (int attempt = 0; attempt < 500; ++attempt) {
+        std::istringstream in(follower.call("replication").body);
+        nlohmann::json status;
+        in >> status;
+        if (status.at("sequence").get<double>() >= static_cast<double>(sequence)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+}
+
+TEST_CASE("Replication log serves operations after any retained sequence", "[replication]") {
+    ReplicationLog log(10);
+    REQUIRE(log.latest() == 10);
+    REQUIRE(log.append({{"op", "user"}, {"id", "USR1"}, {"name", "A"}}, 1000) == 11);
+    REQUIRE(log.append({{"op", "delete"}, {"id", "EXP4"}}, 2000) == 12);
+
+    ReplicationBatch batch = log.after(10, 1);
+    REQUIRE(batch.leaderSequence == 12);
+    REQUIRE(batch.leaderTime == 2000);
+    REQUIRE(batch.operations.size() == 1);
+    REQUIRE(batch.operations[0].sequence == 11);
+    REQUIRE(log.after(12, 5).operations.empty());
+    REQUIRE_THROWS_AS(log.after(9, 5), std::invalid_argument);
+    REQUIRE_THROWS_AS(log.after(13, 5), std::invalid_argument);
+
+    ReplicationBatch decoded = ReplicationBatch::decode(log.after(10, 5).encode());
+    REQUIRE(decoded.operations.size() == 2);
+    REQUIRE(decoded.operations[1].sequence == 12);
+    REQUIRE(decoded.operations[1].time == 2000);
+    REQUIRE(decoded.operations[1].operation.at("id").get<std::string>() == "EXP4");
+    REQUIRE_THROWS_AS(ReplicationBatch::decode("{}"), std::runtime_error);
+}
+
+TEST_CASE("Followers replay a leader's operations exactly and report lag", "[replication]") {
+    SplitwiseManager leader;
+    std::string a = leader.addUser("A");  // before logging: both sides start from this state
+    leader.enableReplicationLog();
+    std::string b = leader.addUser("B");
+    leader.addUserWithId("USR9", "C");
+    std::string trip = leader.addGroup("Trip", {a, b});
+    auto equal = SplitStrategyFactory::create("equal");
+    std::string taxi = leader.addExpense(trip, "Taxi", split(a, {a, b}, 30.0), equal, 100);
+    leader.addGroupMember(trip, "USR9", 200);
+    std::string dinner = leader.addExpense(trip, "Dinner", split("USR9", {a, b, "USR9"}, 90.0), equal);
+    SplitInput euros = split(b, {a, b}, 10.0);
+    euros.currency = "EUR";
+    leader.addExpense(trip, "Museum", euros, equal, 300);
+    leader.updateExpense(taxi, "Taxi home", split(b, {a, b}, 40.0), equal);
+    leader.deleteExpense(dinner);
+    REQUIRE(leader.getReplicationSequence() == 9);
+    REQUIRE(leader.getReplicationStatus().role == "leader");
+    REQUIRE_THROWS_AS(leader.addRecurringExpense(trip, "Rent", split(a, {a, b}, 10.0), equal, {0, 60}),
+                      std::invalid_argument);
+    REQUIRE(leader.memoryUsage().components.count("replicationLog") == 1);
+
+    SplitwiseManager follower;
+    follower.addUser("A");
+    REQUIRE(follower.applyReplicatedBatch(leader.getReplicatedOperations(0, 4)) == 4);
+    ReplicationStatus status = follower.getReplicationStatus();
+    REQUIRE(status.role == "follower");
+    REQUIRE(status.lagOperations == 5);
+    REQUIRE(status.lagMillis >= 0);
+    // A batch that skips operations is refused; one that repeats them is harmless.
+    REQUIRE_THROWS_AS(follower.applyReplicatedBatch(leader.getReplicatedOperations(5)), std::invalid_argument);
+    REQUIRE(follower.applyReplicatedBatch(leader.getReplicatedOperations(0)) == 5);
+    REQUIRE(follower.applyReplicatedBatch(leader.getReplicatedOperations(0)) == 0);
+    REQUIRE(follower.getReplicationStatus().lagOperations == 0);
+    requireSameLedger(leader, follower);
+    REQUIRE_THROWS_AS(follower.enableReplicationLog(), std::invalid_argument);
+    REQUIRE_THROWS_AS(leader.applyReplicatedBatch({}), std::invalid_argument);
+
+    // The sequence is saved with the ledger, so a copy loaded from the leader's file catches up from there.
+    leader.saveToJson("replication_test.json");
+    leader.addExpense(trip, "Late", split(a, {a, b, "USR9"}, 12.0), equal, 400);
+    SplitwiseManager restored;
+    restored.loadFromJson("replication_test.json");
+    REQUIRE(restored.getReplicationSequence() == 9);
+    REQUIRE(restored.applyReplicatedBatch(leader.getReplicatedOperations(restored.getReplicationSequence())) == 1);
+    requireSameLedger(leader, restored);
+    std::remove("replication_test.json");
+
+    // A promoted replica numbers new records after the replicated ones.
+    REQUIRE(follower.addUser("D") == "USR10");
+}
+
+TEST_CASE("Followers behind the leader's retained log bootstrap from a snapshot", "[replication][daemon]") {
+    ReplicationLog log(0, 3);
+    for (int i = 1; i <= 5; ++i) {
+        log.append({{"op", "delete"}, {"id", "EXP" + std::to_string(i)}}, i);
+    }
+    REQUIRE(log.start() == 2);
+    REQUIRE(log.latest() == 5);
+    REQUIRE(log.after(2, 10).operations.front().sequence == 3);
+    std::string trimmed;
+    try {
+        log.after(1, 10);
+    } catch (const std::invalid_argument &ex) {
+        trimmed = ex.what();
+    }
+    REQUIRE(trimmed.find(ReplicationLog::kNotRetained) != std::string::npos);
+    REQUIRE_THROWS_AS(ReplicationLog(0, 0), std::invalid_argument);
+
+    SplitwiseManager leader;
+    leader.enableReplicationLog(4);
+    const std::string path = "replication_retain_" + std::to_string(::getpid()) + ".sock";
+    auto server = std::make_unique<DaemonServer>(leader, DaemonOptions{path, 0, 2});
+    server->start();
+    SplitwiseManager replica;
+    ReplicationFollower follower(replica, FollowerOptions{path, std::chrono::milliseconds(5), 2});
+    std::string a = leader.addUser("A");
+    std::string b = leader.addUser("B");
+    std::string flat = leader.addGroup("Flat", {a, b});
+    REQUIRE(follower.syncOnce() == 3);
+
+    // Ten more operations while the follower is away: its position falls out of the four the leader keeps.
+    for (int i = 0; i < 10; ++i) {
+        leader.addExpense(flat, "Groceries", split(i % 2 ? a : b, {a, b}, 10.0 + i),
+                          SplitStrategyFactory::create("equal"), 1000 + i);
+    }
+    REQUIRE(leader.memoryUsage().components.at("replicationLog").objects == 4);
+    REQUIRE_THROWS_AS(leader.getReplicatedOperations(3), std::invalid_argument);
+    REQUIRE(follower.syncOnce() == 0);
+    REQUIRE(follower.bootstraps() == 1);
+    requireSameLedger(leader, replica);
+    REQUIRE(replica.getReplicationStatus().role == "follower");
+
+    // From the snapshot's sequence on it follows the log again.
+    leader.addExpense(flat, "Milk", split(a, {a, b}, 4.0), SplitStrategyFactory::create("equal"), 2000);
+    REQUIRE(follower.syncOnce() == 1);
+    REQUIRE(follower.bootstraps() == 1);
+    requireSameLedger(leader, replica);
+    server.reset();
+}
+
+TEST_CASE("A leader restarted from a partitioned ledger continues its sequence", "[replication][daemon]") {
+    const std::string dir = "replication_partitioned_" + std::to_string(::getpid());
+    const std::string path = "replication_restart_" + std::to_string(::getpid()) + ".sock";
+    SplitwiseManager replica;
+    std::string a;
+    std::string b;
+    std::string flat;
+    {
+        SplitwiseManager leader;
+        leader.enableReplicationLog();
+        DaemonServer server(leader, DaemonOptions{path, 0, 2});
+        server.start();
+        a = leader.addUser("A");
+        b = leader.addUser("B");
+        flat = leader.addGroup("Flat", {a, b});
+        leader.addExpense(flat, "Rent", split(a, {a, b}, 900.0), SplitStrategyFactory::create("equal"), 100);
+        leader.savePartitioned(dir);
+        ReplicationFollower follower(replica, FollowerOptions{path, std::chrono::milliseconds(5), 8});
+        REQUIRE(follower.syncOnce() == 4);
+    }
+
+    SplitwiseManager leader;
+    leader.openPartitioned(dir);
+    REQUIRE(leader.getReplicationSequence() == 4);
+    leader.enableReplicationLog();
+    DaemonServer server(leader, DaemonOptions{path, 0, 2});
+    server.start();
+    // Numbered after what the follower already applied, so it is not mistaken for a replay.
+    leader.addExpense(flat, "Power", split(b, {a, b}, 60.0), SplitStrategyFactory::create("equal"), 200);
+    ReplicationFollower follower(replica, FollowerOptions{path, std::chrono::milliseconds(5), 8});
+    REQUIRE(follower.syncOnce() == 1);
+    REQUIRE(replica.getReplicationSequence() == 5);
+    REQUIRE(replica.getExpenses().size() == 2);
+    REQUIRE(replica.getBalancesByCurrency() == leader.getBalancesByCurrency());
+    server.stop();
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Follower threads track a leader daemon and reconnect", "[replication][daemon]") {
+    SplitwiseManager leader;
+    leader.enableReplicationLog();
+    const std::string path = "replication_test_" + std::to_string(::getpid()) + ".sock";
+    auto server = std::make_unique<DaemonServer>(leader, DaemonOptions{path, 0, 2});
+    server->start();
+
+    SplitwiseManager replica;
+    ReplicationFollower follower(replica, FollowerOptions{path, std::chrono::milliseconds(5), 2});
+    REQUIRE(follower.syncOnce() == 0);
+    std::string a = leader.addUser("A");
+    std::string b = leader.addUser("B");
+    std::string flat = leader.addGroup("Flat", {a, b});
+    // Five operations arrive in batches of two within one round.
+    REQUIRE(follower.syncOnce() == 3);
+    REQUIRE(follower.connected());
+
+    follower.start();
+    // Clients read the replica through the same read-only script path a follower daemon serves, while the follower
+    // thread applies batches underneath them; every answer must be a consistent (zero-sum) ledger state.
+    std::atomic<bool> writing{true};
+    std::vector<std::string> failures;
+    std::thread reader([&] {
+        ScriptOptions options;
+        options.readOnly = true;
+        while (writing) {
+            std::ostringstream out;
+            ScriptRunner runner(replica, out, options);
+            if (!runner.execute("balances") || !runner.execute("balance-summary")) {
+                failures.push_back("read failed");
+            }
+            runner.flush();
+            std::istringstream lines(out.str());
+            std::string userId;
+            double balance = 0.0;
+            double total = 0.0;
+            while (lines >> userId >> balance) {
+                total += balance;
+            }
+            if (std::fabs(total) > 0.02) {
+                failures.push_back("unbalanced read: " + std::to_string(total));
+            }
+        }
+    });
+    for (int i = 0; i < 50; ++i) {
+        leader.addExpense(flat, "Groceries", split(i % 2 ? a : b, {a, b}, 10.0 + i),
+                          SplitStrategyFactory::create("equal"), 1000 + i);
+    }
+    REQUIRE(follower.waitFor(leader.getReplicationSequence(), std::chrono::seconds(5)));
+    writing = false;
+    reader.join();
+    REQUIRE(failures.empty());
+    requireSameLedger(leader, replica);
+    follower.stop();
+
+    server.reset();  // closes the follower's connection
+    REQUIRE_THROWS_AS(follower.syncOnce(), std::runtime_error);
+    REQUIRE(!follower.connected());
+    REQUIRE(!follower.lastError().empty());
+}
+
+TEST_CASE("Leader and follower daemons replicate as separate processes", "[replication][process]") {
+    const std::string dir =
+        (std::filesystem::temp_directory_path() / ("splitwise_replication_" + std::to_string(::getpid()))).string();
+    std::filesystem::create_directories(dir);
+    const std::string leaderSocket = dir + "/leader.sock";
+    DaemonProcess leaderProcess(leaderSocket, {"--leader"});
+    DaemonProcess followerProcess(dir + "/follower.sock", {"--follow", leaderSocket});
+
+    DaemonClient leader = DaemonClient::connectUnix(leaderSocket);
+    for (const auto &response :
+         leader.callBatch({"add-user A", "add-user B", "add-group Trip USR1 USR2",
+                           "add-expense GRP1 USR1 60 equal Hotel @10", "add-expense GRP1 USR2 20 equal Taxi @20"})) {
+        REQUIRE(response.ok);
+    }
+    DaemonClient follower = DaemonClient::connectUnix(dir + "/follower.sock");
+    REQUIRE(waitForSequence(follower, 5));
+    REQUIRE(follower.call("balances").body == leader.call("balances").body);
+    REQUIRE(follower.call("settle").body == "USR2 USR1 20.00\n");
+    protocol::Response write = follower.call("add-user C");
+    REQUIRE(!write.ok);
+    REQUIRE(write.body.find("read-only") != std::string::npos);
+
+    // A follower started later, from a copy the leader saved, catches up from the copy's sequence.
+    REQUIRE(leader.call("save " + dir + "/leader.json").ok);
+    REQUIRE(leader.call("delete-expense EXP2").ok);
+    DaemonProcess lateProcess(dir + "/late.sock", {"--follow", leaderSocket, "--load", dir + "/leader.json"});
+    DaemonClient late = DaemonClient::connectUnix(dir + "/late.sock");
+    REQUIRE(waitForSequence(late, 6));
+    REQUIRE(late.call("balances").body == "USR1 30.00\nUSR2 -30.00\n");
+    std::filesystem::remove_all(dir);
+}
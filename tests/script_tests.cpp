@@ -0,0 +1,98 @@
+#include "../third_party/catch2.hpp"
+
+#include "script_runner.hpp"
+
+#include <sstream>
+
+namespace {
+const char *SCRIPT = R"(# trip ledger
+add-user Alice
+add-user "Bob B"
+add-user Carol
+add-group Friends USR1 USR2 USR3
+add-expense GRP1 USR1 120 equal Dinner
+add-expense GRP1 USR2 60 percent "Movie night" USR1=30 USR2=30 USR3=40
+add-expense GRP1 USR3 45 exact Taxi USR2=20 USR3=25
+add-expense GRP1 USR9 10 equal Broken
+balances
+settle
+)";
+
+std::string runScript(std::size_t batchSize, ScriptSummary &summary, SplitwiseManager &manager) {
+    std::istringstream in(SCRIPT);
+    std::ostringstream out;
+    ScriptOptions options;
+    options.batchSize = batchSize;
+    ScriptRunner runner(manager, out, options);
+    summary = runner.run(in);
+    return out.str();
+}
+}
+
+TEST_CASE("Scripts drive the manager and report errors per line", "[script]") {
+    SplitwiseManager manager;
+    ScriptSummary summary;
+    std::string output = runScript(1, summary, manager);
+
+    REQUIRE(summary.commands == 10);
+    REQUIRE(summary.errors == 1);
+    REQUIRE(manager.getUsers().at("USR2").getName() == "Bob B");
+    REQUIRE(manager.getExpenses().at("EXP2").getDescription() == "Movie night");
+    REQUIRE(manager.getAllBalances().at("USR1") == Approx(62.0));
+    REQUIRE(manager.getAllBalances().at("USR3") == Approx(-44.0));
+    REQUIRE(output.find("error: line 9: Payer must be part of the group") != std::string::npos);
+    REQUIRE(output.find("USR1 62.00\n") != std::string::npos);
+}
+
+TEST_CASE("Batched expense submission matches unbatched output", "[script]") {
+    SplitwiseManager unbatched;
+    SplitwiseManager batched;
+    ScriptSummary first;
+    ScriptSummary second;
+    std::string expected = runScript(1, first, unbatched);
+    std::string actual = runScript(64, second, batched);
+
+    REQUIRE(actual == expected);
+    REQUIRE(second.errors == first.errors);
+    if (metrics::kEnabled) {
+        REQUIRE(batched.getStats().operations.at("addExpenses").count == 1);
+    }
+}
+
+TEST_CASE("Scripts can correct and remove expenses", "[script]") {
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-group G USR1 USR2\n"
+                          "add-expense GRP1 USR1 100 equal Hotel\n"
+                          "update-expense EXP1 USR2 40 exact Hotel USR1=10 USR2=30\n"
+                          "delete-expense EXP9\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+
+    REQUIRE(summary.errors == 1);
+    REQUIRE(manager.getAllBalances().at("USR1") == Approx(-10.0));
+    REQUIRE(out.str().find("error: line 6: Unknown expense id: EXP9") != std::string::npos);
+}
+
+TEST_CASE("Scripts backdate expenses and query by time", "[script]") {
+    SplitwiseManager manager;
+    std::istringstream in("add-user A\nadd-user B\nadd-group G USR1 USR2\n"
+                          "add-expense GRP1 USR1 100 equal Hotel @2024-03-01\n"
+                          "add-expense GRP1 USR2 50 equal Taxi @2024-03-05T08:00\n"
+                          "expenses-between * 2024-03-01 2024-03-04\n"
+                          "balances-as-of 2024-03-02\n");
+    std::ostringstream out;
+    ScriptRunner runner(manager, out);
+    ScriptSummary summary = runner.run(in);
+
+    REQUIRE(summary.errors == 0);
+    REQUIRE(manager.getExpenses().at("EXP2").getTimestamp() == 1709625600);
+    REQUIRE(out.str().find("EXP1 1709251200 GRP1 100.00\nUSR1 50.00\nUSR2 -50.00\n") != std::string::npos);
+}
+
+TEST_CASE("Command tokenizer honours quotes", "[script]") {
+    auto tokens = tokenizeCommand(R"(add-expense GRP1 USR1 10 equal "Hotel \"Lisbon\"")");
+    REQUIRE(tokens.size() == 6);
+    REQUIRE(tokens[5] == "Hotel \"Lisbon\"");
+    REQUIRE_THROWS_AS(tokenizeCommand("add-user \"open"), std::invalid_argument);
+}
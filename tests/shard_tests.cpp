@@ -0,0 +1,176 @@
+#include "../third_party/catch2.hpp"
+
+#include "daemon_server.hpp"
+#include "script_runner.hpp"
+#include "shard_coordinator.hpp"
+#include "splitwise_manager.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+std::string idOf(const protocol::Response &response) { return response.body.substr(0, response.body.find('\n')); }
+}
+
+TEST_CASE("Sharded managers number records disjointly and ids name their shard", "[shards]") {
+    SplitwiseManager manager;
+    manager.setIdSequence(1, 3);
+    REQUIRE(manager.addUser("A") == "USR1");
+    manager.addUserWithId("USR7", "B");
+    REQUIRE(manager.addUser("C") == "USR8");
+    REQUIRE_THROWS_AS(manager.addUserWithId("USR7", "again"), std::invalid_argument);
+    REQUIRE_THROWS_AS(manager.setIdSequence(3, 3), std::invalid_argument);
+
+    REQUIRE(manager.addGroup("Trip", {"USR1", "USR7"}) == "GRP2");
+    REQUIRE(manager.addGroup("Flat", {"USR1", "USR8"}) == "GRP5");
+    SplitInput input;
+    input.payerId = "USR1";
+    input.amount = 30.0;
+    input.participantIds = {"USR1", "USR7"};
+    REQUIRE(manager.addExpense("GRP2", "Taxi", input, SplitStrategyFactory::create("equal"), 100) == "EXP2");
+    for (const std::string id : {"GRP5", "EXP2", "REC8#3", "GRP0011"}) {
+        REQUIRE(ShardCoordinator::shardOf(id, 3) == 1);
+    }
+    REQUIRE(ShardCoordinator::shardOf("GRP3", 3) == 2);
+    REQUIRE_THROWS_AS(ShardCoordinator::shardOf("USR", 3), std::invalid_argument);
+    REQUIRE_THROWS_AS(ShardCoordinator::shardOf("GRP0", 3), std::invalid_argument);
+
+    manager.saveToJson("shard_test.json");
+    SplitwiseManager loaded;
+    loaded.setIdSequence(1, 3);
+    loaded.loadFromJson("shard_test.json");
+    REQUIRE(loaded.addGroup("Later", {"USR7"}) == "GRP8");
+    std::remove("shard_test.json");
+}
+
+TEST_CASE("Coordinator over in-process shards matches a single ledger", "[shards][daemon]") {
+    constexpr std::size_t kShards = 3;
+    std::vector<std::unique_ptr<SplitwiseManager>> managers;
+    std::vector<std::unique_ptr<DaemonServer>> servers;
+    std::vector<std::string> paths;
+    for (std::size_t k = 0; k < kShards; ++k) {
+        managers.push_back(std::make_unique<SplitwiseManager>());
+        managers.back()->setIdSequence(k, kShards);
+        paths.push_back("shard_test_" + std::to_string(::getpid()) + "_" + std::to_string(k) + ".sock");
+        servers.push_back(std::make_unique<DaemonServer>(*managers.back(), DaemonOptions{paths.back(), 0, 1}));
+        servers.back()->start();
+    }
+    ShardCoordinator coordinator(paths);
+    REQUIRE(coordinator.shardCount() == kShards);
+
+    SplitwiseManager reference;
+    std::ostringstream ignored;
+    ScriptRunner runner(reference, ignored);
+    auto both = [&](const std::string &command) {
+        protocol::Response response = coordinator.execute(command);
+        REQUIRE(runner.execute(command) == response.ok);
+        return response;
+    };
+
+    std::vector<std::string> users;
+    for (int i = 0; i < 12; ++i) {
+        users.push_back(idOf(both("add-user \"Member " + std::to_string(i) + "\"")));
+    }
+    REQUIRE(managers[2]->getUsers().at(users[3]).getName() == "Member 3");
+    // Groups go to the shards in turn, which numbers them exactly like a single ledger.
+    std::vector<std::string> groups;
+    for (int g = 0; g < 6; ++g) {
+        std::string command = "add-group G" + std::to_string(g);
+        for (int m = 0; m < 4; ++m) {
+            command += " " + users[(g * 2 + m) % users.size()];
+        }
+        groups.push_back(idOf(both(command)));
+        REQUIRE(groups.back() == "GRP" + std::to_string(g + 1));
+        REQUIRE(managers[g % kShards]->getGroups().count(groups.back()) == 1);
+    }
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> cents(100, 20000);
+    std::vector<std::string> shardedIds;
+    for (int i = 0; i < 300; ++i) {
+        const int g = i % 6;
+        const std::string payer = users[(g * 2 + i % 4) % users.size()];
+        char amount[32];
+        std::snprintf(amount, sizeof(amount), "%.2f", cents(rng) / 100.0);
+        protocol::Response added = both("add-expense " + groups[g] + " " + payer + " " + amount + " equal Item @" +
+                                        std::to_string(1000 + i));
+        REQUIRE(added.ok);
+        shardedIds.push_back(idOf(added));
+    }
+    REQUIRE(!both("add-expense " + groups[0] + " " + users[11] + " 10 equal Outsider " + users[11]).ok);
+
+    // Expense ids differ between the layouts, so edits are applied to each by its own id.
+    coordinator.execute("delete-expense " + shardedIds[7]);
+    runner.execute("delete-expense EXP8");
+    coordinator.execute("update-expense " + shardedIds[20] + " " + users[4] + " 99 equal Fixed");
+    runner.execute("update-expense EXP21 " + users[4] + " 99 equal Fixed");
+
+    const BalanceSheet::BalanceMap expected = reference.getAllBalances();
+    const BalanceSheet::BalanceMap actual = coordinator.getAllBalances();
+    REQUIRE(actual.size() == expected.size());
+    for (const auto &[userId, balance] : expected) {
+        REQUIRE(actual.at(userId) == Approx(balance));
+    }
+    std::vector<SettlementTransaction> transfers = coordinator.settleUpGreedy();
+    std::vector<SettlementTransaction> single = reference.settleUpGreedy();
+    REQUIRE(transfers.size() == single.size());
+    for (std::size_t i = 0; i < single.size(); ++i) {
+        REQUIRE(transfers[i].fromUserId == single[i].fromUserId);
+        REQUIRE(transfers[i].toUserId == single[i].toUserId);
+        REQUIRE(transfers[i].amount == Approx(single[i].amount));
+    }
+
+    REQUIRE(coordinator.execute("rank " + users[4] + " " + groups[2]).body ==
+            std::to_string(*reference.getBalanceRank(users[4], groups[2])) + "\n");
+    protocol::Response settle = coordinator.execute("settle");
+    REQUIRE(settle.ok);
+    REQUIRE(std::count(settle.body.begin(), settle.body.end(), '\n') == static_cast<long>(single.size()));
+    REQUIRE(!coordinator.execute("stats").ok);
+    REQUIRE(!coordinator.execute("delete-expense nothing").ok);
+
+    for (auto &server : servers) {
+        server->stop();
+    }
+}
+
+TEST_CASE("Coordinator starts shard processes that persist their own ledgers", "[shards][process]") {
+    const std::string dir = (std::filesystem::temp_directory_path() /
+                             ("splitwise_shards_" + std::to_string(::getpid())))
+                                .string();
+    std::filesystem::remove_all(dir);
+    const ShardSpawnOptions options{SPLITWISE_BINARY, dir, 2, 1};
+    std::string balances;
+    {
+        ShardCoordinator coordinator(options);
+        for (const char *command : {"add-user A", "add-user B", "add-user C", "add-group Trip USR1 USR2",
+                                    "add-group Flat USR2 USR3", "add-expense GRP1 USR1 60 equal Hotel @10",
+                                    "add-expense GRP2 USR3 40 equal Rent @20", "add-member GRP1 USR3 @30",
+                                    "add-expense GRP1 USR3 30 equal Dinner @40"}) {
+            protocol::Response response = coordinator.execute(command);
+            REQUIRE(response.ok);
+        }
+        balances = coordinator.execute("balances").body;
+        REQUIRE(balances == "USR1 20.00\nUSR2 -60.00\nUSR3 40.00\n");
+        REQUIRE(coordinator.execute("settle").body == "USR2 USR3 40.00\nUSR2 USR1 20.00\n");
+        REQUIRE(coordinator.execute("save " + dir).ok);
+    }
+    REQUIRE(std::filesystem::exists(dir + "/shard-0.json"));
+    REQUIRE(std::filesystem::exists(dir + "/shard-1.json"));
+
+    ShardCoordinator restarted(options);
+    REQUIRE(restarted.execute("balances").body == balances);
+    REQUIRE(restarted.execute("add-user D").body == "USR4\n");
+    // Shard 0 continues its own sequence: GRP1, GRP3, ...
+    REQUIRE(restarted.execute("add-group Club USR4 USR1").body == "GRP3\n");
+    REQUIRE(restarted.execute("add-expense GRP3 USR4 10 equal Fee").ok);
+    REQUIRE(restarted.execute("balances").body == "USR1 15.00\nUSR2 -60.00\nUSR3 40.00\nUSR4 5.00\n");
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,154 @@
+#include "../third_party/catch2.hpp"
+
+#include "ledger_snapshot.hpp"
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+std::string readFile(const std::string &path) {
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+void buildLedger(SplitwiseManager &manager, std::size_t users, std::size_t expenses) {
+    std::vector<std::string> ids;
+    for (std::size_t i = 0; i < users; ++i) {
+        ids.push_back(manager.addUser("user" + std::to_string(i)));
+    }
+    std::vector<std::string> groups;
+    for (std::size_t start = 0; start + 4 <= users; start += 4) {
+        groups.push_back(manager.addGroup("g", {ids.begin() + static_cast<std::ptrdiff_t>(start),
+                                                ids.begin() + static_cast<std::ptrdiff_t>(start + 4)}));
+    }
+    auto equal = SplitStrategyFactory::create("equal");
+    for (std::size_t i = 0; i < expenses; ++i) {
+        std::size_t g = i % groups.size();
+        SplitInput input;
+        input.payerId = ids[g * 4 + i % 4];
+        input.amount = 1.0 + static_cast<double>(i % 97) / 7.0;
+        input.participantIds = {ids[g * 4], ids[g * 4 + 1], ids[g * 4 + 2], ids[g * 4 + 3]};
+        manager.addExpense(groups[g], "Expense \"" + std::to_string(i) + "\"", input, equal,
+                           1700000000 + static_cast<std::int64_t>((i * 37) % 5000));
+    }
+}
+}
+
+TEST_CASE("Thread pool runs parallel loops, reductions and nested work", "[pool]") {
+    ThreadPool pool(3);
+    REQUIRE(pool.size() == 3);
+
+    std::vector<int> hits(10001, 0);
+    parallelFor(&pool, hits.size(), 64, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            ++hits[i];
+        }
+    });
+    for (int hit : hits) {
+        REQUIRE(hit == 1);
+    }
+
+    auto sumOfInverses = [](ThreadPool *target) {
+        return parallelReduce(
+            target, 100000, 1000, 0.0,
+            [](std::size_t begin, std::size_t end) {
+                double sum = 0.0;
+                for (std::size_t i = begin; i < end; ++i) {
+                    sum += 1.0 / static_cast<double>(i + 1);
+                }
+                return sum;
+            },
+            [](double a, double b) { return a + b; });
+    };
+    // Ranges depend only on the grain, so the parallel and inline answers are bit-identical.
+    REQUIRE(sumOfInverses(&pool) == sumOfInverses(nullptr));
+
+    REQUIRE_THROWS_AS(parallelFor(&pool, 100, 1,
+                                  [](std::size_t begin, std::size_t) {
+                                      if (begin == 42) {
+                                          throw std::invalid_argument("chunk 42");
+                                      }
+                                  }),
+                      std::invalid_argument);
+
+    // Loops started from inside pool tasks must not deadlock even when every worker is busy running one.
+    std::atomic<std::size_t> total{0};
+    std::vector<std::future<void>> outer;
+    for (int task = 0; task < 6; ++task) {
+        auto done = std::make_shared<std::promise<void>>();
+        outer.push_back(done->get_future());
+        pool.submit([&, done] {
+            parallelFor(&pool, 1000, 10, [&](std::size_t begin, std::size_t end) { total += end - begin; });
+            done->set_value();
+        });
+    }
+    for (auto &future : outer) {
+        future.get();
+    }
+    REQUIRE(total.load() == 6000);
+}
+
+TEST_CASE("Parallel manager operations match sequential results exactly", "[pool][manager]") {
+    SplitwiseManager source;
+    buildLedger(source, 400, 20000);
+    source.setParallelism(1);
+    source.saveToJson("pool_sequential.json");
+    source.setParallelism(4);
+    REQUIRE(source.getParallelism() == 4);
+    source.saveToJson("pool_parallel.json");
+    const std::string sequentialText = readFile("pool_sequential.json");
+    REQUIRE(sequentialText == readFile("pool_parallel.json"));
+
+    SplitwiseManager sequential;
+    sequential.setParallelism(1);
+    sequential.loadFromJson("pool_sequential.json");
+    SplitwiseManager parallel;
+    parallel.setParallelism(4);
+    parallel.loadFromJson("pool_sequential.json");
+    REQUIRE(parallel.getAllBalances() == sequential.getAllBalances());
+    REQUIRE(parallel.getBalancesAsOf(1700002500) == sequential.getBalancesAsOf(1700002500));
+
+    auto expected = sequential.settleUpGreedy();
+    auto actual = parallel.settleUpGreedy();
+    REQUIRE(actual.size() == expected.size());
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+        REQUIRE(actual[i].fromUserId == expected[i].fromUserId);
+        REQUIRE(actual[i].toUserId == expected[i].toUserId);
+        REQUIRE(actual[i].amount == expected[i].amount);
+    }
+
+    // The parallel writer produces the same bytes as the generic dumper, with and without indentation.
+    LedgerSnapshot snapshot;
+    for (const auto &[id, expense] : parallel.getExpenses()) {
+        snapshot.expenses.push_back(expense);
+    }
+    ThreadPool pool(2);
+    REQUIRE(snapshot.dump(2, &pool) == snapshot.toJson().dump(2));
+    REQUIRE(snapshot.dump(-1, &pool) == snapshot.toJson().dump());
+
+    // A bad record in any chunk fails the whole load.
+    std::string corrupt = sequentialText;
+    corrupt.replace(corrupt.rfind("\"GRP"), 4, "\"BAD");
+    {
+        std::ofstream out("pool_corrupt.json");
+        out << corrupt;
+    }
+    SplitwiseManager broken;
+    broken.setParallelism(4);
+    REQUIRE_THROWS_AS(broken.loadFromJson("pool_corrupt.json"), std::runtime_error);
+
+    std::remove("pool_sequential.json");
+    std::remove("pool_parallel.json");
+    std::remove("pool_corrupt.json");
+}
@@ -0,0 +1,53 @@
+#include "../third_party/catch2.hpp"
+
+#include "split_strategy_factory.hpp"
+#include "splitwise_manager.hpp"
+#include "tracing.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("Trace spans are exported in Chrome trace format", "[tracing]") {
+    SplitwiseManager manager;
+    std::string alice = manager.addUser("Alice");
+    std::string bob = manager.addUser("Bob");
+    std::string groupId = manager.addGroup("Trip", {alice, bob});
+    SplitInput hotel;
+    hotel.payerId = alice;
+    hotel.amount = 80.0;
+    hotel.participantIds = {alice, bob};
+    manager.addExpense(groupId, "Hotel", hotel, SplitStrategyFactory::create("equal"));
+
+    REQUIRE(!tracing::enabled());
+    manager.saveToJson("trace_state.json");
+
+    tracing::clear();
+    tracing::start("trace_test.json");
+    REQUIRE(tracing::enabled());
+    manager.loadFromJson("trace_state.json");
+    manager.settleUpGreedy();
+    tracing::stop();
+    REQUIRE(!tracing::enabled());
+
+    std::ifstream in("trace_test.json");
+    nlohmann::json trace;
+    in >> trace;
+    std::ostringstream names;
+    std::size_t spans = 0;
+    for (const auto &event : trace.at("traceEvents")) {
+        if (event.at("ph").get<std::string>() == "X") {
+            ++spans;
+            names << event.at("name").get<std::string>() << ' ';
+        }
+    }
+    REQUIRE(spans >= 9);
+    REQUIRE(names.str().find("loadFromJson.parse") != std::string::npos);
+    REQUIRE(names.str().find("recomputeBalances") != std::string::npos);
+    REQUIRE(names.str().find("settleUpGreedy.match") != std::string::npos);
+    REQUIRE(names.str().find("saveToJson") == std::string::npos);
+
+    tracing::clear();
+    std::remove("trace_state.json");
+    std::remove("trace_test.json");
+}
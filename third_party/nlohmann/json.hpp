@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cctype>
+#include <charconv>
 #include <cstdlib>
 #include <initializer_list>
 #include <limits>
@@ -106,6 +107,36 @@ public:
         return oss.str();
     }
 
+    /**
+     * Write this value as it would appear nested `depth` levels deep in an indented document, so large documents can
+     * be rendered piecewise.
+     */
+    void dump_to(std::ostream &os, int indent, int depth = 0) const { dumpInternal(os, indent, depth); }
+
+    /**
+     * Heap bytes owned by this value and its children: array buffers, object tree nodes and out-of-line strings.
+     * `block(n)` maps an allocation request of n bytes to what it really costs, e.g. including allocator headers.
+     */
+    template <typename BlockSize> std::size_t heap_bytes(BlockSize &&block) const {
+        auto text = [&](const std::string &s) { return s.capacity() > 15 ? block(s.capacity() + 1) : 0; };
+        std::size_t bytes = 0;
+        if (const auto *s = std::get_if<std::string>(&data_)) {
+            bytes += text(*s);
+        } else if (const auto *arr = std::get_if<array_t>(&data_)) {
+            bytes += arr->capacity() ? block(arr->capacity() * sizeof(json)) : 0;
+            for (const auto &item : *arr) {
+                bytes += item.heap_bytes(block);
+            }
+        } else if (const auto *obj = std::get_if<object_t>(&data_)) {
+            for (const auto &kv : *obj) {
+                // Red-black tree node: colour word and three pointers ahead of the key/value pair.
+                bytes += block(4 * sizeof(void *) + sizeof(object_t::value_type)) + text(kv.first) +
+                         kv.second.heap_bytes(block);
+            }
+        }
+        return bytes;
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const json &j) {
         int indent = static_cast<int>(os.width());
         if (indent > 0) {
@@ -360,7 +391,10 @@ private:
         } else if (std::holds_alternative<bool>(data_)) {
             os << (std::get<bool>(data_) ? "true" : "false");
         } else if (std::holds_alternative<double>(data_)) {
-            os << std::get<double>(data_);
+            // Shortest representation that parses back to the same double (ids and amounts must round-trip).
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), std::get<double>(data_));
+            os.write(buffer, result.ptr - buffer);
         } else if (std::holds_alternative<std::string>(data_)) {
             os << '"' << escape(std::get<std::string>(data_)) << '"';
         } else if (std::holds_alternative<array_t>(data_)) {
@@ -509,5 +543,16 @@ template <> inline std::map<std::string, double> json::get<std::map<std::string,
     return result;
 }
 
+template <> inline std::map<std::string, std::string> json::get<std::map<std::string, std::string>>() const {
+    if (!is_object()) {
+        throw std::logic_error("json value is not an object");
+    }
+    std::map<std::string, std::string> result;
+    for (const auto &kv : std::get<object_t>(data_)) {
+        result[kv.first] = kv.second.get<std::string>();
+    }
+    return result;
+}
+
 } // namespace nlohmann
 
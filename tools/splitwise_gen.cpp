@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ordered_pipeline.hpp"
+#include "splitwise_manager.hpp"
+
+namespace {
+/**
+ * @brief Parameters describing the synthetic ledger to generate.
+ */
+struct GenOptions {
+    std::string outPath{"ledger.json"};
+    std::uint64_t seed{1};
+    std::size_t users{1000};
+    std::size_t groups{100};
+    std::size_t expenses{10000};
+    std::size_t minGroupSize{2};
+    std::size_t maxGroupSize{5000};
+    double groupSizeAlpha{1.5};
+    std::size_t maxParticipants{8};
+    double equalWeight{0.6};
+    double exactWeight{0.25};
+    double percentWeight{0.15};
+    std::size_t chunkSize{4096};
+    unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+    bool verify{false};
+};
+
+constexpr const char *DESCRIPTIONS[] = {"Dinner",    "Groceries",    "Hotel Lisbon", "Taxi",      "Rent",
+                                        "Utilities", "Coffee",       "Flights",      "Museum",    "Fuel",
+                                        "Concert",   "Internet bill", "Breakfast",   "Car rental", "Pharmacy"};
+
+/**
+ * @brief SplitMix64 step used to derive independent per-chunk seeds.
+ */
+std::uint64_t mixSeed(std::uint64_t seed, std::uint64_t stream, std::uint64_t index) {
+    std::uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (stream * 0x100000001B3ULL + index + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief A serialised slice of one section plus the balance deltas it contributes.
+ */
+struct Chunk {
+    std::string text;
+    std::vector<std::pair<std::uint32_t, double>> deltas;
+};
+
+void appendMoney(std::string &out, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.2f", value);
+    out += buffer;
+}
+
+/**
+ * @brief Pick `count` distinct users (Floyd's algorithm) so large groups never need a full shuffle.
+ */
+std::vector<std::uint32_t> sampleDistinct(std::size_t population, std::size_t count, std::mt19937_64 &rng) {
+    std::unordered_set<std::uint32_t> chosen;
+    std::vector<std::uint32_t> result;
+    result.reserve(count);
+    for (std::size_t j = population - count; j < population; ++j) {
+        std::uniform_int_distribution<std::size_t> pick(0, j);
+        auto candidate = static_cast<std::uint32_t>(pick(rng));
+        if (!chosen.insert(candidate).second) {
+            candidate = static_cast<std::uint32_t>(j);
+            chosen.insert(candidate);
+        }
+        result.push_back(candidate);
+    }
+    return result;
+}
+
+/**
+ * @brief Streams a `saveToJson`-compatible ledger to disk.
+ */
+class LedgerGenerator {
+public:
+    explicit LedgerGenerator(GenOptions options) : options_(std::move(options)) {
+        if (options_.users < 2) {
+            throw std::invalid_argument("At least two users are required");
+        }
+        if (options_.groups == 0 && options_.expenses > 0) {
+            throw std::invalid_argument("Expenses require at least one group");
+        }
+        options_.minGroupSize = std::max<std::size_t>(1, std::min(options_.minGroupSize, options_.users));
+        options_.maxGroupSize = std::max(options_.minGroupSize, std::min(options_.maxGroupSize, options_.users));
+        options_.maxParticipants = std::max<std::size_t>(1, options_.maxParticipants);
+        options_.chunkSize = std::max<std::size_t>(1, options_.chunkSize);
+        options_.threads = std::max(1u, options_.threads);
+    }
+
+    void run() {
+        std::ofstream out(options_.outPath, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error("Failed to open file for writing: " + options_.outPath);
+        }
+        std::vector<char> buffer(1 << 20);
+        out.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+        balances_.assign(options_.users, 0.0);
+        generateMemberships();
+
+        out << "{\n\"users\": [\n";
+        writeSection(out, options_.users, 0, [this](std::size_t i, std::mt19937_64 &, Chunk &chunk) {
+            chunk.text += "{\"id\": \"USR" + std::to_string(i + 1) + "\", \"name\": \"User " + std::to_string(i + 1) +
+                          "\"}";
+        });
+        out << "],\n\"groups\": [\n";
+        writeSection(out, options_.groups, 1, [this](std::size_t g, std::mt19937_64 &, Chunk &chunk) {
+            chunk.text += "{\"id\": \"GRP" + std::to_string(g + 1) + "\", \"name\": \"Group " + std::to_string(g + 1) +
+                          "\", \"members\": [";
+            const auto &members = members_[g];
+            for (std::size_t m = 0; m < members.size(); ++m) {
+                chunk.text += (m ? ", \"USR" : "\"USR") + std::to_string(members[m] + 1) + "\"";
+            }
+            chunk.text += "]}";
+        });
+        out << "],\n\"expenses\": [\n";
+        writeSection(out, options_.expenses, 2, [this](std::size_t e, std::mt19937_64 &rng, Chunk &chunk) {
+            appendExpense(e, rng, chunk);
+        });
+        out << "],\n\"balances\": {\n";
+        for (std::size_t i = 0; i < balances_.size(); ++i) {
+            char value[48];
+            std::snprintf(value, sizeof(value), "%.15g", std::abs(balances_[i]) < 1e-9 ? 0.0 : balances_[i]);
+            out << (i ? ",\n" : "") << "\"USR" << (i + 1) << "\": " << value;
+        }
+        out << "\n}\n}\n";
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Failed while writing: " + options_.outPath);
+        }
+    }
+
+    std::uint64_t bytesWritten() const noexcept { return bytesWritten_; }
+
+private:
+    /**
+     * @brief Draw heavy-tailed (Pareto) group sizes and their member sets in parallel.
+     */
+    void generateMemberships() {
+        members_.assign(options_.groups, {});
+        std::size_t chunkCount = (options_.groups + options_.chunkSize - 1) / options_.chunkSize;
+        std::atomic<std::size_t> next{0};
+        auto worker = [&] {
+            for (std::size_t c = next.fetch_add(1); c < chunkCount; c = next.fetch_add(1)) {
+                std::mt19937_64 rng(mixSeed(options_.seed, 3, c));
+                std::uniform_real_distribution<double> uniform(std::numeric_limits<double>::min(), 1.0);
+                std::size_t end = std::min(options_.groups, (c + 1) * options_.chunkSize);
+                for (std::size_t g = c * options_.chunkSize; g < end; ++g) {
+                    double draw = static_cast<double>(options_.minGroupSize) *
+                                  std::pow(uniform(rng), -1.0 / options_.groupSizeAlpha);
+                    std::size_t size = static_cast<std::size_t>(
+                        std::min(draw, static_cast<double>(options_.maxGroupSize)));
+                    members_[g] = sampleDistinct(options_.users, std::max(options_.minGroupSize, size), rng);
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < options_.threads; ++t) {
+            workers.emplace_back(worker);
+        }
+        for (auto &thread : workers) {
+            thread.join();
+        }
+    }
+
+    template <typename Emit>
+    void writeSection(std::ofstream &out, std::size_t count, std::uint64_t stream, Emit emit) {
+        std::size_t chunkCount = (count + options_.chunkSize - 1) / options_.chunkSize;
+        runOrderedPipeline<Chunk>(
+            chunkCount,
+            options_.threads,
+            [&](std::size_t c) {
+                Chunk chunk;
+                std::mt19937_64 rng(mixSeed(options_.seed, stream, c));
+                std::size_t end = std::min(count, (c + 1) * options_.chunkSize);
+                for (std::size_t i = c * options_.chunkSize; i < end; ++i) {
+                    emit(i, rng, chunk);
+                    chunk.text += i + 1 < count ? ",\n" : "\n";
+                }
+                return chunk;
+            },
+            [&](std::size_t, const Chunk &chunk) {
+                out.write(chunk.text.data(), static_cast<std::streamsize>(chunk.text.size()));
+                bytesWritten_ += chunk.text.size();
+                for (const auto &[user, delta] : chunk.deltas) {
+                    balances_[user] += delta;
+                }
+            });
+    }
+
+    void appendExpense(std::size_t e, std::mt19937_64 &rng, Chunk &chunk) {
+        std::uniform_int_distribution<std::size_t> groupPick(0, options_.groups - 1);
+        std::size_t g = groupPick(rng);
+        const auto &members = members_[g];
+
+        std::size_t participantCount = std::min(members.size(), options_.maxParticipants);
+        std::vector<std::uint32_t> participants;
+        if (participantCount == members.size()) {
+            participants = members;
+        } else {
+            for (auto index : sampleDistinct(members.size(), participantCount, rng)) {
+                participants.push_back(members[index]);
+            }
+        }
+        std::uniform_int_distribution<std::size_t> payerPick(0, participants.size() - 1);
+        std::uint32_t payer = participants[payerPick(rng)];
+
+        std::uniform_int_distribution<long long> centsDist(100, 500000);
+        long long cents = centsDist(rng);
+        double amount = static_cast<double>(cents) / 100.0;
+
+        std::uniform_real_distribution<double> mix(0.0, options_.equalWeight + options_.exactWeight +
+                                                              options_.percentWeight);
+        double roll = mix(rng);
+        const char *strategy = roll < options_.equalWeight                          ? "equal"
+                               : roll < options_.equalWeight + options_.exactWeight ? "exact"
+                                                                                    : "percent";
+
+        std::vector<double> exactShares;
+        std::vector<double> percentShares;
+        chunk.deltas.emplace_back(payer, amount);
+        if (strategy[1] == 'q') {
+            double share = amount / static_cast<double>(participants.size());
+            for (auto participant : participants) {
+                chunk.deltas.emplace_back(participant, -share);
+            }
+        } else {
+            // Split integer units (cents, or hundredths of a percent) so shares sum exactly.
+            long long units = strategy[1] == 'x' ? cents : 10000;
+            std::vector<long long> weights(participants.size());
+            std::uniform_int_distribution<long long> weightDist(1, 100);
+            long long totalWeight = 0;
+            for (auto &weight : weights) {
+                weight = weightDist(rng);
+                totalWeight += weight;
+            }
+            long long assigned = 0;
+            for (std::size_t i = 0; i < participants.size(); ++i) {
+                long long part = i + 1 == participants.size() ? units - assigned : units * weights[i] / totalWeight;
+                assigned += part;
+                double value = static_cast<double>(part) / 100.0;
+                if (strategy[1] == 'x') {
+                    exactShares.push_back(value);
+                    chunk.deltas.emplace_back(participants[i], -value);
+                } else {
+                    percentShares.push_back(value);
+                    chunk.deltas.emplace_back(participants[i], -amount * (value / 100.0));
+                }
+            }
+        }
+
+        std::uniform_int_distribution<std::size_t> descPick(0, std::size(DESCRIPTIONS) - 1);
+        std::string &text = chunk.text;
+        text += "{\"id\": \"EXP" + std::to_string(e + 1) + "\", \"groupId\": \"GRP" + std::to_string(g + 1) +
+                "\", \"description\": \"" + DESCRIPTIONS[descPick(rng)] + "\", \"payerId\": \"USR" +
+                std::to_string(payer + 1) + "\", \"amount\": ";
+        appendMoney(text, amount);
+        text += ", \"participants\": [";
+        for (std::size_t i = 0; i < participants.size(); ++i) {
+            text += (i ? ", \"USR" : "\"USR") + std::to_string(participants[i] + 1) + "\"";
+        }
+        auto appendShares = [&text](const std::vector<double> &shares) {
+            text += "[";
+            for (std::size_t i = 0; i < shares.size(); ++i) {
+                if (i) {
+                    text += ", ";
+                }
+                appendMoney(text, shares[i]);
+            }
+            text += "]";
+        };
+        text += "], \"exactShares\": ";
+        appendShares(exactShares);
+        text += ", \"percentShares\": ";
+        appendShares(percentShares);
+        text += ", \"strategy\": \"";
+        text += strategy;
+        text += "\"}";
+    }
+
+    GenOptions options_;
+    std::vector<std::vector<std::uint32_t>> members_;
+    std::vector<double> balances_;
+    std::uint64_t bytesWritten_{0};
+};
+
+void printUsage() {
+    std::cout << "Usage: splitwise_gen [--out FILE] [--seed N] [--users N] [--groups N] [--expenses N]\n"
+              << "                     [--min-group-size N] [--max-group-size N] [--group-alpha X]\n"
+              << "                     [--max-participants N] [--mix EQUAL:EXACT:PERCENT] [--threads N]\n"
+              << "                     [--chunk-size N] [--verify]\n";
+}
+
+void parseMix(const std::string &value, GenOptions &options) {
+    std::size_t first = value.find(':');
+    std::size_t second = value.find(':', first == std::string::npos ? first : first + 1);
+    if (first == std::string::npos || second == std::string::npos) {
+        throw std::invalid_argument("--mix expects EQUAL:EXACT:PERCENT weights");
+    }
+    options.equalWeight = std::stod(value.substr(0, first));
+    options.exactWeight = std::stod(value.substr(first + 1, second - first - 1));
+    options.percentWeight = std::stod(value.substr(second + 1));
+    if (options.equalWeight < 0 || options.exactWeight < 0 || options.percentWeight < 0 ||
+        options.equalWeight + options.exactWeight + options.percentWeight <= 0) {
+        throw std::invalid_argument("--mix weights must be non-negative and not all zero");
+    }
+}
+}
+
+int main(int argc, char **argv) {
+    GenOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--out") {
+                options.outPath = next();
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(next());
+            } else if (arg == "--users") {
+                options.users = std::stoul(next());
+            } else if (arg == "--groups") {
+                options.groups = std::stoul(next());
+            } else if (arg == "--expenses") {
+                options.expenses = std::stoul(next());
+            } else if (arg == "--min-group-size") {
+                options.minGroupSize = std::stoul(next());
+            } else if (arg == "--max-group-size") {
+                options.maxGroupSize = std::stoul(next());
+            } else if (arg == "--group-alpha") {
+                options.groupSizeAlpha = std::stod(next());
+            } else if (arg == "--max-participants") {
+                options.maxParticipants = std::stoul(next());
+            } else if (arg == "--mix") {
+                parseMix(next(), options);
+            } else if (arg == "--threads") {
+                options.threads = static_cast<unsigned>(std::stoul(next()));
+            } else if (arg == "--chunk-size") {
+                options.chunkSize = std::stoul(next());
+            } else if (arg == "--verify") {
+                options.verify = true;
+            } else {
+                printUsage();
+                return arg == "--help" ? 0 : 2;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        LedgerGenerator generator(options);
+        generator.run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Wrote " << options.outPath << " (" << generator.bytesWritten() / (1024.0 * 1024.0) << " MiB of records in "
+                  << seconds << " s)\n";
+
+        if (options.verify) {
+            SplitwiseManager manager;
+            manager.loadFromJson(options.outPath);
+            if (manager.getUsers().size() != options.users || manager.getGroups().size() != options.groups ||
+                manager.getExpenses().size() != options.expenses) {
+                throw std::runtime_error("Verification failed: entity counts do not match the requested parameters");
+            }
+            std::cout << "Verified: " << manager.getUsers().size() << " users, " << manager.getGroups().size()
+                      << " groups, " << manager.getExpenses().size() << " expenses\n";
+        }
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "daemon_client.hpp"
+
+namespace {
+/**
+ * @brief Parameters describing the load to drive against a running daemon.
+ */
+struct LoadOptions {
+    std::string socketPath;
+    std::uint16_t port{0};
+    std::size_t connections{4};
+    std::size_t depth{16};
+    std::size_t requests{20000};
+    std::size_t users{100};
+    std::size_t groups{10};
+    double writeRatio{0.8};
+    std::uint64_t seed{1};
+};
+
+DaemonClient connect(const LoadOptions &options) {
+    return options.socketPath.empty() ? DaemonClient::connectTcp("127.0.0.1", options.port)
+                                      : DaemonClient::connectUnix(options.socketPath);
+}
+
+std::string firstLine(const std::string &body) {
+    return body.substr(0, body.find('\n'));
+}
+
+/**
+ * @brief Create the users and groups the workload refers to; returns the member ids of every group.
+ */
+std::vector<std::vector<std::string>> setUp(const LoadOptions &options) {
+    DaemonClient client = connect(options);
+    std::vector<std::string> commands;
+    for (std::size_t i = 0; i < options.users; ++i) {
+        commands.push_back("add-user Load User " + std::to_string(i));
+    }
+    std::vector<std::string> userIds;
+    for (const auto &response : client.callBatch(commands)) {
+        if (!response.ok) {
+            throw std::runtime_error("Setup failed: " + response.body);
+        }
+        userIds.push_back(firstLine(response.body));
+    }
+
+    std::vector<std::vector<std::string>> members(options.groups);
+    commands.clear();
+    for (std::size_t g = 0; g < options.groups; ++g) {
+        std::string command = "add-group load-" + std::to_string(g);
+        // Contiguous slices of the user list, so groups overlap only at their edges.
+        std::size_t begin = g * userIds.size() / options.groups;
+        std::size_t end = std::max(begin + 2, (g + 1) * userIds.size() / options.groups);
+        for (std::size_t u = begin; u < std::min(end, userIds.size()); ++u) {
+            members[g].push_back(userIds[u]);
+            command += " " + userIds[u];
+        }
+        commands.push_back(command);
+    }
+    std::vector<std::string> groupIds;
+    for (const auto &response : client.callBatch(commands)) {
+        if (!response.ok) {
+            throw std::runtime_error("Setup failed: " + response.body);
+        }
+        groupIds.push_back(firstLine(response.body));
+    }
+    for (std::size_t g = 0; g < options.groups; ++g) {
+        members[g].insert(members[g].begin(), groupIds[g]);
+    }
+    return members;
+}
+
+/**
+ * @brief Drive one connection: keep `depth` requests in flight and record each one's round-trip latency.
+ */
+void drive(const LoadOptions &options,
+           const std::vector<std::vector<std::string>> &groups,
+           std::size_t worker,
+           std::vector<std::uint64_t> &latencies,
+           std::atomic<std::size_t> &failures) {
+    using Clock = std::chrono::steady_clock;
+    DaemonClient client = connect(options);
+    std::mt19937_64 rng(options.seed * 7919 + worker);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const std::size_t total = options.requests / options.connections + (worker < options.requests % options.connections);
+
+    std::vector<Clock::time_point> sentAt(total);
+    latencies.reserve(total);
+    std::size_t sent = 0;
+    std::size_t received = 0;
+    while (received < total) {
+        while (sent < total && sent - received < options.depth) {
+            const auto &group = groups[rng() % groups.size()];
+            const std::string &member = group[1 + rng() % (group.size() - 1)];
+            if (unit(rng) < options.writeRatio) {
+                client.send("add-expense " + group[0] + " " + member + " " + std::to_string(1 + rng() % 200) +
+                            " equal Load");
+            } else {
+                client.send("user-expenses " + member + " - 10");
+            }
+            sentAt[sent++] = Clock::now();
+        }
+        protocol::Response response = client.receive();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sentAt[received++]);
+        latencies.push_back(static_cast<std::uint64_t>(elapsed.count()));
+        if (!response.ok) {
+            ++failures;
+        }
+    }
+}
+
+double percentileUs(const std::vector<std::uint64_t> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    std::size_t rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return static_cast<double>(sorted[rank]) / 1000.0;
+}
+
+void printUsage() {
+    std::cout << "Usage: splitwise_loadgen (--socket PATH | --port N) [--connections N] [--depth N]\n"
+              << "                         [--requests N] [--users N] [--groups N] [--write-ratio X] [--seed N]\n";
+}
+}
+
+int main(int argc, char **argv) {
+    LoadOptions options;
+    try {
+        bool haveEndpoint = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--socket") {
+                options.socketPath = next();
+                haveEndpoint = true;
+            } else if (arg == "--port") {
+                options.port = static_cast<std::uint16_t>(std::stoul(next()));
+                haveEndpoint = true;
+            } else if (arg == "--connections") {
+                options.connections = std::stoul(next());
+            } else if (arg == "--depth") {
+                options.depth = std::stoul(next());
+            } else if (arg == "--requests") {
+                options.requests = std::stoul(next());
+            } else if (arg == "--users") {
+                options.users = std::stoul(next());
+            } else if (arg == "--groups") {
+                options.groups = std::stoul(next());
+            } else if (arg == "--write-ratio") {
+                options.writeRatio = std::stod(next());
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(next());
+            } else {
+                printUsage();
+                return arg == "--help" ? 0 : 2;
+            }
+        }
+        if (!haveEndpoint) {
+            printUsage();
+            return 2;
+        }
+        if (options.connections == 0 || options.depth == 0 || options.groups == 0 || options.users < 2) {
+            throw std::invalid_argument("--connections, --depth and --groups must be positive and --users at least 2");
+        }
+
+        auto groups = setUp(options);
+        std::vector<std::vector<std::uint64_t>> latencies(options.connections);
+        std::atomic<std::size_t> failures{0};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t w = 0; w < options.connections; ++w) {
+            workers.emplace_back([&, w] { drive(options, groups, w, latencies[w], failures); });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<std::uint64_t> all;
+        for (const auto &samples : latencies) {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        std::sort(all.begin(), all.end());
+        std::cout << all.size() << " requests over " << options.connections << " connection(s), depth "
+                  << options.depth << ": " << static_cast<std::uint64_t>(all.size() / seconds) << " req/s\n"
+                  << "latency us: p50 " << percentileUs(all, 0.5) << "  p90 " << percentileUs(all, 0.9) << "  p99 "
+                  << percentileUs(all, 0.99) << "  p99.9 " << percentileUs(all, 0.999) << "  max "
+                  << percentileUs(all, 1.0) << "\n";
+        if (failures.load() != 0) {
+            std::cerr << failures.load() << " request(s) failed\n";
+            return 1;
+        }
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}